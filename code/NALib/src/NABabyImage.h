@@ -29,15 +29,27 @@
 // at the end of a horizontal line, meaning, all bytes are packed. Also at the
 // end of the data, there are no padding bytes. For each color value, if the
 // alpha channel is zero, all other channels must be zero as well.
+//
+// Alternatively, an image can be stored in tiles of 64x64 pixels. Each tile
+// is stored like a small image on its own, the tiles are arranged from left
+// to right and then from bottom to top. Tiles at the right and top border are
+// padded to the full tile size. Large images processed region by region
+// then touch only the memory of the tiles involved. All functions of this
+// file work with both kinds of images, except for the ones returning raw
+// lines.
 
 
 #include "NABase.h"
 #include "NACoord.h"
 #include "NABabyColor.h"
+#include "NAThreading.h"
 
 
 typedef struct NABabyImage NABabyImage;
 
+// The width and height of a tile in pixels.
+#define NA_BABY_IMAGE_TILE_SIZE 64
+
 // Note that BLACK_GREEN and WHITE_GREEN only work for opaque images.
 typedef enum{
   NA_BLEND_ZERO,        // Does not blend at all. The base remains as it is.
@@ -48,10 +60,25 @@ typedef enum{
   NA_BLEND_WHITE_GREEN  // Blends where base has light green pixels
 } NABlendMode;
 
+// The filters used when resizing images. All of them are separable.
+typedef enum{
+  NA_RESAMPLE_BILINEAR, // Triangle filter with radius 1. Fast but blurry.
+  NA_RESAMPLE_BICUBIC,  // Catmull-Rom spline with radius 2.
+  NA_RESAMPLE_LANCZOS   // Lanczos filter with radius 3. Sharpest result.
+} NAResampleFilter;
+
 // Creates an image with the specified size and fills it with the given color.
 // If color is Null, the image contents will be uninitialized.
 NA_API NABabyImage* naCreateBabyImage(NASizei size, const NABabyColor color);
 
+// Same as naCreateBabyImage but stores the image in tiles.
+NA_API NABabyImage* naCreateBabyImageTiled(NASizei size, const NABabyColor color);
+
+// Creates a copy of the image which is stored in tiles or not.
+NA_API NABabyImage* naCreateBabyImageWithTiling(
+  const NABabyImage* image,
+  NABool             tiled);
+
 // Creates a new image with a semi-transparent one-color representation of
 // the base image. The mode defines, how the tint color will be applied. The
 // blend factor defines how strong the tinting is.
@@ -73,19 +100,65 @@ NA_DEF NABabyImage* naCreateBabyImageWithBlend(
 // Creates an image half the size. Rescales data bilinearily.
 NA_API NABabyImage* naCreateBabyImageWithHalfSize(const NABabyImage* image);
 
-// Retains and Releases an image.
+// Creates an image with the given size, resampling the image with the given
+// filter. Works for any scale, in both directions independently. Colors are
+// weighted by alpha, the resulting alpha is limited to 1.
+NA_API NABabyImage* naCreateBabyImageWithResize(
+  const NABabyImage* image,
+  NASizei            size,
+  NAResampleFilter   filter);
+
+// Retains and Releases an image. Both are atomic, an image can be shared
+// between threads.
 NA_API NABabyImage* naRetainBabyImage(const NABabyImage* image);
 NA_API void naReleaseBabyImage(const NABabyImage* image);
 
-// Returns the number of float values per horizontal line.
+// Returns the number of float values per horizontal line. Only for images
+// which are not tiled.
 NA_API NAInt naGetBabyImageValuesPerLine(const NABabyImage* image);
 
 // Returns the image dimensions.
 NA_API NASizei naGetBabyImageSize(const NABabyImage* image);
 
-// Returns the raw image data.
+// Returns the raw image data. Only for images which are not tiled.
 NA_API float* naGetBabyImageData(const NABabyImage* image);
 
+// Returns whether the image is stored in tiles.
+NA_API NABool naIsBabyImageTiled(const NABabyImage* image);
+
+// Iterating over the tiles of an image: The rect of a tile denotes the
+// pixels of the image stored in that tile. The data of a tile starts with the
+// pixel at the origin of the rect, the lines of a tile consist of the given
+// number of values per line. Images which are not tiled consist of one
+// single tile covering the whole image.
+NA_API size_t  naGetBabyImageTileCount(const NABabyImage* image);
+NA_API NARecti naGetBabyImageTileRect(const NABabyImage* image, size_t tileIndex);
+NA_API float*  naGetBabyImageTileData(const NABabyImage* image, size_t tileIndex);
+NA_API NAInt   naGetBabyImageTileValuesPerLine(const NABabyImage* image);
+
+// Copies the pixels of the given rect between the image and data. Data
+// contains the lines of the rect from bottom to top without padding. Only
+// the tiles containing the rect are touched.
+NA_API void naGetBabyImageRegion(
+  const NABabyImage* image,
+  NARecti            rect,
+  float*             data);
+NA_API void naSetBabyImageRegion(
+  NABabyImage*       image,
+  NARecti            rect,
+  const float*       data);
+
+// Blends the top image upon the base image, placing the bottom left corner
+// of top at origin in base. Top must be completely inside of base. Other
+// than naCreateBabyImageWithBlend, the base image itself is changed and only
+// the tiles of base covered by top are touched.
+NA_API void naBlendBabyImageRegion(
+  NABabyImage*       base,
+  const NABabyImage* top,
+  NAPosi             origin,
+  NABlendMode        mode,
+  float              blend);
+
 // Fills the image with the given data. The data is expected to contain as
 // many RGBA values stored as uint8 necessary for the whole image with no
 // padding. Depending on the topToBottom flag, the data is expected as such.
@@ -106,6 +179,12 @@ NA_API void naConvertBabyImageTou8(
   NABool             topToBottom,
   NAColorBufferType  bufferType);
 
+// Sets the thread pool used by the functions above for large images. They
+// then process bands of lines in parallel. The pool is not retained and must
+// exist until it is unset by sending Null. By default, no pool is set and
+// all work is done on the calling thread.
+NA_API void naSetBabyImageThreadPool(NAThreadPool* pool);
+
 
 #ifdef __cplusplus
   } // extern "C"
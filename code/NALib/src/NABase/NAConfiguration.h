@@ -188,6 +188,11 @@
 // good speed improvements for naNew. A large enough custom byteSize can
 // result in up to 2 times faster allocation and deallocation.
 //
+// Every part is aligned to this size, which is why it is also the maximal
+// size a part can have. Types with few or rarely used values can choose a
+// smaller part size with NA_RUNTIME_TYPE_WITH_PART_SIZE. Such parts are
+// carved out of blocks of this size.
+//
 // Default is (1 << 16)
 
 #ifndef NA_POOLPART_BYTESIZE
@@ -150,6 +150,28 @@
 
 
 
+// The vector instruction sets the compiler is allowed to emit. SSE2 is
+// available on every 64 bit x86 processor, AVX2 only when explicitly
+// enabled with compiler flags like -mavx2 or /arch:AVX2. Define these
+// macros as 0 beforehand to force NALib to use the plain C code.
+#ifndef NA_SIMD_SSE2
+  #if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+    #define NA_SIMD_SSE2 1
+  #else
+    #define NA_SIMD_SSE2 0
+  #endif
+#endif
+
+#ifndef NA_SIMD_AVX2
+  #if NA_SIMD_SSE2 && defined __AVX2__
+    #define NA_SIMD_AVX2 1
+  #else
+    #define NA_SIMD_AVX2 0
+  #endif
+#endif
+
+
+
 #if (NA_SIZE_T_BITS != NA_ADDRESS_BITS)
   #warning "size_t and address size do not match. Might cause problems."
 #endif
@@ -194,6 +194,14 @@ NA_API void naAccumulateChecksum(
   NAChecksum* checksum,
   const NAByte* buf,
   size_t byteSize);
+
+// Combines the two checksums as if all bytes accumulated in appended had
+// been accumulated in checksum as well. Use this to compute the checksum of
+// large data in parallel: Accumulate consecutive parts in separate checksums
+// and combine them in order. Both checksums must have the same type.
+NA_API void naCombineChecksum(
+  NAChecksum* checksum,
+  const NAChecksum* appended);
 NA_API uint32 naGetChecksumResult(NAChecksum* checksum);
 
 
@@ -10,6 +10,7 @@
 typedef struct NABuffer NABuffer;
 typedef struct NABufferSource NABufferSource;
 typedef struct NABufferIterator NABufferIterator;
+typedef struct NABufferLineIterator NABufferLineIterator;
 
 
 
@@ -271,6 +272,11 @@ NA_API NABool naEqualBufferToData(      NABuffer* buffer,
 NA_API void naAppendBufferToBuffer(         NABuffer* dstbuffer,
                                       const NABuffer* srcBuffer);
 
+// Appends a copy of the given bytes to the end of dstbuffer.
+NA_API void naAppendBufferBytes(            NABuffer* dstbuffer,
+                                           const void* data,
+                                                size_t byteSize);
+
 // Converts the bytes of the given buffer to a string encoded in Base64.
 // When appendEndSign is NA_TRUE, equal signs = will be appended if needed.
 NA_API NAString* naNewStringWithBufferBase64Encoded(
@@ -290,6 +296,20 @@ NA_API void naWriteBufferToData(NABuffer* buffer, void* data);
 NA_API void naAccumulateChecksumBuffer( NAChecksum* checksum,
                                           NABuffer* buffer);
 
+// Fills spans with the contiguous memory blocks the given range of the buffer
+// consists of, without copying anything. The range is cached beforehand,
+// therefore the buffer must have a source for all bytes of the range.
+// At most maxCount spans are stored. The return value is the number of spans
+// needed for the whole range, even if it is bigger than maxCount. Hence, call
+// it with spans being NA_NULL to get the count first.
+//
+// The spans stay valid as long as the buffer is not altered or released. They
+// can be handed directly to naWriteFileByteSpans or any other I/O function.
+NA_API size_t naGetBufferSpans(   NABuffer* buffer,
+                                  NARangei range,
+                                NAByteSpan* spans,
+                                     size_t maxCount);
+
 
 
 // ////////////////////////////////
@@ -554,6 +574,28 @@ NA_API void naSkipBufferDelimiter(NABufferIterator* iter);
 NA_API NAString* naParseBufferLine( NABufferIterator* iter,
                                                NABool skipEmpty);
 
+// A line iterator walks through the lines of a buffer without creating a
+// new string for every line. Lines are delimited by CR, LF or CR-LF like in
+// naParseBufferLine. The line returned by naGetBufferLineUTF8Pointer points
+// directly into the memory of the buffer. Only lines crossing the border
+// between two buffer parts are copied into a storage of the iterator. The
+// pointer is NOT Null-terminated and stays valid until the next iteration or
+// until the iterator is cleared. naGetBufferLineStringView returns the same
+// line as an NAStringView.
+//
+// naIterateBufferLine returns NA_FALSE if there are no more lines. When
+// skipEmpty is NA_TRUE, lines without any character will be skipped.
+NA_API NABufferLineIterator naMakeBufferLineIterator(NABuffer* buffer);
+NA_API NABool naIterateBufferLine(  NABufferLineIterator* lineIter,
+                                                   NABool skipEmpty);
+NA_IAPI const NAUTF8Char* naGetBufferLineUTF8Pointer(
+                                const NABufferLineIterator* lineIter);
+NA_IAPI size_t naGetBufferLineByteSize(
+                                const NABufferLineIterator* lineIter);
+NA_API NAStringView naGetBufferLineStringView(
+                                const NABufferLineIterator* lineIter);
+NA_API void naClearBufferLineIterator(NABufferLineIterator* lineIter);
+
 // Returns the current line number (starting with 1). This is an experimental
 // feature which currently only works reliably if naParseBufferLine is used.
 // If this function returns 0, naParseBufferLine has never been called.
@@ -15,29 +15,105 @@
 // elements but which are wrapped around at the end such that the one element
 // after the last one of the array will again be the first one.
 //
-// This implementation stores void pointers. The implementation allocates
-// space for exactly count+1 elements. The additional element is required to
-// guarantee proper function of the circular structure.
+// All circular buffers here store void pointers. Pushing and pulling does
+// not copy any content, only the pointers are stored.
+//
+// There are three variants:
+// - NACircularBuffer is meant to be used by one thread only. The
+//   implementation allocates space for exactly count+1 elements. The
+//   additional element is required to distinguish a full from an empty
+//   buffer.
+// - NASPSCCircularBuffer can be used by exactly one thread pushing and
+//   exactly one (other) thread pulling at the same time. Both operations
+//   are wait-free.
+// - NAMPMCCircularBuffer can be used by any number of threads pushing and
+//   pulling at the same time. It is lock-free but not wait-free.
+// The concurrent variants round the count up to a power of two. Their
+// push and pull functions return immediately if the buffer is full or
+// empty respectively. Do not use mutexes to guard them.
+
+#include "NABase.h"
+
 
 
-// The full type definition is in the file "NACircularBufferII.h"
+// The full type definitions are in the file "NACircularBufferII.h"
 typedef struct NACircularBuffer NACircularBuffer;
+typedef struct NASPSCCircularBuffer NASPSCCircularBuffer;
+typedef struct NAMPMCCircularBuffer NAMPMCCircularBuffer;
 
 
 
+// ////////////////////////
+// NACircularBuffer
+// ////////////////////////
+
 // Creates a circular buffer with sufficient space for the given number of
 // void-Pointers.
-NACircularBuffer* naInitCircularBuffer(NACircularBuffer* buffer, NAInt count);
+NA_IAPI NACircularBuffer* naInitCircularBuffer(NACircularBuffer* buffer, NAInt count);
 
 // Clears the circular buffer. Does not deletes the content-pointers!
-void naClearCircularBuffer(NACircularBuffer* buffer);
+NA_IAPI void naClearCircularBuffer(NACircularBuffer* buffer);
 
 // Returns the beginning of the filled buffer and moves the buffer forward.
-void* naPullCircularBuffer(NACircularBuffer* buffer);
+NA_IAPI void* naPullCircularBuffer(NACircularBuffer* buffer);
 
 // Puts one element at the tail of the buffer. Does not copy any content, only
 // stores the pointer!
-void naPushCircularBuffer(NACircularBuffer* buffer, void* newData);
+NA_IAPI void naPushCircularBuffer(NACircularBuffer* buffer, void* newData);
+
+// Returns the number of elements stored and whether the buffer is empty or
+// full.
+NA_IAPI NAInt  naGetCircularBufferCount(const NACircularBuffer* buffer);
+NA_IAPI NABool naIsCircularBufferEmpty (const NACircularBuffer* buffer);
+NA_IAPI NABool naIsCircularBufferFull  (const NACircularBuffer* buffer);
+
+
+
+// ////////////////////////
+// NASPSCCircularBuffer
+// ////////////////////////
+
+// Creates and clears a single-producer single-consumer circular buffer which
+// has space for at least count elements.
+NA_IAPI NASPSCCircularBuffer* naInitSPSCCircularBuffer(NASPSCCircularBuffer* buffer, NAInt count);
+NA_IAPI void naClearSPSCCircularBuffer(NASPSCCircularBuffer* buffer);
+
+// Must only be called by the producing thread. Returns NA_FALSE if the
+// buffer is full. The batch variant pushes as many elements of the given
+// array as there is space for and returns their number.
+NA_IAPI NABool naPushSPSCCircularBuffer(NASPSCCircularBuffer* buffer, void* newData);
+NA_IAPI size_t naPushSPSCCircularBufferBatch(NASPSCCircularBuffer* buffer, void* const* newData, size_t count);
+
+// Must only be called by the consuming thread. Returns NA_FALSE if the
+// buffer is empty and leaves data untouched. The batch variant pulls up to
+// maxCount elements into the given array and returns their number.
+NA_IAPI NABool naPullSPSCCircularBuffer(NASPSCCircularBuffer* buffer, void** data);
+NA_IAPI size_t naPullSPSCCircularBufferBatch(NASPSCCircularBuffer* buffer, void** data, size_t maxCount);
+
+
+
+// ////////////////////////
+// NAMPMCCircularBuffer
+// ////////////////////////
+
+// Creates and clears a multi-producer multi-consumer circular buffer which
+// has space for at least count elements. Every element slot carries a
+// sequence number telling whether it is ready to be written or read, see
+// Dmitry Vyukov's bounded MPMC queue.
+NA_IAPI NAMPMCCircularBuffer* naInitMPMCCircularBuffer(NAMPMCCircularBuffer* buffer, NAInt count);
+NA_IAPI void naClearMPMCCircularBuffer(NAMPMCCircularBuffer* buffer);
+
+// Can be called by any thread. Returns NA_FALSE if the buffer is full. The
+// batch variant reserves as many consecutive slots as possible at once and
+// returns the number of elements pushed.
+NA_IAPI NABool naPushMPMCCircularBuffer(NAMPMCCircularBuffer* buffer, void* newData);
+NA_IAPI size_t naPushMPMCCircularBufferBatch(NAMPMCCircularBuffer* buffer, void* const* newData, size_t count);
+
+// Can be called by any thread. Returns NA_FALSE if the buffer is empty and
+// leaves data untouched. The batch variant returns the number of elements
+// pulled into the given array.
+NA_IAPI NABool naPullMPMCCircularBuffer(NAMPMCCircularBuffer* buffer, void** data);
+NA_IAPI size_t naPullMPMCCircularBufferBatch(NAMPMCCircularBuffer* buffer, void** data, size_t maxCount);
 
 
 
@@ -1,6 +1,27 @@
 
 #include "../../NABinaryData.h"
 #include "../../NAMemory.h"
+#include "../../NAThreading.h"
+#include "../../NAMathOperators.h"
+
+
+
+#if NA_SIMD_SSE2 && (defined __GNUC__ || defined _MSC_VER)
+  // The carry-less multiplication is not part of SSE2. Whether the processor
+  // supports it is detected at runtime.
+  #define NA_CHECKSUM_USE_CLMUL 1
+  #include <emmintrin.h>
+  #include <wmmintrin.h>
+  #if defined _MSC_VER
+    #include <intrin.h>
+    #define NA_CHECKSUM_CLMUL_TARGET
+  #else
+    #include <cpuid.h>
+    #define NA_CHECKSUM_CLMUL_TARGET __attribute__((target("sse2,pclmul")))
+  #endif
+#else
+  #define NA_CHECKSUM_USE_CLMUL 0
+#endif
 
 
 
@@ -11,37 +32,230 @@
 //
 // Code stolen and adapted from the PNG reference:
 // http://www.w3.org/TR/PNG/#D-CRCAppendix
+//
+// The bytes are processed 8 at a time using 8 tables (slicing-by-8). On x86
+// processors supporting carry-less multiplication, blocks of 64 bytes are
+// folded together as described by Intel in "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction".
+
+#define NA_CHECKSUM_CRC_POLYNOM 0xedb88320
 
 typedef struct NAChecksumCRC NAChecksumCRC;
 struct NAChecksumCRC{
   uint32 value;
-  uint32 table[256];
 };
 
+typedef struct NAChecksumCRCTables NAChecksumCRCTables;
+struct NAChecksumCRCTables{
+  uint32 table[8][256];
+  NABool useCLMUL;
+};
+
+// The tables are shared by all checksums and created by the first one.
+static NAChecksumCRCTables* na_ChecksumCRCTables = NA_NULL;
+
+
 
+#if NA_CHECKSUM_USE_CLMUL
+
+NA_HIDEF NABool na_HasCLMULSupport(void){
+  #if defined _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] >> 1) & 1;
+  #else
+    unsigned int eax, ebx, ecx, edx;
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)){return NA_FALSE;}
+    return (ecx & bit_PCLMUL) ? NA_TRUE : NA_FALSE;
+  #endif
+}
+
+// Computes the crc of a byteSize being a multiple of 16 and at least 64.
+// The constants are x^(4*128+32), x^(4*128-32), x^(128+32), x^(128-32),
+// x^64 modulo the polynom, all bit reflected, followed by the constants for
+// the final barrett reduction.
+NA_HDEF NA_CHECKSUM_CLMUL_TARGET uint32 na_AccumulateCRCPNGCLMUL(uint32 crc, const NAByte* buf, size_t byteSize){
+  const __m128i k1k2 = _mm_set_epi32((int)0x00000001, (int)0xc6e41596, (int)0x00000001, (int)0x54442bd4);
+  const __m128i k3k4 = _mm_set_epi32((int)0x00000000, (int)0xccaa009e, (int)0x00000001, (int)0x751997d0);
+  const __m128i k5k0 = _mm_set_epi32((int)0x00000000, (int)0x00000000, (int)0x00000001, (int)0x63cd6124);
+  const __m128i poly = _mm_set_epi32((int)0x00000001, (int)0xf7011641, (int)0x00000001, (int)0xdb710641);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+  __m128i x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+  __m128i x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+  __m128i x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+  __m128i x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+  buf += 64;
+  byteSize -= 64;
+
+  // Fold 4 times 128 bits in parallel.
+  while(byteSize >= 64){
+    __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(buf + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(buf + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(buf + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(buf + 0x30)));
+    buf += 64;
+    byteSize -= 64;
+  }
+
+  // Fold the 4 values into one, then the remaining 16 byte blocks.
+  __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+  while(byteSize >= 16){
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)buf)), x5);
+    buf += 16;
+    byteSize -= 16;
+  }
+
+  // Fold 128 bits to 64 bits.
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett reduction to 32 bits.
+  x2 = _mm_and_si128(x1, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+  x2 = _mm_and_si128(x2, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return (uint32)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
 
-NA_HIDEF void na_PrepareCRCPNG(NAChecksumCRC* checksumcrc){
- int n, k;
- for (n = 0; n < 256; n++) {
-   uint32 c = (uint32) n;
-   for (k = 0; k < 8; k++) {
-     if (c & 1)
-       c = 0xedb88320 ^ (c >> 1);
-     else
-       c = c >> 1;
+#endif // NA_CHECKSUM_USE_CLMUL
+
+
+
+NA_HDEF const NAChecksumCRCTables* na_GetChecksumCRCTables(void){
+  NAChecksumCRCTables* tables = naLoadAtomicPointer((void**)&na_ChecksumCRCTables);
+  if(!tables){
+    NAChecksumCRCTables* newTables = naAlloc(NAChecksumCRCTables);
+    for(uint32 n = 0; n < 256; n++){
+      uint32 c = n;
+      for(int k = 0; k < 8; k++){
+        c = (c & 1) ? (NA_CHECKSUM_CRC_POLYNOM ^ (c >> 1)) : (c >> 1);
+      }
+      newTables->table[0][n] = c;
+    }
+    // Table k contains the crc of a byte followed by k zero bytes.
+    for(int k = 1; k < 8; k++){
+      for(uint32 n = 0; n < 256; n++){
+        uint32 c = newTables->table[k - 1][n];
+        newTables->table[k][n] = newTables->table[0][c & 0xff] ^ (c >> 8);
+      }
     }
-    checksumcrc->table[n] = c;
+    #if NA_CHECKSUM_USE_CLMUL
+      newTables->useCLMUL = na_HasCLMULSupport();
+    #else
+      newTables->useCLMUL = NA_FALSE;
+    #endif
+
+    // Another thread might have been faster.
+    if(naCompareExchangeAtomicPointer((void**)&na_ChecksumCRCTables, NA_NULL, newTables)){
+      tables = newTables;
+    }else{
+      naFree(newTables);
+      tables = naLoadAtomicPointer((void**)&na_ChecksumCRCTables);
+    }
+  }
+  return tables;
+}
+
+
+
+NA_HIDEF uint32 na_AccumulateCRCPNGBytes(const NAChecksumCRCTables* tables, uint32 c, const NAByte* buf, size_t byteSize){
+  while(byteSize >= 8){
+    uint32 one = c ^ ((uint32)buf[0] | ((uint32)buf[1] << 8) | ((uint32)buf[2] << 16) | ((uint32)buf[3] << 24));
+    uint32 two = (uint32)buf[4] | ((uint32)buf[5] << 8) | ((uint32)buf[6] << 16) | ((uint32)buf[7] << 24);
+    c = tables->table[7][one & 0xff]
+      ^ tables->table[6][(one >> 8) & 0xff]
+      ^ tables->table[5][(one >> 16) & 0xff]
+      ^ tables->table[4][one >> 24]
+      ^ tables->table[3][two & 0xff]
+      ^ tables->table[2][(two >> 8) & 0xff]
+      ^ tables->table[1][(two >> 16) & 0xff]
+      ^ tables->table[0][two >> 24];
+    buf += 8;
+    byteSize -= 8;
   }
+  while(byteSize){
+    c = tables->table[0][(c ^ *buf) & 0xff] ^ (c >> 8);
+    buf++;
+    byteSize--;
+  }
+  return c;
 }
 
 
 
 NA_HIDEF void na_AccumulateCRCPNG(NAChecksumCRC* checksumcrc, const NAByte* buf, size_t byteSize){
- uint32 c = checksumcrc->value;
- for(size_t n = 0; n < byteSize; n++){
-   c = checksumcrc->table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
- }
- checksumcrc->value = c;
+  const NAChecksumCRCTables* tables = na_GetChecksumCRCTables();
+  uint32 c = checksumcrc->value;
+  #if NA_CHECKSUM_USE_CLMUL
+    if(tables->useCLMUL && byteSize >= 64){
+      size_t blockSize = byteSize & ~(size_t)15;
+      c = na_AccumulateCRCPNGCLMUL(c, buf, blockSize);
+      buf += blockSize;
+      byteSize -= blockSize;
+    }
+  #endif
+  checksumcrc->value = na_AccumulateCRCPNGBytes(tables, c, buf, byteSize);
+}
+
+
+
+// Multiplies two polynoms modulo the crc polynom. Bit 31 denotes x^0.
+NA_HDEF uint32 na_MultiplyCRCPolynoms(uint32 a, uint32 b){
+  uint32 m = (uint32)1 << 31;
+  uint32 p = 0;
+  while(m){
+    if(a & m){p ^= b;}
+    m >>= 1;
+    b = (b & 1) ? ((b >> 1) ^ NA_CHECKSUM_CRC_POLYNOM) : (b >> 1);
+  }
+  return p;
+}
+
+// Returns x^(8 * byteSize) modulo the crc polynom.
+NA_HDEF uint32 na_GetCRCShiftPolynom(size_t byteSize){
+  uint32 power = (uint32)1 << 31;        // x^0
+  uint32 square = (uint32)1 << 23;       // x^8
+  while(byteSize){
+    if(byteSize & 1){power = na_MultiplyCRCPolynoms(power, square);}
+    square = na_MultiplyCRCPolynoms(square, square);
+    byteSize >>= 1;
+  }
+  return power;
+}
+
+// The crc of the concatenation is the first crc shifted by the length of
+// the second part, combined with the second crc. The initial and final
+// inversion of the crc cancel each other out.
+NA_HIDEF void na_CombineCRCPNG(NAChecksumCRC* checksumcrc, const NAChecksumCRC* appended, size_t appendedByteSize){
+  uint32 crc1 = checksumcrc->value ^ 0xffffffff;
+  uint32 crc2 = appended->value ^ 0xffffffff;
+  uint32 result = na_MultiplyCRCPolynoms(na_GetCRCShiftPolynom(appendedByteSize), crc1) ^ crc2;
+  checksumcrc->value = result ^ 0xffffffff;
 }
 
 
@@ -51,9 +265,13 @@ NA_HIDEF void na_AccumulateCRCPNG(NAChecksumCRC* checksumcrc, const NAByte* buf,
 //
 // Code stolen and adapted from the RFC 1950:
 // http://www.ietf.org/rfc/rfc1950.txt
+//
+// The modulo is only computed every NA_CHECKSUM_ADLER_NMAX bytes which is
+// the largest number of bytes for which s2 can not overflow 32 bits.
 
 #include "../../NAMathConstants.h"
-#define NA_CHECKSUM_ADLER_BASE NA_PRIME_BEFORE_2_16;
+#define NA_CHECKSUM_ADLER_BASE NA_PRIME_BEFORE_2_16
+#define NA_CHECKSUM_ADLER_NMAX 5552
 
 typedef struct NAChecksumAdler NAChecksumAdler;
 struct NAChecksumAdler{
@@ -64,10 +282,79 @@ struct NAChecksumAdler{
 
 
 NA_HIDEF void na_AccumulateAdler(NAChecksumAdler* checksumadler, const NAByte* buf, size_t byteSize){
-  for(size_t n = 0; n < byteSize; n++){
-    checksumadler->s1 = (checksumadler->s1 + buf[n]) % NA_CHECKSUM_ADLER_BASE;
-    checksumadler->s2 = (checksumadler->s2 + checksumadler->s1) % NA_CHECKSUM_ADLER_BASE;
+  uint32 s1 = checksumadler->s1;
+  uint32 s2 = checksumadler->s2;
+
+  while(byteSize){
+    size_t blockSize = naMins(byteSize, NA_CHECKSUM_ADLER_NMAX);
+    byteSize -= blockSize;
+
+    #if NA_SIMD_SSE2
+      // For 16 bytes b_i, s2 grows by 16 * s1 + sum((16 - i) * b_i) and s1 by
+      // sum(b_i). The 16 * s1 part of all blocks is summed up in prevS1.
+      size_t vectorSize = blockSize & ~(size_t)15;
+      if(vectorSize){
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weightsLo = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+        const __m128i weightsHi = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+        __m128i vs1 = zero;
+        __m128i vs2 = zero;
+        __m128i prevS1 = zero;
+        s2 += s1 * (uint32)vectorSize;
+        for(size_t i = 0; i < vectorSize; i += 16){
+          __m128i bytes = _mm_loadu_si128((const __m128i*)&buf[i]);
+          prevS1 = _mm_add_epi32(prevS1, vs1);
+          vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(bytes, zero));
+          vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), weightsLo));
+          vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), weightsHi));
+        }
+        vs2 = _mm_add_epi32(vs2, _mm_slli_epi32(prevS1, 4));
+        vs1 = _mm_add_epi32(vs1, _mm_srli_si128(vs1, 8));
+        vs2 = _mm_add_epi32(vs2, _mm_srli_si128(vs2, 8));
+        vs2 = _mm_add_epi32(vs2, _mm_srli_si128(vs2, 4));
+        s1 += (uint32)_mm_cvtsi128_si32(vs1);
+        s2 += (uint32)_mm_cvtsi128_si32(vs2);
+        buf += vectorSize;
+        blockSize -= vectorSize;
+      }
+    #endif
+
+    while(blockSize >= 8){
+      s1 += buf[0]; s2 += s1;
+      s1 += buf[1]; s2 += s1;
+      s1 += buf[2]; s2 += s1;
+      s1 += buf[3]; s2 += s1;
+      s1 += buf[4]; s2 += s1;
+      s1 += buf[5]; s2 += s1;
+      s1 += buf[6]; s2 += s1;
+      s1 += buf[7]; s2 += s1;
+      buf += 8;
+      blockSize -= 8;
+    }
+    while(blockSize){
+      s1 += *buf++;
+      s2 += s1;
+      blockSize--;
+    }
+    s1 %= NA_CHECKSUM_ADLER_BASE;
+    s2 %= NA_CHECKSUM_ADLER_BASE;
   }
+
+  checksumadler->s1 = s1;
+  checksumadler->s2 = s2;
+}
+
+
+
+NA_HIDEF void na_CombineAdler(NAChecksumAdler* checksumadler, const NAChecksumAdler* appended, size_t appendedByteSize){
+  // Every byte of the appended part has been added to s2 once more for
+  // every byte of the first part.
+  uint32 rem = (uint32)(appendedByteSize % NA_CHECKSUM_ADLER_BASE);
+  uint32 s1 = checksumadler->s1 + appended->s1 + NA_CHECKSUM_ADLER_BASE - 1;
+  uint32 s2 = (rem * checksumadler->s1) % NA_CHECKSUM_ADLER_BASE;
+  s2 += checksumadler->s2 + appended->s2 + NA_CHECKSUM_ADLER_BASE - rem;
+  checksumadler->s1 = s1 % NA_CHECKSUM_ADLER_BASE;
+  checksumadler->s2 = s2 % NA_CHECKSUM_ADLER_BASE;
 }
 
 
@@ -82,11 +369,9 @@ NA_DEF NAChecksum* naInitChecksum(NAChecksum* checksum, NAChecksumType type){
   switch(type){
   case NA_CHECKSUM_TYPE_CRC_PNG:
     checksum->data = naAlloc(NAChecksumCRC);
-    na_PrepareCRCPNG((NAChecksumCRC*)(checksum->data));
     break;
   case NA_CHECKSUM_TYPE_ADLER_32:
     checksum->data = naAlloc(NAChecksumAdler);
-    //naPrepareAdler((NAChecksumAdler*)(checksum->data)); // nothing to be prepared
     break;
   default:
     #if NA_DEBUG
@@ -107,6 +392,7 @@ NA_DEF void naClearChecksum(NAChecksum* checksum){
 
 
 NA_DEF void naResetChecksum(NAChecksum* checksum){
+  checksum->byteSize = 0;
   switch(checksum->type){
   case NA_CHECKSUM_TYPE_CRC_PNG:
     ((NAChecksumCRC*)(checksum->data))->value = 0xffffffff;
@@ -126,6 +412,7 @@ NA_DEF void naResetChecksum(NAChecksum* checksum){
 
 
 NA_DEF void naAccumulateChecksum(NAChecksum* checksum, const NAByte* buf, size_t byteSize){
+  checksum->byteSize += byteSize;
   switch(checksum->type){
   case NA_CHECKSUM_TYPE_CRC_PNG:
     na_AccumulateCRCPNG(((NAChecksumCRC*)(checksum->data)), buf, byteSize);
@@ -143,6 +430,29 @@ NA_DEF void naAccumulateChecksum(NAChecksum* checksum, const NAByte* buf, size_t
 
 
 
+NA_DEF void naCombineChecksum(NAChecksum* checksum, const NAChecksum* appended){
+  #if NA_DEBUG
+    if(checksum->type != appended->type)
+      naError("Checksums have different types");
+  #endif
+  switch(checksum->type){
+  case NA_CHECKSUM_TYPE_CRC_PNG:
+    na_CombineCRCPNG(((NAChecksumCRC*)(checksum->data)), ((const NAChecksumCRC*)(appended->data)), appended->byteSize);
+    break;
+  case NA_CHECKSUM_TYPE_ADLER_32:
+    na_CombineAdler(((NAChecksumAdler*)(checksum->data)), ((const NAChecksumAdler*)(appended->data)), appended->byteSize);
+    break;
+  default:
+    #if NA_DEBUG
+      naError("Checksum type invalid");
+    #endif
+    break;
+  }
+  checksum->byteSize += appended->byteSize;
+}
+
+
+
 NA_DEF uint32 naGetChecksumResult(NAChecksum* checksum){
   uint32 retValue;
   switch(checksum->type){
@@ -6,6 +6,7 @@
 
 struct NAChecksum{
   NAChecksumType type;
+  size_t byteSize;    // Number of bytes accumulated since the last reset
   void* data;
 };
 
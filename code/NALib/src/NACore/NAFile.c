@@ -2,6 +2,23 @@
 #include "../NAFile.h"
 #include "../NAString.h"
 
+#if NA_OS != NA_OS_WINDOWS
+  #include <limits.h>
+  #include <sys/mman.h>
+  #include <sys/uio.h>
+
+  // The number of spans gathered into one writev call. Linux only defines
+  // IOV_MAX with X/Open features but always has UIO_MAXIOV. 16 is the
+  // smallest value POSIX allows.
+  #if defined IOV_MAX
+    #define NA_FILE_SPANS_PER_WRITE IOV_MAX
+  #elif defined UIO_MAXIOV
+    #define NA_FILE_SPANS_PER_WRITE UIO_MAXIOV
+  #else
+    #define NA_FILE_SPANS_PER_WRITE 16
+  #endif
+#endif
+
 
 
 
@@ -25,7 +42,7 @@ NA_DEF NABool naIsDir(const char* path){
     retValue = (GetFileAttributes(sysstring)  & FILE_ATTRIBUTE_DIRECTORY) ? NA_TRUE : NA_FALSE;
     free(sysstring);
     return retValue;
-  #elif NA_OS == NA_OS_MAC_OS_X
+  #else
     struct stat stat_struct;
     stat(path, &stat_struct);
     return (stat_struct.st_mode & S_IFDIR) ? NA_TRUE : NA_FALSE;
@@ -41,13 +58,149 @@ NA_DEF NABool naIsHidden(const char* path){
     retValue = (GetFileAttributes(sysstring) & FILE_ATTRIBUTE_HIDDEN) ? NA_TRUE : NA_FALSE;
     free(sysstring);
     return retValue;
-  #elif NA_OS == NA_OS_MAC_OS_X
+  #else
     return (path[0] == '.');
   #endif
 }
 
 
 
+NA_DEF NAFileSize naReadFileBytesAt(NAFile* file, void* buf, NAFileSize byteOffset, NAFileSize byteSize){
+  #if NA_DEBUG
+    if(!naIsFileOpen(file))
+      naError("File is not open.");
+    if(byteOffset < 0)
+      naError("Negative offset.");
+    if(byteSize < 0)
+      naError("Negative count.");
+  #endif
+  NAFileSize totalSize = 0;
+  while(totalSize < byteSize){
+    NAFileSize readSize;
+    #if NA_OS == NA_OS_WINDOWS
+      // ReadFile with an offset reads at that offset no matter where the
+      // file pointer is which makes it the Windows counterpart of pread. As
+      // the handle is synchronous, the file pointer moves nonetheless.
+      HANDLE handle = (HANDLE)_get_osfhandle(file->desc);
+      OVERLAPPED overlapped;
+      DWORD chunkSize = (byteSize - totalSize > NA_MAX_i32) ? (DWORD)NA_MAX_i32 : (DWORD)(byteSize - totalSize);
+      DWORD chunkReadSize = 0;
+      naZeron(&overlapped, sizeof(OVERLAPPED));
+      overlapped.Offset = (DWORD)((byteOffset + totalSize) & 0xffffffff);
+      overlapped.OffsetHigh = (DWORD)((uint64)(byteOffset + totalSize) >> 32);
+      if(!ReadFile(handle, (NAByte*)buf + totalSize, chunkSize, &chunkReadSize, &overlapped)){break;}
+      readSize = (NAFileSize)chunkReadSize;
+    #else
+      readSize = (NAFileSize)pread(file->desc, (NAByte*)buf + totalSize, (size_t)(byteSize - totalSize), byteOffset + totalSize);
+    #endif
+    if(readSize <= 0){break;}
+    totalSize += readSize;
+  }
+  return totalSize;
+}
+
+
+
+NA_DEF void* naMapFileBytes(NAFile* file, NAFileSize byteSize){
+  #if NA_DEBUG
+    if(!naIsFileOpen(file))
+      naError("File is not open.");
+    if(byteSize <= 0)
+      naError("byteSize must be positive.");
+  #endif
+  // Files too big for the address space can not be mapped.
+  if((NAFileSize)(size_t)byteSize != byteSize){return NA_NULL;}
+  #if NA_OS == NA_OS_WINDOWS
+    HANDLE handle = (HANDLE)_get_osfhandle(file->desc);
+    HANDLE mapping = CreateFileMapping(handle, NA_NULL, PAGE_WRITECOPY, 0, 0, NA_NULL);
+    if(!mapping){return NA_NULL;}
+    // The view keeps the mapping object alive.
+    void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, (SIZE_T)byteSize);
+    CloseHandle(mapping);
+    return data;
+  #else
+    void* data = mmap(NA_NULL, (size_t)byteSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, file->desc, 0);
+    return (data == MAP_FAILED) ? NA_NULL : data;
+  #endif
+}
+
+
+
+NA_DEF void naUnmapFileBytes(void* data, NAFileSize byteSize){
+  #if NA_DEBUG
+    if(!data)
+      naCrash("data is Null");
+  #endif
+  #if NA_OS == NA_OS_WINDOWS
+    NA_UNUSED(byteSize);
+    UnmapViewOfFile(data);
+  #else
+    munmap(data, (size_t)byteSize);
+  #endif
+}
+
+
+
+NA_DEF NAFileSize naWriteFileByteSpans(NAFile* file, const NAByteSpan* spans, size_t spanCount){
+  #if NA_DEBUG
+    if(!naIsFileOpen(file))
+      naError("File is not open.");
+    if(!spans && spanCount)
+      naCrash("spans is Null");
+  #endif
+  NAFileSize totalSize = 0;
+  size_t spanIndex = 0;
+  size_t spanOffset = 0;
+  while(NA_TRUE){
+    // Empty spans and spans written completely are skipped.
+    while(spanIndex < spanCount && spanOffset == spans[spanIndex].byteSize){
+      spanIndex++;
+      spanOffset = 0;
+    }
+    if(spanIndex == spanCount){break;}
+
+    NAFileSize writtenSize;
+    #if NA_OS == NA_OS_WINDOWS
+      // Windows has no gathering write for files. The spans are written one
+      // by one.
+      writtenSize = naWriteFileBytes(
+        file,
+        (const NAByte*)spans[spanIndex].data + spanOffset,
+        (NAFileSize)(spans[spanIndex].byteSize - spanOffset));
+    #else
+      struct iovec iov[NA_FILE_SPANS_PER_WRITE];
+      int iovCount = 0;
+      for(size_t i = spanIndex; i < spanCount && iovCount < NA_FILE_SPANS_PER_WRITE; ++i){
+        size_t offset = (i == spanIndex) ? spanOffset : 0;
+        if(spans[i].byteSize == offset){continue;}
+        iov[iovCount].iov_base = (void*)((const NAByte*)spans[i].data + offset);
+        iov[iovCount].iov_len = spans[i].byteSize - offset;
+        iovCount++;
+      }
+      writtenSize = (NAFileSize)writev(file->desc, iov, iovCount);
+    #endif
+    if(writtenSize <= 0){break;}
+    totalSize += writtenSize;
+
+    // The system may write less than requested. Continue where it stopped.
+    size_t remainingSize = (size_t)writtenSize;
+    while(remainingSize){
+      size_t spanRemainingSize = spans[spanIndex].byteSize - spanOffset;
+      if(remainingSize < spanRemainingSize){
+        spanOffset += remainingSize;
+        remainingSize = 0;
+      }else{
+        remainingSize -= spanRemainingSize;
+        spanIndex++;
+        spanOffset = 0;
+      }
+    }
+  }
+  return totalSize;
+}
+
+
+
 NA_HDEF void na_DeallocFile(NAFile* file){
   if(file->desc > 2){
     naClose(file->desc);
@@ -112,6 +112,96 @@ NA_IDEF void naReleaseRefCount(NARefCount* refCount, void* data, NAMutator destr
 
 
 
+// The atomic variants. On Windows, the Interlocked functions are full memory
+// barriers. All other systems are assumed to use GCC or Clang which provide
+// atomic builtins.
+//
+// Retaining needs no ordering as the thread retaining already has a
+// reference. Releasing orders all prior accesses before the decrement and the
+// decrement before the destructor, so the last thread releasing sees all
+// changes. The debug checks use the values returned by the atomic operations
+// as reading the count separately might see a value changed in the meantime.
+
+NA_HIDEF size_t na_IncreaseRefCountAtomic(NARefCount* refCount){
+  #if NA_OS == NA_OS_WINDOWS
+    #if NA_ADDRESS_BITS == NA_TYPE64_BITS
+      return (size_t)InterlockedIncrement64((volatile LONG64*)&(refCount->count)) - 1;
+    #else
+      return (size_t)InterlockedIncrement((volatile LONG*)&(refCount->count)) - 1;
+    #endif
+  #else
+    return __atomic_fetch_add(&(refCount->count), 1, __ATOMIC_RELAXED);
+  #endif
+}
+
+
+
+// Returns the count after decreasing.
+NA_HIDEF size_t na_DecreaseRefCountAtomic(NARefCount* refCount){
+  #if NA_OS == NA_OS_WINDOWS
+    #if NA_ADDRESS_BITS == NA_TYPE64_BITS
+      return (size_t)InterlockedDecrement64((volatile LONG64*)&(refCount->count));
+    #else
+      return (size_t)InterlockedDecrement((volatile LONG*)&(refCount->count));
+    #endif
+  #else
+    return __atomic_sub_fetch(&(refCount->count), 1, __ATOMIC_ACQ_REL);
+  #endif
+}
+
+
+
+NA_IDEF NARefCount* naRetainRefCountAtomic(NARefCount* refCount){
+  #if NA_DEBUG
+    if(!refCount){
+      naCrash("refCount is Null-Pointer.");
+      return NA_NULL;
+    }
+    if(refCount->dummy != NA_REFCOUNT_DUMMY_VALUE)
+      naError("Consistency problem: dummy value wrong. Is NARefCount really defined as the first field of this struct?");
+    size_t prevCount = na_IncreaseRefCountAtomic(refCount);
+    if(prevCount == NA_ZERO)
+      naError("Retaining NARefCount with a count of 0");
+    if(prevCount == NA_MAX_s)
+      naError("Reference count overflow");
+  #else
+    na_IncreaseRefCountAtomic(refCount);
+  #endif
+  return refCount;
+}
+
+
+
+// Returns NA_TRUE if the count reached zero. In that case, the destructor
+// has been called.
+NA_HIDEF NABool na_ReleaseRefCountAtomic(NARefCount* refCount, void* data, NAMutator destructor){
+  #if NA_DEBUG
+    if(!refCount)
+      naCrash("refCount is Null-Pointer.");
+    if(refCount->dummy != NA_REFCOUNT_DUMMY_VALUE)
+      naError("Consistency problem: dummy value wrong. Is NARefCount really defined as the first field of this struct?");
+  #endif
+  size_t count = na_DecreaseRefCountAtomic(refCount);
+  #if NA_DEBUG
+    if(count == NA_MAX_s)
+      naError("Releasing NARefCount with a count of 0");
+  #endif
+
+  if(count == NA_ZERO){
+    if(destructor){destructor(data);}
+    return NA_TRUE;
+  }
+  return NA_FALSE;
+}
+
+
+
+NA_IDEF void naReleaseRefCountAtomic(NARefCount* refCount, void* data, NAMutator destructor){
+  na_ReleaseRefCountAtomic(refCount, data, destructor);
+}
+
+
+
 // This is free and unencumbered software released into the public domain.
 
 // Anyone is free to copy, modify, publish, use, compile, sell, or
@@ -1,9 +1,13 @@
 
 #include "../../NAMemory.h"
 #include "../../NABinaryData.h"
+#include "../../NAThreading.h"
 
-#if NA_DEBUG
-  #include "stdio.h"
+#include <stdio.h>
+#if NA_OS == NA_OS_WINDOWS
+  #include <malloc.h>
+#elif NA_OS != NA_OS_MAC_OS_X && defined __GLIBC__
+  #include <malloc.h>
 #endif
 
 // //////////////////////////////////////
@@ -36,7 +40,9 @@
 // The curPart field of the NA_TypeInfo points to the part which is
 // expected to have a free space for the desired runtime type. From there on,
 // parts going forward (next to curPart) are expected to have free space
-// and partss going backward (prev from curPart) are expected to be full.
+// and parts going backward (prev from curPart) are expected to be full.
+// Note that parts currently in use by a thread are not in that list, see the
+// explanation about threads below.
 //
 // While the first bytes of a memory block are filled with the contents of
 // NA_PoolPart, the remaining bytes are used for storing the actual values,
@@ -66,19 +72,46 @@
 // really fast!
 //
 // When finally the number of spaces used in a part equals the maximum number
-// of spaces, the part has no more space. Then, the next part in the list is
-// selected in hope to find a free space there. If the next part also has no
-// space, a new part needs to be created. The new part gets added to the
-// circular part list and is used as the current part.
-//
-// When deleting a space from a completely full part, that part will get moved
-// in the list right after the current part hence making the part available for
-// new allocations as soon as the current part is filled.
+// of spaces, the part has no more space. Then, the part is handed back and
+// another part with free space is taken, see below. If there is none, a new
+// part is created.
 //
 // Upon deleting spaces, a part may become completely empty. If that is the
 // case, the part gets automatically deallocated, hence freeing all of the
 // memory.
 
+// /////////////
+// Threads:
+//
+// naNew and naDelete can be called from any thread. In order to not lock
+// anything for the common case, every thread has its own cache storing one
+// part per type which is exclusively owned by that thread. The owner is
+// stored in the NA_PoolPart. Only the owner allocates from the part and
+// only the owner puts deleted spaces into the firstUnused list as described
+// above. No synchronization is needed for that, it is as fast as it gets.
+//
+// When a different thread deletes a space of a part, it pushes the space
+// onto a second list of the part called remoteUnused. This list is a
+// lock-free stack which is only accessed atomically. Whenever the owner finds
+// its part to be full, it first collects all spaces of the remoteUnused list
+// at once and puts them into the firstUnused list. Only if there still is no
+// space, the part is handed back to the type.
+//
+// All parts not owned by any thread form the cyclic double linked list of
+// the type which starts at curPart and which is guarded by a mutex stored in
+// the type. Parts with free space are kept at the front, full parts at the
+// back. A thread needing a new part takes the first one if it has space or
+// creates a new part otherwise. Deleting a space of a part not owned by any
+// thread happens with the mutex locked.
+//
+// Note that a thread deleting a space might see an owner which just now hands
+// back the part. The space then ends up in the remoteUnused list of a part not
+// owned by anyone. It will be collected as soon as the part is used again,
+// it just can not be reused until then.
+//
+// The thread caches of all threads are stored in the runtime. When a thread
+// ends, naDetachRuntimeThread hands back all of its parts.
+
 // /////////////
 // Garbage collection:
 //
@@ -95,7 +128,7 @@
 
 
 // This structure is stored in the first bytes of every part block.
-// Its size is ALWAYS 8 times an addressSize, the rest of the block is
+// Its size is ALWAYS 16 times an addressSize, the rest of the block is
 // available for the memory.
 typedef struct NA_PoolPart NA_PoolPart;
 struct NA_PoolPart{
@@ -104,24 +137,55 @@ struct NA_PoolPart{
   size_t usedCount;
   size_t everUsedCount;
   void* firstUnused;
+  // The thread cache owning this part or Null if the part is in the part
+  // list of the type. Only accessed atomically.
+  void* owner;
+  // The number of spaces ever handed out by this part. For statistics.
+  size_t allocCount;
+  // The following field has no meaning in release code. It is used in
+  // debugging though. Points at first byte of the whole pool for consistency
+  // check.
+  void* dummy;
+  // Spaces deleted by threads not owning this part. Only accessed atomically.
+  // On 64 bit systems, this field lies on a different cache line than the
+  // fields above such that remote deletions do not slow down the owner.
+  void* remoteUnused;
+  // Only used while the part is in the part list of the type.
   NA_PoolPart* prevPart;
   NA_PoolPart* nextPart;
-  // The following field is a dummy entry and has no meaning in release code.
-  // It shall not be removed though as the total amount of bytes used for
-  // an NA_PoolPart shall be 8 times an addressSize.
-  // It is used in debugging though. Points at first byte of the whole pool
-  // for consistency check.
-  void* dummy;
+  // Only used in the first part of a slab: The number of parts of the slab
+  // currently in use. See na_AllocSlabPart.
+  size_t slabUsedCount;
+  // Unused fields which make the total amount of bytes used for an
+  // NA_PoolPart 16 times an addressSize.
+  void* padding[4];
 };
 
 struct NA_TypeInfo{
   NA_PoolPart*      curPart;
   size_t            typeSize;
   NAMutator         destructor;
-  NABool            refCounting;
-  #if NA_DEBUG
-    const char*     typeName;
-  #endif
+  int               refCounting;
+  const char*       typeName;
+  size_t            partSize;
+  NAMutex           mutex;
+  NAInt             cacheIndex;
+  NAInt             partCount;
+  NAInt             peakPartCount;
+  NAInt             retiredAllocCount;  // allocCount of all deleted parts
+  NAInt             listUsedCount;      // usedCount of all parts in the list
+  NAInt             peakCount;          // The highest count observed
+  size_t            partSizeMask;
+  NA_PoolPart*      freeParts;          // Unused parts of all slabs
+};
+
+// The parts owned by one thread. The index into the parts array is the
+// cacheIndex of the type. The entry at index 0 is unused.
+struct NA_RuntimeThreadCache{
+  NA_PoolPart**           parts;
+  NAInt                   partsCount;
+  NA_RuntimeThreadCache*  prev;
+  NA_RuntimeThreadCache*  next;
 };
 
 
@@ -141,20 +205,48 @@ struct NAMallocGarbage{
 // The global runtime variable.
 NARuntime* na_Runtime = NA_NULL;
 
+// The thread cache of the current thread. As the runtime might have been
+// stopped and started again in the meantime, the cache is only valid if its
+// epoch equals the number of times the runtime has been started.
+static NA_THREAD_LOCAL NA_RuntimeThreadCache* na_ThreadCache = NA_NULL;
+static NA_THREAD_LOCAL size_t na_ThreadCacheEpoch = 0;
+static size_t na_RuntimeEpoch = 0;
+
+// The cacheIndex of a type is never reset, hence this counter never
+// decreases, even when the runtime is stopped.
+static NAInt na_RuntimeCacheIndexCount = 0;
+
 
 
 // Security check: The pool byteSize must be big enough to store one struct
 // of NA_PoolPart. Note that byteSize 0 has the meaning of using the
 // memory page size.
-#if (NA_POOLPART_BYTESIZE != 0) && (NA_POOLPART_BYTESIZE <= 8 * NA_ADDRESS_BYTES)
+#if (NA_POOLPART_BYTESIZE != 0) && (NA_POOLPART_BYTESIZE <= 16 * NA_ADDRESS_BYTES)
   #error "Memory pool size is too small"
 #endif
 
 
 
+// Returns the number of bytes of one part of the given type.
+NA_HIDEF size_t na_GetTypeInfoPartSize(const NA_TypeInfo* typeInfo){
+  return typeInfo->partSize ? typeInfo->partSize : na_Runtime->partSize;
+}
+
+
+
+// Returns the part the given pointer belongs to. Parts of the runtime part
+// size are aligned to it. Smaller parts are aligned to their own size and
+// carved out of slabs of the runtime part size. As the first part of a slab
+// always stores the type, the part size of any pointer can be found.
+NA_HIDEF NA_PoolPart* na_GetPoolPart(const void* pointer){
+  const NA_PoolPart* slab = (const NA_PoolPart*)((size_t)pointer & na_Runtime->partSizeMask);
+  return (NA_PoolPart*)((size_t)pointer & slab->typeInfo->partSizeMask);
+}
+
+
+
 // Registers a runtime type. Adds the typeInfo to the typeInfos found
-// in na_Runtime. Note that when aggressive cleanup is turned on, any type
-// which had been registered previously had already been unregistered.
+// in na_Runtime. Expects the mutex of the runtime to be locked.
 NA_HIDEF void na_RegisterTypeInfo(NA_TypeInfo* typeInfo){
   NA_TypeInfo** newinfos;
 
@@ -163,7 +255,13 @@ NA_HIDEF void na_RegisterTypeInfo(NA_TypeInfo* typeInfo){
       naError("Newly registered type should have Null as current part.");
     if(typeInfo->typeSize < NA_ADDRESS_BYTES)
       naError("Size of type is too small");
-    if(typeInfo->typeSize > (na_Runtime->partSize - sizeof(NA_PoolPart)))
+    if(typeInfo->partSize > na_Runtime->partSize)
+      naError("Part size of type is greater than NA_POOLPART_BYTESIZE");
+    if(typeInfo->partSize && typeInfo->partSize <= sizeof(NA_PoolPart))
+      naError("Part size of type is too small");
+    if(typeInfo->partSize & (typeInfo->partSize - 1))
+      naError("Part size of type is not a power of two");
+    if(typeInfo->typeSize > (na_GetTypeInfoPartSize(typeInfo) - sizeof(NA_PoolPart)))
       naError("Size of type is too big");
   #endif
 
@@ -171,10 +269,17 @@ NA_HIDEF void na_RegisterTypeInfo(NA_TypeInfo* typeInfo){
   // typeSize to incorporate reference counting, if any.
   if(typeInfo->refCounting){typeInfo->typeSize += sizeof(NARefCount);}
 
+  typeInfo->mutex = naMakeMutex();
+  typeInfo->partCount = 0;
+  typeInfo->peakPartCount = 0;
+  typeInfo->retiredAllocCount = 0;
+  typeInfo->listUsedCount = 0;
+  typeInfo->peakCount = 0;
+  typeInfo->partSizeMask = ~(na_GetTypeInfoPartSize(typeInfo) - NA_ONE_s);
+  typeInfo->freeParts = NA_NULL;
+
   // We enlarge the na_Runtime info array by one. Yes, this is very bad
-  // performance, but this code is usually called rather seldomly. If you
-  // experience here a lot of memory allocations, you might want to check if
-  // NA_MEMORY_POOL_AGGRESSIVE_CLEANUP is set to 1 and set it back to 0.
+  // performance, but this code is called only once per type.
   newinfos = naMalloc(sizeof(NA_TypeInfo*) * (na_Runtime->typeInfoCount + NA_ONE_s));
 
   // We copy all previous infos to the newly allocated memory block.
@@ -215,22 +320,28 @@ NA_HIDEF void na_UnregisterTypeInfo(NA_TypeInfo* typeInfo){
   naFree(na_Runtime->typeInfos);
   na_Runtime->typeInfos = newinfos;
 
-  // We restore the original typeSize in case NA_MEMORY_POOL_AGGRESSIVE_CLEANUP
-  // is set to 1 which means, the type might get re-registered.
+  naClearMutex(typeInfo->mutex);
+  typeInfo->mutex = NA_NULL;
+
+  // We restore the original typeSize as the type will be re-registered when
+  // the runtime is started again.
   if(typeInfo->refCounting){typeInfo->typeSize -= sizeof(NARefCount);}
 }
 
 
 
-NA_HDEF size_t na_GetTypeInfoAllocatedCount(NA_TypeInfo* typeInfo){
-  NA_PoolPart* firstpart = typeInfo->curPart;
-  NA_PoolPart* curPart = firstpart->nextPart;
-  size_t totalCount = firstpart->usedCount;
-  while(curPart != firstpart){
-    totalCount += curPart->usedCount;
-    curPart = curPart->nextPart;
+// Returns the address where the pointer to the next unused space is stored
+// in a space which currently is not in use. For reference counting types,
+// this is the place where the actual content is stored, not the reference
+// count. With that, it is still possible to do some error checks when for
+// example the programmer wants to erroneously retain or release a pointer
+// which has already been erased.
+NA_HIDEF void** na_GetPoolSpaceNextUnused(const NA_TypeInfo* typeInfo, void* pointer){
+  if(typeInfo->refCounting){
+    return (void**)((NAByte*)pointer + sizeof(NARefCount));
+  }else{
+    return (void**)pointer;
   }
-  return totalCount;
 }
 
 
@@ -241,33 +352,178 @@ NA_HIDEF NABool na_IsPoolPartFull(NA_PoolPart* part){
 
 
 
-NA_HIDEF void na_AttachPoolPartAfterCurPoolPart(NA_TypeInfo* typeInfo, NA_PoolPart* part){
-  part->prevPart = typeInfo->curPart;
-  part->nextPart = typeInfo->curPart->nextPart;
-  part->prevPart->nextPart = part;
-  part->nextPart->prevPart = part;
+// Moves all spaces deleted by other threads into the firstUnused list. Must
+// only be called by the owner of the part or, if the part has no owner, with
+// the mutex of the type locked.
+NA_HIDEF void na_CollectRemoteUnused(NA_PoolPart* part){
+  void* pointer = naLoadAtomicPointer(&(part->remoteUnused));
+  if(!pointer){return;}
+
+  // Only the caller removes from the list, hence it can only have grown if
+  // exchanging fails.
+  while(!naCompareExchangeAtomicPointer(&(part->remoteUnused), pointer, NA_NULL)){
+    pointer = naLoadAtomicPointer(&(part->remoteUnused));
+  }
+
+  while(pointer){
+    void** nextUnused = na_GetPoolSpaceNextUnused(part->typeInfo, pointer);
+    void* remotePointer = *nextUnused;
+    *nextUnused = part->firstUnused;
+    part->firstUnused = pointer;
+    part->usedCount--;
+    // Only parts in the list have a prevPart. Their mutex is locked.
+    if(part->prevPart){part->typeInfo->listUsedCount--;}
+    pointer = remotePointer;
+  }
+}
+
+
+
+// Pushes a space onto the remoteUnused list of a part. This is lock-free and
+// can be called by any thread at any time.
+NA_HIDEF void na_PushRemoteUnused(NA_PoolPart* part, void* pointer){
+  void** nextUnused = na_GetPoolSpaceNextUnused(part->typeInfo, pointer);
+  void* head;
+  do{
+    head = naLoadAtomicPointer(&(part->remoteUnused));
+    *nextUnused = head;
+  }while(!naCompareExchangeAtomicPointer(&(part->remoteUnused), head, pointer));
+}
+
+
+
+// Adds a part to the part list of the type, either as the first part or as
+// the last part. Expects the mutex of the type to be locked.
+NA_HIDEF void na_AttachPoolPart(NA_TypeInfo* typeInfo, NA_PoolPart* part, NABool asFirst){
+  if(typeInfo->curPart){
+    part->nextPart = typeInfo->curPart;
+    part->prevPart = typeInfo->curPart->prevPart;
+    part->prevPart->nextPart = part;
+    part->nextPart->prevPart = part;
+    if(asFirst){typeInfo->curPart = part;}
+  }else{
+    part->prevPart = part;
+    part->nextPart = part;
+    typeInfo->curPart = part;
+  }
+  typeInfo->listUsedCount += (NAInt)part->usedCount;
+}
+
+
+
+// Removes a part from the part list of the type. Expects the mutex of the
+// type to be locked.
+NA_HIDEF void na_DetachPoolPart(NA_TypeInfo* typeInfo, NA_PoolPart* part){
+  if(part->nextPart == part){
+    typeInfo->curPart = NA_NULL;
+  }else{
+    if(typeInfo->curPart == part){typeInfo->curPart = part->nextPart;}
+    part->prevPart->nextPart = part->nextPart;
+    part->nextPart->prevPart = part->prevPart;
+  }
+  typeInfo->listUsedCount -= (NAInt)part->usedCount;
+  part->prevPart = NA_NULL;
+  part->nextPart = NA_NULL;
+}
+
+
+
+// The unused parts of the slabs of a type are stored in a list using the
+// prevPart and nextPart fields. Expects the mutex of the type to be locked.
+NA_HIDEF void na_PushFreeSlabPart(NA_TypeInfo* typeInfo, NA_PoolPart* part){
+  part->prevPart = NA_NULL;
+  part->nextPart = typeInfo->freeParts;
+  if(part->nextPart){part->nextPart->prevPart = part;}
+  typeInfo->freeParts = part;
+}
+
+
+
+NA_HIDEF void na_RemoveFreeSlabPart(NA_TypeInfo* typeInfo, NA_PoolPart* part){
+  if(part->prevPart){
+    part->prevPart->nextPart = part->nextPart;
+  }else{
+    typeInfo->freeParts = part->nextPart;
+  }
+  if(part->nextPart){part->nextPart->prevPart = part->prevPart;}
+  part->prevPart = NA_NULL;
+  part->nextPart = NA_NULL;
+}
+
+
+
+// Returns the memory for a part smaller than the runtime part size. Such
+// parts are carved out of a slab: A block of the runtime part size, aligned
+// to it, which only contains parts of the given type. Therefore, a small
+// part does not need the alignment of the runtime part size for itself. The
+// typeInfo field of the first part of a slab stays valid as long as the slab
+// exists, even if the part is unused. Expects the mutex of the type to be
+// locked.
+NA_HIDEF NA_PoolPart* na_AllocSlabPart(NA_TypeInfo* typeInfo){
+  if(!typeInfo->freeParts){
+    size_t partSize = na_GetTypeInfoPartSize(typeInfo);
+    NAByte* slab = (NAByte*)naMallocAligned(na_Runtime->partSize, na_Runtime->partSize);
+    ((NA_PoolPart*)slab)->slabUsedCount = 0;
+    for(size_t offset = na_Runtime->partSize; offset > 0; offset -= partSize){
+      NA_PoolPart* part = (NA_PoolPart*)(slab + offset - partSize);
+      part->typeInfo = typeInfo;
+      na_PushFreeSlabPart(typeInfo, part);
+    }
+  }
+
+  NA_PoolPart* part = typeInfo->freeParts;
+  na_RemoveFreeSlabPart(typeInfo, part);
+  ((NA_PoolPart*)((size_t)part & na_Runtime->partSizeMask))->slabUsedCount++;
+  return part;
 }
 
-// This function gets called when no part has any more space.
-// A new part is created and added to the list at the current position.
-NA_HIDEF void na_EnhancePool(NA_TypeInfo* typeInfo){
+
+
+// Hands back a part of a slab. If no part of the slab is in use anymore,
+// the whole slab is freed. Expects the mutex of the type to be locked.
+NA_HIDEF void na_FreeSlabPart(NA_PoolPart* part){
+  NA_TypeInfo* typeInfo = part->typeInfo;
+  NA_PoolPart* slab = (NA_PoolPart*)((size_t)part & na_Runtime->partSizeMask);
+  na_PushFreeSlabPart(typeInfo, part);
+  slab->slabUsedCount--;
+
+  if(!slab->slabUsedCount){
+    size_t partSize = na_GetTypeInfoPartSize(typeInfo);
+    for(size_t offset = 0; offset < na_Runtime->partSize; offset += partSize){
+      na_RemoveFreeSlabPart(typeInfo, (NA_PoolPart*)((NAByte*)slab + offset));
+    }
+    naFreeAligned(slab);
+  }
+}
+
+
+
+// Creates a new part. The part is not attached to any list.
+NA_HIDEF NA_PoolPart* na_NewPoolPart(NA_TypeInfo* typeInfo){
   NA_PoolPart* part;
 
-  // We create a new part with the size of a full part but we type it as
-  // NA_PoolPart to access the first bytes.
-  part = (NA_PoolPart*)naMallocAligned(na_Runtime->partSize, na_Runtime->partSize);
+  // We create a new part with the part size of the type but we type it as
+  // NA_PoolPart to access the first bytes. All parts are aligned to their
+  // part size such that na_GetPoolPart finds the part.
+  size_t partSize = na_GetTypeInfoPartSize(typeInfo);
+  if(partSize < na_Runtime->partSize){
+    part = na_AllocSlabPart(typeInfo);
+  }else{
+    part = (NA_PoolPart*)naMallocAligned(partSize, na_Runtime->partSize);
+  }
   #if NA_DEBUG
     // Do you think the following check is not necessary? You'd be surprised
     // how many systems do not align memory correctly!
-    if(((size_t)part & ~na_Runtime->partSizeMask) != 0)
+    if(((size_t)part & ~typeInfo->partSizeMask) != 0)
       naError("pool part badly aligned");
   #endif
 
   // We initialize the basic fields of part.
   part->typeInfo = typeInfo;
-  part->maxCount = ((na_Runtime->partSize - sizeof(NA_PoolPart)) / typeInfo->typeSize);
+  part->maxCount = ((partSize - sizeof(NA_PoolPart)) / typeInfo->typeSize);
   part->usedCount = 0;
   part->everUsedCount = 0;
+  part->allocCount = 0;
 
   // Implementation note from the author: In earlier versions, everUsedCount
   // did not exists and the whole memory block needed to be intialized either
@@ -278,6 +534,10 @@ NA_HIDEF void na_EnhancePool(NA_TypeInfo* typeInfo){
   // We set the pointer to the first available space to the first byte right
   // after the NA_PoolPart.
   part->firstUnused = (void*)(((NAByte*)part) + sizeof(NA_PoolPart));
+  part->prevPart = NA_NULL;
+  part->nextPart = NA_NULL;
+  part->owner = NA_NULL;
+  part->remoteUnused = NA_NULL;
 
   // If we are in debug mode, we also set the dummy variable for a consistency
   // check.
@@ -285,17 +545,229 @@ NA_HIDEF void na_EnhancePool(NA_TypeInfo* typeInfo){
     part->dummy = part;
   #endif
 
-  // Add the new part after the current part or set the part as the first and
-  // only part, if there is none available yet.
-  if(typeInfo->curPart){
-    na_AttachPoolPartAfterCurPoolPart(typeInfo, part);
+  // Parts are created and deleted seldomly, hence simple atomics suffice.
+  NAInt partCount = naAddAtomicInt(&(typeInfo->partCount), 1);
+  NAInt peakPartCount = naLoadAtomicInt(&(typeInfo->peakPartCount));
+  while(partCount > peakPartCount){
+    if(naCompareExchangeAtomicInt(&(typeInfo->peakPartCount), peakPartCount, partCount)){break;}
+    peakPartCount = naLoadAtomicInt(&(typeInfo->peakPartCount));
+  }
+
+  return part;
+}
+
+
+
+// Deletes an empty part which is not attached to any list.
+NA_HIDEF void na_DeletePoolPart(NA_PoolPart* part){
+  NA_TypeInfo* typeInfo = part->typeInfo;
+  naAddAtomicInt(&(typeInfo->retiredAllocCount), (NAInt)part->allocCount);
+  naAddAtomicInt(&(typeInfo->partCount), -1);
+  if(na_GetTypeInfoPartSize(typeInfo) < na_Runtime->partSize){
+    na_FreeSlabPart(part);
   }else{
-    part->prevPart = part;
-    part->nextPart = part;
+    naFreeAligned(part);
   }
+}
+
+
 
-  // Set the newly created part to be the current part.
-  typeInfo->curPart = part;
+// Hands back a part owned by a thread to the part list of the type. Expects
+// the mutex of the type to be locked.
+NA_HDEF void na_ReleasePoolPart(NA_PoolPart* part){
+  NA_TypeInfo* typeInfo = part->typeInfo;
+  naStoreAtomicPointer(&(part->owner), NA_NULL);
+  na_CollectRemoteUnused(part);
+
+  #if NA_MEMORY_POOL_AGGRESSIVE_CLEANUP == 1
+    NABool keepPart = (part->usedCount != 0);
+  #else
+    NABool keepPart = (part->usedCount != 0) || !typeInfo->curPart;
+  #endif
+
+  if(keepPart){
+    na_AttachPoolPart(typeInfo, part, !na_IsPoolPartFull(part));
+  }else{
+    na_DeletePoolPart(part);
+  }
+}
+
+
+
+NA_HIDEF NA_RuntimeThreadCache* na_GetThreadCache(){
+  return (na_ThreadCacheEpoch == na_RuntimeEpoch) ? na_ThreadCache : NA_NULL;
+}
+
+
+
+NA_HDEF NA_RuntimeThreadCache* na_NewThreadCache(){
+  NA_RuntimeThreadCache* cache = naAlloc(NA_RuntimeThreadCache);
+  cache->parts = NA_NULL;
+  cache->partsCount = 0;
+  cache->prev = NA_NULL;
+
+  naLockMutex(na_Runtime->mutex);
+    cache->next = na_Runtime->threadCaches;
+    if(cache->next){cache->next->prev = cache;}
+    na_Runtime->threadCaches = cache;
+  naUnlockMutex(na_Runtime->mutex);
+
+  na_ThreadCache = cache;
+  na_ThreadCacheEpoch = na_RuntimeEpoch;
+  return cache;
+}
+
+
+
+// Hands back all parts of the cache and deletes it.
+NA_HDEF void na_DeleteThreadCache(NA_RuntimeThreadCache* cache){
+  for(NAInt i = 1; i < cache->partsCount; i++){
+    NA_PoolPart* part = cache->parts[i];
+    if(part){
+      NAMutex mutex = part->typeInfo->mutex;
+      naLockMutex(mutex);
+        na_ReleasePoolPart(part);
+        cache->parts[i] = NA_NULL;
+      naUnlockMutex(mutex);
+    }
+  }
+
+  naLockMutex(na_Runtime->mutex);
+    if(cache->prev){
+      cache->prev->next = cache->next;
+    }else{
+      na_Runtime->threadCaches = cache->next;
+    }
+    if(cache->next){cache->next->prev = cache->prev;}
+  naUnlockMutex(na_Runtime->mutex);
+
+  naFree(cache->parts);
+  naFree(cache);
+}
+
+
+
+// Registers the type if necessary and makes sure, the cache is big enough
+// to store a part for the type. Returns the cacheIndex of the type.
+NA_HDEF NAInt na_PrepareThreadCache(NA_RuntimeThreadCache* cache, NA_TypeInfo* typeInfo){
+  naLockMutex(na_Runtime->mutex);
+    NAInt cacheIndex = typeInfo->cacheIndex;
+    if(!cacheIndex){
+      na_RuntimeCacheIndexCount++;
+      cacheIndex = na_RuntimeCacheIndexCount;
+      naStoreAtomicInt(&(typeInfo->cacheIndex), cacheIndex);
+    }
+    if(!typeInfo->mutex){na_RegisterTypeInfo(typeInfo);}
+
+    // The parts array is read by naGetRuntimeTypeStats, hence it is replaced
+    // with the mutex locked.
+    if(cacheIndex >= cache->partsCount){
+      NAInt newCount = cacheIndex + 1;
+      NA_PoolPart** newParts = naMalloc(sizeof(NA_PoolPart*) * (size_t)newCount);
+      naZeron(newParts, sizeof(NA_PoolPart*) * (size_t)newCount);
+      if(cache->parts){
+        naCopyn(newParts, cache->parts, sizeof(NA_PoolPart*) * (size_t)cache->partsCount);
+      }
+      naFree(cache->parts);
+      cache->parts = newParts;
+      cache->partsCount = newCount;
+    }
+  naUnlockMutex(na_Runtime->mutex);
+
+  return cacheIndex;
+}
+
+
+
+// Returns the number of values of the type currently in use and raises the
+// peak count if necessary. Expects the mutexes of the runtime and of the type
+// to be locked. The parts owned by threads are still in use though and hence
+// their counts are read without synchronization.
+NA_HDEF size_t na_UpdateTypeInfoPeakCount(NA_TypeInfo* typeInfo){
+  NAInt cacheIndex = typeInfo->cacheIndex;
+  NAInt count = typeInfo->listUsedCount;
+  NA_RuntimeThreadCache* cache = na_Runtime->threadCaches;
+  while(cache){
+    if(cacheIndex < cache->partsCount && cache->parts[cacheIndex]){
+      count += (NAInt)cache->parts[cacheIndex]->usedCount;
+    }
+    cache = cache->next;
+  }
+  if(count > typeInfo->peakCount){typeInfo->peakCount = count;}
+  return (size_t)count;
+}
+
+
+
+// This function gets called when the thread has no part for the type or when
+// its part is full. Returns a part owned by the current thread which has
+// space.
+NA_HDEF NA_PoolPart* na_AcquirePoolPart(NA_TypeInfo* typeInfo){
+  NA_RuntimeThreadCache* cache = na_GetThreadCache();
+  if(!cache){cache = na_NewThreadCache();}
+
+  NAInt cacheIndex = naLoadAtomicInt(&(typeInfo->cacheIndex));
+  NA_PoolPart* part = NA_NULL;
+  if(cacheIndex && cacheIndex < cache->partsCount){part = cache->parts[cacheIndex];}
+
+  if(part){
+    // Maybe other threads have deleted spaces in the meantime.
+    na_CollectRemoteUnused(part);
+    if(!na_IsPoolPartFull(part)){return part;}
+  }else{
+    // This happends either upon first naNew of this type in this thread or
+    // when aggressive memory cleanup is activated. See Configuration.h
+    cacheIndex = na_PrepareThreadCache(cache, typeInfo);
+  }
+
+  // Note that the parts of the cache are only changed with the mutex of the
+  // type locked such that naGetRuntimeTypeStats can read them. The mutex of
+  // the runtime is needed to observe the peak count, which is done here once
+  // per part instead of upon every naNew.
+  naLockMutex(na_Runtime->mutex);
+  naLockMutex(typeInfo->mutex);
+    if(part){na_ReleasePoolPart(part);}
+
+    // Parts with space are at the front of the list. If the first part is
+    // full, all are and we move it to the back.
+    part = typeInfo->curPart;
+    if(part){
+      na_CollectRemoteUnused(part);
+      if(na_IsPoolPartFull(part)){
+        typeInfo->curPart = part->nextPart;
+        part = NA_NULL;
+      }else{
+        na_DetachPoolPart(typeInfo, part);
+      }
+    }
+
+    // If no part in the list has any space left, we must create a new part.
+    if(!part){part = na_NewPoolPart(typeInfo);}
+
+    naStoreAtomicPointer(&(part->owner), cache);
+    cache->parts[cacheIndex] = part;
+    na_UpdateTypeInfoPeakCount(typeInfo);
+  naUnlockMutex(typeInfo->mutex);
+  naUnlockMutex(na_Runtime->mutex);
+
+  return part;
+}
+
+
+
+NA_HDEF size_t na_GetTypeInfoAllocatedCount(NA_TypeInfo* typeInfo){
+  // Note that this only counts the parts not owned by any thread. Hence, this
+  // function is only called after all thread caches have been deleted.
+  size_t totalCount = 0;
+  NA_PoolPart* firstpart = typeInfo->curPart;
+  NA_PoolPart* curPart = firstpart;
+  while(curPart){
+    na_CollectRemoteUnused(curPart);
+    totalCount += curPart->usedCount;
+    curPart = curPart->nextPart;
+    if(curPart == firstpart){break;}
+  }
+  return totalCount;
 }
 
 
@@ -312,35 +784,22 @@ NA_DEF void* na_NewStruct(NATypeInfo* info){
 
   NA_TypeInfo* typeInfo = (NA_TypeInfo*)info;
 
-  // If there is no current part, create a first one.
-  // This happends either upon first naNew of this type ever or when aggressive
-  // memory cleanup is activated. See Configuration.h
-  if(!typeInfo->curPart){
-    // As this is the first one, we register the type to the runtime system.
-    na_RegisterTypeInfo(typeInfo);
-    na_EnhancePool(typeInfo);
-    #if NA_DEBUG
-      if(!typeInfo->curPart)
-        naCrash("No part available even after enhancing.");
-    #endif
-  }
+  // We look for the part of the current thread. If there is none or if it
+  // is full, we acquire a part with space.
+  NA_RuntimeThreadCache* cache = na_GetThreadCache();
+  NAInt cacheIndex = naLoadAtomicInt(&(typeInfo->cacheIndex));
+  NA_PoolPart* part = NA_NULL;
+  if(cache && cacheIndex < cache->partsCount){part = cache->parts[cacheIndex];}
+  if(!part || na_IsPoolPartFull(part)){part = na_AcquirePoolPart(typeInfo);}
 
-  // If the current part is full, we try the next in the part list.
-  if(na_IsPoolPartFull(typeInfo->curPart)){
-    typeInfo->curPart = typeInfo->curPart->nextPart;
-    // If the next in the part list is full too, no part in the list has any
-    // space left and hence we must create a new part.
-    if(na_IsPoolPartFull(typeInfo->curPart)){na_EnhancePool(typeInfo);}
-  }
-
-  // Now, we can be sure that the current part has space.
+  // Now, we can be sure that the part has space.
   #if NA_DEBUG
-    if(na_IsPoolPartFull(typeInfo->curPart))
+    if(na_IsPoolPartFull(part))
       naCrash("Still no space after creating new space.");
   #endif
 
   // We get the pointer to the first currently unused space.
-  void* pointer = typeInfo->curPart->firstUnused;
+  void* pointer = part->firstUnused;
   void* retPointer = pointer;
   
   // In case this is a reference counting type, initialize the refCounter
@@ -351,33 +810,31 @@ NA_DEF void* na_NewStruct(NATypeInfo* info){
   }
 
   // We find out which will be the next pointer to return.
-  if(typeInfo->curPart->usedCount == typeInfo->curPart->everUsedCount){
+  if(part->usedCount == part->everUsedCount){
     // The current space has not been used ever and is de facto the one unused
     // space with the lowest address in this part. Use the next address one
     // typeSize ahead for the next space.
-    typeInfo->curPart->firstUnused = (NAByte*)(typeInfo->curPart->firstUnused) + typeInfo->typeSize;
+    part->firstUnused = (NAByte*)(part->firstUnused) + typeInfo->typeSize;
 
     // Increase the number of ever used spaces in this part.
-    typeInfo->curPart->everUsedCount++;
+    part->everUsedCount++;
   }else{
     // The space has already been used and deleted before which means, it
     // currently stores a pointer to the next unused space.
-    // Note that the next pointer is stored at retPointer, not pointer. This
-    // is because reference counting types use the first bytes for the
-    // NARefCount structure which still is useful for error checking. So one
-    // can still detect if the programmer erroneously wants to retain or
-    // release the pointer.
-    typeInfo->curPart->firstUnused = *((void**)retPointer);
+    // Note that the next pointer is stored at retPointer, not pointer. See
+    // na_GetPoolSpaceNextUnused.
+    part->firstUnused = *((void**)retPointer);
   }
 
   // Increase the number of spaces used in this part.
-  typeInfo->curPart->usedCount++;
+  part->usedCount++;
+  part->allocCount++;
 
   #if NA_DEBUG
     #if defined NA_SYSTEM_SIZEINT_NOT_ADDRESS_SIZE
       naError("No native integer type to successfully run the runtime system.");
     #else
-      if(typeInfo->curPart != (NA_PoolPart*)((size_t)pointer & na_Runtime->partSizeMask))
+      if(part != na_GetPoolPart(pointer))
         naError("Pointer seems to be outside of part");
     #endif
   #endif
@@ -389,64 +846,73 @@ NA_DEF void* na_NewStruct(NATypeInfo* info){
 
 NA_HIDEF void na_EjectPoolPartObject(NA_PoolPart* part, void* pointer){
   // The memory at pointer is expected to be erased and hence garbage.
+  NA_TypeInfo* typeInfo = part->typeInfo;
+  NA_RuntimeThreadCache* cache = na_GetThreadCache();
+  void* owner = naLoadAtomicPointer(&(part->owner));
+
+  if(owner && owner == cache){
+    // The part is owned by the current thread. We explicitely store a pointer
+    // to the next unused space at that position, ultimately creating a list.
+    *na_GetPoolSpaceNextUnused(typeInfo, pointer) = part->firstUnused;
+    part->firstUnused = pointer;
+
+    // We reduce the number of used spaces in this part.
+    part->usedCount--;
+
+    #if NA_MEMORY_POOL_AGGRESSIVE_CLEANUP == 1
+      // If no more spaces are in use, we shrink the part away. As the part is
+      // owned by the current thread, no other thread uses it. Only
+      // naGetRuntimeTypeStats might read it, hence the mutex.
+      if(!part->usedCount){
+        naLockMutex(typeInfo->mutex);
+          cache->parts[naLoadAtomicInt(&(typeInfo->cacheIndex))] = NA_NULL;
+          na_DeletePoolPart(part);
+        naUnlockMutex(typeInfo->mutex);
+      }
+    #endif
+
+  }else if(owner){
+    // The part is owned by a different thread.
+    na_PushRemoteUnused(part, pointer);
 
-  // We explicitely store a pointer to the next unused space at that
-  // position, ultimately creating a list.
-  // Note that for reference counting types, we store the next pointer at
-  // the place where the actual content is stored, not the reference count.
-  // With that, it is still possible to do some error checks when for example
-  // the programmer wants to erroneously retain or release a pointer which
-  // has already been erased.
-  if(part->typeInfo->refCounting){
-    *((void**)((NAByte*)pointer + sizeof(NARefCount))) = part->firstUnused;
   }else{
-    *((void**)pointer) = part->firstUnused;
-  }
-  part->firstUnused = pointer;
+    // The part is not owned by any thread and hence is in the part list of
+    // the type.
+    naLockMutex(typeInfo->mutex);
+    if(naLoadAtomicPointer(&(part->owner))){
+      // Some other thread took the part in the meantime.
+      naUnlockMutex(typeInfo->mutex);
+      na_PushRemoteUnused(part, pointer);
+      return;
+    }
 
-  // If the part was full up until now, we reattach it in the list such that
-  // it comes one after the current part. But only if there are more than one
-  // parts around and the current part of the typeInfo is not already the
-  // current part.
-  if(na_IsPoolPartFull(part) && (part->nextPart != part) && (part->typeInfo->curPart != part)){
-    part->nextPart->prevPart = part->prevPart;
-    part->prevPart->nextPart = part->nextPart;
-    na_AttachPoolPartAfterCurPoolPart(part->typeInfo, part);
-  }
-
-  // We reduce the number of used spaces in this part.
-  part->usedCount--;
-
-  // If no more spaces are in use, we can shrink that part away.
-  if(!part->usedCount){
-    if(part->nextPart == part){
-      #if NA_MEMORY_POOL_AGGRESSIVE_CLEANUP == 1
-        // If this part is the last part of the pool and the cleanup is set to
-        // aggressive, we shrink it away and unregister the type.
-        NA_TypeInfo* typeInfo = part->typeInfo;
-        naFreeAligned(part);
-        typeInfo->curPart = NA_NULL;
-        na_UnregisterTypeInfo(typeInfo);
-      #endif
-    }else{
-      // There are other parts in the pool. If the empty part is the one which
-      // is the current part of the pool, we move to the next part.
-      if(part->typeInfo->curPart == part){
-        part->typeInfo->curPart = part->nextPart;
-      }
+    NABool wasFull = na_IsPoolPartFull(part);
+    *na_GetPoolSpaceNextUnused(typeInfo, pointer) = part->firstUnused;
+    part->firstUnused = pointer;
+    part->usedCount--;
+    typeInfo->listUsedCount--;
 
+    #if NA_MEMORY_POOL_AGGRESSIVE_CLEANUP == 1
+      NABool removePart = !part->usedCount;
+    #else
+      NABool removePart = !part->usedCount && (part->nextPart != part);
+    #endif
+
+    if(removePart){
       // Now, one could think of checking whether there are more parts with
       // free space available and keep the part if there is absolutely none
       // available. But that would become a bit of a list nightmare and would
       // destroy the simplicity of the current approach. Still, might be an
       // idea.
-
-      // We unlink the part from the list.
-      part->prevPart->nextPart = part->nextPart;
-      part->nextPart->prevPart = part->prevPart;
-      // And delete its memory.
-      naFreeAligned(part);
+      na_DetachPoolPart(typeInfo, part);
+      na_DeletePoolPart(part);
+    }else if(wasFull){
+      // If the part was full up until now, we move it to the front of the
+      // list, making it available for new allocations.
+      na_DetachPoolPart(typeInfo, part);
+      na_AttachPoolPart(typeInfo, part, NA_TRUE);
     }
+    naUnlockMutex(typeInfo->mutex);
   }
 }
 
@@ -465,9 +931,8 @@ NA_DEF void naDelete(void* pointer){
     NA_UNUSED(pointer);
   #else
 
-    // Find the part entry at the beginning of the part by AND'ing the
-    // address with the partSizeMask
-    part = (NA_PoolPart*)((size_t)pointer & na_Runtime->partSizeMask);
+    // Find the part entry at the beginning of the part.
+    part = na_GetPoolPart(pointer);
 
     #if NA_DEBUG
       if(part->dummy != part)
@@ -492,24 +957,33 @@ NA_DEF void* naRetain(void* pointer){
       naCrash("Runtime not running. Use naStartRuntime()");
     if(!pointer)
       naCrash("pointer is Null");
+  #endif
 
-    // Find the part entry at the beginning of the part by AND'ing the
-    // address with the partSizeMask
-    #if defined NA_SYSTEM_SIZEINT_NOT_ADDRESS_SIZE
+  #if defined NA_SYSTEM_SIZEINT_NOT_ADDRESS_SIZE
+    #if NA_DEBUG
       naError("No native integer type to successfully run the runtime system.");
-      NA_UNUSED(part);
-    #else
-      NA_PoolPart* part = (NA_PoolPart*)((size_t)pointer & na_Runtime->partSizeMask);
+    #endif
+  #else
+
+    // Find the part entry at the beginning of the part.
+    NA_PoolPart* part = na_GetPoolPart(pointer);
+
+    #if NA_DEBUG
       if(part->dummy != part)
         naError("Pointer seems not to be from a pool.");
       if(!part->typeInfo->refCounting)
         naError("Pointer belongs to a NON-reference-counting entity. You can't use naRetain!");
     #endif
-  #endif
 
-  // Retain the refCounter.
-  NARefCount* refCount = (NARefCount*)((NAByte*)pointer - sizeof(NARefCount));
-  naRetainRefCount(refCount);
+    // Retain the refCounter.
+    NARefCount* refCount = (NARefCount*)((NAByte*)pointer - sizeof(NARefCount));
+    if(part->typeInfo->refCounting == NA_REFCOUNTING_ATOMIC){
+      naRetainRefCountAtomic(refCount);
+    }else{
+      naRetainRefCount(refCount);
+    }
+
+  #endif
   return pointer;
 }
 
@@ -524,17 +998,14 @@ NA_DEF void naRelease(void* pointer){
   #endif
 
   #if defined NA_SYSTEM_SIZEINT_NOT_ADDRESS_SIZE
-    NA_UNUSED(part);
     NA_UNUSED(pointer);
-    NA_UNUSED(refCount);
     #if NA_DEBUG
       naError("No native integer type to successfully run the runtime system.");
     #endif
   #else
 
-    // Find the pool entry at the beginning of the part by AND'ing the
-    // address with the partSizeMask
-    NA_PoolPart* part = (NA_PoolPart*)((size_t)pointer & na_Runtime->partSizeMask);
+    // Find the part entry at the beginning of the part.
+    NA_PoolPart* part = na_GetPoolPart(pointer);
 
     #if NA_DEBUG
       if(part->dummy != part)
@@ -545,13 +1016,22 @@ NA_DEF void naRelease(void* pointer){
 
     // Release the space and delete it with the destructor if refCount is zero.
     NARefCount* refCount = (NARefCount*)((NAByte*)pointer - sizeof(NARefCount));
-    naReleaseRefCount(refCount, pointer, part->typeInfo->destructor);
-    // Note: The following test could also be achieved by using a special
-    // mutator function in the previous naReleaseRefCount call. But this would
-    // always cause a function call, even for types without a destructor.
-    // Therefore, we do this here:
-    if(!na_GetRefCountCount(refCount)){
-      na_EjectPoolPartObject(part, refCount);
+    if(part->typeInfo->refCounting == NA_REFCOUNTING_ATOMIC){
+      // Reading the count after releasing would race with other threads
+      // releasing at the same time. Only the thread which reached zero
+      // ejects the space.
+      if(na_ReleaseRefCountAtomic(refCount, pointer, part->typeInfo->destructor)){
+        na_EjectPoolPartObject(part, refCount);
+      }
+    }else{
+      naReleaseRefCount(refCount, pointer, part->typeInfo->destructor);
+      // Note: The following test could also be achieved by using a special
+      // mutator function in the previous naReleaseRefCount call. But this would
+      // always cause a function call, even for types without a destructor.
+      // Therefore, we do this here:
+      if(!na_GetRefCountCount(refCount)){
+        na_EjectPoolPartObject(part, refCount);
+      }
     }
 
   #endif
@@ -648,7 +1128,7 @@ NA_DEF void naStartRuntime(){
     #if NA_DEBUG
       if(naIsRuntimeRunning())
         naCrash("Runtime already running");
-      if(sizeof(NA_PoolPart) != (8 * NA_ADDRESS_BYTES))
+      if(sizeof(NA_PoolPart) != (16 * NA_ADDRESS_BYTES))
         naError("NA_PoolPart struct encoding misaligned");
     #endif
     na_Runtime = naAlloc(NARuntime);
@@ -666,7 +1146,264 @@ NA_DEF void naStartRuntime(){
     na_Runtime->totalMallocGarbageByteCount = 0;
     na_Runtime->typeInfoCount = 0;
     na_Runtime->typeInfos = NA_NULL;
+    na_Runtime->mutex = naMakeMutex();
+    na_Runtime->threadCaches = NA_NULL;
+
+    // All thread caches of a previous run become invalid.
+    na_RuntimeEpoch++;
+  #endif
+}
+
+
+
+NA_DEF void naDetachRuntimeThread(){
+  if(!naIsRuntimeRunning()){return;}
+  NA_RuntimeThreadCache* cache = na_GetThreadCache();
+  if(cache){
+    na_DeleteThreadCache(cache);
+    na_ThreadCache = NA_NULL;
+  }
+}
+
+
+
+NA_DEF size_t naGetRuntimeTypeCount(){
+  #if NA_DEBUG
+    if(!naIsRuntimeRunning())
+      naCrash("Runtime not running. Use naStartRuntime()");
   #endif
+  naLockMutex(na_Runtime->mutex);
+    size_t typeCount = na_Runtime->typeInfoCount;
+  naUnlockMutex(na_Runtime->mutex);
+  return typeCount;
+}
+
+
+
+NA_DEF void naGetRuntimeTypeStats(NARuntimeTypeStats* stats, size_t index){
+  #if NA_DEBUG
+    if(!naIsRuntimeRunning())
+      naCrash("Runtime not running. Use naStartRuntime()");
+    if(!stats)
+      naCrash("stats is Null");
+  #endif
+
+  naZeron(stats, sizeof(NARuntimeTypeStats));
+
+  naLockMutex(na_Runtime->mutex);
+  if(index >= na_Runtime->typeInfoCount){
+    #if NA_DEBUG
+      naError("index out of range");
+    #endif
+    naUnlockMutex(na_Runtime->mutex);
+    return;
+  }
+
+  NA_TypeInfo* typeInfo = na_Runtime->typeInfos[index];
+  NAInt cacheIndex = typeInfo->cacheIndex;
+  size_t allocCount = 0;
+
+  // With both mutexes locked, no part can be deleted and no thread cache can
+  // change its parts. The parts owned by threads are still in use though
+  // and hence their counts are read without synchronization.
+  naLockMutex(typeInfo->mutex);
+    size_t count = na_UpdateTypeInfoPeakCount(typeInfo);
+
+    NA_RuntimeThreadCache* cache = na_Runtime->threadCaches;
+    while(cache){
+      if(cacheIndex < cache->partsCount && cache->parts[cacheIndex]){
+        allocCount += cache->parts[cacheIndex]->allocCount;
+      }
+      cache = cache->next;
+    }
+
+    NA_PoolPart* firstpart = typeInfo->curPart;
+    NA_PoolPart* curPart = firstpart;
+    while(curPart){
+      allocCount += curPart->allocCount;
+      curPart = curPart->nextPart;
+      if(curPart == firstpart){break;}
+    }
+
+    stats->partCount = (size_t)naLoadAtomicInt(&(typeInfo->partCount));
+    stats->peakPartCount = (size_t)naLoadAtomicInt(&(typeInfo->peakPartCount));
+    stats->peakCount = (size_t)typeInfo->peakCount;
+    allocCount += (size_t)naLoadAtomicInt(&(typeInfo->retiredAllocCount));
+  naUnlockMutex(typeInfo->mutex);
+  naUnlockMutex(na_Runtime->mutex);
+
+  stats->typeName = typeInfo->typeName;
+  stats->typeSize = typeInfo->typeSize;
+  stats->count = count;
+  stats->allocCount = allocCount;
+  stats->deleteCount = allocCount - count;
+  stats->partSize = na_GetTypeInfoPartSize(typeInfo);
+  stats->reservedBytes = stats->partCount * stats->partSize;
+  stats->usedBytes = count * typeInfo->typeSize;
+}
+
+
+
+NA_DEF void naPrintRuntimeStats(){
+  size_t typeCount = naGetRuntimeTypeCount();
+  size_t totalReserved = 0;
+  size_t totalUsed = 0;
+
+  printf("Runtime type statistics (part size %zu Bytes):" NA_NL, na_Runtime->partSize);
+  printf("%-24s %8s %10s %10s %12s %12s %7s %9s %12s %12s %6s" NA_NL,
+    "Type", "Size", "Count", "Peak", "Allocs", "Deletes", "Parts", "PeakParts", "Reserved", "Used", "Use %");
+  for(size_t i = 0; i < typeCount; i++){
+    NARuntimeTypeStats stats;
+    naGetRuntimeTypeStats(&stats, i);
+    double usage = stats.reservedBytes ? 100. * (double)stats.usedBytes / (double)stats.reservedBytes : 0.;
+    printf("%-24s %8zu %10zu %10zu %12zu %12zu %7zu %9zu %12zu %12zu %6.1f" NA_NL,
+      stats.typeName,
+      stats.typeSize,
+      stats.count,
+      stats.peakCount,
+      stats.allocCount,
+      stats.deleteCount,
+      stats.partCount,
+      stats.peakPartCount,
+      stats.reservedBytes,
+      stats.usedBytes,
+      usage);
+    totalReserved += stats.reservedBytes;
+    totalUsed += stats.usedBytes;
+  }
+  printf("Total: %zu of %zu reserved Bytes used" NA_NL, totalUsed, totalReserved);
+}
+
+
+
+NA_DEF void naPrintRuntimeStatsJSON(){
+  size_t typeCount = naGetRuntimeTypeCount();
+
+  printf("{\"partSize\": %zu, \"types\": [", na_Runtime->partSize);
+  for(size_t i = 0; i < typeCount; i++){
+    NARuntimeTypeStats stats;
+    naGetRuntimeTypeStats(&stats, i);
+    printf("%s" NA_NL "  {\"name\": \"%s\", \"typeSize\": %zu, \"count\": %zu, \"peakCount\": %zu, \"allocCount\": %zu, \"deleteCount\": %zu, \"partSize\": %zu, \"partCount\": %zu, \"peakPartCount\": %zu, \"reservedBytes\": %zu, \"usedBytes\": %zu}",
+      i ? "," : "",
+      stats.typeName,
+      stats.typeSize,
+      stats.count,
+      stats.peakCount,
+      stats.allocCount,
+      stats.deleteCount,
+      stats.partSize,
+      stats.partCount,
+      stats.peakPartCount,
+      stats.reservedBytes,
+      stats.usedBytes);
+  }
+  printf(NA_NL "]}" NA_NL);
+}
+
+
+
+// Orders parts with more values in use first.
+NA_HDEF int na_ComparePoolPartUsage(const void* a, const void* b){
+  const NA_PoolPart* partA = *(const NA_PoolPart* const*)a;
+  const NA_PoolPart* partB = *(const NA_PoolPart* const*)b;
+  if(partA->usedCount > partB->usedCount){return -1;}
+  if(partA->usedCount < partB->usedCount){return 1;}
+  return 0;
+}
+
+
+
+// Releases all empty parts in the part list of the type and sorts the
+// remaining parts by their usage. Expects the mutex of the type to be locked.
+// Returns the number of bytes released.
+NA_HDEF size_t na_TrimTypeInfo(NA_TypeInfo* typeInfo){
+  size_t releasedBytes = 0;
+
+  // The empty parts of the current thread are handed back first.
+  NA_RuntimeThreadCache* cache = na_GetThreadCache();
+  if(cache && typeInfo->cacheIndex < cache->partsCount){
+    NA_PoolPart* part = cache->parts[typeInfo->cacheIndex];
+    if(part){
+      na_CollectRemoteUnused(part);
+      if(!part->usedCount){
+        naStoreAtomicPointer(&(part->owner), NA_NULL);
+        na_AttachPoolPart(typeInfo, part, NA_TRUE);
+        cache->parts[typeInfo->cacheIndex] = NA_NULL;
+      }
+    }
+  }
+
+  if(!typeInfo->curPart){return releasedBytes;}
+
+  // We take all parts out of the list and delete the empty ones.
+  size_t partCount = 1;
+  NA_PoolPart* curPart = typeInfo->curPart->nextPart;
+  while(curPart != typeInfo->curPart){
+    partCount++;
+    curPart = curPart->nextPart;
+  }
+
+  NA_PoolPart** parts = naMalloc(sizeof(NA_PoolPart*) * partCount);
+  size_t keptCount = 0;
+  while(typeInfo->curPart){
+    curPart = typeInfo->curPart;
+    na_DetachPoolPart(typeInfo, curPart);
+    na_CollectRemoteUnused(curPart);
+    if(curPart->usedCount){
+      parts[keptCount] = curPart;
+      keptCount++;
+    }else{
+      releasedBytes += na_GetTypeInfoPartSize(typeInfo);
+      na_DeletePoolPart(curPart);
+    }
+  }
+
+  // The remaining parts are sorted such that the fullest parts with space
+  // come first and the full parts come last. New values are hence created in
+  // the fullest parts and the emptier parts have a chance to become empty.
+  qsort(parts, keptCount, sizeof(NA_PoolPart*), na_ComparePoolPartUsage);
+  for(size_t i = 0; i < keptCount; i++){
+    if(!na_IsPoolPartFull(parts[i])){na_AttachPoolPart(typeInfo, parts[i], NA_FALSE);}
+  }
+  for(size_t i = 0; i < keptCount; i++){
+    if(na_IsPoolPartFull(parts[i])){na_AttachPoolPart(typeInfo, parts[i], NA_FALSE);}
+  }
+  naFree(parts);
+
+  return releasedBytes;
+}
+
+
+
+NA_DEF size_t naTrimRuntimePools(){
+  #if NA_DEBUG
+    if(!naIsRuntimeRunning())
+      naCrash("Runtime not running. Use naStartRuntime()");
+  #endif
+
+  size_t releasedBytes = 0;
+  naLockMutex(na_Runtime->mutex);
+    for(size_t i = 0; i < na_Runtime->typeInfoCount; i++){
+      NA_TypeInfo* typeInfo = na_Runtime->typeInfos[i];
+      naLockMutex(typeInfo->mutex);
+        releasedBytes += na_TrimTypeInfo(typeInfo);
+      naUnlockMutex(typeInfo->mutex);
+    }
+  naUnlockMutex(na_Runtime->mutex);
+
+  // The parts are freed now but the system allocator might still keep the
+  // memory. We ask it to hand back what it can.
+  if(releasedBytes){
+    #if NA_OS == NA_OS_WINDOWS
+      _heapmin();
+    #elif NA_OS == NA_OS_MAC_OS_X
+      malloc_zone_pressure_relief(NA_NULL, 0);
+    #elif defined __GLIBC__
+      malloc_trim(0);
+    #endif
+  }
+
+  return releasedBytes;
 }
 
 
@@ -681,6 +1418,13 @@ NA_DEF void naStopRuntime(){
     }
   #endif
 
+  // All threads hand back their parts. Note that all threads using the
+  // runtime are expected to have ended or at least to not use it anymore.
+  while(na_Runtime->threadCaches){
+    na_DeleteThreadCache(na_Runtime->threadCaches);
+  }
+  na_ThreadCache = NA_NULL;
+
   // Then, we detect, if there are any memory leaks.
   #if NA_DEBUG
     NABool leakMessagePrinted = NA_FALSE;
@@ -709,12 +1453,12 @@ NA_DEF void naStopRuntime(){
     NA_PoolPart* curPart;
     NA_PoolPart* nextPart;
 
-    // Free all parts.
+    // Free all parts. Deleting them frees the slabs of small parts as well.
     firstpart = na_Runtime->typeInfos[0]->curPart;
     curPart = firstpart;
     while(curPart){
       nextPart = curPart->nextPart;
-      naFreeAligned(curPart);
+      na_DeletePoolPart(curPart);
       if(nextPart == firstpart){break;}
       curPart = nextPart;
     }
@@ -724,6 +1468,7 @@ NA_DEF void naStopRuntime(){
     na_UnregisterTypeInfo(na_Runtime->typeInfos[0]);
   }
 
+  naClearMutex(na_Runtime->mutex);
   naFree(na_Runtime);
   na_Runtime = NA_NULL;
 }
@@ -744,11 +1489,10 @@ NA_HDEF void na_DestructPointer(NAPointer* pointer){
 
 NA_HDEF size_t naGetRuntimeTypeRefCount(const void* pointer){
   #if NA_DEBUG
-    // Find the pool entry at the beginning of the part by AND'ing the
-    // address with the partSizeMask
+    // Find the pool entry at the beginning of the part.
     if(!pointer)
       naCrash("pointer is Null");
-    NA_PoolPart* part = (NA_PoolPart*)((size_t)pointer & na_Runtime->partSizeMask);
+    NA_PoolPart* part = na_GetPoolPart(pointer);
     if(part->dummy != part)
       naError("Pointer seems not to be from a pool.");
     if(!part->typeInfo->refCounting)
@@ -11,10 +11,19 @@ struct NATypeInfo{
   void*             curPoolPart;    // The actual type of this entry is hidden.
   size_t            typeSize;
   NAMutator         destructor;
-  NABool            refCounting;
-  #if NA_DEBUG
-    const char*     typeName;
-  #endif
+  int               refCounting;    // NA_FALSE, NA_TRUE or NA_REFCOUNTING_ATOMIC
+  const char*       typeName;
+  size_t            partSize;       // 0 denotes NA_POOLPART_BYTESIZE
+  // The following fields are set by the runtime upon first use.
+  void*             mutex;
+  NAInt             cacheIndex;
+  NAInt             partCount;
+  NAInt             peakPartCount;
+  NAInt             retiredAllocCount;
+  NAInt             listUsedCount;
+  NAInt             peakCount;
+  size_t            partSizeMask;
+  void*             freeParts;
 };
 
 
@@ -22,22 +31,20 @@ struct NATypeInfo{
 // This is the runtime type macro which actually creates a global variable
 // called na_MyStruct_Typeinfo (for whatever MyStruct is) storing all values.
 #undef NA_RUNTIME_TYPE
-#if NA_DEBUG
-  #define NA_RUNTIME_TYPE(typeName, destructor, refCounting)\
-    NATypeInfo na_ ## typeName ## TypeInfo =\
-    {NA_NULL,\
-    sizeof(typeName),\
-    (NAMutator)destructor,\
-    refCounting,\
-    #typeName}
-#else
-  #define NA_RUNTIME_TYPE(typeName, destructor, refCounting)\
-    NATypeInfo na_ ## typeName ## TypeInfo =\
-    {NA_NULL,\
-    sizeof(typeName),\
-    (NAMutator)destructor,\
-    refCounting}
-#endif
+#define NA_RUNTIME_TYPE(typeName, destructor, refCounting)\
+  NA_RUNTIME_TYPE_WITH_PART_SIZE(typeName, destructor, refCounting, 0)
+
+#undef NA_RUNTIME_TYPE_WITH_PART_SIZE
+#define NA_RUNTIME_TYPE_WITH_PART_SIZE(typeName, destructor, refCounting, partSize)\
+  NATypeInfo na_ ## typeName ## TypeInfo =\
+  {NA_NULL,\
+  sizeof(typeName),\
+  (NAMutator)destructor,\
+  refCounting,\
+  #typeName,\
+  partSize,\
+  NA_NULL,\
+  0, 0, 0, 0, 0, 0, 0, NA_NULL}
 
 
 
@@ -61,6 +68,7 @@ NA_API void* na_NewStruct(NATypeInfo* info);
 typedef struct NA_TypeInfo NA_TypeInfo;
 typedef struct NAMallocGarbage NAMallocGarbage;
 typedef struct NARuntime NARuntime;
+typedef struct NA_RuntimeThreadCache NA_RuntimeThreadCache;
 
 // The runtime struct stores base informations about the runtime.
 struct NARuntime{
@@ -71,6 +79,8 @@ struct NARuntime{
   size_t totalMallocGarbageByteCount;
   size_t typeInfoCount;
   NA_TypeInfo** typeInfos;
+  void* mutex;                          // Guards typeInfos and threadCaches.
+  NA_RuntimeThreadCache* threadCaches;
 };
 
 extern NARuntime* na_Runtime;
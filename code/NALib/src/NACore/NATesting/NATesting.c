@@ -9,13 +9,45 @@
 #if NA_OS == NA_OS_WINDOWS
   #include <windows.h>
   #include <Tlhelp32.h>
-#elif NA_OS == NA_OS_MAC_OS_X
+  #include <intrin.h>
+#else
   #include <sys/time.h>
-  #include <sys/sysctl.h>
-  #include <libproc.h>
   #include <errno.h>
+  #include <unistd.h>
+  #include <sys/wait.h>
+  #if NA_OS == NA_OS_MAC_OS_X
+    #include <sys/sysctl.h>
+    #include <libproc.h>
+  #endif
+#endif
+
+#if defined _M_X64 || defined _M_IX86 || defined __x86_64__ || defined __i386__
+  #define NA_BENCHMARK_CYCLES_AVAILABLE 1
+  #if NA_OS != NA_OS_WINDOWS
+    #include <x86intrin.h>
+  #endif
+#else
+  #define NA_BENCHMARK_CYCLES_AVAILABLE 0
 #endif
 
+// The hardware performance counters are read with perf_event_open and the
+// benchmarks are pinned to a processor with sched_setaffinity. Both are only
+// available on Linux.
+#if defined __linux__
+  #define NA_BENCHMARK_COUNTERS_AVAILABLE 1
+  #define NA_BENCHMARK_PINNING_AVAILABLE 1
+  #include <errno.h>
+  #include <string.h>
+  #include <unistd.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <linux/perf_event.h>
+#else
+  #define NA_BENCHMARK_COUNTERS_AVAILABLE 0
+  #define NA_BENCHMARK_PINNING_AVAILABLE 0
+#endif
+
+#include "../../NABuffer.h"
 #include "../../NAStack.h"
 #include "../../NAList.h"
 #include "../../NAString.h"
@@ -26,6 +58,57 @@
 #define NA_TEST_INDEX_COUNT 0x10000
 #define NA_TEST_INDEX_MASK (NA_TEST_INDEX_COUNT - 1)
 
+// Number of samples measured per benchmark after warming up. Every sample
+// takes roughly timePerBenchmark / NA_BENCHMARK_SAMPLE_COUNT seconds.
+#define NA_BENCHMARK_SAMPLE_COUNT 15
+
+// A benchmark is considered a regression if its median is slower than the
+// baseline by this ratio and by more than 3 standard deviations estimated
+// from the median absolute deviation.
+#define NA_BENCHMARK_REGRESSION_RATIO .05
+#define NA_BENCHMARK_MAD_TO_SIGMA 1.4826
+
+// When testing in parallel, the test groups at this depth below the root are
+// executed by worker processes. For the NALib tests, these are the groups of
+// the individual types like NAString or NABuffer.
+#define NA_TEST_WORKER_GROUP_DEPTH 2
+
+// Number of unsigned longs holding the processor mask of the benchmarks.
+#define NA_BENCHMARK_CPU_MASK_COUNT 16
+
+// The hardware performance counters which are read with the -H argument.
+typedef enum{
+  NA_BENCHMARK_COUNTER_CYCLES,
+  NA_BENCHMARK_COUNTER_INSTRUCTIONS,
+  NA_BENCHMARK_COUNTER_L1D_MISSES,
+  NA_BENCHMARK_COUNTER_LLC_MISSES,
+  NA_BENCHMARK_COUNTER_BRANCH_MISSES,
+  NA_BENCHMARK_COUNTER_COUNT
+} NABenchmarkCounter;
+
+static const char* na_BenchmarkCounterNames[NA_BENCHMARK_COUNTER_COUNT] = {
+  "cyc",
+  "ins",
+  "L1D miss",
+  "LLC miss",
+  "br miss",
+};
+
+static const char* na_BenchmarkCounterFieldNames[NA_BENCHMARK_COUNTER_COUNT] = {
+  "hw_cycles_per_op",
+  "instructions_per_op",
+  "l1d_misses_per_op",
+  "llc_misses_per_op",
+  "branch_misses_per_op",
+};
+
+typedef struct NABenchmarkBaseline NABenchmarkBaseline;
+struct NABenchmarkBaseline {
+  NAString* name;
+  double median;
+  double mad;
+};
+
 typedef struct NATestData NATestData;
 struct NATestData {
   const char* name;
@@ -35,9 +118,40 @@ struct NATestData {
   int childSuccessCount;
   int leafSuccessCount;
   int totalLeafCount;
+  NABool isGroup;
   NATestData* parent;
 };
 
+#if NA_OS != NA_OS_WINDOWS
+  // A worker process executing a single test group. The process writes its
+  // printout and its results into two temporary files which are read once
+  // the process exits. A pid of 0 denotes an unused worker.
+  typedef struct NATestWorker NATestWorker;
+  struct NATestWorker {
+    pid_t pid;
+    NATestData* testData;
+    FILE* outputFile;
+    FILE* resultFile;
+  };
+
+  // The results of a worker are stored as a sequence of records, each
+  // followed by textLength bytes of the test expression or group name.
+  typedef enum{
+    NA_TEST_RECORD_TEST,
+    NA_TEST_RECORD_GROUP,
+    NA_TEST_RECORD_GROUP_END,
+    NA_TEST_RECORD_UNTESTED
+  } NATestRecordType;
+
+  typedef struct NATestRecord NATestRecord;
+  struct NATestRecord {
+    int32 type;
+    int32 lineNum;
+    int32 success;
+    uint32 textLength;
+  };
+#endif
+
 typedef struct NATesting NATesting;
 struct NATesting {
   NATestData* rootTestData;
@@ -46,6 +160,7 @@ struct NATesting {
   NABool printAllTestGroups;
   NABool testCaseRunning;
   NABool letCrashTestsCrash;
+  NABool benchmarksEnabled;
   NABool testingStartSuccessful;
   int errorCount;
   NAStack untestedStrings;
@@ -56,9 +171,48 @@ struct NATesting {
   char out[NA_TEST_INDEX_COUNT];
   #if NA_OS == NA_OS_WINDOWS
     HANDLE logFile;
-  #elif NA_OS == NA_OS_MAC_OS_X
+    double timerFrequency;
+  #else
     NAFile* logFile;
   #endif
+
+  // Number of test groups executed at the same time. Only the root process
+  // starts workers. In a worker, workerTestData denotes its group.
+  int testWorkerCount;
+  #if NA_OS != NA_OS_WINDOWS
+    NATestWorker* testWorkers;
+    NATestData* workerTestData;
+    FILE* workerResultFile;
+    size_t workerUntestedStart;
+    NAStack workerNames;
+  #endif
+
+  size_t benchmarkTestSize;
+  NABool benchmarkWarmingUp;
+  size_t benchmarkSampleCount;
+  double benchmarkTimes[NA_BENCHMARK_SAMPLE_COUNT];
+  double benchmarkCycles[NA_BENCHMARK_SAMPLE_COUNT];
+  NAFile* benchmarkOutFile;
+  NABool benchmarkOutJSON;
+  size_t benchmarkOutCount;
+  NAStack benchmarkBaselines;
+  int benchmarkRegressionCount;
+
+  // All counters are opened as one group led by the first counter which
+  // could be opened. The index denotes the position of a counter in the
+  // values read from the group or is -1 if the counter is not available.
+  NABool benchmarkCountersEnabled;
+  int benchmarkCounterLeader;
+  int benchmarkCounterFds[NA_BENCHMARK_COUNTER_COUNT];
+  int benchmarkCounterIndices[NA_BENCHMARK_COUNTER_COUNT];
+  double benchmarkCounterDiffs[NA_BENCHMARK_COUNTER_COUNT];
+  double benchmarkCounters[NA_BENCHMARK_COUNTER_COUNT][NA_BENCHMARK_SAMPLE_COUNT];
+
+  // Benchmark groups are never executed by workers. While testing in
+  // parallel, the benchmarks are pinned to a single processor.
+  int benchmarkGroupDepth;
+  NABool benchmarkPinned;
+  unsigned long benchmarkCpuMask[NA_BENCHMARK_CPU_MASK_COUNT];
 };
 
 NATesting* na_Testing = NA_NULL;
@@ -76,16 +230,13 @@ NA_HDEF NAString* na_NewTestApplicationPath(void){
     pid_t pid = (pid_t)getpid();
     proc_pidpath (pid, pathbuf, sizeof(pathbuf));
     exePath = naNewStringWithFormat("%s", pathbuf);
+  #else
+    // readlink does not null terminate.
+    char pathbuf[4096];
+    ssize_t pathLength = readlink("/proc/self/exe", pathbuf, sizeof(pathbuf) - 1);
+    pathbuf[pathLength < 0 ? 0 : pathLength] = '\0';
+    exePath = naNewStringWithFormat("%s", pathbuf);
   #endif
-  // This is how Linux would do it:
-//    char dest[PATH_MAX];
-//    memset(dest, 0, sizeof(dest)); // readlink does not null terminate!
-//    if (readlink("/proc/self/exe", dest, PATH_MAX) == -1) {
-//      perror("readlink");
-//    } else {
-//      printf("%s\n", dest);
-//    }
-//    return naNewStringWithFormat("%s", dest);
   return exePath;
 }
 
@@ -111,6 +262,7 @@ NA_HIDEF void na_InitTestingData(NATestData* testData, const char* name, NATestD
   testData->childSuccessCount = 0;
   testData->leafSuccessCount = 0;
   testData->totalLeafCount = 0;
+  testData->isGroup = NA_FALSE;
   testData->parent = parent;
 }
 
@@ -185,6 +337,305 @@ NA_HIDEF void na_PrintTestGroup(NATestData* testData){
 
 
 
+NA_HDEF void na_WriteBenchmarkOutput(NAString* string){
+  naWriteFileBytes(
+    na_Testing->benchmarkOutFile,
+    naGetStringUTF8Pointer(string),
+    (NAFileSize)naGetStringByteSize(string));
+  naDelete(string);
+}
+
+
+
+// Results are written as CSV, or as JSON if the path ends with ".json".
+NA_HDEF void na_OpenBenchmarkOutput(const char* path){
+  if(na_Testing->benchmarkOutFile){
+    printf("Benchmark output already set, ignoring %s" NA_NL, path);
+    return;
+  }
+
+  na_Testing->benchmarkOutFile = naCreateFileWritingPath(path, NA_FILEMODE_DEFAULT);
+  if(!naIsFileOpen(na_Testing->benchmarkOutFile)){
+    printf("Could not open benchmark output %s" NA_NL, path);
+    naReleaseFile(na_Testing->benchmarkOutFile);
+    na_Testing->benchmarkOutFile = NA_NULL;
+    return;
+  }
+
+  NAString* pathString = naNewStringWithFormat("%s", path);
+  NAString* suffix = naNewStringWithSuffixOfPath(pathString);
+  na_Testing->benchmarkOutJSON = naEqualStringToUTF8CString(suffix, "json", NA_FALSE);
+  naDelete(suffix);
+  naDelete(pathString);
+
+  if(na_Testing->benchmarkOutJSON){
+    na_WriteBenchmarkOutput(naNewStringWithFormat("["));
+  }else{
+    NAString* header = naNewString();
+    naAppendStringFormat(header, "median_ns,p95_ns,mad_ns,cycles_per_op");
+    for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+      naAppendStringFormat(header, ",%s", na_BenchmarkCounterFieldNames[i]);
+    }
+    naAppendStringFormat(header, ",runs_per_sample,samples,line,name\n");
+    na_WriteBenchmarkOutput(header);
+  }
+}
+
+
+
+// Creates a CSV field surrounded by quotes with all quotes doubled.
+NA_HDEF NAString* na_NewBenchmarkCSVField(const NAString* name){
+  const NAUTF8Char* ptr = naGetStringUTF8Pointer(name);
+  size_t byteSize = naGetStringByteSize(name);
+  NAUTF8Char* field = naMalloc(byteSize * 2 + 3);
+  size_t fieldSize = 0;
+  field[fieldSize++] = '"';
+  for(size_t i = 0; i < byteSize; i++){
+    if(ptr[i] == '"'){field[fieldSize++] = '"';}
+    field[fieldSize++] = ptr[i];
+  }
+  field[fieldSize++] = '"';
+  field[fieldSize] = '\0';
+  NAString* string = naNewStringWithFormat("%s", field);
+  naFree(field);
+  return string;
+}
+
+
+
+// Creates a JSON string surrounded by quotes. Quotes and backslashes are
+// escaped, control characters are written as \u00XX.
+NA_HDEF NAString* na_NewBenchmarkJSONString(const NAString* name){
+  const NAUTF8Char* ptr = naGetStringUTF8Pointer(name);
+  size_t byteSize = naGetStringByteSize(name);
+  NAUTF8Char* field = naMalloc(byteSize * 6 + 3);
+  size_t fieldSize = 0;
+  field[fieldSize++] = '"';
+  for(size_t i = 0; i < byteSize; i++){
+    NAByte curChar = (NAByte)ptr[i];
+    if(curChar == '"' || curChar == '\\'){
+      field[fieldSize++] = '\\';
+      field[fieldSize++] = (NAUTF8Char)curChar;
+    }else if(curChar < 0x20){
+      fieldSize += (size_t)snprintf(&field[fieldSize], 7, "\\u%04x", (unsigned int)curChar);
+    }else{
+      field[fieldSize++] = (NAUTF8Char)curChar;
+    }
+  }
+  field[fieldSize++] = '"';
+  field[fieldSize] = '\0';
+  NAString* string = naNewStringWithFormat("%s", field);
+  naFree(field);
+  return string;
+}
+
+
+
+// Reverts na_NewBenchmarkCSVField.
+NA_HDEF NAString* na_NewBenchmarkNameWithCSVField(NAStringView field){
+  const NAUTF8Char* ptr = naGetStringViewUTF8Pointer(field);
+  size_t byteSize = naGetStringViewByteSize(field);
+  if(byteSize >= 2 && ptr[0] == '"' && ptr[byteSize - 1] == '"'){
+    ptr++;
+    byteSize -= 2;
+  }
+  NAUTF8Char* name = naMalloc(byteSize + 1);
+  size_t nameSize = 0;
+  for(size_t i = 0; i < byteSize; i++){
+    name[nameSize++] = ptr[i];
+    if(ptr[i] == '"' && i + 1 < byteSize && ptr[i + 1] == '"'){i++;}
+  }
+  name[nameSize] = '\0';
+  NAString* string = naNewStringWithFormat("%s", name);
+  naFree(name);
+  return string;
+}
+
+
+
+// Loads the medians of a CSV file written by an earlier run.
+NA_HDEF void na_LoadBenchmarkBaselines(const char* path){
+  if(!naExists(path)){
+    printf("Benchmark baseline not found: %s" NA_NL, path);
+    return;
+  }
+
+  NABuffer* buffer = naNewBufferWithInputPath(path);
+  NABufferLineIterator lineIter = naMakeBufferLineIterator(buffer);
+  while(naIterateBufferLine(&lineIter, NA_TRUE)){
+    NAStringView line = naGetBufferLineStringView(&lineIter);
+    // Skips the header and anything else not starting with a number.
+    NAUTF8Char firstChar = naGetStringViewUTF8Pointer(line)[0];
+    if(firstChar < '0' || firstChar > '9'){continue;}
+
+    NABenchmarkBaseline* baseline = naPushStack(&(na_Testing->benchmarkBaselines));
+    baseline->median = naParseStringViewDouble(naParseStringViewTokenWithDelimiter(&line, ','));
+    naParseStringViewTokenWithDelimiter(&line, ',');
+    baseline->mad = naParseStringViewDouble(naParseStringViewTokenWithDelimiter(&line, ','));
+    // The name is the last field and the only one in quotes.
+    while(!naIsStringViewEmpty(line) && naGetStringViewUTF8Pointer(line)[0] != '"'){
+      naParseStringViewTokenWithDelimiter(&line, ',');
+    }
+    baseline->name = na_NewBenchmarkNameWithCSVField(line);
+  }
+  naClearBufferLineIterator(&lineIter);
+  naRelease(buffer);
+}
+
+
+
+NA_HIDEF void na_ClearBenchmarkBaseline(NABenchmarkBaseline* baseline){
+  naDelete(baseline->name);
+}
+
+
+
+NA_HDEF const NABenchmarkBaseline* na_FindBenchmarkBaseline(const NAString* name){
+  size_t count = naGetStackCount(&(na_Testing->benchmarkBaselines));
+  for(size_t i = 0; i < count; i++){
+    const NABenchmarkBaseline* baseline = naPeekStack(&(na_Testing->benchmarkBaselines), i);
+    if(naEqualStringToString(baseline->name, name, NA_TRUE)){return baseline;}
+  }
+  return NA_NULL;
+}
+
+
+
+#if NA_BENCHMARK_COUNTERS_AVAILABLE
+
+NA_HIDEF void na_InitBenchmarkCounterAttributes(struct perf_event_attr* attr, NABenchmarkCounter counter){
+  memset(attr, 0, sizeof(struct perf_event_attr));
+  attr->size = sizeof(struct perf_event_attr);
+  switch(counter){
+  case NA_BENCHMARK_COUNTER_CYCLES:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case NA_BENCHMARK_COUNTER_INSTRUCTIONS:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case NA_BENCHMARK_COUNTER_L1D_MISSES:
+    attr->type = PERF_TYPE_HW_CACHE;
+    attr->config = PERF_COUNT_HW_CACHE_L1D
+      | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+      | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    break;
+  case NA_BENCHMARK_COUNTER_LLC_MISSES:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_CACHE_MISSES;
+    break;
+  default:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+    break;
+  }
+  // Only the benchmarked code is counted, not the kernel. This is allowed
+  // for unprivileged processes with the default perf_event_paranoid level.
+  attr->exclude_kernel = 1;
+  attr->exclude_hv = 1;
+  attr->read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+}
+
+#endif
+
+
+
+// Opens the hardware performance counters. Counters not supported by the
+// processor or the system are left out. Returns false if not a single one
+// is available, in which case the benchmarks run without counters.
+NA_HDEF NABool na_OpenBenchmarkCounters(){
+  size_t openCount = 0;
+  na_Testing->benchmarkCounterLeader = -1;
+  for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+    na_Testing->benchmarkCounterFds[i] = -1;
+    na_Testing->benchmarkCounterIndices[i] = -1;
+  }
+
+  #if NA_BENCHMARK_COUNTERS_AVAILABLE
+    int lastErrno = 0;
+    for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+      struct perf_event_attr attr;
+      na_InitBenchmarkCounterAttributes(&attr, (NABenchmarkCounter)i);
+      // The leader starts disabled and enables all counters of the group.
+      attr.disabled = (na_Testing->benchmarkCounterLeader == -1);
+      int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, na_Testing->benchmarkCounterLeader, 0);
+      if(fd == -1){
+        lastErrno = errno;
+        continue;
+      }
+      if(na_Testing->benchmarkCounterLeader == -1){
+        na_Testing->benchmarkCounterLeader = fd;
+      }
+      na_Testing->benchmarkCounterFds[i] = fd;
+      na_Testing->benchmarkCounterIndices[i] = (int)openCount;
+      openCount++;
+    }
+
+    if(!openCount){
+      printf("Hardware performance counters not available, perf_event_open failed: %s" NA_NL, strerror(lastErrno));
+      if(lastErrno == EACCES || lastErrno == EPERM){
+        printf("Access might be restricted by /proc/sys/kernel/perf_event_paranoid." NA_NL);
+      }else if(lastErrno == ENOENT || lastErrno == ENODEV || lastErrno == EOPNOTSUPP){
+        printf("The system does not expose hardware counters, which is common in virtual machines." NA_NL);
+      }
+      printf("Benchmarks run without counters." NA_NL);
+    }else if(openCount < NA_BENCHMARK_COUNTER_COUNT){
+      printf("Hardware performance counters not available:");
+      for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+        if(na_Testing->benchmarkCounterIndices[i] == -1){
+          printf(" %s", na_BenchmarkCounterNames[i]);
+        }
+      }
+      printf(NA_NL);
+    }
+  #else
+    printf("Hardware performance counters are only available on Linux." NA_NL);
+  #endif
+
+  return openCount > 0;
+}
+
+
+
+NA_HDEF void na_CloseBenchmarkCounters(){
+  #if NA_BENCHMARK_COUNTERS_AVAILABLE
+    // The group members are closed before the leader.
+    for(int i = NA_BENCHMARK_COUNTER_COUNT - 1; i >= 0; i--){
+      if(na_Testing->benchmarkCounterFds[i] != -1){
+        close(na_Testing->benchmarkCounterFds[i]);
+        na_Testing->benchmarkCounterFds[i] = -1;
+      }
+    }
+  #endif
+  na_Testing->benchmarkCountersEnabled = NA_FALSE;
+}
+
+
+
+// Prepares the workers executing test groups in parallel. A count of zero
+// or less means one worker per processor.
+NA_HDEF void na_InitTestWorkers(int count){
+  #if NA_OS != NA_OS_WINDOWS
+    if(na_Testing->testWorkers){return;}
+    if(count <= 0){
+      count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if(count > 1){
+      na_Testing->testWorkers = naMalloc((size_t)count * sizeof(NATestWorker));
+      for(int i = 0; i < count; i++){
+        na_Testing->testWorkers[i].pid = 0;
+      }
+      na_Testing->testWorkerCount = count;
+    }
+  #else
+    NA_UNUSED(count);
+    printf("Parallel testing is not available on this system." NA_NL);
+  #endif
+}
+
+
+
 NA_DEF NABool naStartTesting(const NAUTF8Char* rootName, double timePerBenchmark, NABool printAllGroups, int argc, const char** argv){
 #if NA_DEBUG
   if(na_Testing)
@@ -200,6 +651,7 @@ NA_DEF NABool naStartTesting(const NAUTF8Char* rootName, double timePerBenchmark
   na_Testing->timePerBenchmark = timePerBenchmark;
   na_Testing->printAllTestGroups = printAllGroups;
   na_Testing->letCrashTestsCrash = NA_FALSE;
+  na_Testing->benchmarksEnabled = NA_FALSE;
   na_Testing->testingStartSuccessful = NA_FALSE;
   na_SetTestCaseRunning(NA_FALSE);
   na_ResetErrorCount();
@@ -211,12 +663,58 @@ NA_DEF NABool naStartTesting(const NAUTF8Char* rootName, double timePerBenchmark
   naInitStack(&(na_Testing->untestedStrings), sizeof(NAString*), 0, 0);
   naInitList(&(na_Testing->testRestriction));
 
+  #if NA_OS == NA_OS_WINDOWS
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    na_Testing->timerFrequency = (double)frequency.QuadPart;
+  #endif
+  na_Testing->benchmarkOutFile = NA_NULL;
+  na_Testing->benchmarkOutJSON = NA_FALSE;
+  na_Testing->benchmarkOutCount = 0;
+  naInitStack(&(na_Testing->benchmarkBaselines), sizeof(NABenchmarkBaseline), 0, 0);
+  na_Testing->benchmarkRegressionCount = 0;
+  na_Testing->benchmarkCountersEnabled = NA_FALSE;
+  na_Testing->benchmarkCounterLeader = -1;
+  for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+    na_Testing->benchmarkCounterFds[i] = -1;
+    na_Testing->benchmarkCounterIndices[i] = -1;
+  }
+  na_Testing->benchmarkGroupDepth = 0;
+  na_Testing->benchmarkPinned = NA_FALSE;
+  na_Testing->testWorkerCount = 1;
+  #if NA_OS != NA_OS_WINDOWS
+    na_Testing->testWorkers = NA_NULL;
+    na_Testing->workerTestData = NA_NULL;
+    na_Testing->workerResultFile = NA_NULL;
+    na_Testing->workerUntestedStart = 0;
+    naInitStack(&(na_Testing->workerNames), sizeof(NAString*), 0, 0);
+  #endif
+
   if(argc > 1){
     for(int i = 1; i < argc; i++)
     {
       if(argv[i][0] == '-'){
         if(argv[i][1] == 'C'){
           na_Testing->letCrashTestsCrash = NA_TRUE;
+        }else if(argv[i][1] == 'P'){
+          na_Testing->benchmarksEnabled = NA_TRUE;
+        }else if(argv[i][1] == 'H'){
+          if(!na_Testing->benchmarkCountersEnabled){
+            na_Testing->benchmarkCountersEnabled = na_OpenBenchmarkCounters();
+          }
+        }else if((argv[i][1] == 'O' || argv[i][1] == 'B') && i + 1 == argc){
+          printf("Missing path for executable argument: %c" NA_NL, argv[i][1]);
+        }else if(argv[i][1] == 'J' && i + 1 == argc){
+          printf("Missing worker count for executable argument: %c" NA_NL, argv[i][1]);
+        }else if(argv[i][1] == 'O'){
+          i++;
+          na_OpenBenchmarkOutput(argv[i]);
+        }else if(argv[i][1] == 'B'){
+          i++;
+          na_LoadBenchmarkBaselines(argv[i]);
+        }else if(argv[i][1] == 'J'){
+          i++;
+          na_InitTestWorkers(atoi(argv[i]));
         }else{
           printf("Unrecognized executable argument: %c" NA_NL, argv[i][1]);
         }
@@ -250,7 +748,7 @@ NA_DEF NABool naStartTesting(const NAUTF8Char* rootName, double timePerBenchmark
           FILE_ATTRIBUTE_NORMAL,
           NULL );
     naFree(systemCrashLogPath);
-  #elif NA_OS == NA_OS_MAC_OS_X
+  #else
     na_Testing->logFile = naCreateFileWritingPath(naGetStringUTF8Pointer(crashLogPath), NA_FILEMODE_DEFAULT);
   #endif
 
@@ -279,9 +777,30 @@ NA_DEF void naStopTesting(){
         na_PrintTestGroup(na_Testing->rootTestData);
       }
     }
+    if(naGetStackCount(&(na_Testing->benchmarkBaselines))){
+      printf("Benchmark regressions against baseline: %d" NA_NL, na_Testing->benchmarkRegressionCount);
+    }
     printf("Testing finished." NA_NL NA_NL);
   }
 
+  if(na_Testing->benchmarkOutFile){
+    if(na_Testing->benchmarkOutJSON){
+      na_WriteBenchmarkOutput(naNewStringWithFormat("\n]\n"));
+    }
+    naReleaseFile(na_Testing->benchmarkOutFile);
+  }
+  naForeachStackMutable(&(na_Testing->benchmarkBaselines), (NAMutator)na_ClearBenchmarkBaseline);
+  naClearStack(&(na_Testing->benchmarkBaselines));
+  na_CloseBenchmarkCounters();
+
+  #if NA_OS != NA_OS_WINDOWS
+    if(na_Testing->testWorkers){
+      naFree(na_Testing->testWorkers);
+    }
+    naForeachStackpMutable(&(na_Testing->workerNames), (NAMutator)naDelete);
+    naClearStack(&(na_Testing->workerNames));
+  #endif
+
   na_ClearTestingData(na_Testing->rootTestData);
   naFree(na_Testing->rootTestData);
   naForeachStackpMutable(&(na_Testing->untestedStrings), (NAMutator)naDelete);
@@ -293,7 +812,7 @@ NA_DEF void naStopTesting(){
 
   #if NA_OS == NA_OS_WINDOWS
     CloseHandle(na_Testing->logFile);
-  #elif NA_OS == NA_OS_MAC_OS_X
+  #else
     naReleaseFile(na_Testing->logFile);
   #endif
 
@@ -467,7 +986,7 @@ NA_HDEF void na_ExecuteCrashProcess(const char* expr, int lineNum){
     naDelete(testPath);
     naDelete(commandPath);
   
-  #elif NA_OS == NA_OS_MAC_OS_X
+  #else
 
     int oldStdOut = dup(1);
     close(1); //Close stdout
@@ -539,8 +1058,9 @@ NA_HDEF void na_ExecuteCrashProcess(const char* expr, int lineNum){
 //      close(oldStdErr);
 
     }else{
+      // Only wait for this very process, as test workers may exit meanwhile.
       int exitCode;
-      wait(&exitCode);
+      waitpid(childPid, &exitCode, 0);
 
       // Revert the file descriptors
       close(1);
@@ -563,6 +1083,8 @@ NA_HDEF void na_ExecuteCrashProcess(const char* expr, int lineNum){
     naDelete(modulePath);
 
   #endif
+
+  naIterateListBack(&(na_Testing->restrictionIt));
 }
 
 
@@ -610,6 +1132,12 @@ NA_HDEF NABool na_LetCrashTestCrash(){
 
 
 
+NA_HDEF NABool na_GetBenchmarksEnabled(){
+  return na_Testing->benchmarksEnabled;
+}
+
+
+
 NA_HDEF NABool na_ShallExecuteGroup(const char* name){
   const NAString* allowedGroup = naGetListCurConst(&(na_Testing->restrictionIt));
   NABool shallExecute =
@@ -629,6 +1157,243 @@ NA_HDEF NABool na_ShallExecuteGroup(const char* name){
 
 
 
+#if NA_OS != NA_OS_WINDOWS
+
+NA_HDEF void na_WriteTestRecord(FILE* file, NATestRecordType type, int lineNum, NABool success, const char* text){
+  NATestRecord record;
+  record.type = (int32)type;
+  record.lineNum = (int32)lineNum;
+  record.success = (int32)success;
+  record.textLength = (uint32)naStrlen(text);
+  fwrite(&record, sizeof(NATestRecord), 1, file);
+  if(record.textLength){
+    fwrite(text, 1, record.textLength, file);
+  }
+}
+
+
+
+NA_HDEF void na_WriteTestRecords(FILE* file, const NATestData* testData){
+  NAStackIterator iter = naMakeStackAccessor(&(testData->childs));
+  while(naIterateStack(&iter)){
+    const NATestData* childData = naGetStackCurConst(&iter);
+    if(childData->isGroup){
+      na_WriteTestRecord(file, NA_TEST_RECORD_GROUP, childData->lineNum, childData->success, childData->name);
+      na_WriteTestRecords(file, childData);
+      na_WriteTestRecord(file, NA_TEST_RECORD_GROUP_END, 0, NA_TRUE, "");
+    }else{
+      na_WriteTestRecord(file, NA_TEST_RECORD_TEST, childData->lineNum, childData->success, childData->name);
+    }
+  }
+  naClearStackIterator(&iter);
+}
+
+
+
+// Adds the results of a worker to the given test data the same way as if
+// the tests had been executed in this process.
+NA_HDEF void na_ReadTestRecords(FILE* file, NATestData* testData){
+  NATestRecord record;
+  while(fread(&record, sizeof(NATestRecord), 1, file) == 1){
+    if(record.type == NA_TEST_RECORD_GROUP_END){return;}
+
+    NAUTF8Char* text = naMalloc((size_t)record.textLength + 1);
+    text[fread(text, 1, record.textLength, file)] = '\0';
+    NAString* textString = naNewStringWithFormat("%s", text);
+    naFree(text);
+
+    if(record.type == NA_TEST_RECORD_UNTESTED){
+      NAString** string = naPushStack(&(na_Testing->untestedStrings));
+      *string = textString;
+      continue;
+    }
+
+    // The names are referenced by the test data and kept until testing
+    // stops.
+    NAString** name = naPushStack(&(na_Testing->workerNames));
+    *name = textString;
+
+    NATestData* childData = naPushStack(&(testData->childs));
+    na_InitTestingData(childData, naGetStringUTF8Pointer(textString), testData, record.lineNum);
+    if(record.type == NA_TEST_RECORD_GROUP){
+      childData->isGroup = NA_TRUE;
+      testData->childSuccessCount++;
+      na_ReadTestRecords(file, childData);
+    }else{
+      childData->success = (NABool)record.success;
+      na_UpdateTestParentLeaf(testData, childData->success);
+    }
+  }
+}
+
+
+
+NA_HDEF void na_CollectTestWorker(NATestWorker* worker, int status){
+  // Print everything the worker printed in one piece.
+  char buffer[4096];
+  size_t readCount;
+  fflush(stdout);
+  rewind(worker->outputFile);
+  while((readCount = fread(buffer, 1, sizeof(buffer), worker->outputFile))){
+    fwrite(buffer, 1, readCount, stdout);
+  }
+
+  if(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS){
+    rewind(worker->resultFile);
+    na_ReadTestRecords(worker->resultFile, worker->testData);
+  }else{
+    // The results of the worker are lost. Mark the whole group as failed.
+    NATestData* testData = worker->testData;
+    NATestData* childData = naPushStack(&(testData->childs));
+    na_InitTestingData(childData, "Worker", testData, testData->lineNum);
+    childData->success = NA_FALSE;
+    na_UpdateTestParentLeaf(testData, NA_FALSE);
+    printf("  ");
+    na_PrintTestName(testData);
+    printf(" Line %d: Worker process terminated unexpectedly" NA_NL, testData->lineNum);
+    na_PrintTestGroup(testData);
+  }
+
+  fclose(worker->outputFile);
+  fclose(worker->resultFile);
+  worker->pid = 0;
+}
+
+
+
+// Waits until any worker exits. Returns false if there is none.
+NA_HDEF NABool na_WaitForTestWorker(){
+  while(NA_TRUE){
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if(pid == -1){
+      if(errno == EINTR){continue;}
+      return NA_FALSE;
+    }
+    for(int i = 0; i < na_Testing->testWorkerCount; i++){
+      NATestWorker* worker = &(na_Testing->testWorkers[i]);
+      if(worker->pid == pid){
+        na_CollectTestWorker(worker, status);
+        return NA_TRUE;
+      }
+    }
+  }
+}
+
+
+
+NA_HDEF void na_WaitForAllTestWorkers(){
+  if(!na_Testing->testWorkers){return;}
+  for(int i = 0; i < na_Testing->testWorkerCount; i++){
+    while(na_Testing->testWorkers[i].pid){
+      if(!na_WaitForTestWorker()){
+        na_Testing->testWorkers[i].pid = 0;
+      }
+    }
+  }
+}
+
+
+
+NA_HDEF NATestWorker* na_GetFreeTestWorker(){
+  while(NA_TRUE){
+    for(int i = 0; i < na_Testing->testWorkerCount; i++){
+      if(!na_Testing->testWorkers[i].pid){
+        return &(na_Testing->testWorkers[i]);
+      }
+    }
+    if(!na_WaitForTestWorker()){
+      return NA_NULL;
+    }
+  }
+}
+
+
+
+NA_HDEF NABool na_ShallDispatchTestGroup(const NATestData* testData){
+  if(!na_Testing->testWorkers
+    || na_Testing->workerTestData
+    || na_Testing->benchmarkGroupDepth){
+    return NA_FALSE;
+  }
+  int depth = 0;
+  while(testData->parent){
+    depth++;
+    testData = testData->parent;
+  }
+  return depth == NA_TEST_WORKER_GROUP_DEPTH;
+}
+
+
+
+// Forks a worker executing the given group. Returns true in the calling
+// process if the worker started and false in the worker itself or if no
+// worker could be started, in which case the group is executed right away.
+NA_HDEF NABool na_DispatchTestGroup(NATestData* testData){
+  NATestWorker* worker = na_GetFreeTestWorker();
+  if(!worker){return NA_FALSE;}
+
+  FILE* outputFile = tmpfile();
+  FILE* resultFile = tmpfile();
+  if(!outputFile || !resultFile){
+    if(outputFile){fclose(outputFile);}
+    if(resultFile){fclose(resultFile);}
+    return NA_FALSE;
+  }
+
+  // Anything still buffered would otherwise be printed by the worker too.
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+
+  if(pid == -1){
+    fclose(outputFile);
+    fclose(resultFile);
+    return NA_FALSE;
+  }else if(!pid){
+    dup2(fileno(outputFile), 1);
+    dup2(fileno(outputFile), 2);
+    fclose(outputFile);
+    // The counters inherited from the parent count the parent. Benchmarks
+    // within the group need counters of the worker.
+    if(na_Testing->benchmarkCountersEnabled){
+      na_CloseBenchmarkCounters();
+      na_Testing->benchmarkCountersEnabled = na_OpenBenchmarkCounters();
+    }
+    na_Testing->workerTestData = testData;
+    na_Testing->workerResultFile = resultFile;
+    na_Testing->workerUntestedStart = naGetStackCount(&(na_Testing->untestedStrings));
+    return NA_FALSE;
+  }
+
+  worker->pid = pid;
+  worker->testData = testData;
+  worker->outputFile = outputFile;
+  worker->resultFile = resultFile;
+  return NA_TRUE;
+}
+
+
+
+// Called in the worker once its group is complete. Never returns.
+NA_HDEF void na_FinishTestWorker(){
+  FILE* file = na_Testing->workerResultFile;
+  na_WriteTestRecords(file, na_Testing->workerTestData);
+  size_t untestedCount = naGetStackCount(&(na_Testing->untestedStrings));
+  for(size_t i = na_Testing->workerUntestedStart; i < untestedCount; i++){
+    const NAString* string = *(const NAString**)naPeekStack(&(na_Testing->untestedStrings), i);
+    na_WriteTestRecord(file, NA_TEST_RECORD_UNTESTED, 0, NA_TRUE, naGetStringUTF8Pointer(string));
+  }
+  fclose(file);
+  fflush(stdout);
+  fflush(stderr);
+  _exit(EXIT_SUCCESS);
+}
+
+#endif
+
+
+
 NA_HDEF NABool na_StartTestGroup(const char* name, int lineNum){
   #if NA_DEBUG
   if(!na_Testing)
@@ -640,8 +1405,19 @@ NA_HDEF NABool na_StartTestGroup(const char* name, int lineNum){
   {
     NATestData* testData = naPushStack(&(na_Testing->curTestData->childs));
     na_InitTestingData(testData, name, na_Testing->curTestData, lineNum);
+    testData->isGroup = NA_TRUE;
     na_Testing->curTestData->childSuccessCount++;
     na_Testing->curTestData = testData;
+
+    #if NA_OS != NA_OS_WINDOWS
+      if(na_ShallDispatchTestGroup(testData) && na_DispatchTestGroup(testData)){
+        // The group is executed by a worker. Its results are added as soon
+        // as the worker exits.
+        na_Testing->curTestData = testData->parent;
+        naIterateListBack(&(na_Testing->restrictionIt));
+        shallExecute = NA_FALSE;
+      }
+    #endif
   }
   return shallExecute;
 }
@@ -654,15 +1430,84 @@ NA_HDEF void na_StopTestGroup(){
     naError("Testing not running. Use naStartTesting.");
   #endif
 
+  #if NA_OS != NA_OS_WINDOWS
+    // The results of all groups within this group must be complete.
+    na_WaitForAllTestWorkers();
+  #endif
+
   if(na_Testing->printAllTestGroups || !na_Testing->curTestData->success){
     na_PrintTestGroup(na_Testing->curTestData);
   }
+
+  #if NA_OS != NA_OS_WINDOWS
+    if(na_Testing->curTestData == na_Testing->workerTestData){
+      na_FinishTestWorker();
+    }
+  #endif
+
   na_Testing->curTestData = na_Testing->curTestData->parent;
   naIterateListBack(&(na_Testing->restrictionIt));
 }
 
 
 
+// While testing in parallel, the benchmarks run on the last processor
+// available, as it usually serves the fewest interrupts.
+NA_HDEF void na_PinBenchmarks(NABool pin){
+  #if NA_BENCHMARK_PINNING_AVAILABLE
+    unsigned long* mask = na_Testing->benchmarkCpuMask;
+    if(pin){
+      if(na_Testing->testWorkerCount <= 1){return;}
+      long byteSize = syscall(SYS_sched_getaffinity, 0, sizeof(na_Testing->benchmarkCpuMask), mask);
+      if(byteSize <= 0){return;}
+      size_t bitsPerMask = sizeof(unsigned long) * 8;
+      unsigned long pinMask[NA_BENCHMARK_CPU_MASK_COUNT] = {0};
+      for(long cpu = byteSize * 8 - 1; cpu >= 0; cpu--){
+        if(mask[cpu / bitsPerMask] & (1UL << (cpu % bitsPerMask))){
+          pinMask[cpu / bitsPerMask] = 1UL << (cpu % bitsPerMask);
+          na_Testing->benchmarkPinned = syscall(SYS_sched_setaffinity, 0, sizeof(pinMask), pinMask) == 0;
+          break;
+        }
+      }
+    }else if(na_Testing->benchmarkPinned){
+      syscall(SYS_sched_setaffinity, 0, sizeof(na_Testing->benchmarkCpuMask), mask);
+      na_Testing->benchmarkPinned = NA_FALSE;
+    }
+  #else
+    NA_UNUSED(pin);
+  #endif
+}
+
+
+
+NA_HDEF NABool na_StartBenchmarkGroup(const char* name, int lineNum){
+  #if NA_OS != NA_OS_WINDOWS
+    // Benchmarks shall not be disturbed by tests running in parallel.
+    na_WaitForAllTestWorkers();
+  #endif
+
+  na_Testing->benchmarkGroupDepth++;
+  NABool shallExecute = na_StartTestGroup(name, lineNum);
+  if(!shallExecute){
+    na_Testing->benchmarkGroupDepth--;
+  }else if(na_Testing->benchmarkGroupDepth == 1){
+    na_PinBenchmarks(NA_TRUE);
+  }
+  return shallExecute;
+}
+
+
+
+NA_HDEF void na_StopBenchmarkGroup(){
+  na_StopTestGroup();
+  na_Testing->benchmarkGroupDepth--;
+  if(!na_Testing->benchmarkGroupDepth){
+    na_PinBenchmarks(NA_FALSE);
+  }
+}
+
+
+
 NA_HDEF uint32 na_GetBenchmarkIn(){
   na_Testing->curInIndex = (na_Testing->curInIndex + 1) & NA_TEST_INDEX_MASK;
   return na_Testing->in[na_Testing->curInIndex];
@@ -672,16 +1517,63 @@ NA_HDEF uint32 na_GetBenchmarkIn(){
 
 NA_HDEF double na_BenchmarkTime(){
   // Note: Reimplemented here because NADateTime uses int64 to compute.
+  // The clock is monotonic and not affected by changes of the system time.
   #if NA_OS == NA_OS_WINDOWS
-    FILETIME fileTime;
-    GetSystemTimeAsFileTime(&fileTime);
-    fileTime.dwLowDateTime;
-    return fileTime.dwLowDateTime / 10000000.;  // see definition of dwLowDateDime
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / na_Testing->timerFrequency;
   #else
-    struct timeval curtime;
-    struct timezone curTimeZone;
-    gettimeofday(&curtime, &curTimeZone);
-    return curtime.tv_sec + curtime.tv_usec / 1000000.;
+    struct timespec curTime;
+    clock_gettime(CLOCK_MONOTONIC, &curTime);
+    return (double)curTime.tv_sec + (double)curTime.tv_nsec * .000000001;
+  #endif
+}
+
+
+
+NA_HDEF double na_BenchmarkCycles(){
+  // The time stamp counter of x86 processors. Note that modern processors
+  // count with a constant rate which may differ from the current core clock.
+  #if NA_BENCHMARK_CYCLES_AVAILABLE
+    return (double)__rdtsc();
+  #else
+    return 0.;
+  #endif
+}
+
+
+
+NA_HDEF void na_StartBenchmarkCounters(){
+  #if NA_BENCHMARK_COUNTERS_AVAILABLE
+    if(na_Testing->benchmarkCountersEnabled){
+      ioctl(na_Testing->benchmarkCounterLeader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(na_Testing->benchmarkCounterLeader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+  #endif
+}
+
+
+
+NA_HDEF void na_StopBenchmarkCounters(){
+  #if NA_BENCHMARK_COUNTERS_AVAILABLE
+    if(na_Testing->benchmarkCountersEnabled){
+      ioctl(na_Testing->benchmarkCounterLeader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+      // The group is read as the number of counters, the time enabled, the
+      // time running and all counter values. If the processor had to share
+      // its counters with other groups, the values are extrapolated.
+      uint64 values[3 + NA_BENCHMARK_COUNTER_COUNT];
+      ssize_t byteSize = read(na_Testing->benchmarkCounterLeader, values, sizeof(values));
+      double scale = (byteSize >= (ssize_t)(3 * sizeof(uint64)) && values[2])
+        ? (double)values[1] / (double)values[2]
+        : 0.;
+      for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+        int index = na_Testing->benchmarkCounterIndices[i];
+        na_Testing->benchmarkCounterDiffs[i] = (index != -1 && (uint64)index < values[0])
+          ? (double)values[3 + index] * scale
+          : 0.;
+      }
+    }
   #endif
 }
 
@@ -699,20 +1591,226 @@ NA_HDEF size_t na_GetBenchmarkTestSizeLimit(){
 
 
 
-NA_HDEF void na_PrintBenchmark(double timeDiff, size_t testSize, const char* exprString, int lineNum){
-  if(timeDiff < na_GetBenchmarkLimit() || testSize >= naPowerOf2s(na_GetBenchmarkTestSizeLimit())){
-      printf("Line %d: Immeasurable   : %s" NA_NL, lineNum, exprString);
+NA_HDEF size_t na_StartBenchmark(){
+  #if NA_DEBUG
+  if(!na_Testing)
+    naError("Testing not running. Use naStartTesting.");
+  #endif
+
+  na_Testing->benchmarkTestSize = 1;
+  na_Testing->benchmarkWarmingUp = NA_TRUE;
+  na_Testing->benchmarkSampleCount = 0;
+  return na_Testing->benchmarkTestSize;
+}
+
+
+
+NA_HDEF size_t na_AddBenchmarkSample(double timeDiff, double cycleDiff){
+  if(na_Testing->benchmarkWarmingUp){
+    // The batch size is doubled until one batch takes as long as a sample
+    // shall take. All runs up to then warm up the caches and the branch
+    // predictor and are not measured.
+    if(timeDiff >= na_GetBenchmarkLimit() / NA_BENCHMARK_SAMPLE_COUNT){
+      na_Testing->benchmarkWarmingUp = NA_FALSE;
+    }else if(na_Testing->benchmarkTestSize >= naPowerOf2s(na_GetBenchmarkTestSizeLimit())){
+      // Probably, the expression has been optimized away.
+      return 0;
+    }else{
+      na_Testing->benchmarkTestSize <<= 1;
+    }
+    return na_Testing->benchmarkTestSize;
+  }
+
+  size_t sampleIndex = na_Testing->benchmarkSampleCount;
+  na_Testing->benchmarkTimes[sampleIndex] = timeDiff / (double)na_Testing->benchmarkTestSize;
+  na_Testing->benchmarkCycles[sampleIndex] = cycleDiff / (double)na_Testing->benchmarkTestSize;
+  for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+    na_Testing->benchmarkCounters[i][sampleIndex] = na_Testing->benchmarkCounterDiffs[i] / (double)na_Testing->benchmarkTestSize;
+  }
+  na_Testing->benchmarkSampleCount++;
+  return (na_Testing->benchmarkSampleCount < NA_BENCHMARK_SAMPLE_COUNT)
+    ? na_Testing->benchmarkTestSize
+    : 0;
+}
+
+
+
+NA_HIDEF int na_CompareBenchmarkValues(const void* a, const void* b){
+  double value1 = *(const double*)a;
+  double value2 = *(const double*)b;
+  return (value1 > value2) - (value1 < value2);
+}
+
+
+
+// Linearly interpolates between the two nearest values of a sorted array.
+NA_HIDEF double na_GetBenchmarkQuantile(const double* values, size_t count, double quantile){
+  double pos = quantile * (double)(count - 1);
+  size_t index = (size_t)pos;
+  if(index + 1 >= count){return values[count - 1];}
+  return values[index] + (pos - (double)index) * (values[index + 1] - values[index]);
+}
+
+
+
+NA_HIDEF NABool na_IsBenchmarkCounterMeasured(NABenchmarkCounter counter){
+  return na_Testing->benchmarkCountersEnabled
+    && na_Testing->benchmarkCounterIndices[counter] != -1;
+}
+
+
+
+NA_HDEF void na_WriteBenchmarkResult(const NAString* name, int lineNum, double median, double p95, double mad, double cycles, const double* counters){
+  size_t testSize = na_Testing->benchmarkTestSize;
+  int sampleCount = (int)na_Testing->benchmarkSampleCount;
+
+  if(na_Testing->benchmarkOutJSON){
+    NAString* nameString = na_NewBenchmarkJSONString(name);
+    NAString* cyclesString = NA_BENCHMARK_CYCLES_AVAILABLE
+      ? naNewStringWithFormat("%.3f", cycles)
+      : naNewStringWithFormat("null");
+    NAString* countersString = naNewString();
+    for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+      if(na_IsBenchmarkCounterMeasured((NABenchmarkCounter)i)){
+        naAppendStringFormat(countersString, ", \"%s\": %.3f", na_BenchmarkCounterFieldNames[i], counters[i]);
+      }else{
+        naAppendStringFormat(countersString, ", \"%s\": null", na_BenchmarkCounterFieldNames[i]);
+      }
+    }
+    na_WriteBenchmarkOutput(naNewStringWithFormat(
+      "%s\n  {\"name\": %s, \"line\": %d, \"median_ns\": %.3f, \"p95_ns\": %.3f, \"mad_ns\": %.3f, \"cycles_per_op\": %s%s, \"runs_per_sample\": %zu, \"samples\": %d}",
+      na_Testing->benchmarkOutCount ? "," : "",
+      naGetStringUTF8Pointer(nameString),
+      lineNum,
+      median * 1000000000.,
+      p95 * 1000000000.,
+      mad * 1000000000.,
+      naGetStringUTF8Pointer(cyclesString),
+      naGetStringUTF8Pointer(countersString),
+      testSize,
+      sampleCount));
+    naDelete(countersString);
+    naDelete(cyclesString);
+    naDelete(nameString);
   }else{
-    double execsPerSec = testSize / timeDiff;
-    if(execsPerSec > 1000000000.)
-      printf("Line %d: %6.2f G : %s" NA_NL, lineNum, execsPerSec * .000000001, exprString);
-    else if(execsPerSec > 1000000.)
-      printf("Line %d: %6.2f M : %s" NA_NL, lineNum, execsPerSec * .000001, exprString);
-    else if(execsPerSec > 1000.)
-      printf("Line %d: %6.2f k : %s" NA_NL, lineNum, execsPerSec * .001, exprString);
-    else
-      printf("Line %d: %6.2f   : %s" NA_NL, lineNum, execsPerSec, exprString);
+    NAString* nameString = na_NewBenchmarkCSVField(name);
+    NAString* cyclesString = NA_BENCHMARK_CYCLES_AVAILABLE
+      ? naNewStringWithFormat("%.3f", cycles)
+      : naNewString();
+    NAString* countersString = naNewString();
+    for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+      if(na_IsBenchmarkCounterMeasured((NABenchmarkCounter)i)){
+        naAppendStringFormat(countersString, ",%.3f", counters[i]);
+      }else{
+        naAppendStringFormat(countersString, ",");
+      }
+    }
+    na_WriteBenchmarkOutput(naNewStringWithFormat(
+      "%.3f,%.3f,%.3f,%s%s,%zu,%d,%d,%s\n",
+      median * 1000000000.,
+      p95 * 1000000000.,
+      mad * 1000000000.,
+      naGetStringUTF8Pointer(cyclesString),
+      naGetStringUTF8Pointer(countersString),
+      testSize,
+      sampleCount,
+      lineNum,
+      naGetStringUTF8Pointer(nameString)));
+    naDelete(countersString);
+    naDelete(cyclesString);
+    naDelete(nameString);
+  }
+  na_Testing->benchmarkOutCount++;
+}
+
+
+
+NA_HDEF void na_StopBenchmark(const char* exprString, int lineNum){
+  size_t sampleCount = na_Testing->benchmarkSampleCount;
+  double* times = na_Testing->benchmarkTimes;
+  double* cycles = na_Testing->benchmarkCycles;
+  double deviations[NA_BENCHMARK_SAMPLE_COUNT];
+
+  if(!sampleCount){
+    printf("Line %d: Immeasurable   : %s" NA_NL, lineNum, exprString);
+    return;
+  }
+
+  qsort(times, sampleCount, sizeof(double), na_CompareBenchmarkValues);
+  qsort(cycles, sampleCount, sizeof(double), na_CompareBenchmarkValues);
+  double median = na_GetBenchmarkQuantile(times, sampleCount, .5);
+  double p95 = na_GetBenchmarkQuantile(times, sampleCount, .95);
+  double cyclesMedian = na_GetBenchmarkQuantile(cycles, sampleCount, .5);
+  for(size_t i = 0; i < sampleCount; i++){
+    deviations[i] = naAbs(times[i] - median);
+  }
+  qsort(deviations, sampleCount, sizeof(double), na_CompareBenchmarkValues);
+  double mad = na_GetBenchmarkQuantile(deviations, sampleCount, .5);
+  double counterMedians[NA_BENCHMARK_COUNTER_COUNT];
+  for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+    qsort(na_Testing->benchmarkCounters[i], sampleCount, sizeof(double), na_CompareBenchmarkValues);
+    counterMedians[i] = na_GetBenchmarkQuantile(na_Testing->benchmarkCounters[i], sampleCount, .5);
+  }
+
+  if(median <= 0.){
+    printf("Line %d: Immeasurable   : %s" NA_NL, lineNum, exprString);
+    return;
+  }
+
+  double execsPerSec = 1. / median;
+  if(execsPerSec > 1000000000.)
+    printf("Line %d: %6.2f G", lineNum, execsPerSec * .000000001);
+  else if(execsPerSec > 1000000.)
+    printf("Line %d: %6.2f M", lineNum, execsPerSec * .000001);
+  else if(execsPerSec > 1000.)
+    printf("Line %d: %6.2f k", lineNum, execsPerSec * .001);
+  else
+    printf("Line %d: %6.2f  ", lineNum, execsPerSec);
+  printf(" (%10.2f ns, p95 %10.2f ns, MAD %5.1f%%", median * 1000000000., p95 * 1000000000., mad / median * 100.);
+  if(NA_BENCHMARK_CYCLES_AVAILABLE){
+    printf(", %8.1f cycles", cyclesMedian);
+  }
+  printf(")");
+  if(na_Testing->benchmarkCountersEnabled){
+    const char* separator = " [";
+    for(int i = 0; i < NA_BENCHMARK_COUNTER_COUNT; i++){
+      if(na_IsBenchmarkCounterMeasured((NABenchmarkCounter)i)){
+        printf("%s%.1f %s", separator, counterMedians[i], na_BenchmarkCounterNames[i]);
+        separator = ", ";
+      }
+    }
+    if(na_IsBenchmarkCounterMeasured(NA_BENCHMARK_COUNTER_CYCLES)
+      && na_IsBenchmarkCounterMeasured(NA_BENCHMARK_COUNTER_INSTRUCTIONS)
+      && counterMedians[NA_BENCHMARK_COUNTER_CYCLES] > 0.){
+      printf(", %.2f IPC", counterMedians[NA_BENCHMARK_COUNTER_INSTRUCTIONS] / counterMedians[NA_BENCHMARK_COUNTER_CYCLES]);
+    }
+    printf("]");
+  }
+  printf(" : %s", exprString);
+
+  NAString* testPath = na_NewTestPath(na_Testing->curTestData, NA_FALSE);
+  NAString* name = naNewStringWithFormat("%s: %s", naGetStringUTF8Pointer(testPath), exprString);
+  naDelete(testPath);
+
+  const NABenchmarkBaseline* baseline = na_FindBenchmarkBaseline(name);
+  if(baseline && baseline->median > 0.){
+    double baselineMedian = baseline->median * .000000001;
+    double baselineMad = baseline->mad * .000000001;
+    double ratio = (median - baselineMedian) / baselineMedian;
+    double noise = 3. * NA_BENCHMARK_MAD_TO_SIGMA * naMax(mad, baselineMad);
+    if(ratio > NA_BENCHMARK_REGRESSION_RATIO && median - baselineMedian > noise){
+      printf("  REGRESSION %+.1f%%", ratio * 100.);
+      na_Testing->benchmarkRegressionCount++;
+    }else{
+      printf("  %+.1f%%", ratio * 100.);
+    }
+  }
+  printf(NA_NL);
+
+  if(na_Testing->benchmarkOutFile){
+    na_WriteBenchmarkResult(name, lineNum, median, p95, mad, cyclesMedian, counterMedians);
   }
+  naDelete(name);
 }
 
 
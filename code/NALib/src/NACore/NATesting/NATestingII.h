@@ -15,6 +15,7 @@
 #undef naTestGroupFunction
 #undef naUntested
 #undef naBenchmark
+#undef naBenchmarkGroupFunction
 #undef naTestIn
 
 
@@ -27,6 +28,8 @@ NA_HAPI void   na_AddTestCrash(const char* expr, int lineNum);
 NA_HAPI void   na_ExecuteCrashProcess(const char* expr, int lineNum);
 NA_HAPI NABool na_StartTestGroup(const char* name, int lineNum);
 NA_HAPI void   na_StopTestGroup(void);
+NA_HAPI NABool na_StartBenchmarkGroup(const char* name, int lineNum);
+NA_HAPI void   na_StopBenchmarkGroup(void);
 NA_HAPI void   na_RegisterUntested(const char* text);
 NA_HAPI NABool na_GetTestCaseRunning(void);
 NA_HAPI void   na_SetTestCaseRunning(NABool running);
@@ -35,12 +38,18 @@ NA_HAPI void   na_ResetErrorCount(void);
 NA_HAPI int    na_GetErrorCount(void);
 NA_HDEF NABool na_LetCrashTestCrash(void);
 NA_HAPI NABool na_ShallExecuteGroup(const char* name);
+NA_HAPI NABool na_GetBenchmarksEnabled(void);
 
 NA_HAPI uint32 na_GetBenchmarkIn(void);
 NA_HAPI double na_BenchmarkTime(void);
+NA_HAPI double na_BenchmarkCycles(void);
 NA_HAPI double na_GetBenchmarkLimit(void);
 NA_HAPI size_t na_GetBenchmarkTestSizeLimit(void);
-NA_HAPI void   na_PrintBenchmark(double timeDiff, size_t testSize, const char* exprString, int lineNum);
+NA_HAPI size_t na_StartBenchmark(void);
+NA_HAPI size_t na_AddBenchmarkSample(double timeDiff, double cycleDiff);
+NA_HAPI void   na_StopBenchmark(const char* exprString, int lineNum);
+NA_HAPI void   na_StartBenchmarkCounters(void);
+NA_HAPI void   na_StopBenchmarkCounters(void);
 NA_HAPI void   na_StoreBenchmarkResult(char);
 
 
@@ -120,29 +129,38 @@ NA_HAPI void   na_StoreBenchmarkResult(char);
 #define naUntested(text)\
   na_RegisterUntested(#text);
 
+// The batch size returned by na_StartBenchmark and na_AddBenchmarkSample
+// first grows while warming up and is then kept constant for all samples.
+// Zero means that the benchmark is complete.
 #define naBenchmark(expr)\
 {\
-  int testSize = 1;\
-  double timeDiff = 0;\
-  size_t pow;\
-  double startT = na_BenchmarkTime();\
-  double endT;\
-  for(pow = 0; pow < na_GetBenchmarkTestSizeLimit(); pow++){\
-    for(int testRun = 0; testRun < testSize; testRun++){\
+  size_t testSize = na_StartBenchmark();\
+  while(testSize){\
+    na_StartBenchmarkCounters();\
+    double startC = na_BenchmarkCycles();\
+    double startT = na_BenchmarkTime();\
+    for(size_t testRun = 0; testRun < testSize; testRun++){\
       /*na_StoreBenchmarkResult((char)(expr));*/\
       {\
         (void)expr; (void)0;\
       }\
     }\
-    endT = na_BenchmarkTime();\
-    timeDiff = endT - startT;\
-    if(timeDiff < 0.){timeDiff = 0; break;}\
-    if(timeDiff > na_GetBenchmarkLimit()){break;}\
-    testSize <<= 1;\
+    double timeDiff = na_BenchmarkTime() - startT;\
+    double cycleDiff = na_BenchmarkCycles() - startC;\
+    na_StopBenchmarkCounters();\
+    testSize = na_AddBenchmarkSample(timeDiff, cycleDiff);\
   }\
-  na_PrintBenchmark(timeDiff, testSize * 2, #expr, __LINE__);\
+  na_StopBenchmark(#expr, __LINE__);\
 }
 
+#define naBenchmarkGroupFunction(identifier)\
+  {\
+  if(na_GetBenchmarksEnabled() && na_StartBenchmarkGroup(#identifier, __LINE__)){\
+    benchmark ## identifier();\
+    na_StopBenchmarkGroup();\
+  }\
+  }
+
 #define naTestIn\
   na_GetBenchmarkIn()
 
@@ -164,6 +182,7 @@ NA_HAPI void   na_StoreBenchmarkResult(char);
 #define naTestGroupFunction(identifier)
 #define naUntested(text)
 #define naBenchmark(expr)
+#define naBenchmarkGroupFunction(identifier)
 #define naTestIn 0
 
 #endif // NA_TESTING_ENABLED == 1
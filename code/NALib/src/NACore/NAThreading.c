@@ -0,0 +1,511 @@
+
+#include "../NAThreading.h"
+
+
+
+// Number of rounds an idle worker keeps looking for tasks before going to
+// sleep. Sleeping workers are woken up by the alarm of the pool whenever a
+// new task is added. A trigger might get lost when a worker is about to go
+// to sleep exactly at that moment, hence the timeout.
+#define NA_THREAD_POOL_SPIN_ROUNDS      64
+#define NA_THREAD_POOL_IDLE_TIMEOUT     .005
+#define NA_THREAD_POOL_DEQUE_CAPACITY   256
+// Number of subranges per worker when naRunParallelFor chooses the grain.
+#define NA_PARALLEL_FOR_RANGES_PER_WORKER 8
+// Keeps the ends of a deque accessed by different threads on different
+// cache lines.
+#define NA_THREAD_POOL_CACHE_LINE_SIZE  64
+
+
+
+typedef struct NAThreadPoolTask NAThreadPoolTask;
+typedef struct NAWorkDequeArray NAWorkDequeArray;
+typedef struct NAWorkDeque NAWorkDeque;
+typedef struct NAThreadPoolWorker NAThreadPoolWorker;
+typedef struct NAParallelForRange NAParallelForRange;
+
+struct NAThreadPoolTask{
+  NAMutator function;
+  void* arg;
+  NATaskGroup* group;
+  NAThreadPoolTask* next;       // Only used in the shared queue.
+};
+
+// The array of a deque is replaced by one with double the capacity when
+// full. As thieves might still read from the old one, all previous arrays
+// are kept until the pool is deleted.
+struct NAWorkDequeArray{
+  NAInt capacity;               // Always a power of two.
+  void** tasks;
+  NAWorkDequeArray* previous;
+};
+
+// Work stealing deque after Chase and Lev, "Dynamic Circular Work-Stealing
+// Deque", with the memory ordering of Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models". Only the owning worker pushes and
+// takes at the bottom, any thread may steal at the top.
+struct NAWorkDeque{
+  NAInt top;
+  NAByte topPadding[NA_THREAD_POOL_CACHE_LINE_SIZE - sizeof(NAInt)];
+  NAInt bottom;
+  NAWorkDequeArray* array;
+  NAByte bottomPadding[NA_THREAD_POOL_CACHE_LINE_SIZE - sizeof(NAInt) - sizeof(NAWorkDequeArray*)];
+};
+
+struct NAThreadPoolWorker{
+  NAWorkDeque deque;
+  NAThreadPool* pool;
+  NAThread thread;
+  uint32 randomState;
+};
+
+struct NAThreadPool{
+  NAThreadPoolWorker* workers;
+  size_t workerCount;
+
+  NAMutex sharedMutex;
+  NAThreadPoolTask* sharedFirst;
+  NAThreadPoolTask* sharedLast;
+  NAInt sharedCount;
+
+  NAAlarm alarm;
+  NAInt sleepingCount;
+  NAInt stop;
+};
+
+struct NAParallelForRange{
+  NAParallelForFunction function;
+  void* arg;
+  size_t begin;
+  size_t end;
+  size_t grainSize;
+  NATaskGroup* group;
+};
+
+NA_HAPI void na_DestructThreadPool(NAThreadPool* pool);
+NA_RUNTIME_TYPE(NAThreadPool, na_DestructThreadPool, NA_FALSE);
+
+// The worker running on the current thread or NA_NULL if the current thread
+// is not a worker of any pool.
+static NA_THREAD_LOCAL NAThreadPoolWorker* na_currentWorker = NA_NULL;
+
+
+
+NA_HDEF NAWorkDequeArray* na_NewWorkDequeArray(NAInt capacity, NAWorkDequeArray* previous){
+  NAWorkDequeArray* array = naAlloc(NAWorkDequeArray);
+  array->capacity = capacity;
+  array->tasks = naMalloc((size_t)capacity * sizeof(void*));
+  array->previous = previous;
+  return array;
+}
+
+
+
+NA_HDEF void na_InitWorkDeque(NAWorkDeque* deque){
+  deque->top = 0;
+  deque->bottom = 0;
+  deque->array = na_NewWorkDequeArray(NA_THREAD_POOL_DEQUE_CAPACITY, NA_NULL);
+}
+
+
+
+NA_HDEF void na_ClearWorkDeque(NAWorkDeque* deque){
+  NAWorkDequeArray* array = deque->array;
+  while(array){
+    NAWorkDequeArray* previous = array->previous;
+    naFree(array->tasks);
+    naFree(array);
+    array = previous;
+  }
+}
+
+
+
+// Called by the owner only.
+NA_HDEF void na_PushWorkDeque(NAWorkDeque* deque, NAThreadPoolTask* task){
+  NAInt bottom = deque->bottom;
+  NAInt top = naLoadAtomicInt(&(deque->top));
+  NAWorkDequeArray* array = deque->array;
+
+  if(bottom - top >= array->capacity){
+    NAWorkDequeArray* newArray = na_NewWorkDequeArray(array->capacity * 2, array);
+    for(NAInt i = top; i < bottom; ++i){
+      newArray->tasks[i & (newArray->capacity - 1)] = array->tasks[i & (array->capacity - 1)];
+    }
+    naStoreAtomicPointer((void**)&(deque->array), newArray);
+    array = newArray;
+  }
+
+  naStoreAtomicPointer(&(array->tasks[bottom & (array->capacity - 1)]), task);
+  naStoreAtomicInt(&(deque->bottom), bottom + 1);
+}
+
+
+
+// Called by the owner only.
+NA_HDEF NAThreadPoolTask* na_TakeWorkDeque(NAWorkDeque* deque){
+  NAInt bottom = deque->bottom - 1;
+  NAWorkDequeArray* array = deque->array;
+  NAInt top;
+  NAThreadPoolTask* task = NA_NULL;
+
+  naStoreAtomicInt(&(deque->bottom), bottom);
+  naFenceAtomic();
+  top = naLoadAtomicInt(&(deque->top));
+
+  if(top <= bottom){
+    task = naLoadAtomicPointer(&(array->tasks[bottom & (array->capacity - 1)]));
+    if(top == bottom){
+      // This is the last task. Race against the thieves.
+      if(!naCompareExchangeAtomicInt(&(deque->top), top, top + 1)){
+        task = NA_NULL;
+      }
+      naStoreAtomicInt(&(deque->bottom), bottom + 1);
+    }
+  }else{
+    naStoreAtomicInt(&(deque->bottom), bottom + 1);
+  }
+  return task;
+}
+
+
+
+// Can be called by any thread. Returns NA_NULL if the deque is empty or if
+// another thread was faster.
+NA_HDEF NAThreadPoolTask* na_StealWorkDeque(NAWorkDeque* deque){
+  NAInt top = naLoadAtomicInt(&(deque->top));
+  NAInt bottom;
+  naFenceAtomic();
+  bottom = naLoadAtomicInt(&(deque->bottom));
+
+  if(top < bottom){
+    NAWorkDequeArray* array = naLoadAtomicPointer((void**)&(deque->array));
+    NAThreadPoolTask* task = naLoadAtomicPointer(&(array->tasks[top & (array->capacity - 1)]));
+    if(naCompareExchangeAtomicInt(&(deque->top), top, top + 1)){
+      return task;
+    }
+  }
+  return NA_NULL;
+}
+
+
+
+NA_HDEF void na_PushSharedThreadPoolTask(NAThreadPool* pool, NAThreadPoolTask* task){
+  task->next = NA_NULL;
+  naLockMutex(pool->sharedMutex);
+  if(pool->sharedLast){
+    pool->sharedLast->next = task;
+  }else{
+    pool->sharedFirst = task;
+  }
+  pool->sharedLast = task;
+  naAddAtomicInt(&(pool->sharedCount), 1);
+  naUnlockMutex(pool->sharedMutex);
+}
+
+
+
+NA_HDEF NAThreadPoolTask* na_PopSharedThreadPoolTask(NAThreadPool* pool){
+  NAThreadPoolTask* task = NA_NULL;
+  if(!naLoadAtomicInt(&(pool->sharedCount))){return NA_NULL;}
+  naLockMutex(pool->sharedMutex);
+  task = pool->sharedFirst;
+  if(task){
+    pool->sharedFirst = task->next;
+    if(!pool->sharedFirst){pool->sharedLast = NA_NULL;}
+    naAddAtomicInt(&(pool->sharedCount), -1);
+  }
+  naUnlockMutex(pool->sharedMutex);
+  return task;
+}
+
+
+
+// Looks for a task in the own deque first, then in the shared queue and
+// then tries to steal from the other workers, starting at a random one.
+// The worker may be NA_NULL if the current thread does not belong to the
+// pool.
+NA_HDEF NAThreadPoolTask* na_FindThreadPoolTask(NAThreadPool* pool, NAThreadPoolWorker* worker){
+  NAThreadPoolTask* task = NA_NULL;
+  size_t start = 0;
+
+  if(worker){
+    task = na_TakeWorkDeque(&(worker->deque));
+    if(task){return task;}
+  }
+  task = na_PopSharedThreadPoolTask(pool);
+  if(task){return task;}
+
+  if(worker){
+    // xorshift32
+    worker->randomState ^= worker->randomState << 13;
+    worker->randomState ^= worker->randomState >> 17;
+    worker->randomState ^= worker->randomState << 5;
+    start = worker->randomState % pool->workerCount;
+  }
+  for(size_t i = 0; i < pool->workerCount; ++i){
+    NAThreadPoolWorker* victim = &(pool->workers[(start + i) % pool->workerCount]);
+    if(victim == worker){continue;}
+    task = na_StealWorkDeque(&(victim->deque));
+    if(task){return task;}
+  }
+  return NA_NULL;
+}
+
+
+
+NA_HDEF void na_RunThreadPoolTask(NAThreadPoolTask* task){
+  NATaskGroup* group = task->group;
+  task->function(task->arg);
+  naFree(task);
+  // The group might be cleared by the waiting thread right after this call.
+  naAddAtomicInt(&(group->pendingCount), -1);
+}
+
+
+
+NA_HDEF void na_RunThreadPoolWorker(void* arg){
+  NAThreadPoolWorker* worker = (NAThreadPoolWorker*)arg;
+  NAThreadPool* pool = worker->pool;
+  size_t idleRounds = 0;
+  na_currentWorker = worker;
+
+  while(!naLoadAtomicInt(&(pool->stop))){
+    NAThreadPoolTask* task = na_FindThreadPoolTask(pool, worker);
+    if(task){
+      na_RunThreadPoolTask(task);
+      idleRounds = 0;
+    }else if(idleRounds < NA_THREAD_POOL_SPIN_ROUNDS){
+      idleRounds++;
+    }else{
+      // Announce the sleep before looking a last time such that a thread
+      // adding a task afterwards triggers the alarm.
+      naAddAtomicInt(&(pool->sleepingCount), 1);
+      task = na_FindThreadPoolTask(pool, worker);
+      if(task){
+        naAddAtomicInt(&(pool->sleepingCount), -1);
+        na_RunThreadPoolTask(task);
+        idleRounds = 0;
+      }else{
+        naAwaitAlarm(pool->alarm, NA_THREAD_POOL_IDLE_TIMEOUT);
+        naAddAtomicInt(&(pool->sleepingCount), -1);
+      }
+    }
+  }
+
+  na_currentWorker = NA_NULL;
+  // Workers on Mac run on dispatch queues which do not detach by themselves.
+  naDetachRuntimeThread();
+}
+
+
+
+NA_DEF NAThreadPool* naNewThreadPool(size_t workerCount){
+  NAThreadPool* pool = naNew(NAThreadPool);
+
+  if(workerCount == 0){
+    workerCount = naGetSystemProcessorCount();
+  }
+  pool->workerCount = workerCount;
+  pool->workers = naMalloc(workerCount * sizeof(NAThreadPoolWorker));
+
+  pool->sharedMutex = naMakeMutex();
+  pool->sharedFirst = NA_NULL;
+  pool->sharedLast = NA_NULL;
+  pool->sharedCount = 0;
+
+  pool->alarm = naMakeAlarm();
+  pool->sleepingCount = 0;
+  pool->stop = NA_FALSE;
+
+  for(size_t i = 0; i < workerCount; ++i){
+    NAThreadPoolWorker* worker = &(pool->workers[i]);
+    na_InitWorkDeque(&(worker->deque));
+    worker->pool = pool;
+    worker->randomState = (uint32)(i * 2654435761u + 1);
+    worker->thread = naMakeThread("NAThreadPool Worker", na_RunThreadPoolWorker, worker);
+  }
+  // Start the workers only after all deques are initialized as they
+  // immediately start stealing from each other.
+  naFenceAtomic();
+  for(size_t i = 0; i < workerCount; ++i){
+    naRunThread(pool->workers[i].thread);
+  }
+
+  return pool;
+}
+
+
+
+NA_HDEF void na_DestructThreadPool(NAThreadPool* pool){
+  #if NA_DEBUG
+    if(na_currentWorker && na_currentWorker->pool == pool)
+      naError("A thread pool can not be deleted by one of its own tasks.");
+    if(naLoadAtomicInt(&(pool->sharedCount)))
+      naError("There are tasks left which have not been waited for.");
+  #endif
+
+  naStoreAtomicInt(&(pool->stop), NA_TRUE);
+  for(size_t i = 0; i < pool->workerCount; ++i){
+    naTriggerAlarm(pool->alarm);
+  }
+  for(size_t i = 0; i < pool->workerCount; ++i){
+    naJoinThread(pool->workers[i].thread);
+    naClearThread(pool->workers[i].thread);
+    na_ClearWorkDeque(&(pool->workers[i].deque));
+  }
+  naFree(pool->workers);
+
+  naClearAlarm(pool->alarm);
+  naClearMutex(pool->sharedMutex);
+}
+
+
+
+NA_DEF size_t naGetThreadPoolWorkerCount(const NAThreadPool* pool){
+  return pool->workerCount;
+}
+
+
+
+NA_DEF NATaskGroup* naInitTaskGroup(NATaskGroup* group, NAThreadPool* pool){
+  #if NA_DEBUG
+    if(!group)
+      naCrash("group is Null-Pointer");
+    if(!pool)
+      naError("pool is Null-Pointer");
+  #endif
+  group->pool = pool;
+  group->pendingCount = 0;
+  return group;
+}
+
+
+
+NA_DEF void naClearTaskGroup(NATaskGroup* group){
+  naWaitTaskGroup(group);
+}
+
+
+
+NA_DEF void naAddTask(NATaskGroup* group, NAMutator function, void* arg){
+  NAThreadPool* pool = group->pool;
+  NAThreadPoolWorker* worker = na_currentWorker;
+  NAThreadPoolTask* task = naAlloc(NAThreadPoolTask);
+  task->function = function;
+  task->arg = arg;
+  task->group = group;
+
+  naAddAtomicInt(&(group->pendingCount), 1);
+  if(worker && worker->pool == pool){
+    na_PushWorkDeque(&(worker->deque), task);
+  }else{
+    na_PushSharedThreadPoolTask(pool, task);
+  }
+
+  naFenceAtomic();
+  if(naLoadAtomicInt(&(pool->sleepingCount))){
+    naTriggerAlarm(pool->alarm);
+  }
+}
+
+
+
+NA_DEF void naWaitTaskGroup(NATaskGroup* group){
+  NAThreadPool* pool = group->pool;
+  NAThreadPoolWorker* worker = na_currentWorker;
+  size_t idleRounds = 0;
+  if(worker && worker->pool != pool){worker = NA_NULL;}
+
+  while(naLoadAtomicInt(&(group->pendingCount))){
+    NAThreadPoolTask* task = na_FindThreadPoolTask(pool, worker);
+    if(task){
+      na_RunThreadPoolTask(task);
+      idleRounds = 0;
+    }else if(idleRounds < NA_THREAD_POOL_SPIN_ROUNDS){
+      idleRounds++;
+    }else{
+      // The remaining tasks are running on other threads.
+      naSleepU(50);
+    }
+  }
+}
+
+
+
+NA_HDEF void na_RunParallelForRange(void* arg){
+  NAParallelForRange* range = (NAParallelForRange*)arg;
+  // Give away the upper halves such that thieves get big chunks.
+  while(range->end - range->begin > range->grainSize){
+    size_t middle = range->begin + (range->end - range->begin) / 2;
+    NAParallelForRange* upper = naAlloc(NAParallelForRange);
+    *upper = *range;
+    upper->begin = middle;
+    range->end = middle;
+    naAddTask(range->group, na_RunParallelForRange, upper);
+  }
+  range->function(range->arg, range->begin, range->end);
+  naFree(range);
+}
+
+
+
+NA_DEF void naRunParallelFor(
+  NAThreadPool* pool,
+  size_t count,
+  size_t grainSize,
+  NAParallelForFunction function,
+  void* arg)
+{
+  NATaskGroup group;
+  NAParallelForRange* range;
+  #if NA_DEBUG
+    if(!function)
+      naCrash("function is Null-Pointer");
+  #endif
+  if(!count){return;}
+
+  if(grainSize == 0){
+    grainSize = count / (pool->workerCount * NA_PARALLEL_FOR_RANGES_PER_WORKER);
+    if(grainSize == 0){grainSize = 1;}
+  }
+
+  naInitTaskGroup(&group, pool);
+  range = naAlloc(NAParallelForRange);
+  range->function = function;
+  range->arg = arg;
+  range->begin = 0;
+  range->end = count;
+  range->grainSize = grainSize;
+  range->group = &group;
+  // The calling thread works on the first subrange itself.
+  na_RunParallelForRange(range);
+  naClearTaskGroup(&group);
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
@@ -16,6 +16,19 @@
   #ifndef DISPATCH_QUEUE_SERIAL
     #define DISPATCH_QUEUE_SERIAL NULL
   #endif
+#else
+  #include <unistd.h>
+  #include <errno.h>
+  #include <time.h>
+  #include <pthread.h>
+#endif
+
+// Storage class for variables which exist once per thread. Used by the
+// implementation files of NALib.
+#if NA_OS == NA_OS_WINDOWS
+  #define NA_THREAD_LOCAL __declspec(thread)
+#else
+  #define NA_THREAD_LOCAL __thread
 #endif
 
 
@@ -30,12 +43,26 @@ NA_IDEF int naSleepN(size_t nanoSeconds){
 
 
 
+#if NA_OS != NA_OS_WINDOWS && NA_OS != NA_OS_MAC_OS_X
+  // usleep is obsolete in POSIX, hence nanosleep is used.
+  NA_HIDEF int na_SleepPosix(size_t microSeconds){
+    struct timespec duration;
+    duration.tv_sec = (time_t)(microSeconds / 1000000);
+    duration.tv_nsec = (long)((microSeconds % 1000000) * 1000);
+    return nanosleep(&duration, NA_NULL);
+  }
+#endif
+
+
+
 NA_IDEF int naSleepU(size_t microSeconds){
   #if NA_OS == NA_OS_WINDOWS
     Sleep((DWORD)(microSeconds / 1000));
     return 0;
   #elif NA_OS == NA_OS_MAC_OS_X
     return usleep((useconds_t)(microSeconds));
+  #else
+    return na_SleepPosix(microSeconds);
   #endif
 }
 
@@ -47,6 +74,8 @@ NA_IDEF int naSleepM(size_t milliSeconds){
     return 0;
   #elif NA_OS == NA_OS_MAC_OS_X
     return usleep((useconds_t)(milliSeconds * 1000LL));
+  #else
+    return na_SleepPosix(milliSeconds * 1000);
   #endif
 }
 
@@ -58,6 +87,8 @@ NA_IDEF int naSleepS(double seconds){
     return 0;
   #elif NA_OS == NA_OS_MAC_OS_X
     return usleep((useconds_t)(seconds * 1000000LL));
+  #else
+    return na_SleepPosix((size_t)(seconds * 1000000LL));
   #endif
 }
 
@@ -80,6 +111,8 @@ NA_IDEF int naSleepS(double seconds){
   typedef HANDLE            NANativeThread;
 #elif NA_OS == NA_OS_MAC_OS_X
   typedef dispatch_queue_t  NANativeThread;
+#else
+  typedef pthread_t         NANativeThread;
 #endif
 
 
@@ -89,7 +122,10 @@ struct NAThreadStruct{
   NANativeThread nativeThread;  // If you experience an error here when working
   NAMutator function;           // with plain C files on a Mac: Turn off the
   void* arg;                    // automatic reference counting in project
-};                              // settings.
+  #if NA_OS != NA_OS_WINDOWS && NA_OS != NA_OS_MAC_OS_X
+    NABool joinable;            // settings.
+  #endif
+};
 
 
 
@@ -98,8 +134,11 @@ NA_IDEF NAThread naMakeThread(const char* threadName, NAMutator function, void*
   threadstruct->name = threadName;
   #if NA_OS == NA_OS_WINDOWS
     threadstruct->nativeThread = NA_NULL; // Note that on windows, creating the thread would immediately start it.
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
     threadstruct->nativeThread = dispatch_queue_create(threadName, DISPATCH_QUEUE_SERIAL);
+  #else
+    // Same as on windows, creating a pthread immediately starts it.
+    threadstruct->joinable = NA_FALSE;
   #endif
   threadstruct->function = function;
   threadstruct->arg = arg;
@@ -112,12 +151,14 @@ NA_IDEF void naClearThread(NAThread thread){
   NAThreadStruct* threadstruct = (NAThreadStruct*)thread;
   #if NA_OS == NA_OS_WINDOWS
     CloseHandle(threadstruct->nativeThread);
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
     #if NA_MACOS_USES_ARC
       // Thread will be released automatically when ARC is turned on.
     #else
       dispatch_release(threadstruct->nativeThread);
     #endif
+  #else
+    if(threadstruct->joinable){pthread_detach(threadstruct->nativeThread);}
   #endif
   naFree(threadstruct);
 }
@@ -130,8 +171,23 @@ NA_IDEF void naClearThread(NAThread thread){
   NA_HDEF static DWORD __stdcall na_RunWindowsThread(LPVOID arg){
     NAThreadStruct* thread = (NAThreadStruct*)arg;
     thread->function(thread->arg);
+    naDetachRuntimeThread();
     return 0;
   }
+#elif NA_OS == NA_OS_MAC_OS_X
+  // Joining a queue is done by synchronously dispatching this function which
+  // does nothing. It returns when all previously dispatched calls are done.
+  NA_HIDEF void na_JoinMacintoshThread(void* arg){
+    NA_UNUSED(arg);
+  }
+#else
+  // Same as on Windows, pthreads expect a different callback type.
+  NA_HIDEF void* na_RunPosixThread(void* arg){
+    NAThreadStruct* thread = (NAThreadStruct*)arg;
+    thread->function(thread->arg);
+    naDetachRuntimeThread();
+    return NA_NULL;
+  }
 #endif
 
 
@@ -140,8 +196,40 @@ NA_IDEF void naRunThread(NAThread thread){
   NAThreadStruct* threadstruct = (NAThreadStruct*)thread;
   #if NA_OS == NA_OS_WINDOWS
     threadstruct->nativeThread = CreateThread(NULL, 0, na_RunWindowsThread, threadstruct, 0, 0);
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
     dispatch_async_f(threadstruct->nativeThread, threadstruct->arg, threadstruct->function);
+  #else
+    // A previous run which has not been joined can not be joined anymore.
+    if(threadstruct->joinable){pthread_detach(threadstruct->nativeThread);}
+    threadstruct->joinable = (pthread_create(&(threadstruct->nativeThread), NA_NULL, na_RunPosixThread, threadstruct) == 0);
+    #if NA_DEBUG
+      if(!threadstruct->joinable)
+        naError("Thread could not be created.");
+    #endif
+  #endif
+}
+
+
+
+NA_IDEF void naJoinThread(NAThread thread){
+  NAThreadStruct* threadstruct = (NAThreadStruct*)thread;
+  #if NA_OS == NA_OS_WINDOWS
+    #if NA_DEBUG
+      if(!threadstruct->nativeThread)
+        naError("Thread has not been run.");
+    #endif
+    WaitForSingleObject(threadstruct->nativeThread, INFINITE);
+  #elif NA_OS == NA_OS_MAC_OS_X
+    dispatch_sync_f(threadstruct->nativeThread, NA_NULL, na_JoinMacintoshThread);
+  #else
+    #if NA_DEBUG
+      if(!threadstruct->joinable)
+        naError("Thread has not been run or has already been joined.");
+    #endif
+    if(threadstruct->joinable){
+      pthread_join(threadstruct->nativeThread, NA_NULL);
+      threadstruct->joinable = NA_FALSE;
+    }
   #endif
 }
 
@@ -177,7 +265,7 @@ NA_IDEF void naRunThread(NAThread thread){
   // the same thread. The author thinks that this is inconsistent and therefore
   // has implemented mutexes like this to be the same on all systems.
 
-#else
+#elif NA_OS == NA_OS_MAC_OS_X
 
   #if NA_DEBUG
     typedef struct NAMacintoshMutex NAMacintoshMutex;
@@ -189,6 +277,17 @@ NA_IDEF void naRunThread(NAThread thread){
     typedef dispatch_semaphore_t NAMacintoshMutex;
   #endif
 
+#else
+
+  // When debugging, the pthread mutex checks for errors which allows to
+  // detect a double lock by the same thread like on all other systems.
+  typedef struct NAPosixMutex NAPosixMutex;
+  struct NAPosixMutex{
+    pthread_mutex_t mutex;
+    #if NA_DEBUG
+      NABool seemslocked;
+    #endif
+  };
 
 #endif
 
@@ -207,7 +306,7 @@ NA_IDEF NAMutex naMakeMutex(void){
       windowsMutex->seemslocked = NA_FALSE;
     #endif
     return windowsMutex;
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
 
     #if NA_DEBUG
       NAMacintoshMutex* macintoshmutex = naAlloc(NAMacintoshMutex);
@@ -218,6 +317,19 @@ NA_IDEF NAMutex naMakeMutex(void){
       NAMutex mutex = NA_COCOA_PTR_OBJC_TO_C(dispatch_semaphore_create(1));
       return mutex;
     #endif
+  #else
+    NAPosixMutex* posixMutex = naAlloc(NAPosixMutex);
+    #if NA_DEBUG
+      pthread_mutexattr_t attr;
+      pthread_mutexattr_init(&attr);
+      pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK);
+      pthread_mutex_init(&(posixMutex->mutex), &attr);
+      pthread_mutexattr_destroy(&attr);
+      posixMutex->seemslocked = NA_FALSE;
+    #else
+      pthread_mutex_init(&(posixMutex->mutex), NA_NULL);
+    #endif
+    return posixMutex;
   #endif
 }
 
@@ -232,7 +344,7 @@ NA_IDEF void naClearMutex(NAMutex mutex){
       CloseHandle(windowsMutex->mutex);
     #endif
     naFree(windowsMutex);
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
     #if NA_DEBUG
       NAMacintoshMutex* macintoshmutex = (NAMacintoshMutex*)mutex;
       #if NA_MACOS_USES_ARC
@@ -249,6 +361,10 @@ NA_IDEF void naClearMutex(NAMutex mutex){
         dispatch_release(mutex);
       #endif
     #endif
+  #else
+    NAPosixMutex* posixMutex = (NAPosixMutex*)mutex;
+    pthread_mutex_destroy(&(posixMutex->mutex));
+    naFree(posixMutex);
   #endif
 }
 
@@ -273,7 +389,7 @@ NA_IDEF void naLockMutex(NAMutex mutex){
     #if NA_DEBUG
       windowsMutex->seemslocked = NA_TRUE;
     #endif
-   #else
+   #elif NA_OS == NA_OS_MAC_OS_X
     #if NA_DEBUG
       NAMacintoshMutex* macintoshmutex = (NAMacintoshMutex*)mutex;
       dispatch_semaphore_wait(macintoshmutex->mutex, DISPATCH_TIME_FOREVER);
@@ -281,6 +397,17 @@ NA_IDEF void naLockMutex(NAMutex mutex){
     #else
       dispatch_semaphore_wait(NA_COCOA_PTR_C_TO_OBJC(mutex), DISPATCH_TIME_FOREVER);
     #endif
+  #else
+    NAPosixMutex* posixMutex = (NAPosixMutex*)mutex;
+    #if NA_DEBUG
+      if(pthread_mutex_lock(&(posixMutex->mutex)) == EDEADLK){
+        naError("Mutex was already locked by this thread. This is not how Mutexes in NALib work.");
+        return;
+      }
+      posixMutex->seemslocked = NA_TRUE;
+    #else
+      pthread_mutex_lock(&(posixMutex->mutex));
+    #endif
   #endif
 }
 
@@ -305,7 +432,7 @@ NA_IDEF void naUnlockMutex(NAMutex mutex){
     #else
       ReleaseMutex(windowsMutex->mutex);
     #endif
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
     #if NA_DEBUG
       NAMacintoshMutex* macintoshmutex = (NAMacintoshMutex*)mutex;
       macintoshmutex->seemslocked = NA_FALSE;
@@ -313,6 +440,14 @@ NA_IDEF void naUnlockMutex(NAMutex mutex){
     #else
       dispatch_semaphore_signal(NA_COCOA_PTR_C_TO_OBJC(mutex));
     #endif
+  #else
+    NAPosixMutex* posixMutex = (NAPosixMutex*)mutex;
+    #if NA_DEBUG
+      if(!naIsMutexLocked(mutex))
+        naError("Mutex was not locked. Note: If this only happends once and very rarely, it might be because this check is unreliable!");
+      posixMutex->seemslocked = NA_FALSE;
+    #endif
+    pthread_mutex_unlock(&(posixMutex->mutex));
   #endif
 }
 
@@ -323,9 +458,12 @@ NA_IDEF void naUnlockMutex(NAMutex mutex){
     #if NA_OS == NA_OS_WINDOWS
       NAWindowsMutex* windowsMutex = (NAWindowsMutex*)mutex;
       return windowsMutex->seemslocked;
-    #else
+    #elif NA_OS == NA_OS_MAC_OS_X
       NAMacintoshMutex* macintoshmutex = (NAMacintoshMutex*)mutex;
       return macintoshmutex->seemslocked;
+    #else
+      NAPosixMutex* posixMutex = (NAPosixMutex*)mutex;
+      return posixMutex->seemslocked;
     #endif
 
     // This was the old code which worked but it introduced long wait times
@@ -361,6 +499,9 @@ NA_IDEF NABool naTryMutex(NAMutex mutex){
           return NA_FALSE;
         }else{
           windowsMutex->islockedbythisthread = NA_TRUE;
+          #if NA_DEBUG
+            windowsMutex->seemslocked = NA_TRUE;
+          #endif
           return NA_TRUE;
         }
       }
@@ -375,24 +516,39 @@ NA_IDEF NABool naTryMutex(NAMutex mutex){
           return NA_FALSE;
         }else{
           windowsMutex->islockedbythisthread = NA_TRUE;
+          #if NA_DEBUG
+            windowsMutex->seemslocked = NA_TRUE;
+          #endif
           return NA_TRUE;
         }
       }
     #endif
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
     #if NA_DEBUG
       NAMacintoshMutex* macintoshmutex = (NAMacintoshMutex*)mutex;
       long retValue = dispatch_semaphore_wait(macintoshmutex->mutex, DISPATCH_TIME_NOW);
       if(retValue){
         return NA_FALSE;
       }else{
-        return NA_TRUE;
         macintoshmutex->seemslocked = NA_TRUE;
+        return NA_TRUE;
       }
     #else
       long retValue = dispatch_semaphore_wait(NA_COCOA_PTR_C_TO_OBJC(mutex), DISPATCH_TIME_NOW);
       return (retValue ? NA_FALSE : NA_TRUE);
     #endif
+  #else
+    // Note that an error checking mutex returns EBUSY when trying to lock
+    // it a second time by the same thread, which is the desired behaviour.
+    NAPosixMutex* posixMutex = (NAPosixMutex*)mutex;
+    if(pthread_mutex_trylock(&(posixMutex->mutex))){
+      return NA_FALSE;
+    }else{
+      #if NA_DEBUG
+        posixMutex->seemslocked = NA_TRUE;
+      #endif
+      return NA_TRUE;
+    }
   #endif
 }
 
@@ -407,6 +563,16 @@ NA_IDEF NABool naTryMutex(NAMutex mutex){
   typedef HANDLE            NANativeAlarm;
 #elif NA_OS == NA_OS_MAC_OS_X
   typedef dispatch_semaphore_t  NANativeAlarm;
+#else
+  // An alarm is a condition variable guarded by a mutex. The generation
+  // counter distinguishes a real trigger from a spurious wakeup.
+  typedef struct NAPosixAlarm NAPosixAlarm;
+  struct NAPosixAlarm{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32 generation;
+  };
+  typedef NAPosixAlarm*     NANativeAlarm;
 #endif
 
 
@@ -416,9 +582,21 @@ NA_IDEF NAAlarm naMakeAlarm(void){
   #if NA_OS == NA_OS_WINDOWS
     alarmer = CreateEvent(NULL, FALSE, FALSE, NULL);
     return (NAAlarm)alarmer;
-#else
+  #elif NA_OS == NA_OS_MAC_OS_X
     alarmer = dispatch_semaphore_create(0);
     return (NAAlarm)NA_COCOA_PTR_OBJC_TO_C(alarmer);
+  #else
+    pthread_condattr_t attr;
+    alarmer = naAlloc(NAPosixAlarm);
+    pthread_mutex_init(&(alarmer->mutex), NA_NULL);
+    // Timed waits are measured with the monotonic clock such that changing
+    // the system time does not affect them.
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&(alarmer->cond), &attr);
+    pthread_condattr_destroy(&attr);
+    alarmer->generation = 0;
+    return (NAAlarm)alarmer;
   #endif
 }
 
@@ -427,13 +605,18 @@ NA_IDEF NAAlarm naMakeAlarm(void){
 NA_IDEF void naClearAlarm(NAAlarm alarmer){
   #if NA_OS == NA_OS_WINDOWS
     CloseHandle(alarmer);
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
     #if NA_MACOS_USES_ARC
       NA_UNUSED(alarmer);
       // Alarm will be released automatically when ARC is turned on.
     #else
       dispatch_release(alarmer);
     #endif
+  #else
+    NAPosixAlarm* posixAlarm = (NAPosixAlarm*)alarmer;
+    pthread_cond_destroy(&(posixAlarm->cond));
+    pthread_mutex_destroy(&(posixAlarm->mutex));
+    naFree(posixAlarm);
   #endif
 }
 
@@ -453,7 +636,7 @@ NA_IDEF NABool naAwaitAlarm(NAAlarm alarmer, double maxWaitTime){
       result = WaitForSingleObject(alarmer, (DWORD)(1000. * maxWaitTime));
     }
     return (result == WAIT_OBJECT_0);
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
     long result;
     #if NA_DEBUG
       if(maxWaitTime < 0.)
@@ -466,6 +649,38 @@ NA_IDEF NABool naAwaitAlarm(NAAlarm alarmer, double maxWaitTime){
       result = dispatch_semaphore_wait(NA_COCOA_PTR_C_TO_OBJC(alarmer), timeout);
     }
     return (result ? NA_FALSE : NA_TRUE);
+  #else
+    NAPosixAlarm* posixAlarm = (NAPosixAlarm*)alarmer;
+    uint32 generation;
+    int result = 0;
+    #if NA_DEBUG
+      if(maxWaitTime < 0.)
+        naError("maxWaitTime should not be negative. Beware of the zero!");
+    #endif
+    pthread_mutex_lock(&(posixAlarm->mutex));
+    generation = posixAlarm->generation;
+    if(maxWaitTime == 0){
+      while(generation == posixAlarm->generation){
+        pthread_cond_wait(&(posixAlarm->cond), &(posixAlarm->mutex));
+      }
+    }else{
+      struct timespec timeout;
+      // Negative times do not wait at all. Keeping nanoSeconds positive keeps
+      // tv_nsec within [0, 1e9) which pthread_cond_timedwait requires.
+      int64 nanoSeconds = (maxWaitTime > 0.) ? (int64)(1000000000. * maxWaitTime) : 0;
+      clock_gettime(CLOCK_MONOTONIC, &timeout);
+      nanoSeconds += timeout.tv_nsec;
+      timeout.tv_sec += (time_t)(nanoSeconds / 1000000000);
+      timeout.tv_nsec = (long)(nanoSeconds % 1000000000);
+      // Only spurious wakeups and interruptions continue waiting. A timeout
+      // or an error stops.
+      while(generation == posixAlarm->generation && (result == 0 || result == EINTR)){
+        result = pthread_cond_timedwait(&(posixAlarm->cond), &(posixAlarm->mutex), &timeout);
+      }
+    }
+    generation = posixAlarm->generation - generation;
+    pthread_mutex_unlock(&(posixAlarm->mutex));
+    return (generation ? NA_TRUE : NA_FALSE);
   #endif
 }
 
@@ -474,8 +689,136 @@ NA_IDEF NABool naAwaitAlarm(NAAlarm alarmer, double maxWaitTime){
 NA_IDEF void naTriggerAlarm(NAAlarm alarmer){
   #if NA_OS == NA_OS_WINDOWS
     SetEvent(alarmer);
-  #else
+  #elif NA_OS == NA_OS_MAC_OS_X
     dispatch_semaphore_signal(NA_COCOA_PTR_C_TO_OBJC(alarmer));
+  #else
+    NAPosixAlarm* posixAlarm = (NAPosixAlarm*)alarmer;
+    pthread_mutex_lock(&(posixAlarm->mutex));
+    posixAlarm->generation++;
+    pthread_mutex_unlock(&(posixAlarm->mutex));
+    pthread_cond_signal(&(posixAlarm->cond));
+  #endif
+}
+
+
+
+// ////////////////////////////
+// ATOMICS
+// ////////////////////////////
+
+
+// On Windows, the Interlocked functions are full memory barriers. Plain
+// loads and stores are surrounded by explicit barriers as the volatile
+// semantics of the compiler depend on the target architecture. All other
+// systems are assumed to use GCC or Clang which provide atomic builtins.
+
+NA_IDEF NAInt naLoadAtomicInt(NAInt* value){
+  #if NA_OS == NA_OS_WINDOWS
+    NAInt result = *(volatile NAInt*)value;
+    MemoryBarrier();
+    return result;
+  #else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+  #endif
+}
+
+
+
+NA_IDEF void naStoreAtomicInt(NAInt* value, NAInt newValue){
+  #if NA_OS == NA_OS_WINDOWS
+    MemoryBarrier();
+    *(volatile NAInt*)value = newValue;
+  #else
+    __atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+  #endif
+}
+
+
+
+NA_IDEF NAInt naAddAtomicInt(NAInt* value, NAInt summand){
+  #if NA_OS == NA_OS_WINDOWS
+    #if NA_TYPE_NAINT_BITS == NA_TYPE64_BITS
+      return (NAInt)InterlockedExchangeAdd64((volatile LONG64*)value, (LONG64)summand) + summand;
+    #else
+      return (NAInt)InterlockedExchangeAdd((volatile LONG*)value, (LONG)summand) + summand;
+    #endif
+  #else
+    return __atomic_add_fetch(value, summand, __ATOMIC_SEQ_CST);
+  #endif
+}
+
+
+
+NA_IDEF NABool naCompareExchangeAtomicInt(NAInt* value, NAInt expected, NAInt newValue){
+  #if NA_OS == NA_OS_WINDOWS
+    #if NA_TYPE_NAINT_BITS == NA_TYPE64_BITS
+      return InterlockedCompareExchange64((volatile LONG64*)value, (LONG64)newValue, (LONG64)expected) == (LONG64)expected;
+    #else
+      return InterlockedCompareExchange((volatile LONG*)value, (LONG)newValue, (LONG)expected) == (LONG)expected;
+    #endif
+  #else
+    return __atomic_compare_exchange_n(value, &expected, newValue, NA_FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  #endif
+}
+
+
+
+NA_IDEF void* naLoadAtomicPointer(void** pointer){
+  #if NA_OS == NA_OS_WINDOWS
+    void* result = *(void* volatile*)pointer;
+    MemoryBarrier();
+    return result;
+  #else
+    return __atomic_load_n(pointer, __ATOMIC_ACQUIRE);
+  #endif
+}
+
+
+
+NA_IDEF void naStoreAtomicPointer(void** pointer, void* newValue){
+  #if NA_OS == NA_OS_WINDOWS
+    MemoryBarrier();
+    *(void* volatile*)pointer = newValue;
+  #else
+    __atomic_store_n(pointer, newValue, __ATOMIC_RELEASE);
+  #endif
+}
+
+
+
+NA_IDEF NABool naCompareExchangeAtomicPointer(void** pointer, void* expected, void* newValue){
+  #if NA_OS == NA_OS_WINDOWS
+    return InterlockedCompareExchangePointer((PVOID volatile*)pointer, newValue, expected) == expected;
+  #else
+    return __atomic_compare_exchange_n(pointer, &expected, newValue, NA_FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  #endif
+}
+
+
+
+NA_IDEF void naFenceAtomic(){
+  #if NA_OS == NA_OS_WINDOWS
+    MemoryBarrier();
+  #else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  #endif
+}
+
+
+
+// ////////////////////////////
+// THREAD POOL
+// ////////////////////////////
+
+
+NA_IDEF size_t naGetSystemProcessorCount(){
+  #if NA_OS == NA_OS_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwNumberOfProcessors;
+  #else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count < 1) ? 1 : (size_t)count;
   #endif
 }
 
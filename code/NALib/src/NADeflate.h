@@ -15,8 +15,16 @@
 #include "NABuffer.h"
 
 
-// NA_DEFLATE_COMPRESSION_FASTEST:  No compression at all. Storing bytes as is.
-// The other compression levels have not been implemented yet.
+// The compression levels differ in how thoroughly the encoder searches for
+// repeating byte sequences within the 32 KB window:
+// NA_DEFLATE_COMPRESSION_FASTEST:  Very short search, takes the first match.
+// NA_DEFLATE_COMPRESSION_FAST:     Short search, lazy matching.
+// NA_DEFLATE_COMPRESSION_DEFAULT:  Medium search, lazy matching.
+// NA_DEFLATE_COMPRESSION_MAX:      Exhaustive search, lazy matching.
+// On typical data, a higher level compresses at least as well as a lower one.
+// Every block is written either stored, with fixed or with dynamic huffman
+// codes, whichever results in the smallest output. Therefore, incompressible
+// data grows only by a few bytes.
 typedef enum{
   NA_DEFLATE_COMPRESSION_FASTEST  = 0,
   NA_DEFLATE_COMPRESSION_FAST     = 1,
@@ -26,8 +34,10 @@ typedef enum{
 
 
 // Decompresses a bit stream which is encoded in the ZLIB format and stores it
-// at the current writing position in the given buffer.
-NA_API void naFillBufferWithZLIBDecompression(NABuffer* output,
+// at the current writing position in the given buffer. Returns NA_FALSE if
+// the stream is corrupt or truncated. The bytes decoded up to that point are
+// stored in the buffer nonetheless.
+NA_API NABool naFillBufferWithZLIBDecompression(NABuffer* output,
                                               NABuffer* input);
 
 // Compresses a bit stream with ZLIB and stores it at the current writing
@@ -39,6 +49,75 @@ NA_API void naFillBufferWithZLIBCompression(  NABuffer* output,
 
 
 
+// Streaming
+//
+// The following objects decompress or compress a ZLIB stream piece by
+// piece. Apart from the input fed but not consumed yet and the output not
+// drained yet, they only keep the 32 KB window and their state. Use them
+// like this:
+//
+// NAZLIBInflater* inflater = naNewZLIBInflater();
+// while(more input available){
+//   naFeedZLIBInflater(inflater, chunk, chunkSize);
+//   while((count = naDrainZLIBInflater(inflater, out, outSize))){
+//     use count bytes of out
+//   }
+// }
+// NABool success = naFinishZLIBInflater(inflater);
+// naDelete(inflater);
+//
+// Drain the output before feeding more input. Otherwise, the input will
+// accumulate.
+
+typedef struct NAZLIBInflater NAZLIBInflater;
+typedef struct NAZLIBDeflater NAZLIBDeflater;
+
+// Creates a new inflater. Delete it with naDelete.
+NA_API NAZLIBInflater* naNewZLIBInflater(void);
+
+// Appends the given bytes to the compressed input.
+NA_API void naFeedZLIBInflater(
+  NAZLIBInflater* inflater,
+  const NAByte* data,
+  size_t byteSize);
+
+// Decompresses as much as possible into data, up to byteSize bytes, and
+// returns the number of bytes written. If 0 is returned, more input is
+// needed or the stream is complete.
+NA_API size_t naDrainZLIBInflater(
+  NAZLIBInflater* inflater,
+  NAByte* data,
+  size_t byteSize);
+
+// Declares the input as complete. Returns NA_TRUE if the stream ended
+// properly and its checksum matches. Call this after all output has been
+// drained.
+NA_API NABool naFinishZLIBInflater(NAZLIBInflater* inflater);
+
+// Creates a new deflater with the given compression level. Delete it with
+// naDelete.
+NA_API NAZLIBDeflater* naNewZLIBDeflater(NADeflateCompressionLevel level);
+
+// Compresses the given bytes. The compressed output becomes available in
+// parts whenever enough input has been gathered.
+NA_API void naFeedZLIBDeflater(
+  NAZLIBDeflater* deflater,
+  const NAByte* data,
+  size_t byteSize);
+
+// Declares the input as complete and writes the remaining output including
+// the checksum. No more input can be fed afterwards.
+NA_API void naFinishZLIBDeflater(NAZLIBDeflater* deflater);
+
+// Copies up to byteSize bytes of the available compressed output to data
+// and returns the number of bytes copied.
+NA_API size_t naDrainZLIBDeflater(
+  NAZLIBDeflater* deflater,
+  NAByte* data,
+  size_t byteSize);
+
+
+
 #ifdef __cplusplus
   } // extern "C"
 #endif
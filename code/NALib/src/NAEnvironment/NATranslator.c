@@ -9,6 +9,20 @@
 
 
 
+// Groups whose ids span more than this many slots per inserted string are
+// not stored in a table. Such sparse groups are looked up in the trees.
+#define NA_TRANSLATOR_TABLE_MAX_SLOTS_PER_STRING 4
+
+// The strings of one group indexed by their id minus minid, already resolved
+// according to the language preferences. A stringcount of -1 denotes a group
+// which needs to be looked up in the trees.
+typedef struct NATranslatorTable NATranslatorTable;
+struct NATranslatorTable{
+  NAInt minid;
+  NAInt stringcount;
+  const NAUTF8Char** strings;
+};
+
 struct NATranslator{
   NATree groups;
   NATreeConfiguration* groupsconfig;
@@ -17,6 +31,12 @@ struct NATranslator{
   NAList languagepreferences;
   NAInt curgroup;
   NAInt curlang;
+
+  // Built on the first translation after the strings or the language
+  // preferences changed.
+  NATranslatorTable* tables;
+  NAInt tablecount;
+  NABool tablesvalid;
 };
 
 #if NA_COMPILE_GUI == 1
@@ -61,6 +81,23 @@ NA_HDEF void na_DestructGroups(NAPtr leafData){
 
 
 
+NA_HDEF void na_ClearTranslatorTables(void){
+  NAInt i;
+  for(i = 0; i < NA_TRANSLATOR->tablecount; i++){
+    if(NA_TRANSLATOR->tables[i].strings){
+      naFree(NA_TRANSLATOR->tables[i].strings);
+    }
+  }
+  if(NA_TRANSLATOR->tables){
+    naFree(NA_TRANSLATOR->tables);
+  }
+  NA_TRANSLATOR->tables = NA_NULL;
+  NA_TRANSLATOR->tablecount = 0;
+  NA_TRANSLATOR->tablesvalid = NA_FALSE;
+}
+
+
+
 NA_DEF void naStartTranslator(void){
   #if NA_DEBUG
     #if NA_COMPILE_GUI == 1
@@ -85,6 +122,10 @@ NA_DEF void naStartTranslator(void){
   naInitList(&(NA_TRANSLATOR->languagepreferences));
   NA_TRANSLATOR->curgroup = -1;
   NA_TRANSLATOR->curlang = 0;
+
+  NA_TRANSLATOR->tables = NA_NULL;
+  NA_TRANSLATOR->tablecount = 0;
+  NA_TRANSLATOR->tablesvalid = NA_FALSE;
 }
 
 
@@ -99,6 +140,7 @@ NA_DEF void naStopTranslator(void){
         naCrash("No translator running. Please use naStartTranslator.");
     #endif
   #endif
+  na_ClearTranslatorTables();
   naClearTree(&(NA_TRANSLATOR->groups));
   naForeachListMutable(&(NA_TRANSLATOR->languagepreferences), naFree);
   naClearList(&(NA_TRANSLATOR->languagepreferences));
@@ -108,6 +150,7 @@ NA_DEF void naStopTranslator(void){
   naReleaseTreeConfiguration(NA_TRANSLATOR->stringsconfig);
 
   naFree(NA_TRANSLATOR);
+  NA_TRANSLATOR = NA_NULL;
 }
 
 
@@ -123,6 +166,7 @@ NA_DEF NAInt naRegisterTranslatorGroup(void){
     #endif
   #endif
   NA_TRANSLATOR->curgroup++;
+  NA_TRANSLATOR->tablesvalid = NA_FALSE;
   return NA_TRANSLATOR->curgroup;
 }
 
@@ -155,6 +199,7 @@ NA_DEF void naSwitchTranslatorInsertionLanguage(NALanguageCode3 code){
     NAInt* newcode = naAlloc(NAInt);  // No, not TranslatorCode3, enums may have not the same size!!!
     *newcode = code;
     naAddListLastMutable(&(NA_TRANSLATOR->languagepreferences), newcode);
+    NA_TRANSLATOR->tablesvalid = NA_FALSE;
   }
 }
 
@@ -193,12 +238,15 @@ NA_DEF void naInsertTranslatorString(NAInt id, NAUTF8Char* str){
   stringiter = naMakeTreeModifier(languagepack);
   naAddTreeKeyConst(&stringiter, &id, str, NA_TRUE);
   naClearTreeIterator(&stringiter);
+
+  NA_TRANSLATOR->tablesvalid = NA_FALSE;
 }
 
 
 
 NA_DEF void naSetTranslatorLanguagePreference(NALanguageCode3 code){
   NABool codefound;
+  NABool isfirst;
   NAListIterator it;
   
   #if NA_DEBUG
@@ -211,13 +259,19 @@ NA_DEF void naSetTranslatorLanguagePreference(NALanguageCode3 code){
     #endif
   #endif
   codefound = NA_FALSE;
+  isfirst = NA_TRUE;
   it = naMakeListModifier(&(NA_TRANSLATOR->languagepreferences));
   while(!codefound && naIterateList(&it)){
     const NALanguageCode3* curcode = naGetListCurConst(&it);
     if(*curcode == code){
       codefound = NA_TRUE;
-      naMoveListCurToFirst(&it, NA_FALSE, &(NA_TRANSLATOR->languagepreferences));
+      // The tables stay valid if the language already is the preferred one.
+      if(!isfirst){
+        naMoveListCurToFirst(&it, NA_FALSE, &(NA_TRANSLATOR->languagepreferences));
+        NA_TRANSLATOR->tablesvalid = NA_FALSE;
+      }
     }
+    isfirst = NA_FALSE;
   }
   naClearListIterator(&it);
   
@@ -225,15 +279,147 @@ NA_DEF void naSetTranslatorLanguagePreference(NALanguageCode3 code){
     NAInt* newcode = naAlloc(NAInt);  // No, not TranslatorCode3, enums may have not the same size!!!
     *newcode = code;
     naAddListFirstMutable(&(NA_TRANSLATOR->languagepreferences), newcode);
+    NA_TRANSLATOR->tablesvalid = NA_FALSE;
+  }
+}
+
+
+
+// Returns the strings of the given language in the given group, if any.
+NA_HDEF NATree* na_GetTranslatorLanguagePack(NATree* grouppack, const NAInt* lang){
+  NATree* languagepack = NA_NULL;
+  NATreeIterator languageiter = naMakeTreeModifier(grouppack);
+  if(naLocateTreeKey(&languageiter, lang, NA_TRUE)){
+    languagepack = naGetTreeCurLeafMutable(&languageiter);
   }
+  naClearTreeIterator(&languageiter);
+  return languagepack;
+}
+
+
+
+// Returns the group pack of the given group, if any.
+NA_HDEF NATree* na_GetTranslatorGroupPack(NAInt group){
+  NATree* grouppack = NA_NULL;
+  NATreeIterator groupiter = naMakeTreeModifier(&(NA_TRANSLATOR->groups));
+  if(naLocateTreeKey(&groupiter, &group, NA_TRUE)){
+    grouppack = naGetTreeCurLeafMutable(&groupiter);
+  }
+  naClearTreeIterator(&groupiter);
+  return grouppack;
+}
+
+
+
+// Searches the string in the trees going through the preferred languages.
+NA_HDEF const NAUTF8Char* na_LookupTranslatorString(NAInt group, NAInt id){
+  const NAUTF8Char* retValue = NA_NULL;
+  NATree* grouppack = na_GetTranslatorGroupPack(group);
+  if(grouppack){
+    NAListIterator preflangit = naMakeListAccessor(&(NA_TRANSLATOR->languagepreferences));
+    NABool found = NA_FALSE;
+    while(!found && naIterateList(&preflangit)){
+      NATree* languagepack = na_GetTranslatorLanguagePack(grouppack, naGetListCurConst(&preflangit));
+      if(languagepack){
+        NATreeIterator stringiter = naMakeTreeAccessor(languagepack);
+        found = naLocateTreeKey(&stringiter, &id, NA_FALSE);
+        if(found){
+          retValue = naGetTreeCurLeafConst(&stringiter);
+        }
+        naClearTreeIterator(&stringiter);
+      }
+    }
+    naClearListIterator(&preflangit);
+  }
+  return retValue;
+}
+
+
+
+// Resolves all strings of a group according to the language preferences.
+// The least preferred language is stored first and then overwritten by the
+// more preferred ones.
+NA_HDEF void na_BuildTranslatorTable(NATranslatorTable* table, NATree* grouppack){
+  NAInt minid = NA_MAX_i;
+  NAInt maxid = NA_MIN_i;
+  NAInt insertcount = 0;
+  NAListIterator preflangit;
+
+  table->minid = 0;
+  table->stringcount = 0;
+  table->strings = NA_NULL;
+
+  preflangit = naMakeListAccessor(&(NA_TRANSLATOR->languagepreferences));
+  while(naIterateList(&preflangit)){
+    NATree* languagepack = na_GetTranslatorLanguagePack(grouppack, naGetListCurConst(&preflangit));
+    if(languagepack){
+      NATreeIterator stringiter = naMakeTreeAccessor(languagepack);
+      while(naIterateTree(&stringiter, NA_NULL, NA_NULL)){
+        NAInt id = *(const NAInt*)naGetTreeCurLeafKey(&stringiter);
+        if(id < minid){minid = id;}
+        if(id > maxid){maxid = id;}
+        insertcount++;
+      }
+      naClearTreeIterator(&stringiter);
+    }
+  }
+  naClearListIterator(&preflangit);
+
+  if(!insertcount){return;}
+
+  // The range is computed unsigned as maxid - minid may overflow.
+  if((size_t)maxid - (size_t)minid >= (size_t)insertcount * NA_TRANSLATOR_TABLE_MAX_SLOTS_PER_STRING){
+    table->stringcount = -1;
+    return;
+  }
+
+  table->minid = minid;
+  table->stringcount = maxid - minid + 1;
+  table->strings = naMalloc((size_t)table->stringcount * sizeof(const NAUTF8Char*));
+  naZeron(table->strings, (size_t)table->stringcount * sizeof(const NAUTF8Char*));
+
+  preflangit = naMakeListAccessor(&(NA_TRANSLATOR->languagepreferences));
+  while(naIterateListBack(&preflangit)){
+    NATree* languagepack = na_GetTranslatorLanguagePack(grouppack, naGetListCurConst(&preflangit));
+    if(languagepack){
+      NATreeIterator stringiter = naMakeTreeAccessor(languagepack);
+      while(naIterateTree(&stringiter, NA_NULL, NA_NULL)){
+        NAInt id = *(const NAInt*)naGetTreeCurLeafKey(&stringiter);
+        table->strings[id - minid] = naGetTreeCurLeafConst(&stringiter);
+      }
+      naClearTreeIterator(&stringiter);
+    }
+  }
+  naClearListIterator(&preflangit);
+}
+
+
+
+NA_HDEF void na_BuildTranslatorTables(void){
+  NAInt group;
+  na_ClearTranslatorTables();
+
+  NA_TRANSLATOR->tablecount = NA_TRANSLATOR->curgroup + 1;
+  if(NA_TRANSLATOR->tablecount){
+    NA_TRANSLATOR->tables = naMalloc((size_t)NA_TRANSLATOR->tablecount * sizeof(NATranslatorTable));
+    for(group = 0; group < NA_TRANSLATOR->tablecount; group++){
+      NATree* grouppack = na_GetTranslatorGroupPack(group);
+      if(grouppack){
+        na_BuildTranslatorTable(&(NA_TRANSLATOR->tables[group]), grouppack);
+      }else{
+        NA_TRANSLATOR->tables[group].minid = 0;
+        NA_TRANSLATOR->tables[group].stringcount = 0;
+        NA_TRANSLATOR->tables[group].strings = NA_NULL;
+      }
+    }
+  }
+  NA_TRANSLATOR->tablesvalid = NA_TRUE;
 }
 
 
 
 NA_DEF const NAUTF8Char* naTranslate(NAInt group, NAInt id){
-  const NAUTF8Char* retValue = "String not found";
-  NATreeIterator groupiter;
-  NABool groupfound;
+  const NAUTF8Char* retValue = NA_NULL;
   
   #if NA_DEBUG
     #if NA_COMPILE_GUI == 1
@@ -244,40 +430,21 @@ NA_DEF const NAUTF8Char* naTranslate(NAInt group, NAInt id){
         naCrash("No translator running. Please use naStartTranslator.");
     #endif
   #endif
-  
-  // Search for the group pack.
-  groupiter = naMakeTreeModifier(&(NA_TRANSLATOR->groups));
-  groupfound = naLocateTreeKey(&groupiter, &group, NA_TRUE);
-  if(groupfound){
-    NATree* grouppack = naGetTreeCurLeafMutable(&groupiter);
 
-    // Go through the list of preferred languages
-    NAListIterator preflangit = naMakeListAccessor(&(NA_TRANSLATOR->languagepreferences));
-    NABool found = NA_FALSE;
-    while(!found && naIterateList(&preflangit)){
-      const NALanguageCode3* curlang = naGetListCurConst(&preflangit);
-    
-      // Search for the language pack.
-      NATreeIterator languageiter = naMakeTreeModifier(grouppack);
-      NABool langfound = naLocateTreeKey(&languageiter, curlang, NA_TRUE);
-      if(langfound){
-        NATree* languagepack = naGetTreeCurLeafMutable(&languageiter);
-        
-        // Search for the string entry.
-        NATreeIterator stringiter = naMakeTreeModifier(languagepack);
-        found = naLocateTreeKey(&stringiter, &id, NA_FALSE);
-        if(found){
-          retValue = naGetTreeCurLeafConst(&stringiter);
-        }
-        naClearTreeIterator(&stringiter);
-      }
-      naClearTreeIterator(&languageiter);
+  if(!NA_TRANSLATOR->tablesvalid){
+    na_BuildTranslatorTables();
+  }
+
+  if(group >= 0 && group < NA_TRANSLATOR->tablecount && NA_TRANSLATOR->tables[group].stringcount != -1){
+    const NATranslatorTable* table = &(NA_TRANSLATOR->tables[group]);
+    if(id >= table->minid && (size_t)id - (size_t)table->minid < (size_t)table->stringcount){
+      retValue = table->strings[id - table->minid];
     }
-    naClearListIterator(&preflangit);
+  }else{
+    retValue = na_LookupTranslatorString(group, id);
   }
-  naClearTreeIterator(&groupiter);
 
-  return retValue;
+  return retValue ? retValue : "String not found";
 }
 
 
@@ -7,8 +7,9 @@
 
 
 
-// The typedef needs to be here to resolve cyclic include problems.
+// The typedefs need to be here to resolve cyclic include problems.
 typedef struct NAFile NAFile;
+typedef struct NAByteSpan NAByteSpan;
 
 
 
@@ -78,10 +79,12 @@ typedef struct NAFile NAFile;
   #define NA_FILE_OPEN_FLAGS_READ (O_RDONLY | O_BINARY)
   #define NA_FILE_OPEN_FLAGS_WRITE (O_WRONLY | O_CREAT | O_TRUNC | O_BINARY)
   #define NA_FILE_OPEN_FLAGS_APPEND (O_WRONLY | O_CREAT | O_APPEND | O_BINARY)
-#elif NA_OS == NA_OS_MAC_OS_X
+#else
   #include <unistd.h>
   #include <dirent.h>
-  #include <copyfile.h>
+  #if NA_OS == NA_OS_MAC_OS_X
+    #include <copyfile.h>
+  #endif
   typedef off_t NAFileSize;     // Is signed (Important for negative offsets)
   #define NA_FILESIZE_BITS 64
   #define NA_FILESIZE_MAX NA_MAX_i64
@@ -192,6 +195,32 @@ NA_IAPI NAFileSize naReadFileBytes( NAFile* file,
                                       void* buf,
                                  NAFileSize byteSize);
 
+// Reads the given number of bytes starting at byteOffset of the file. Reads
+// until byteSize bytes have been read or the end of the file is reached.
+//
+// On Windows, the file pointer is moved behind the bytes read. On all other
+// systems, the internal file pointer is not used and stays unchanged. Every
+// read states its own offset. Therefore, reading at random positions is
+// possible even if multiple threads use the same file at the same time.
+//
+// Returns the number of bytes read.
+NA_API NAFileSize naReadFileBytesAt(NAFile* file,
+                                      void* buf,
+                                 NAFileSize byteOffset,
+                                 NAFileSize byteSize);
+
+// Maps the first byteSize bytes of a reading file into memory. Nothing is
+// read in advance, the system loads the pages when they are accessed for the
+// first time. The memory can be written to but the changes are private to
+// the process and never go back to the file.
+//
+// The mapping stays valid when the file is released. Unmap it with
+// naUnmapFileBytes using the same byteSize. Returns NA_NULL if the file can
+// not be mapped, for example because it is too big for the address space or
+// because it is a stream.
+NA_API void* naMapFileBytes(NAFile* file, NAFileSize byteSize);
+NA_API void  naUnmapFileBytes(void* data, NAFileSize byteSize);
+
 // Writes the given number of bytes from ptr to the file without further
 // manipulation. The buffer must be big enough, no overflow check is made.
 // This is basically just an encapsulating method for naWrite(). Have a look
@@ -203,6 +232,25 @@ NA_IAPI NAFileSize naWriteFileBytes(  NAFile* file,
                                   const void* ptr,
                                    NAFileSize byteSize);
 
+// A contiguous block of memory. Used to write multiple separate blocks with
+// one system call.
+struct NAByteSpan{
+  const void* data;
+  size_t byteSize;
+};
+
+// Writes all spans one after the other to the file. On all systems but
+// Windows, the spans are gathered with writev, up to IOV_MAX spans per call.
+// This saves a system call per span and does not need any copy into a
+// contiguous block. Windows has no such call for files and writes the spans
+// one by one. Spans with a byteSize of 0 are allowed.
+//
+// Returns the number of bytes written which is less than the total size of
+// all spans only if an error occured.
+NA_API NAFileSize naWriteFileByteSpans(   NAFile* file,
+                                   const NAByteSpan* spans,
+                                              size_t spanCount);
+
 
 // //////////////////////////
 // General input and output methods
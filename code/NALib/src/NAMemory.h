@@ -188,6 +188,17 @@ NA_IAPI void        naReleaseRefCount(NARefCount* refCount,
                                             void* data,
                                         NAMutator destructor);
 
+// Same as above but the count is changed atomically. Use these if the same
+// NARefCount is retained and released by different threads. Retaining does
+// not order any memory, releasing makes sure that the destructor sees all
+// changes made by other threads before they released.
+//
+// Never mix the atomic and non-atomic variants on the same NARefCount.
+NA_IAPI NARefCount* naRetainRefCountAtomic( NARefCount* refCount);
+NA_IAPI void        naReleaseRefCountAtomic(NARefCount* refCount,
+                                                  void* data,
+                                              NAMutator destructor);
+
 // ////////////////////////
 // NAPtr
 //
@@ -417,13 +428,107 @@ NA_IAPI size_t naGetRuntimeGarbageByteSize(void);
 NA_IAPI size_t naGetRuntimeMemoryPageSize(void);
 NA_IAPI size_t naGetRuntimePoolPartSize(void);
 
+// naNew and naDelete can be called from any thread. Every thread allocates
+// from pool parts it owns exclusively, deleting a value which was allocated
+// by another thread hands it back to the owning part without locking.
+//
+// When a thread ends, the parts it owns are handed back to the runtime so
+// that other threads can use them. Threads created with naMakeThread and the
+// workers of an NAThreadPool do this automatically. Any other thread which
+// used naNew shall call naDetachRuntimeThread before it ends. Calling it
+// when the runtime is not running does nothing.
+NA_API  void   naDetachRuntimeThread(void);
+
+// Releases the memory of all parts which are not owned by any thread and
+// which are empty, including the last part of a type which otherwise is kept
+// until the runtime stops. Empty parts of the current thread are released as
+// well. The system allocator is asked to hand freed memory back to the
+// operating system.
+//
+// Values can not be moved, hence a part can only be released when it is
+// empty. Therefore, the remaining parts are sorted such that new values are
+// created in the fullest parts first, giving nearly empty parts a chance to
+// become empty. Such parts are released automatically when their last value
+// is deleted or with the next call to this function.
+//
+// Returns the number of bytes of all released parts. Long running programs
+// may call this periodically or after a peak of memory usage.
+NA_API  size_t naTrimRuntimePools(void);
+
+// Statistics about the runtime types. Every type which has been used since
+// the runtime started has an index from 0 to naGetRuntimeTypeCount() - 1.
+// The values are gathered from all threads without stopping them. If other
+// threads use the runtime at the same time, the values might be slightly
+// inconsistent.
+//
+// count          Number of values currently in use. Values deleted by a
+//                different thread than the one which created them may be
+//                counted until the creating thread reuses their space.
+// peakCount      The highest count observed since the start. To keep naNew
+//                free of shared counters, the count is only observed when a
+//                thread needs a new part and when the statistics are read.
+//                Short peaks within the parts owned by threads might
+//                therefore be missed.
+// allocCount     Number of values created with naNew since the start.
+// deleteCount    Number of values deleted since the start.
+// partSize       Byte size of one pool part of the type.
+// partCount      Number of pool parts currently allocated for the type.
+// peakPartCount  The highest partCount since the start.
+// reservedBytes  Number of bytes in all parts: partCount * partSize.
+// usedBytes      Number of bytes in use: count * typeSize.
+//
+// In order to compute rates, take statistics at two points in time and
+// divide the differences of allocCount and deleteCount by the time passed.
+typedef struct NARuntimeTypeStats NARuntimeTypeStats;
+struct NARuntimeTypeStats{
+  const char* typeName;
+  size_t typeSize;       // Including the reference count, if any.
+  size_t count;
+  size_t peakCount;
+  size_t allocCount;
+  size_t deleteCount;
+  size_t partSize;
+  size_t partCount;
+  size_t peakPartCount;
+  size_t reservedBytes;
+  size_t usedBytes;
+};
+
+NA_API  size_t naGetRuntimeTypeCount(void);
+NA_API  void   naGetRuntimeTypeStats(NARuntimeTypeStats* stats, size_t index);
+
+// Prints the statistics of all types to the standard output, either as a
+// human readable table or as a JSON object.
+NA_API  void   naPrintRuntimeStats(void);
+NA_API  void   naPrintRuntimeStatsJSON(void);
+
 // In order to work with specific types, each type trying to use the runtime
 // system needs to register itself to the runtime system upon compile time.
 // This is achieved by defining a very specific variable of type NATypeInfo.
 // You can do so using the macro NA_RUNTIME_TYPE. Just write the typeName
 // and the function to use for destructing the type.
+//
+// refCounting denotes whether the values of the type are reference counted:
+// NA_FALSE      Not reference counted. Use naNew and naDelete.
+// NA_TRUE       Reference counted. Use naNew, naRetain and naRelease.
+// NA_REFCOUNTING_ATOMIC
+//               Same as NA_TRUE but the reference count is changed atomically
+//               which allows retaining and releasing the same value in
+//               different threads. This costs a little more, use it only for
+//               types which are really shared between threads.
 
 #define NA_RUNTIME_TYPE(typeName, destructor, refCounting)
+#define NA_REFCOUNTING_ATOMIC 2
+
+// The default size of the pool parts is NA_POOLPART_BYTESIZE. A type which
+// only has a handful of values alive at any time can use smaller parts to
+// not pin a whole part. The partSize must be a power of two, must not be
+// greater than NA_POOLPART_BYTESIZE and must fit the part header and at
+// least one value. Smaller parts are carved out of blocks of
+// NA_POOLPART_BYTESIZE which only contain parts of the same type. Such a
+// block is freed when none of its parts is in use anymore.
+
+#define NA_RUNTIME_TYPE_WITH_PART_SIZE(typeName, destructor, refCounting, partSize)
 
 // But note that this macro results in a variable definition and hence must be
 // written in an implementation file (.c). Also, the type must not be opaque
@@ -8,6 +8,7 @@
 
 #include "NACoord.h"
 #include "NABabyImage.h"
+#include "NAThreading.h"
 
 
 typedef struct NAPNG NAPNG;
@@ -37,6 +38,22 @@ NA_API size_t naGetPNGBytesPerPixel(NAPNGColorType colorType);
 
 NA_API void naWritePNGToPath(NAPNG* png, const char* filePath);
 
+// Creates a baby image directly from a png file. Compared to naNewPNGWithPath
+// followed by naCreateBabyImageFromPNG, the image data is decompressed,
+// unfiltered and converted line by line without storing the whole image in
+// between. Returns NA_NULL if the file can not be read.
+NA_API NABabyImage* naCreateBabyImageWithPNGPath(const char* filePath);
+
+// Creates baby images from many png files, using the workers of the given
+// pool. If pool is Null, the files are decoded one after another on the
+// current thread. images must have space for count pointers. Files which
+// can not be read result in a Null pointer.
+NA_API void naCreateBabyImagesWithPNGPaths(
+  NABabyImage**      images,
+  const char* const* filePaths,
+  size_t             count,
+  NAThreadPool*      pool);
+
 
 
 
@@ -7,8 +7,9 @@
 
 
 
-// The typedef needs to be here to resolve cyclic include problems.
+// The typedefs need to be here to resolve cyclic include problems.
 typedef struct NAString NAString;
+typedef struct NAStringView NAStringView;
 
 // The different newline-encodings as an enum type
 typedef enum{
@@ -257,6 +258,84 @@ NA_API float    naParseStringFloat (const NAString* string);
 NA_API double   naParseStringDouble(const NAString* string);
 
 
+
+// /////////////////////////////////////////
+// NAStringView
+// /////////////////////////////////////////
+
+// An NAStringView is a lightweight reference to UTF-8 characters somewhere
+// in memory, consisting of nothing but a pointer and a byteSize. It is not
+// a runtime type: It is stored on the stack, does not need to be deleted and
+// does not own its characters. A view stays valid only as long as the memory
+// it points to does. The characters are NOT Null-terminated.
+//
+// Use views to tokenize and parse large inputs without allocating a new
+// NAString for every token.
+
+// Creates a view of the given bytes or of a Null-terminated C string.
+NA_IAPI NAStringView naMakeStringView(   const NAUTF8Char* ptr,
+                                                    size_t byteSize);
+NA_IAPI NAStringView naMakeStringViewWithUTF8CString(
+                                         const NAUTF8Char* str);
+
+// Creates a view of the contents of the given string. This is zero-copy if
+// the string is stored in one contiguous block which is the case for all
+// strings created with a format or a C string. Otherwise, the contents are
+// copied into temporary memory like naGetStringUTF8Pointer does.
+NA_API NAStringView naMakeStringViewWithString(const NAString* string);
+
+// Creates a view of a part of the given view. Does not copy anything.
+NA_IAPI NAStringView naMakeStringViewExtraction(NAStringView view,
+                                                      size_t offset,
+                                                      size_t byteSize);
+
+NA_IAPI const NAUTF8Char* naGetStringViewUTF8Pointer(NAStringView view);
+NA_IAPI size_t naGetStringViewByteSize(NAStringView view);
+NA_IAPI NABool naIsStringViewEmpty(NAStringView view);
+
+// Creates a new NAString with a copy of the characters of the view.
+NA_API NAString* naNewStringWithStringView(NAStringView view);
+
+// Appends a copy of the characters of the view to originalString.
+NA_API void naAppendStringStringView(  NAString* originalString,
+                                    NAStringView view);
+
+// Compares a view to a string or to another view.
+NA_API NABool naEqualStringViewToString(   NAStringView view,
+                                         const NAString* string,
+                                                  NABool caseSensitive);
+NA_API NABool naEqualStringViews(          NAStringView view1,
+                                            NAStringView view2,
+                                                  NABool caseSensitive);
+
+// Returns the first token of view which is delimited by whitespaces. Leading
+// whitespaces are skipped. After this function, view starts at the first
+// non-whitespace after the token.
+NA_API NAStringView naParseStringViewToken(NAStringView* view);
+
+// Returns everything up to the first occurrence of delimiter. The delimiter
+// is not included. After this function, view starts right after the
+// delimiter. If there is no delimiter, the whole view is returned and view
+// becomes empty. Whitespaces are NOT stripped at all.
+NA_API NAStringView naParseStringViewTokenWithDelimiter(
+                                            NAStringView* view,
+                                              NAUTF8Char delimiter);
+
+// The same as the naParseString functions above. Parses the start of the view
+// which needs not to be Null-terminated.
+NA_API int8     naParseStringViewi8  (NAStringView view);
+NA_API int16    naParseStringViewi16 (NAStringView view);
+NA_API int32    naParseStringViewi32 (NAStringView view);
+NA_API NAi64    naParseStringViewi64 (NAStringView view);
+NA_API uint8    naParseStringViewu8  (NAStringView view);
+NA_API uint16   naParseStringViewu16 (NAStringView view);
+NA_API uint32   naParseStringViewu32 (NAStringView view);
+NA_API NAu64    naParseStringViewu64 (NAStringView view);
+NA_API float    naParseStringViewFloat (NAStringView view);
+NA_API double   naParseStringViewDouble(NAStringView view);
+
+
+
 // Inline implementations are in a separate file:
 #include "NAStruct/NAStringII.h"
 
@@ -1,9 +1,10 @@
 
 #include "../../NABuffer.h"
+#include <string.h>
 
 
 NA_HAPI void na_DeallocBuffer(NABuffer* buffer);
-NA_RUNTIME_TYPE(NABuffer, na_DeallocBuffer, NA_TRUE);
+NA_RUNTIME_TYPE(NABuffer, na_DeallocBuffer, NA_REFCOUNTING_ATOMIC);
 
 
 
@@ -206,20 +207,58 @@ NA_DEF NABuffer* naNewBufferWithSameSource(NABuffer* srcBuffer){
 
 
 
-// This is the filler method of the file input source descriptor
+// This is the filler method of the file input source descriptor. The bytes
+// are read at their position in the file, independent of any previous reads.
 NA_HDEF void na_FillBufferPartFile(void* dst, NARangei sourceRange, void* data){
-  // todo: position at range.origin.
-  naReadFileBytes(data, dst, sourceRange.length);
+  NAFileSize readSize = naReadFileBytesAt(data, dst, (NAFileSize)sourceRange.origin, (NAFileSize)sourceRange.length);
+  // If the file got shorter in the meantime, the rest stays defined.
+  if(readSize < (NAFileSize)sourceRange.length){
+    naZeron((NAByte*)dst + readSize, (size_t)(sourceRange.length - (NAInt)readSize));
+  }
 }
 
 
 
-NA_DEF NABuffer* naNewBufferWithInputPath(const char* filePath){
+typedef struct NA_FileMapping NA_FileMapping;
+struct NA_FileMapping{
+  void* data;
+  NAFileSize byteSize;
+};
+
+NA_HDEF void na_DestructFileMapping(NA_FileMapping* mapping){
+  naUnmapFileBytes(mapping->data, mapping->byteSize);
+  naFree(mapping);
+}
+
+
+
+// Creates a source with all bytes of the file mapped into memory. Returns
+// NA_NULL if the file can not be mapped.
+NA_HDEF NABufferSource* na_NewBufferSourceWithMappedFile(NAFile* file, NARangei range){
+  void* data = naMapFileBytes(file, (NAFileSize)range.length);
+  if(!data){return NA_NULL;}
+
+  NA_FileMapping* mapping = naAlloc(NA_FileMapping);
+  mapping->data = data;
+  mapping->byteSize = (NAFileSize)range.length;
+  NAMemoryBlock* block = na_NewMemoryBlockWithOwner(naMakePtrWithDataMutable(data), (size_t)range.length, mapping, (NAMutator)na_DestructFileMapping);
+
+  NABufferSource* source = naNewBufferSource(NA_NULL, NA_NULL);
+    na_SetBufferSourceMemoryBlock(source, block);
+    naSetBufferSourceLimit(source, range);
+  naRelease(block);
+  return source;
+}
+
+
+
+// Creates a buffer with the contents of the file. If mapFile is NA_FALSE, the
+// file is not mapped into memory but read through a cache buffer as it would
+// be if mapping failed.
+NA_HDEF NABuffer* na_NewBufferWithInputPath(const char* filePath, NABool mapFile){
   NARangei range;
   NAFile* file;
-  NABuffer* fileBuffer;
-  NABufferSource* readsource;
-  NABufferSource* bufsource;
+  NABufferSource* source = NA_NULL;
 
   NABuffer* buffer = naNew(NABuffer);
   na_InitBufferStruct(buffer);
@@ -227,21 +266,38 @@ NA_DEF NABuffer* naNewBufferWithInputPath(const char* filePath){
   file = naCreateFileReadingPath(filePath);
   range = naMakeRangei(0, (NAInt)naComputeFileByteSize(file));
 
-  fileBuffer = naNewBuffer(NA_FALSE);
-  readsource = naNewBufferSource(na_FillBufferPartFile, NA_NULL);
-    naSetBufferSourceData(readsource, file, (NAMutator)naReleaseFile);
-    naSetBufferSourceLimit(readsource, range);
-    fileBuffer->source = naRetain(readsource);
-    fileBuffer->sourceOffset = 0;
-  naRelease(readsource);
-
-  bufsource = naNewBufferSource(NA_NULL, fileBuffer);
-    buffer->source = naRetain(bufsource);
-    buffer->sourceOffset = 0;
-  naRelease(bufsource);
-  naRelease(fileBuffer);
-
-  na_EnsureBufferRange(buffer, 0, range.length);
+  if(range.length > 0){
+    // Preferably, the file is mapped into memory. The buffer parts then point
+    // directly to the mapped pages and any position in the file can be
+    // accessed without reading the bytes before.
+    if(mapFile){source = na_NewBufferSourceWithMappedFile(file, range);}
+
+    if(source){
+      naReleaseFile(file);
+    }else{
+      // If the file can not be mapped, the bytes are read on demand into a
+      // cache buffer which allows to access them again without reading.
+      NABuffer* fileBuffer = naNewBuffer(NA_FALSE);
+      NABufferSource* readsource = naNewBufferSource(na_FillBufferPartFile, NA_NULL);
+        naSetBufferSourceData(readsource, file, (NAMutator)naReleaseFile);
+        naSetBufferSourceLimit(readsource, range);
+        fileBuffer->source = naRetain(readsource);
+        fileBuffer->sourceOffset = 0;
+      naRelease(readsource);
+
+      source = naNewBufferSource(NA_NULL, fileBuffer);
+      naRelease(fileBuffer);
+    }
+  }else{
+    naReleaseFile(file);
+  }
+
+  buffer->source = source;
+  buffer->sourceOffset = 0;
+
+  if(range.length > 0){
+    na_EnsureBufferRange(buffer, 0, range.length);
+  }
   buffer->flags |= NA_BUFFER_FLAG_RANGE_FIXED;
 
   buffer->newlineEncoding = NA_NEWLINE_NATIVE;
@@ -252,6 +308,12 @@ NA_DEF NABuffer* naNewBufferWithInputPath(const char* filePath){
 
 
 
+NA_DEF NABuffer* naNewBufferWithInputPath(const char* filePath){
+  return na_NewBufferWithInputPath(filePath, NA_TRUE);
+}
+
+
+
 NA_DEF NABuffer* naNewBufferWithConstData(const void* data, size_t byteSize){
   NABufferPart* part;
   NARangei range;
@@ -501,17 +563,16 @@ NA_DEF NAInt naSearchBufferByteOffset(NABuffer* buffer, NAByte byte, NAInt start
     curByte = (const NAByte*)na_GetBufferPartDataPointerConst(&iter);
     if(forward){
       size_t remainingBytes = na_GetBufferPartByteSize(part) - (size_t)iter.partOffset;
-      while(remainingBytes){
-        if(*curByte == byte){
-          found = NA_TRUE;
-          break;
-        }
-        indexshift++;
-        curByte++;
-        remainingBytes--;
+      const NAByte* foundByte = memchr(curByte, byte, remainingBytes);
+      if(foundByte){
+        indexshift += foundByte - curByte;
+        found = NA_TRUE;
+      }else{
+        indexshift += (NAInt)remainingBytes;
       }
     }else{
-      size_t remainingBytes = (size_t)iter.partOffset;
+      // The byte at the current offset is included.
+      size_t remainingBytes = (size_t)iter.partOffset + 1;
       while(remainingBytes){
         if(*curByte == byte){
           found = NA_TRUE;
@@ -646,6 +707,15 @@ NA_DEF void naAppendBufferToBuffer(NABuffer* dstbuffer, const NABuffer* srcBuffe
 
 
 
+NA_DEF void naAppendBufferBytes(NABuffer* dstbuffer, const void* data, size_t byteSize){
+  NABufferIterator iter = naMakeBufferModifier(dstbuffer);
+  na_LocateBufferEnd(&iter);
+  naWriteBufferBytes(&iter, data, byteSize);
+  naClearBufferIterator(&iter);
+}
+
+
+
 NA_DEF void naCacheBufferRange(NABuffer* buffer, NARangei range){
   if(range.length){
     NABufferIterator iter = naMakeBufferModifier(buffer);
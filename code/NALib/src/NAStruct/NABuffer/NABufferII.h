@@ -214,9 +214,13 @@ struct NABufferTreeNodeData{
 
 
 
+// NABuffer
+NA_HAPI NABuffer* na_NewBufferWithInputPath(const char* filePath, NABool mapFile);
+
 // NAMemoryBlock
 NA_HAPI NAMemoryBlock* na_NewMemoryBlock(size_t byteSize);
 NA_HAPI NAMemoryBlock* na_NewMemoryBlockWithData(NAPtr data, size_t byteSize, NAMutator destructor);
+NA_HAPI NAMemoryBlock* na_NewMemoryBlockWithOwner(NAPtr data, size_t byteSize, void* owner, NAMutator ownerDestructor);
 NA_HIAPI const void* na_GetMemoryBlockDataPointerConst(NAMemoryBlock* block, size_t index);
 NA_HIAPI void* na_GetMemoryBlockDataPointerMutable(NAMemoryBlock* block, size_t index);
 
@@ -228,6 +232,9 @@ NA_HIAPI NABuffer* na_GetBufferSourceCache(NABufferSource* source);
 NA_HIAPI NABool na_HasBufferSourceLimit(const NABufferSource* source);
 NA_HIAPI NARangei na_GetBufferSourceLimit(const NABufferSource* source);
 NA_HIAPI void na_FillBufferSourceMemory(const NABufferSource* source, void* dst, NARangei range);
+NA_HAPI void na_SetBufferSourceMemoryBlock(NABufferSource* source, NAMemoryBlock* block);
+NA_HIAPI NABool na_HasBufferSourceMemoryBlock(const NABufferSource* source);
+NA_HIAPI NAMemoryBlock* na_GetBufferSourceMemoryBlock(const NABufferSource* source);
 
 
 
@@ -311,7 +311,7 @@ NA_HDEF NABuffer* na_GetBufferIteratorCache(NABufferIterator* iter){
     NABufferPart* part = na_GetBufferPart(iter);
     source = na_GetBufferPartSource(part);
   }
-  if(source){
+  if(source && na_HasBufferSourceCache(source)){
     return na_GetBufferSourceCache(source);
   }else{
     return NA_NULL;
@@ -191,33 +191,42 @@ NA_DEF void naAccumulateChecksumBuffer(NAChecksum* checksum, NABuffer* buffer){
 
 
 
-NA_DEF void naWriteBufferToFile(NABuffer* buffer, NAFile* file){
-  NAInt byteSize;
-  NABufferIterator iter;
+// The number of spans collected before they are written to a file.
+#define NA_BUFFER_SPANS_PER_WRITE 64
 
+NA_DEF void naWriteBufferToFile(NABuffer* buffer, NAFile* file){
   #if NA_DEBUG
     if(!naHasBufferFixedRange(buffer))
       naError("Buffer has no determined range. Use naFixBufferRange");
   #endif
 
-  byteSize = buffer->range.length;
+  size_t byteSize = (size_t)buffer->range.length;
   if(byteSize){
-    iter = naMakeBufferAccessor(buffer);
+    NAByteSpan spans[NA_BUFFER_SPANS_PER_WRITE];
+    size_t spanCount = 0;
+    NABufferIterator iter = naMakeBufferAccessor(buffer);
     na_LocateBufferStart(&iter);
 
+    // The parts are gathered and written in batches, saving a system call
+    // for every part.
     while(byteSize){
-      NABufferPart* part = na_GetBufferPart(&iter);
-      size_t remainingBytes = na_GetBufferPartByteSize(part);
-      const NAByte* src = na_GetBufferPartDataPointerConst(&iter);
-
       #if NA_DEBUG
-        if(na_IsBufferPartSparse(part))
+        if(na_IsBufferPartSparse(na_GetBufferPart(&iter)))
           naError("Buffer contains sparse parts.");
       #endif
-
-      naWriteFileBytes(file, src, (NAFileSize)remainingBytes);
-      na_LocateBufferNextPart(&iter);
+      size_t remainingBytes = naMins(na_GetBufferPartRemainingBytes(&iter), byteSize);
+      spans[spanCount].data = na_GetBufferPartDataPointerConst(&iter);
+      spans[spanCount].byteSize = remainingBytes;
+      spanCount++;
       byteSize -= remainingBytes;
+
+      if(spanCount == NA_BUFFER_SPANS_PER_WRITE || !byteSize){
+        naWriteFileByteSpans(file, spans, spanCount);
+        spanCount = 0;
+      }
+      if(byteSize){
+        na_LocateBufferNextPart(&iter);
+      }
     }
 
     naClearBufferIterator(&iter);
@@ -227,6 +236,44 @@ NA_DEF void naWriteBufferToFile(NABuffer* buffer, NAFile* file){
 
 
 
+NA_DEF size_t naGetBufferSpans(NABuffer* buffer, NARangei range, NAByteSpan* spans, size_t maxCount){
+  #if NA_DEBUG
+    if(range.length < 0)
+      naError("range length is negative.");
+    if(!spans && maxCount)
+      naCrash("spans is Null");
+  #endif
+  size_t spanCount = 0;
+  if(range.length > 0){
+    naCacheBufferRange(buffer, range);
+    NABufferIterator iter = naMakeBufferAccessor(buffer);
+    naLocateBufferAbsolute(&iter, range.origin);
+
+    size_t byteSize = (size_t)range.length;
+    while(byteSize){
+      #if NA_DEBUG
+        if(na_IsBufferIteratorSparse(&iter))
+          naError("Range contains sparse parts.");
+      #endif
+      size_t remainingBytes = naMins(na_GetBufferPartRemainingBytes(&iter), byteSize);
+      if(spanCount < maxCount){
+        spans[spanCount].data = na_GetBufferPartDataPointerConst(&iter);
+        spans[spanCount].byteSize = remainingBytes;
+      }
+      spanCount++;
+      byteSize -= remainingBytes;
+      if(byteSize){
+        na_LocateBufferNextPart(&iter);
+      }
+    }
+
+    naClearBufferIterator(&iter);
+  }
+  return spanCount;
+}
+
+
+
 NA_DEF void naWriteBufferToData(NABuffer* buffer, void* data){
   naCacheBufferRange(buffer, naGetBufferRange(buffer));
   NABufferIterator iter = naMakeBufferModifier(buffer);
@@ -3,6 +3,78 @@
 
 
 
+#if NA_SIMD_SSE2
+  #include <emmintrin.h>
+  #if NA_OS == NA_OS_WINDOWS
+    #include <intrin.h>
+  #endif
+#endif
+
+
+
+// The following functions scan a contiguous block of bytes and return the
+// index of the first byte matching a condition or byteSize if there is none.
+// With SSE2, 16 bytes are tested at once.
+
+#if NA_SIMD_SSE2
+  NA_HIDEF size_t na_GetFirstScanMaskIndex(int mask){
+    #if NA_OS == NA_OS_WINDOWS
+      unsigned long index;
+      _BitScanForward(&index, (unsigned long)mask);
+      return (size_t)index;
+    #else
+      return (size_t)__builtin_ctz((unsigned int)mask);
+    #endif
+  }
+#endif
+
+
+
+// Finds either of two bytes.
+NA_HIDEF size_t na_ScanBytesForEither(const NAByte* bytes, size_t byteSize, NAByte byte1, NAByte byte2){
+  size_t i = 0;
+  #if NA_SIMD_SSE2
+    const __m128i value1 = _mm_set1_epi8((char)byte1);
+    const __m128i value2 = _mm_set1_epi8((char)byte2);
+    for(; i + 16 <= byteSize; i += 16){
+      __m128i chunk = _mm_loadu_si128((const __m128i*)&bytes[i]);
+      int mask = _mm_movemask_epi8(_mm_or_si128(
+        _mm_cmpeq_epi8(chunk, value1),
+        _mm_cmpeq_epi8(chunk, value2)));
+      if(mask){return i + na_GetFirstScanMaskIndex(mask);}
+    }
+  #endif
+  for(; i < byteSize; ++i){
+    if(bytes[i] == byte1 || bytes[i] == byte2){break;}
+  }
+  return i;
+}
+
+
+
+// Finds a whitespace (ord <= 32) when whitespace is NA_TRUE, any other byte
+// otherwise.
+NA_HIDEF size_t na_ScanBytesForWhitespace(const NAByte* bytes, size_t byteSize, NABool whitespace){
+  size_t i = 0;
+  #if NA_SIMD_SSE2
+    // There is no unsigned comparison in SSE2 but a byte is a whitespace if
+    // the unsigned minimum with a space is the byte itself.
+    const __m128i space = _mm_set1_epi8(' ');
+    const int invert = whitespace ? 0 : 0xffff;
+    for(; i + 16 <= byteSize; i += 16){
+      __m128i chunk = _mm_loadu_si128((const __m128i*)&bytes[i]);
+      int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, space), chunk)) ^ invert;
+      if(mask){return i + na_GetFirstScanMaskIndex(mask);}
+    }
+  #endif
+  for(; i < byteSize; ++i){
+    if((bytes[i] <= ' ') == whitespace){break;}
+  }
+  return i;
+}
+
+
+
 NA_DEF void naSkipBufferWhitespaces(NABufferIterator* iter){
   NABool found = NA_FALSE;
 
@@ -15,14 +87,10 @@ NA_DEF void naSkipBufferWhitespaces(NABufferIterator* iter){
     if(naIsBufferAtInitial(iter)){break;}
     curByte = na_GetBufferPartDataPointerConst(iter);
 
-    while(iter->partOffset < (NAInt)na_GetBufferPartByteSize(part)){
-      if(*curByte > ' '){
-        found = NA_TRUE;
-        break;
-      }
-      curByte++;
-      iter->partOffset++;
-    }
+    size_t remainingBytes = na_GetBufferPartByteSize(part) - (size_t)iter->partOffset;
+    size_t index = na_ScanBytesForWhitespace(curByte, remainingBytes, NA_FALSE);
+    iter->partOffset += (NAInt)index;
+    found = (index < remainingBytes);
   }
 }
 
@@ -47,6 +115,7 @@ NA_DEF NAString* naParseBufferLine(NABufferIterator* iter, NABool skipEmpty){
   NABool checkWindowsEnd = NA_FALSE;
   NAInt start = naGetBufferLocation(iter);
   NAInt cur = start;
+  NAInt end = start;
   NABuffer* buffer = na_GetBufferIteratorBufferMutable(iter);
 
   while((!found || checkWindowsEnd) && !naIsBufferAtEnd(iter)){
@@ -57,36 +126,43 @@ NA_DEF NAString* naParseBufferLine(NABufferIterator* iter, NABool skipEmpty){
     part = na_GetBufferPart(iter);
     if(naIsBufferAtInitial(iter)){break;}
     curByte = na_GetBufferPartDataPointerConst(iter);
-    
-    // Note: Do not use NA_NL_XXX macros here. That is semantically wrong.
-    while(iter->partOffset < (NAInt)na_GetBufferPartByteSize(part)){
-      if(checkWindowsEnd){
-        checkWindowsEnd = NA_FALSE;
-        if(*curByte == '\n'){iter->partOffset++; break;}
+
+    if(checkWindowsEnd){
+      checkWindowsEnd = NA_FALSE;
+      if(*curByte == '\n'){
+        cur++;
+        iter->partOffset++;
+        if(!found){start = cur;}
       }
-      if(found){break;}
-      if((*curByte == '\r') || (*curByte == '\n')){
-        if(skipEmpty && ((cur - start) == 0)){
-          start++;
-        }else{
-          found = NA_TRUE;
-          string = naNewStringWithBufferExtraction(buffer, naMakeRangeiWithStartAndEnd(start, cur));
-        }
-        checkWindowsEnd = (*curByte == '\r');
+      continue;
+    }
+
+    // Note: Do not use NA_NL_XXX macros here. That is semantically wrong.
+    size_t remainingBytes = na_GetBufferPartByteSize(part) - (size_t)iter->partOffset;
+    size_t index = na_ScanBytesForEither(curByte, remainingBytes, '\r', '\n');
+    cur += (NAInt)index;
+    iter->partOffset += (NAInt)index;
+    if(index < remainingBytes){
+      checkWindowsEnd = (curByte[index] == '\r');
+      if(skipEmpty && cur == start){
+        start++;
+      }else{
+        found = NA_TRUE;
+        end = cur;
       }
-      curByte++;
       cur++;
       iter->partOffset++;
     }
   }
 
   if(!found){
-    NARangei remainingrange = naMakeRangeiWithStartAndEnd(start, naGetRangeiEnd(buffer->range));
-    if(!naIsRangeiEmpty(remainingrange)){
-      string = naNewStringWithBufferExtraction(buffer, remainingrange);
-    }else{
-      string = naNewString();
-    }
+    end = naGetRangeiEnd(buffer->range);
+  }
+  NARangei linerange = naMakeRangeiWithStartAndEnd(start, end);
+  if(!naIsRangeiEmpty(linerange)){
+    string = naNewStringWithBufferExtraction(buffer, linerange);
+  }else{
+    string = naNewString();
   }
   
   #if NA_DEBUG
@@ -99,6 +175,122 @@ NA_DEF NAString* naParseBufferLine(NABufferIterator* iter, NABool skipEmpty){
 
 
 
+NA_DEF NABufferLineIterator naMakeBufferLineIterator(NABuffer* buffer){
+  NABufferLineIterator lineIter;
+  lineIter.iter = naMakeBufferAccessor(buffer);
+  lineIter.line = NA_NULL;
+  lineIter.lineByteSize = 0;
+  lineIter.storage = NA_NULL;
+  lineIter.storageByteSize = 0;
+  lineIter.skipLineFeed = NA_FALSE;
+  return lineIter;
+}
+
+
+
+// Appends bytes to the line collected in the storage of the iterator.
+NA_HDEF void na_StoreBufferLineBytes(NABufferLineIterator* lineIter, size_t storedByteSize, const NAByte* bytes, size_t byteSize){
+  if(storedByteSize + byteSize > lineIter->storageByteSize){
+    size_t newByteSize = naMaxs(lineIter->storageByteSize * 2, storedByteSize + byteSize);
+    NAUTF8Char* newStorage = naMalloc(newByteSize);
+    if(storedByteSize){naCopyn(newStorage, lineIter->storage, storedByteSize);}
+    if(lineIter->storage){naFree(lineIter->storage);}
+    lineIter->storage = newStorage;
+    lineIter->storageByteSize = newByteSize;
+  }
+  if(byteSize){naCopyn(&lineIter->storage[storedByteSize], bytes, byteSize);}
+}
+
+
+
+NA_DEF NABool naIterateBufferLine(NABufferLineIterator* lineIter, NABool skipEmpty){
+  NABufferIterator* iter = &lineIter->iter;
+  NABool found = NA_FALSE;
+  // The bytes of the current part which belong to the line but have no line
+  // ending yet. They only get stored when the line continues in the next part.
+  const NAByte* pendingBytes = NA_NULL;
+  size_t pendingByteSize = 0;
+  size_t storedByteSize = 0;
+
+  while(!found && !naIsBufferAtEnd(iter)){
+    const NAByte* curByte;
+    const NABufferPart* part;
+
+    if(pendingByteSize){
+      na_StoreBufferLineBytes(lineIter, storedByteSize, pendingBytes, pendingByteSize);
+      storedByteSize += pendingByteSize;
+      pendingByteSize = 0;
+    }
+
+    na_PrepareBuffer(iter, 1);
+    part = na_GetBufferPart(iter);
+    if(naIsBufferAtInitial(iter)){break;}
+    curByte = na_GetBufferPartDataPointerConst(iter);
+
+    if(lineIter->skipLineFeed){
+      lineIter->skipLineFeed = NA_FALSE;
+      if(*curByte == '\n'){
+        iter->partOffset++;
+        continue;
+      }
+    }
+
+    size_t remainingBytes = na_GetBufferPartByteSize(part) - (size_t)iter->partOffset;
+    size_t index = na_ScanBytesForEither(curByte, remainingBytes, '\r', '\n');
+    if(index < remainingBytes){
+      lineIter->skipLineFeed = (curByte[index] == '\r');
+      iter->partOffset += (NAInt)index + 1;
+      if(storedByteSize){
+        na_StoreBufferLineBytes(lineIter, storedByteSize, curByte, index);
+        lineIter->line = lineIter->storage;
+        lineIter->lineByteSize = storedByteSize + index;
+        found = NA_TRUE;
+      }else if(index || !skipEmpty){
+        lineIter->line = (const NAUTF8Char*)curByte;
+        lineIter->lineByteSize = index;
+        found = NA_TRUE;
+      }
+    }else{
+      pendingBytes = curByte;
+      pendingByteSize = remainingBytes;
+      iter->partOffset += (NAInt)remainingBytes;
+    }
+  }
+
+  // The last line of the buffer has no line ending.
+  if(!found && (storedByteSize || pendingByteSize)){
+    if(storedByteSize){
+      na_StoreBufferLineBytes(lineIter, storedByteSize, pendingBytes, pendingByteSize);
+      lineIter->line = lineIter->storage;
+    }else{
+      lineIter->line = (const NAUTF8Char*)pendingBytes;
+    }
+    lineIter->lineByteSize = storedByteSize + pendingByteSize;
+    found = NA_TRUE;
+  }
+
+  if(!found){
+    lineIter->line = NA_NULL;
+    lineIter->lineByteSize = 0;
+  }
+  return found;
+}
+
+
+
+NA_DEF NAStringView naGetBufferLineStringView(const NABufferLineIterator* lineIter){
+  return naMakeStringView(lineIter->line, lineIter->lineByteSize);
+}
+
+
+
+NA_DEF void naClearBufferLineIterator(NABufferLineIterator* lineIter){
+  naClearBufferIterator(&lineIter->iter);
+  if(lineIter->storage){naFree(lineIter->storage);}
+}
+
+
+
 NA_DEF NAString* naParseBufferRemainder(NABufferIterator* iter){
   NABuffer* buffer = na_GetBufferIteratorBufferMutable(iter);
   NAInt abspos = naGetBufferLocation(iter);
@@ -124,15 +316,11 @@ NA_DEF NAString* naParseBufferToken(NABufferIterator* iter){
     if(naIsBufferAtInitial(iter)){break;}
     curByte = na_GetBufferPartDataPointerConst(iter);
 
-    while(iter->partOffset < (NAInt)na_GetBufferPartByteSize(part)){
-      if(*curByte <= ' '){
-        found = NA_TRUE;
-        break;
-      }
-      curByte++;
-      end++;
-      iter->partOffset++;
-    }
+    size_t remainingBytes = na_GetBufferPartByteSize(part) - (size_t)iter->partOffset;
+    size_t index = na_ScanBytesForWhitespace(curByte, remainingBytes, NA_TRUE);
+    end += (NAInt)index;
+    iter->partOffset += (NAInt)index;
+    found = (index < remainingBytes);
   }
 
   if(!found){
@@ -204,15 +392,11 @@ NA_DEF NAString* naParseBufferPathComponent(NABufferIterator* iter){
     if(naIsBufferAtInitial(iter)){break;}
     curByte = na_GetBufferPartDataPointerConst(iter);
 
-    while(iter->partOffset < (NAInt)na_GetBufferPartByteSize(part)){
-      if(*curByte == '/' || *curByte == '\\'){
-        found = NA_TRUE;
-        break;
-      }
-      curByte++;
-      end++;
-      iter->partOffset++;
-    }
+    size_t remainingBytes = na_GetBufferPartByteSize(part) - (size_t)iter->partOffset;
+    size_t index = na_ScanBytesForEither(curByte, remainingBytes, '/', '\\');
+    end += (NAInt)index;
+    iter->partOffset += (NAInt)index;
+    found = (index < remainingBytes);
   }
 
   if(!found){
@@ -5,6 +5,29 @@
 
 
 
+struct NABufferLineIterator{
+  NABufferIterator iter;
+  const NAUTF8Char* line;
+  size_t lineByteSize;
+  NAUTF8Char* storage;      // Collects lines crossing a part border.
+  size_t storageByteSize;
+  NABool skipLineFeed;      // The previous line ended with CR.
+};
+
+
+
+NA_IDEF const NAUTF8Char* naGetBufferLineUTF8Pointer(const NABufferLineIterator* lineIter){
+  return lineIter->line;
+}
+
+
+
+NA_IDEF size_t naGetBufferLineByteSize(const NABufferLineIterator* lineIter){
+  return lineIter->lineByteSize;
+}
+
+
+
 NA_IDEF int8 naParseBufferi8(NABufferIterator* iter, NABool skipDelimiter){
   NAi64 intvalue;
   naParseBufferDecimalSignedInteger(iter, &intvalue, 0, naMakei64WithLo(NA_MIN_i8), naMakei64WithLo(NA_MAX_i8));
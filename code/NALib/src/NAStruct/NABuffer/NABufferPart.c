@@ -346,6 +346,21 @@ NA_HDEF NABufferPart* na_PrepareBufferPartMemory(NATreeIterator* partIter, NARan
       naError("range origin is negative");
   #endif
 
+  // If the source has all of its bytes in one memory block, the whole part
+  // can simply reference that block. Nothing needs to be split or copied.
+  if(part->source && na_HasBufferSourceMemoryBlock(part->source)){
+    NAInt sourceOffset = na_GetBufferPartSourceOffset(part);
+    #if NA_DEBUG
+      if(sourceOffset < 0)
+        naError("source offset is negative");
+      if(na_HasBufferSourceLimit(part->source) && !naEqualRangei(naMakeRangeiWithRangeIntersection(naMakeRangei(sourceOffset, (NAInt)part->byteSize), na_GetBufferSourceLimit(part->source)), naMakeRangei(sourceOffset, (NAInt)part->byteSize)))
+        naError("part is out of source limit");
+    #endif
+    part->memBlock = naRetain(na_GetBufferSourceMemoryBlock(part->source));
+    part->blockOffset = (size_t)sourceOffset;
+    return part;
+  }
+
   // We try to split the current sparse part such that in the end, there is
   // a part containing at least the byte pointed to by partRange.origin but
   // possibly a few bytes more. We do this by aligning start and end at
@@ -399,15 +414,28 @@ NA_HDEF size_t na_PrepareBufferPart(NABufferIterator* iter, size_t byteCount){
     // We decide how to prepare the part.
     NABuffer* cache = na_GetBufferIteratorCache(iter);
     if(cache){
-      // There is a cache, so we try to fill the part with it.
+      // There is a cache, so we try to fill the part with it. The cache
+      // fills the part from its first byte on, therefore the bytes before
+      // the desired offset are split away first. Note that the iterator
+      // moves to the new part.
+      if(iter->partOffset > 0){
+        na_SplitBufferPart(&(iter->partIter), (size_t)iter->partOffset, part->byteSize);
+        iter->partOffset = 0;
+      }
       part = na_PrepareBufferPartCache(
         &(iter->partIter),
         naMakeRangei(iter->partOffset, (NAInt)byteCount));
     }else{
       // We have no cache, meaning, we prepare memory ourselfes.
-      part = na_PrepareBufferPartMemory(
+      NABufferPart* preparedPart = na_PrepareBufferPartMemory(
         &(iter->partIter),
         naMakeRangei(iter->partOffset, (NAInt)byteCount));
+      // If the part has been split, the iterator moved to a new part which
+      // starts right after the bytes remaining in the original part.
+      if(preparedPart != part){
+        iter->partOffset -= (NAInt)part->byteSize;
+      }
+      part = preparedPart;
     }
   }
   
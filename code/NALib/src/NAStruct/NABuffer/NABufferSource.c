@@ -4,7 +4,7 @@
 
 
 NA_HAPI void na_DestructBufferSource(NABufferSource* source);
-NA_RUNTIME_TYPE(NABufferSource, na_DestructBufferSource, NA_TRUE);
+NA_RUNTIME_TYPE(NABufferSource, na_DestructBufferSource, NA_REFCOUNTING_ATOMIC);
 
 
 
@@ -17,15 +17,37 @@ NA_DEF NABufferSource* naNewBufferSource(NABufferFiller filler, NABuffer* cache)
   source->dataDestructor = NA_NULL;
   source->flags = 0;
   source->limit = naMakeRangeiWithStartAndEnd(0, 0);
+  source->block = NA_NULL;
 
   return source;
 }
 
 
 
+// Lets the source hand out the given block instead of filling new memory.
+// Buffer parts reference the block directly, nothing gets copied.
+NA_HDEF void na_SetBufferSourceMemoryBlock(NABufferSource* source, NAMemoryBlock* block){
+  #if NA_DEBUG
+    if(!source)
+      naCrash("Source is Null");
+    if(!block)
+      naCrash("block is Null");
+    if(source->block)
+      naError("Source already has a memory block");
+    if(source->cache)
+      naError("A source with a memory block does not need a cache");
+  #endif
+  naRetain(block);
+  if(source->block){naRelease(source->block);}
+  source->block = block;
+}
+
+
+
 NA_HDEF void na_DestructBufferSource(NABufferSource* source){
   if(source->dataDestructor){source->dataDestructor(source->data);}
   if(source->cache){naRelease(source->cache);}
+  if(source->block){naRelease(source->block);}
 }
 
 
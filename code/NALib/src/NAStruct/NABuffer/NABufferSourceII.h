@@ -18,6 +18,7 @@ struct NABufferSource{
   NAMutator         dataDestructor; // Data destructor.
   uint32            flags;          // Flags for the source
   NARangei          limit;          // Range limit (used if flag set)
+  NAMemoryBlock*    block;          // Memory of the whole source, if any.
 };
 
 
@@ -99,6 +100,30 @@ NA_HIDEF NARangei na_GetBufferSourceLimit(const NABufferSource* source){
 
 
 
+// Returns NA_TRUE if the whole source is available as one memory block, for
+// example a mapped file. Byte 0 of the block is the source index 0.
+NA_HIDEF NABool na_HasBufferSourceMemoryBlock(const NABufferSource* source){
+  #if NA_DEBUG
+    if(!source)
+      naCrash("Source is Null");
+  #endif
+  return source->block != NA_NULL;
+}
+
+
+
+NA_HIDEF NAMemoryBlock* na_GetBufferSourceMemoryBlock(const NABufferSource* source){
+  #if NA_DEBUG
+    if(!source)
+      naCrash("Source is Null");
+    if(!na_HasBufferSourceMemoryBlock(source))
+      naError("source has no memory block");
+  #endif
+  return source->block;
+}
+
+
+
 NA_HIDEF void na_FillBufferSourceMemory(const NABufferSource* source, void* dst, NARangei range){
   #if NA_DEBUG
     if(!source)
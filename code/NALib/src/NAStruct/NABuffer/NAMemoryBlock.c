@@ -4,7 +4,7 @@
 
 
 NA_HAPI void na_DestructMemoryBlock(NAMemoryBlock* block);
-NA_RUNTIME_TYPE(NAMemoryBlock, na_DestructMemoryBlock, NA_TRUE);
+NA_RUNTIME_TYPE(NAMemoryBlock, na_DestructMemoryBlock, NA_REFCOUNTING_ATOMIC);
 
 
 
@@ -17,6 +17,7 @@ NA_HDEF NAMemoryBlock* na_NewMemoryBlock(size_t byteSize){
   NAMemoryBlock* block = naNew(NAMemoryBlock);
   block->data = naMakePtrWithDataMutable(naMalloc(byteSize));
   block->destructor = (NAMutator)naFree;
+  block->owner = NA_NULL;
   #if NA_DEBUG
     block->byteSize = byteSize;
   #endif
@@ -40,6 +41,33 @@ NA_HDEF NAMemoryBlock* na_NewMemoryBlockWithData(NAPtr data, size_t byteSize, NA
   block = naNew(NAMemoryBlock);
   block->data = data;
   block->destructor = destructor;
+  block->owner = NA_NULL;
+  #if NA_DEBUG
+    block->byteSize = byteSize;
+  #endif
+  return block;
+}
+
+
+
+// Creates a block accessing data which belongs to an owner object, for
+// example a file mapping. The ownerDestructor is called with the owner when
+// the block is no longer needed.
+NA_HDEF NAMemoryBlock* na_NewMemoryBlockWithOwner(NAPtr data, size_t byteSize, void* owner, NAMutator ownerDestructor){
+  #if NA_DEBUG
+    if(!naIsPtrValid(data))
+      naError("Invalid data");
+    if(byteSize == 0)
+      naError("byteSize is zero");
+    if(!owner)
+      naError("owner is Null");
+  #else
+    NA_UNUSED(byteSize);
+  #endif
+  NAMemoryBlock* block = naNew(NAMemoryBlock);
+  block->data = data;
+  block->destructor = ownerDestructor;
+  block->owner = owner;
   #if NA_DEBUG
     block->byteSize = byteSize;
   #endif
@@ -49,7 +77,9 @@ NA_HDEF NAMemoryBlock* na_NewMemoryBlockWithData(NAPtr data, size_t byteSize, NA
 
 
 NA_HDEF void na_DestructMemoryBlock(NAMemoryBlock* block){
-  if(block->destructor){
+  if(block->owner){
+    if(block->destructor){block->destructor(block->owner);}
+  }else if(block->destructor){
     block->destructor(naGetPtrMutable(block->data));
   }
 }
@@ -9,6 +9,7 @@ struct NAMemoryBlock{
   // automatic reference counting implemented as runtime type.
   NAPtr     data;
   NAMutator destructor;
+  void*     owner;      // If not Null, the destructor gets this instead of data.
   #if NA_DEBUG
     size_t  byteSize;
   #endif
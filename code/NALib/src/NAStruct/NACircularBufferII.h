@@ -1,10 +1,15 @@
-
 // This file contains inline implementations of the file NACircularBuffer.h
 // Do not include this file directly! It will automatically be included when
 // including "NACircularBuffer.h"
 
 
-#include "NAMemory.h"
+#include "../NAMemory.h"
+#include "../NAMathOperators.h"
+#include "../NAThreading.h"
+
+
+// Indices written by different threads are kept on different cache lines.
+#define NA_CIRCULAR_BUFFER_CACHE_LINE_SIZE 64
 
 
 struct NACircularBuffer{
@@ -14,38 +19,318 @@ struct NACircularBuffer{
   void** data;
 };
 
+// The indices are counting up forever and are masked when accessing the
+// data. Each side keeps a copy of the index of the other side which is only
+// updated when the buffer seems full or empty respectively. This avoids
+// reading the cache line of the other thread for every element.
+struct NASPSCCircularBuffer{
+  void** data;
+  NAInt mask;
+  NAByte padding0[NA_CIRCULAR_BUFFER_CACHE_LINE_SIZE - sizeof(void**) - sizeof(NAInt)];
+  NAInt head;         // Written by the consumer.
+  NAInt cachedTail;
+  NAByte padding1[NA_CIRCULAR_BUFFER_CACHE_LINE_SIZE - 2 * sizeof(NAInt)];
+  NAInt tail;         // Written by the producer.
+  NAInt cachedHead;
+  NAByte padding2[NA_CIRCULAR_BUFFER_CACHE_LINE_SIZE - 2 * sizeof(NAInt)];
+};
+
+typedef struct NAMPMCCircularBufferCell NAMPMCCircularBufferCell;
+struct NAMPMCCircularBufferCell{
+  NAInt sequence;
+  void* data;
+};
+
+struct NAMPMCCircularBuffer{
+  NAMPMCCircularBufferCell* cells;
+  NAInt mask;
+  NAByte padding0[NA_CIRCULAR_BUFFER_CACHE_LINE_SIZE - sizeof(NAMPMCCircularBufferCell*) - sizeof(NAInt)];
+  NAInt tail;         // Next position to push to.
+  NAByte padding1[NA_CIRCULAR_BUFFER_CACHE_LINE_SIZE - sizeof(NAInt)];
+  NAInt head;         // Next position to pull from.
+  NAByte padding2[NA_CIRCULAR_BUFFER_CACHE_LINE_SIZE - sizeof(NAInt)];
+};
+
+
+
+// ////////////////////////
+// NACircularBuffer
+// ////////////////////////
 
-NACircularBuffer* naInitCircularBuffer(NACircularBuffer* buffer, NAInt count){
+NA_IDEF NACircularBuffer* naInitCircularBuffer(NACircularBuffer* buffer, NAInt count){
+  #if NA_DEBUG
+    if(count < 1)
+      naError("count must be at least 1");
+  #endif
   buffer->space = count + 1;
   buffer->cur = 0;
   buffer->last = 0;
-  buffer->data = naMalloc(sizeof(void*) * buffer->space);
+  buffer->data = naMalloc(sizeof(void*) * (size_t)buffer->space);
+  return buffer;
 }
 
 
-void naClearCircularBuffer(NACircularBuffer* buffer){
+
+NA_IDEF void naClearCircularBuffer(NACircularBuffer* buffer){
   naFree(buffer->data);
 }
 
 
-void* naPullCircularBuffer(NACircularBuffer* buffer){
+
+NA_IDEF void* naPullCircularBuffer(NACircularBuffer* buffer){
+  void* retValue;
   #if NA_DEBUG
     if(buffer->last == buffer->cur)
-      naError("naNextCircularBuffer", "Buffer is empty");
+      naError("Buffer is empty");
   #endif
-  void* retValue = buffer->data[buffer->cur];
-  buffer->cur = buffer->cur % buffer->space;
+  retValue = buffer->data[buffer->cur];
+  buffer->cur = (buffer->cur + 1) % buffer->space;
   return retValue;
 }
 
 
-void naPushCircularBuffer(NACircularBuffer* buffer, void* newData){
+
+NA_IDEF void naPushCircularBuffer(NACircularBuffer* buffer, void* newData){
+  #if NA_DEBUG
+    if(naIsCircularBufferFull(buffer)){
+      naError("Buffer is full. Element will be lost.");
+      return;
+    }
+  #endif
   buffer->data[buffer->last] = newData;
-  buffer->last = buffer->last % buffer->space;
+  buffer->last = (buffer->last + 1) % buffer->space;
+}
+
+
+
+NA_IDEF NAInt naGetCircularBufferCount(const NACircularBuffer* buffer){
+  return (buffer->last - buffer->cur + buffer->space) % buffer->space;
+}
+
+
+
+NA_IDEF NABool naIsCircularBufferEmpty(const NACircularBuffer* buffer){
+  return buffer->last == buffer->cur;
+}
+
+
+
+NA_IDEF NABool naIsCircularBufferFull(const NACircularBuffer* buffer){
+  return (buffer->last + 1) % buffer->space == buffer->cur;
+}
+
+
+
+// Returns the smallest power of two which is greater or equal to count.
+NA_HIDEF NAInt na_GetCircularBufferCapacity(NAInt count){
+  NAInt capacity = 1;
   #if NA_DEBUG
-    if(buffer->last == buffer->cur)
-      naError("naPushCircularBuffer", "Buffer did just overflow");
+    if(count < 1)
+      naError("count must be at least 1");
   #endif
+  while(capacity < count){capacity <<= 1;}
+  return capacity;
+}
+
+
+
+// ////////////////////////
+// NASPSCCircularBuffer
+// ////////////////////////
+
+NA_IDEF NASPSCCircularBuffer* naInitSPSCCircularBuffer(NASPSCCircularBuffer* buffer, NAInt count){
+  NAInt capacity = na_GetCircularBufferCapacity(count);
+  buffer->data = naMalloc(sizeof(void*) * (size_t)capacity);
+  buffer->mask = capacity - 1;
+  buffer->head = 0;
+  buffer->cachedTail = 0;
+  buffer->tail = 0;
+  buffer->cachedHead = 0;
+  return buffer;
+}
+
+
+
+NA_IDEF void naClearSPSCCircularBuffer(NASPSCCircularBuffer* buffer){
+  naFree(buffer->data);
+}
+
+
+
+NA_IDEF NABool naPushSPSCCircularBuffer(NASPSCCircularBuffer* buffer, void* newData){
+  NAInt tail = buffer->tail;
+  if(tail - buffer->cachedHead > buffer->mask){
+    buffer->cachedHead = naLoadAtomicInt(&(buffer->head));
+    if(tail - buffer->cachedHead > buffer->mask){return NA_FALSE;}
+  }
+  buffer->data[tail & buffer->mask] = newData;
+  naStoreAtomicInt(&(buffer->tail), tail + 1);
+  return NA_TRUE;
+}
+
+
+
+NA_IDEF size_t naPushSPSCCircularBufferBatch(NASPSCCircularBuffer* buffer, void* const* newData, size_t count){
+  NAInt tail = buffer->tail;
+  NAInt space = buffer->mask + 1 - (tail - buffer->cachedHead);
+  if((size_t)space < count){
+    buffer->cachedHead = naLoadAtomicInt(&(buffer->head));
+    space = buffer->mask + 1 - (tail - buffer->cachedHead);
+    if((size_t)space < count){count = (size_t)space;}
+  }
+  for(size_t i = 0; i < count; ++i){
+    buffer->data[(tail + (NAInt)i) & buffer->mask] = newData[i];
+  }
+  // One release store publishes all elements at once.
+  if(count){naStoreAtomicInt(&(buffer->tail), tail + (NAInt)count);}
+  return count;
+}
+
+
+
+NA_IDEF NABool naPullSPSCCircularBuffer(NASPSCCircularBuffer* buffer, void** data){
+  NAInt head = buffer->head;
+  if(head == buffer->cachedTail){
+    buffer->cachedTail = naLoadAtomicInt(&(buffer->tail));
+    if(head == buffer->cachedTail){return NA_FALSE;}
+  }
+  *data = buffer->data[head & buffer->mask];
+  naStoreAtomicInt(&(buffer->head), head + 1);
+  return NA_TRUE;
+}
+
+
+
+NA_IDEF size_t naPullSPSCCircularBufferBatch(NASPSCCircularBuffer* buffer, void** data, size_t maxCount){
+  NAInt head = buffer->head;
+  size_t count = (size_t)(buffer->cachedTail - head);
+  if(count < maxCount){
+    buffer->cachedTail = naLoadAtomicInt(&(buffer->tail));
+    count = (size_t)(buffer->cachedTail - head);
+  }
+  if(count > maxCount){count = maxCount;}
+  for(size_t i = 0; i < count; ++i){
+    data[i] = buffer->data[(head + (NAInt)i) & buffer->mask];
+  }
+  if(count){naStoreAtomicInt(&(buffer->head), head + (NAInt)count);}
+  return count;
+}
+
+
+
+// ////////////////////////
+// NAMPMCCircularBuffer
+// ////////////////////////
+
+// A cell at position pos is ready to be pushed to if its sequence equals
+// pos and ready to be pulled from if its sequence equals pos + 1. Pulling
+// sets the sequence to pos + capacity which is the next push position
+// mapping to the same cell.
+
+NA_IDEF NAMPMCCircularBuffer* naInitMPMCCircularBuffer(NAMPMCCircularBuffer* buffer, NAInt count){
+  NAInt capacity = na_GetCircularBufferCapacity(count);
+  buffer->cells = naMalloc(sizeof(NAMPMCCircularBufferCell) * (size_t)capacity);
+  for(NAInt i = 0; i < capacity; ++i){
+    buffer->cells[i].sequence = i;
+  }
+  buffer->mask = capacity - 1;
+  buffer->tail = 0;
+  buffer->head = 0;
+  return buffer;
+}
+
+
+
+NA_IDEF void naClearMPMCCircularBuffer(NAMPMCCircularBuffer* buffer){
+  naFree(buffer->cells);
+}
+
+
+
+NA_IDEF NABool naPushMPMCCircularBuffer(NAMPMCCircularBuffer* buffer, void* newData){
+  return naPushMPMCCircularBufferBatch(buffer, &newData, 1) == 1;
+}
+
+
+
+NA_IDEF size_t naPushMPMCCircularBufferBatch(NAMPMCCircularBuffer* buffer, void* const* newData, size_t count){
+  size_t pushedCount = 0;
+  while(pushedCount < count){
+    NAInt tail = naLoadAtomicInt(&(buffer->tail));
+    NAInt freeCount = 0;
+    NAInt maxCount = naMini((NAInt)(count - pushedCount), buffer->mask + 1);
+
+    // Count the consecutive cells which are ready to be pushed to.
+    while(freeCount < maxCount){
+      NAMPMCCircularBufferCell* cell = &(buffer->cells[(tail + freeCount) & buffer->mask]);
+      if(naLoadAtomicInt(&(cell->sequence)) != tail + freeCount){break;}
+      freeCount++;
+    }
+
+    if(freeCount == 0){
+      NAMPMCCircularBufferCell* cell = &(buffer->cells[tail & buffer->mask]);
+      if(naLoadAtomicInt(&(cell->sequence)) < tail){
+        // The cell has not been pulled yet: The buffer is full.
+        break;
+      }
+      // Another thread has pushed in the meantime.
+      continue;
+    }
+
+    if(naCompareExchangeAtomicInt(&(buffer->tail), tail, tail + freeCount)){
+      for(NAInt i = 0; i < freeCount; ++i){
+        NAMPMCCircularBufferCell* cell = &(buffer->cells[(tail + i) & buffer->mask]);
+        cell->data = newData[pushedCount + (size_t)i];
+        naStoreAtomicInt(&(cell->sequence), tail + i + 1);
+      }
+      pushedCount += (size_t)freeCount;
+    }
+  }
+  return pushedCount;
+}
+
+
+
+NA_IDEF NABool naPullMPMCCircularBuffer(NAMPMCCircularBuffer* buffer, void** data){
+  return naPullMPMCCircularBufferBatch(buffer, data, 1) == 1;
+}
+
+
+
+NA_IDEF size_t naPullMPMCCircularBufferBatch(NAMPMCCircularBuffer* buffer, void** data, size_t maxCount){
+  size_t pulledCount = 0;
+  while(pulledCount < maxCount){
+    NAInt head = naLoadAtomicInt(&(buffer->head));
+    NAInt filledCount = 0;
+    NAInt maxFilledCount = naMini((NAInt)(maxCount - pulledCount), buffer->mask + 1);
+
+    // Count the consecutive cells which are ready to be pulled from.
+    while(filledCount < maxFilledCount){
+      NAMPMCCircularBufferCell* cell = &(buffer->cells[(head + filledCount) & buffer->mask]);
+      if(naLoadAtomicInt(&(cell->sequence)) != head + filledCount + 1){break;}
+      filledCount++;
+    }
+
+    if(filledCount == 0){
+      NAMPMCCircularBufferCell* cell = &(buffer->cells[head & buffer->mask]);
+      if(naLoadAtomicInt(&(cell->sequence)) < head + 1){
+        // The cell has not been pushed yet: The buffer is empty.
+        break;
+      }
+      // Another thread has pulled in the meantime.
+      continue;
+    }
+
+    if(naCompareExchangeAtomicInt(&(buffer->head), head, head + filledCount)){
+      for(NAInt i = 0; i < filledCount; ++i){
+        NAMPMCCircularBufferCell* cell = &(buffer->cells[(head + i) & buffer->mask]);
+        data[pulledCount + (size_t)i] = cell->data;
+        naStoreAtomicInt(&(cell->sequence), head + i + buffer->mask + 1);
+      }
+      pulledCount += (size_t)filledCount;
+    }
+  }
+  return pulledCount;
 }
 
 
@@ -488,6 +488,7 @@ NA_DEF NAString* naNewStringXMLEncoded(const NAString* inputString){
   }
   buffer = naNewBuffer(NA_FALSE);
   iter = naMakeBufferAccessor(inputString->buffer);
+  na_LocateBufferStart(&iter);
   outiter = naMakeBufferModifier(buffer);
   while(!naIsBufferAtInitial(&iter)){
     NAUTF8Char curchar = naReadBufferi8(&iter);
@@ -520,6 +521,7 @@ NA_DEF NAString* naNewStringXMLDecoded(const NAString* inputString){
   }
   buffer = naNewBuffer(NA_FALSE);
   iter = naMakeBufferAccessor(inputString->buffer);
+  na_LocateBufferStart(&iter);
   outiter = naMakeBufferModifier(buffer);
   while(!naIsBufferAtInitial(&iter)){
     NAUTF8Char curchar = naReadBufferi8(&iter);
@@ -562,6 +564,7 @@ NA_DEF NAString* naNewStringEPSEncoded(const NAString* inputString){
   }
   buffer = naNewBuffer(NA_FALSE);
   iter = naMakeBufferAccessor(inputString->buffer);
+  na_LocateBufferStart(&iter);
   outiter = naMakeBufferModifier(buffer);
   while(!naIsBufferAtInitial(&iter)){
     NAUTF8Char curchar = naReadBufferi8(&iter);
@@ -590,6 +593,7 @@ NA_DEF NAString* naNewStringEPSDecoded(const NAString* inputString){
   }
   buffer = naNewBuffer(NA_FALSE);
   iter = naMakeBufferAccessor(inputString->buffer);
+  na_LocateBufferStart(&iter);
   outiter = naMakeBufferModifier(buffer);
   while(!naIsBufferAtInitial(&iter)){
     NAUTF8Char curchar = naReadBufferi8(&iter);
@@ -859,6 +863,179 @@ NA_DEF double naParseStringDouble(const NAString* string){
 
 
 
+NA_DEF NAStringView naMakeStringViewWithString(const NAString* string){
+  #if NA_DEBUG
+    if(!string)
+      naCrash("string is Null-Pointer.");
+  #endif
+  if(naIsStringEmpty(string)){
+    return naMakeStringView((const NAUTF8Char*)"", 0);
+  }
+  NAByteSpan span;
+  NARangei range = naGetBufferRange(string->buffer);
+  if(naGetBufferSpans(string->buffer, range, &span, 1) == 1){
+    return naMakeStringView((const NAUTF8Char*)span.data, span.byteSize);
+  }
+  return naMakeStringView(naGetStringUTF8Pointer(string), (size_t)range.length);
+}
+
+
+
+NA_DEF NAString* naNewStringWithStringView(NAStringView view){
+  if(naIsStringViewEmpty(view)){return naNewString();}
+  NAUTF8Char* stringBuf = naMalloc(view.byteSize + 1);
+  naCopyn(stringBuf, view.ptr, view.byteSize);
+  stringBuf[view.byteSize] = '\0';
+  return naNewStringWithMutableUTF8Buffer(stringBuf, view.byteSize, (NAMutator)naFree);
+}
+
+
+
+NA_DEF void naAppendStringStringView(NAString* originalString, NAStringView view){
+  if(naIsStringViewEmpty(view)){return;}
+  naAppendBufferBytes(originalString->buffer, view.ptr, view.byteSize);
+}
+
+
+
+NA_DEF NABool naEqualStringViewToString(NAStringView view, const NAString* string, NABool caseSensitive){
+  return naEqualBufferToData(string->buffer, view.ptr, view.byteSize, caseSensitive);
+}
+
+
+
+NA_DEF NABool naEqualStringViews(NAStringView view1, NAStringView view2, NABool caseSensitive){
+  if(view1.byteSize != view2.byteSize){return NA_FALSE;}
+  // A length of 0 would mean Null-terminated strings.
+  if(!view1.byteSize || view1.ptr == view2.ptr){return NA_TRUE;}
+  return naEqualUTF8CStringLiterals(view1.ptr, view2.ptr, view1.byteSize, caseSensitive);
+}
+
+
+
+NA_DEF NAStringView naParseStringViewToken(NAStringView* view){
+  size_t start = 0;
+  while(start < view->byteSize && (NAByte)view->ptr[start] <= ' '){start++;}
+  size_t end = start;
+  while(end < view->byteSize && (NAByte)view->ptr[end] > ' '){end++;}
+  NAStringView token = naMakeStringView(view->ptr + start, end - start);
+  while(end < view->byteSize && (NAByte)view->ptr[end] <= ' '){end++;}
+  *view = naMakeStringView(view->ptr + end, view->byteSize - end);
+  return token;
+}
+
+
+
+NA_DEF NAStringView naParseStringViewTokenWithDelimiter(NAStringView* view, NAUTF8Char delimiter){
+  NAStringView token;
+  const NAUTF8Char* found = view->byteSize ? memchr(view->ptr, delimiter, view->byteSize) : NA_NULL;
+  if(found){
+    size_t tokenByteSize = (size_t)(found - view->ptr);
+    token = naMakeStringView(view->ptr, tokenByteSize);
+    *view = naMakeStringView(found + 1, view->byteSize - tokenByteSize - 1);
+  }else{
+    token = *view;
+    *view = naMakeStringView(view->ptr + view->byteSize, 0);
+  }
+  return token;
+}
+
+
+
+// Works like naParseBufferDecimalUnsignedInteger but on a contiguous view.
+NA_HDEF NAu64 na_ParseStringViewDecimalUnsignedInteger(const NAUTF8Char* ptr, size_t byteSize, NAu64 max){
+  NAu64 retValuei = NA_ZERO_u64;
+  NAu64 prevval = NA_ZERO_u64;
+  for(size_t i = 0; i < byteSize; ++i){
+    if((ptr[i] < '0') || (ptr[i] > '9')){break;}
+    retValuei = naAddu64(naMulu64(retValuei, naMakeu64WithLo(10)), naMakeu64WithLo((uint32)(ptr[i] - '0')));
+    #if NA_DEBUG
+      if(naGreateru64(retValuei, max))
+        naError("The value overflowed max.");
+      if(naSmalleru64(retValuei, prevval))
+        naError("The value overflowed 64 bit integer space.");
+    #endif
+    if(naSmalleru64(retValuei, prevval) || naGreateru64(retValuei, max)){
+      retValuei = max;
+    }
+    prevval = retValuei;
+  }
+  return retValuei;
+}
+
+
+
+// Works like naParseBufferDecimalSignedInteger but on a contiguous view.
+NA_HDEF NAi64 na_ParseStringViewDecimalSignedInteger(NAStringView view, NAi64 min, NAi64 max){
+  NABool negative = NA_FALSE;
+  NAu64 limit = naCasti64Tou64(max);
+  size_t start = 0;
+  if(view.byteSize && view.ptr[0] == '+'){
+    start = 1;
+  }else if(view.byteSize && view.ptr[0] == '-'){
+    negative = NA_TRUE;
+    // -min is not representable for NA_MIN_i64, hence it is computed unsigned.
+    limit = naAddu64(naCasti64Tou64(naNegi64(naAddi64(min, NA_ONE_i64))), NA_ONE_u64);
+    start = 1;
+  }
+  NAu64 intvalue = na_ParseStringViewDecimalUnsignedInteger(view.ptr + start, view.byteSize - start, limit);
+  if(negative){intvalue = naSubu64(NA_ZERO_u64, intvalue);}
+  return naCastu64Toi64(intvalue);
+}
+
+
+
+NA_DEF int8 naParseStringViewi8(NAStringView view){
+  return naCasti64Toi8(na_ParseStringViewDecimalSignedInteger(view, naMakei64WithLo(NA_MIN_i8), naMakei64WithLo(NA_MAX_i8)));
+}
+NA_DEF int16 naParseStringViewi16(NAStringView view){
+  return naCasti64Toi16(na_ParseStringViewDecimalSignedInteger(view, naMakei64WithLo(NA_MIN_i16), naMakei64WithLo(NA_MAX_i16)));
+}
+NA_DEF int32 naParseStringViewi32(NAStringView view){
+  return naCasti64Toi32(na_ParseStringViewDecimalSignedInteger(view, naMakei64WithLo(NA_MIN_i32), naMakei64WithLo(NA_MAX_i32)));
+}
+NA_DEF NAi64 naParseStringViewi64(NAStringView view){
+  return na_ParseStringViewDecimalSignedInteger(view, NA_MIN_i64, NA_MAX_i64);
+}
+
+
+
+NA_DEF uint8 naParseStringViewu8(NAStringView view){
+  return naCastu64Tou8(na_ParseStringViewDecimalUnsignedInteger(view.ptr, view.byteSize, naMakeu64WithLo(NA_MAX_u8)));
+}
+NA_DEF uint16 naParseStringViewu16(NAStringView view){
+  return naCastu64Tou16(na_ParseStringViewDecimalUnsignedInteger(view.ptr, view.byteSize, naMakeu64WithLo(NA_MAX_u16)));
+}
+NA_DEF uint32 naParseStringViewu32(NAStringView view){
+  return naCastu64Tou32(na_ParseStringViewDecimalUnsignedInteger(view.ptr, view.byteSize, naMakeu64WithLo(NA_MAX_u32)));
+}
+NA_DEF NAu64 naParseStringViewu64(NAStringView view){
+  return na_ParseStringViewDecimalUnsignedInteger(view.ptr, view.byteSize, NA_MAX_u64);
+}
+
+
+
+// The view is not Null-terminated, therefore the characters are copied onto
+// the stack, just as many as naParseStringFloat considers.
+NA_DEF float naParseStringViewFloat(NAStringView view){
+  return (float)naParseStringViewDouble(view);
+}
+NA_DEF double naParseStringViewDouble(NAStringView view){
+  NAUTF8Char buf[21];
+  size_t len = view.byteSize;
+  if(len > 20){
+    len = 20;
+    #if NA_DEBUG
+      naError("String truncated to 20 characters");
+    #endif
+  }
+  if(len){naCopyn(buf, view.ptr, len);}
+  buf[len] = '\0';
+  return atof(buf);
+}
+
+
+
 // This is free and unencumbered software released into the public domain.
 
 // Anyone is free to copy, modify, publish, use, compile, sell, or
@@ -10,6 +10,13 @@
 
 
 
+struct NAStringView{
+  const NAUTF8Char* ptr;
+  size_t byteSize;
+};
+
+
+
 
 NA_IDEF size_t naStrlen(const NAUTF8Char* str){
   return (size_t)strlen((const char*)str);
@@ -41,6 +48,57 @@ NA_IDEF size_t naVarargStringLength(const NAUTF8Char* string, va_list args){
 
 
 
+NA_IDEF NAStringView naMakeStringView(const NAUTF8Char* ptr, size_t byteSize){
+  NAStringView view;
+  #if NA_DEBUG
+    if(!ptr && byteSize)
+      naCrash("ptr is Null-Pointer.");
+  #endif
+  view.ptr = ptr;
+  view.byteSize = byteSize;
+  return view;
+}
+
+
+
+NA_IDEF NAStringView naMakeStringViewWithUTF8CString(const NAUTF8Char* str){
+  #if NA_DEBUG
+    if(!str)
+      naCrash("str is Null-Pointer.");
+  #endif
+  return naMakeStringView(str, naStrlen(str));
+}
+
+
+
+NA_IDEF NAStringView naMakeStringViewExtraction(NAStringView view, size_t offset, size_t byteSize){
+  #if NA_DEBUG
+    if(offset > view.byteSize || byteSize > view.byteSize - offset)
+      naError("Extraction overflows the view.");
+  #endif
+  return naMakeStringView(view.ptr + offset, byteSize);
+}
+
+
+
+NA_IDEF const NAUTF8Char* naGetStringViewUTF8Pointer(NAStringView view){
+  return view.ptr;
+}
+
+
+
+NA_IDEF size_t naGetStringViewByteSize(NAStringView view){
+  return view.byteSize;
+}
+
+
+
+NA_IDEF NABool naIsStringViewEmpty(NAStringView view){
+  return view.byteSize == 0;
+}
+
+
+
 // This is free and unencumbered software released into the public domain.
 
 // Anyone is free to copy, modify, publish, use, compile, sell, or
@@ -13,6 +13,25 @@
 // Returns true if the testing did start sucessfully, false otherwise.
 // A common reason for an unsuccessful start is to forget the rootName in
 // the command line arguments.
+//
+// The following executable arguments are recognized:
+// -C        Lets the naTestCrash tests actually crash.
+// -P        Runs the benchmarks grouped with naBenchmarkGroupFunction.
+// -O path   Writes all benchmark results to the given file. The file is
+//           written as JSON if the path ends with .json, as CSV otherwise.
+// -B path   Compares all benchmarks with a CSV file written by -O in an
+//           earlier run. Benchmarks which got significantly slower are
+//           marked as REGRESSION and counted upon naStopTesting.
+// -H        Reads the hardware performance counters of Linux (perf_event)
+//           around every benchmark sample and reports cycles, instructions,
+//           L1 data cache misses, last level cache misses and branch misses
+//           per execution. If the counters are not available, a message is
+//           printed and the benchmarks run without them.
+// -J count  Executes up to count test groups at the same time, each in its
+//           own worker process. A count of 0 uses one worker per processor.
+//           The results and printouts of a worker are added once the whole
+//           group is complete. Benchmarks wait for all workers and run on
+//           a single processor on Linux. Not available on Windows.
 NA_API NABool naStartTesting(
   const NAUTF8Char* rootName,
   double timePerBenchmark,
@@ -52,10 +71,23 @@ NA_API void naPrintUntested(void);
 // Use this to mark things untested but not forgotten.
 #define naUntested(text)
 
-// Runs a benchmark of expr as long until the time defined in naStartTesting
-// is reached. Outputs the number of executions per second.
+// Runs a benchmark of expr. The expression is repeated in batches of
+// growing size until a batch takes a fraction of the time defined in
+// naStartTesting. These runs serve as a warm-up. Then, multiple samples with
+// that batch size are measured with a monotonic clock. Outputs the number of
+// executions per second together with the median time per execution, the
+// 95th percentile, the median absolute deviation (MAD) and on x86 processors
+// the number of time stamp counter cycles per execution. With -H, the medians
+// of the hardware counters per execution are appended in brackets.
 #define naBenchmark(expr)
 
+// Groups together benchmarks by calling a function named the same as the
+// given identifier, but prefixed with "benchmark". Only executed if the
+// executable argument -P is given. The group names become part of the names
+// of the benchmark results. Benchmark groups are never executed by workers
+// of the -J argument.
+#define naBenchmarkGroupFunction(identifier)
+
 // Evaluates to a pseudo random number. Use this for test inputs to your
 // benchmark expression.
 #define naTestIn
@@ -10,9 +10,8 @@
 // Threading, Sleeping
 //
 // Note that in NALib, on Windows, the native threading functions of WINAPI are
-// used. On Mac, Grand Central Dispatch (GCD) is used. In the future, there
-// might be implementations planned for posix- as well as for C11-Threads. But
-// so far, they are not implemented yet.
+// used. On Mac, Grand Central Dispatch (GCD) is used. On all other systems,
+// POSIX threads (pthreads) are used. C11-Threads are not implemented yet.
 
 // Threading works differently on many systems and many frameworks. The data
 // structures used are also completely different. Therefore, all datatypes here
@@ -61,6 +60,10 @@ NA_IAPI NAThread naMakeThread( const char* threadName,
 NA_IAPI void naClearThread(NAThread thread);
 // Calling this function will execute the thread once.
 NA_IAPI void naRunThread(NAThread thread);
+// Waits until the last run of the given thread has finished. On Mac, this
+// waits for all runs which have been started so far. Joining a thread which
+// has not been run is an error when debugging.
+NA_IAPI void naJoinThread(NAThread thread);
 
 // //////////////////////////////////
 // Mutex
@@ -144,6 +147,109 @@ NA_IAPI void naTriggerAlarm(NAAlarm alarm);
 
 
 
+// //////////////////////////////////
+// Atomics
+//
+// Atomic operations on values which are shared among threads without being
+// guarded by a mutex. Loads have acquire semantics, stores have release
+// semantics and all read-modify-write operations as well as naFenceAtomic
+// are full memory barriers.
+//
+// The values must be naturally aligned and must only be accessed with these
+// functions as long as other threads might access them.
+
+NA_IAPI NAInt  naLoadAtomicInt           (NAInt* value);
+NA_IAPI void   naStoreAtomicInt          (NAInt* value, NAInt newValue);
+// Adds the summand and returns the resulting value.
+NA_IAPI NAInt  naAddAtomicInt            (NAInt* value, NAInt summand);
+// Stores newValue if the current value equals expected. Returns NA_TRUE if
+// the value has been stored.
+NA_IAPI NABool naCompareExchangeAtomicInt(NAInt* value,
+                                               NAInt expected,
+                                               NAInt newValue);
+
+NA_IAPI void*  naLoadAtomicPointer           (void** pointer);
+NA_IAPI void   naStoreAtomicPointer          (void** pointer, void* newValue);
+NA_IAPI NABool naCompareExchangeAtomicPointer(void** pointer,
+                                                   void* expected,
+                                                   void* newValue);
+
+NA_IAPI void   naFenceAtomic(void);
+
+
+
+// //////////////////////////////////
+// Thread pool
+//
+// A thread pool is a fixed set of worker threads executing many small tasks.
+// Every worker has its own double ended queue of tasks. A worker takes the
+// tasks it has added itself from the back of its queue and, when running out
+// of work, steals the oldest tasks from the front of the queues of the other
+// workers. Tasks added by threads which are not workers of the pool are
+// distributed through a shared queue.
+//
+// Tasks are always added to a task group which allows to wait until all of
+// its tasks have been executed. A thread waiting for a group helps executing
+// pending tasks in the meantime. Therefore, tasks can themselves add tasks
+// and wait for them without blocking a worker.
+//
+// Example:
+//
+// NAThreadPool* pool = naNewThreadPool(0);
+// NATaskGroup group;
+// naInitTaskGroup(&group, pool);
+// for(i = 0; i < count; ++i){naAddTask(&group, myFunction, &myData[i]);}
+// naClearTaskGroup(&group); // waits for all tasks.
+// naDelete(pool);
+
+typedef struct NAThreadPool NAThreadPool;
+typedef struct NATaskGroup NATaskGroup;
+typedef void (*NAParallelForFunction)(void* arg, size_t begin, size_t end);
+
+// Do not access the fields of a task group directly.
+struct NATaskGroup{
+  NAThreadPool* pool;
+  NAInt pendingCount;
+};
+
+// Returns the number of processors available to the current process.
+NA_IAPI size_t naGetSystemProcessorCount(void);
+
+// Creates a thread pool with the given number of workers. If workerCount is
+// 0, the number of processors is used. Delete the pool with naDelete after
+// all task groups have been waited for.
+NA_API NAThreadPool* naNewThreadPool(size_t workerCount);
+NA_API size_t naGetThreadPoolWorkerCount(const NAThreadPool* pool);
+
+// Initializes a task group which executes its tasks on the given pool.
+// Clearing the group waits for all of its tasks.
+NA_API NATaskGroup* naInitTaskGroup(NATaskGroup* group, NAThreadPool* pool);
+NA_API void naClearTaskGroup(NATaskGroup* group);
+
+// Adds a task to the group which calls function with arg. The task might
+// already be running when this function returns. Note that arg will NOT be
+// owned by the task.
+NA_API void naAddTask(NATaskGroup* group, NAMutator function, void* arg);
+
+// Waits until all tasks of the group have been executed, including the tasks
+// which have been added during the wait. Executes pending tasks of the pool
+// in the meantime.
+NA_API void naWaitTaskGroup(NATaskGroup* group);
+
+// Calls function for disjoint subranges [begin, end) covering 0 to count
+// in parallel and returns when all of them are done. The range is split in
+// halves recursively until a subrange has at most grainSize elements, which
+// lets idle workers steal big chunks first. If grainSize is 0, a size is
+// chosen which gives every worker several subranges.
+NA_API void naRunParallelFor(
+  NAThreadPool* pool,
+  size_t count,
+  size_t grainSize,
+  NAParallelForFunction function,
+  void* arg);
+
+
+
 
 
 
@@ -146,7 +146,13 @@ NA_API void naInsertTranslatorString(NAInt id, NAUTF8Char* str);
 NA_API void naSetTranslatorLanguagePreference(NALanguageCode3 code);
 
 // Returns the UTF8-String of the given id in the given group, according to
-// the language preferences.
+// the language preferences. The first call after inserting strings or after
+// changing the language preferences resolves all strings into one table per
+// group. Afterwards, this function is a simple array lookup. Ids may be any
+// number, including negative ones. A table costs one entry per id between
+// the smallest and the largest id of the group. Groups whose ids are spread
+// too far apart compared to the number of strings are not stored in a table
+// and are looked up in a tree instead.
 NA_API const NAUTF8Char* naTranslate(NAInt group, NAInt id);
 
 
@@ -1,12 +1,20 @@
 
 #include "../NABabyImage.h"
 #include "../NAVectorAlgebra.h"
+#include "../NAThreading.h"
+#include "../NAMathOperators.h"
+#include "../NABinaryData.h"
+
+#if NA_SIMD_SSE2
+  #include <emmintrin.h>
+#endif
 
 
 struct NABabyImage{
   NARefCount refCount;
   int32 width;
   int32 height;
+  NABool tiled;
   float* data;
 };
 
@@ -17,38 +25,178 @@ NA_DEF NAInt naGetBabyImageValuesPerLine(const NABabyImage* image){
   #if NA_DEBUG
     if(!image)
       naCrash("Given image is a Null-Pointer");
+    if(image->tiled)
+      naError("Tiled images have no lines. Use the tile functions.");
   #endif
   return (NAInt)image->width * NA_BABY_COLOR_CHANNEL_COUNT;
 }
 
 
 
-NA_HIDEF NAInt na_GetBabyImagePixelCount(const NABabyImage* image){
+NA_HIDEF size_t na_GetBabyImageTileCountX(const NABabyImage* image){
+  return ((size_t)image->width + NA_BABY_IMAGE_TILE_SIZE - 1) / NA_BABY_IMAGE_TILE_SIZE;
+}
+
+NA_HIDEF size_t na_GetBabyImageTileCountY(const NABabyImage* image){
+  return ((size_t)image->height + NA_BABY_IMAGE_TILE_SIZE - 1) / NA_BABY_IMAGE_TILE_SIZE;
+}
+
+
+
+// Returns the size of the image as it is stored in memory: A tiled image is
+// stored as one line of pixels for each tile, including the padding of the
+// tiles at the right and top border.
+NA_HIDEF NASizei na_GetBabyImageStorageSize(const NABabyImage* image){
   #if NA_DEBUG
     if(!image)
       naCrash("Given image is a Null-Pointer");
   #endif
-  return (NAInt)image->width * (NAInt)image->height;
+  if(image->tiled){
+    return naMakeSizei(
+      NA_BABY_IMAGE_TILE_SIZE * NA_BABY_IMAGE_TILE_SIZE,
+      (NAInt)(na_GetBabyImageTileCountX(image) * na_GetBabyImageTileCountY(image)));
+  }else{
+    return naMakeSizei(image->width, image->height);
+  }
+}
+
+
+
+NA_HIDEF size_t na_GetBabyImagePixelCount(const NABabyImage* image){
+  NASizei storageSize = na_GetBabyImageStorageSize(image);
+  return (size_t)storageSize.width * (size_t)storageSize.height;
 }
 
 
 
 NA_HIDEF size_t na_GetBabyImageDataSize(const NABabyImage* image){
+  return na_GetBabyImagePixelCount(image) * NA_BABY_COLOR_BYTES_PER_COMPONENT;
+}
+
+
+
+// Returns a pointer to the pixel at x and y and stores in runLength how many
+// pixels of the same line follow contiguously in memory, starting with that
+// pixel.
+NA_HIDEF float* na_GetBabyImageRun(const NABabyImage* image, size_t x, size_t y, size_t* runLength){
+  if(image->tiled){
+    size_t tileX = x / NA_BABY_IMAGE_TILE_SIZE;
+    size_t tileY = y / NA_BABY_IMAGE_TILE_SIZE;
+    size_t localX = x % NA_BABY_IMAGE_TILE_SIZE;
+    size_t localY = y % NA_BABY_IMAGE_TILE_SIZE;
+    size_t tileIndex = tileY * na_GetBabyImageTileCountX(image) + tileX;
+    *runLength = naMins(NA_BABY_IMAGE_TILE_SIZE - localX, (size_t)image->width - x);
+    return &image->data[((tileIndex * NA_BABY_IMAGE_TILE_SIZE + localY) * NA_BABY_IMAGE_TILE_SIZE + localX) * NA_BABY_COLOR_CHANNEL_COUNT];
+  }else{
+    *runLength = (size_t)image->width - x;
+    return &image->data[(y * (size_t)image->width + x) * NA_BABY_COLOR_CHANNEL_COUNT];
+  }
+}
+
+
+
+// Copies count pixels of line y starting at x between the image and the
+// given pixels.
+NA_HDEF void na_GetBabyImageLinePixels(const NABabyImage* image, size_t x, size_t y, size_t count, float* pixels){
+  while(count){
+    size_t runLength;
+    const float* run = na_GetBabyImageRun(image, x, y, &runLength);
+    runLength = naMins(runLength, count);
+    naCopyn(pixels, run, runLength * NA_BABY_COLOR_BYTES_PER_COMPONENT);
+    pixels += runLength * NA_BABY_COLOR_CHANNEL_COUNT;
+    x += runLength;
+    count -= runLength;
+  }
+}
+
+NA_HDEF void na_SetBabyImageLinePixels(NABabyImage* image, size_t x, size_t y, size_t count, const float* pixels){
+  while(count){
+    size_t runLength;
+    float* run = na_GetBabyImageRun(image, x, y, &runLength);
+    runLength = naMins(runLength, count);
+    naCopyn(run, pixels, runLength * NA_BABY_COLOR_BYTES_PER_COMPONENT);
+    pixels += runLength * NA_BABY_COLOR_CHANNEL_COUNT;
+    x += runLength;
+    count -= runLength;
+  }
+}
+
+
+
+NA_DEF float* naGetBabyImageData(const NABabyImage* image){
   #if NA_DEBUG
     if(!image)
       naCrash("Given image is a Null-Pointer");
+    if(image->tiled)
+      naError("The data of tiled images is not stored line by line. Use the tile functions.");
   #endif
-  return (size_t)image->width * (size_t)image->height * NA_BABY_COLOR_BYTES_PER_COMPONENT;
+  return image->data;
 }
 
 
 
-NA_DEF float* naGetBabyImageData(const NABabyImage* image){
+NA_DEF NABool naIsBabyImageTiled(const NABabyImage* image){
   #if NA_DEBUG
     if(!image)
       naCrash("Given image is a Null-Pointer");
   #endif
-  return image->data;
+  return image->tiled;
+}
+
+
+
+NA_DEF size_t naGetBabyImageTileCount(const NABabyImage* image){
+  #if NA_DEBUG
+    if(!image)
+      naCrash("Given image is a Null-Pointer");
+  #endif
+  return image->tiled
+    ? na_GetBabyImageTileCountX(image) * na_GetBabyImageTileCountY(image)
+    : 1;
+}
+
+
+
+NA_DEF NARecti naGetBabyImageTileRect(const NABabyImage* image, size_t tileIndex){
+  #if NA_DEBUG
+    if(tileIndex >= naGetBabyImageTileCount(image))
+      naError("tileIndex out of bounds");
+  #endif
+  if(image->tiled){
+    size_t tileX = tileIndex % na_GetBabyImageTileCountX(image);
+    size_t tileY = tileIndex / na_GetBabyImageTileCountX(image);
+    NAInt x = (NAInt)(tileX * NA_BABY_IMAGE_TILE_SIZE);
+    NAInt y = (NAInt)(tileY * NA_BABY_IMAGE_TILE_SIZE);
+    return naMakeRectiS(
+      x,
+      y,
+      naMini(NA_BABY_IMAGE_TILE_SIZE, image->width - x),
+      naMini(NA_BABY_IMAGE_TILE_SIZE, image->height - y));
+  }else{
+    return naMakeRectiS(0, 0, image->width, image->height);
+  }
+}
+
+
+
+NA_DEF float* naGetBabyImageTileData(const NABabyImage* image, size_t tileIndex){
+  #if NA_DEBUG
+    if(tileIndex >= naGetBabyImageTileCount(image))
+      naError("tileIndex out of bounds");
+  #endif
+  return &image->data[tileIndex * naGetBabyImageTileValuesPerLine(image) * NA_BABY_IMAGE_TILE_SIZE];
+}
+
+
+
+NA_DEF NAInt naGetBabyImageTileValuesPerLine(const NABabyImage* image){
+  #if NA_DEBUG
+    if(!image)
+      naCrash("Given image is a Null-Pointer");
+  #endif
+  return image->tiled
+    ? NA_BABY_IMAGE_TILE_SIZE * NA_BABY_COLOR_CHANNEL_COUNT
+    : (NAInt)image->width * NA_BABY_COLOR_CHANNEL_COUNT;
 }
 
 
@@ -63,7 +211,7 @@ NA_DEF NASizei naGetBabyImageSize(const NABabyImage* image){
 
 
 
-NA_DEF NABabyImage* naCreateBabyImage(NASizei size, const NABabyColor color){
+NA_HDEF NABabyImage* na_CreateBabyImage(NASizei size, const NABabyColor color, NABool tiled){
   NABabyImage* image;
   #if NA_DEBUG
     if(size.width <= 0 || size.height <= 0)
@@ -77,25 +225,148 @@ NA_DEF NABabyImage* naCreateBabyImage(NASizei size, const NABabyColor color){
   naInitRefCount(&image->refCount);
   image->width = (int32)size.width;
   image->height = (int32)size.height;
+  image->tiled = tiled;
   image->data = naMalloc(na_GetBabyImageDataSize(image));
   if(color){
-    NAInt i;
-    NAInt pixelCount = na_GetBabyImagePixelCount(image);
+    size_t pixelCount = na_GetBabyImagePixelCount(image);
     float* ptr = image->data;
-    for(i = 0; i < pixelCount; i++){
+    for(size_t i = 0; i < pixelCount; i++){
       naCopyV4f(ptr, color);
       ptr += NA_BABY_COLOR_CHANNEL_COUNT;
     }
+  }else if(tiled){
+    // The padding of the border tiles gets blended like all other pixels
+    // and hence must contain valid values.
+    size_t tileCountX = na_GetBabyImageTileCountX(image);
+    size_t tileCountY = na_GetBabyImageTileCountY(image);
+    size_t tileByteSize = NA_BABY_IMAGE_TILE_SIZE * NA_BABY_IMAGE_TILE_SIZE * NA_BABY_COLOR_BYTES_PER_COMPONENT;
+    for(size_t tileIndex = 0; tileIndex < tileCountX * tileCountY; tileIndex++){
+      NARecti rect = naGetBabyImageTileRect(image, tileIndex);
+      if(rect.size.width < NA_BABY_IMAGE_TILE_SIZE || rect.size.height < NA_BABY_IMAGE_TILE_SIZE){
+        naZeron(naGetBabyImageTileData(image, tileIndex), tileByteSize);
+      }
+    }
   }
   return image;
 }
 
 
 
-NA_HDEF void na_BlendBabyImage(NAInt pixelCount, float* ret, const float* base, const float* top, NABlendMode mode, float blend, NABool baseIsImage, NABool topIsImage){
-  NAInt i;
-  blend = naLinearizeColorValue(blend);
-  for(i = 0; i < pixelCount; i++){
+NA_DEF NABabyImage* naCreateBabyImage(NASizei size, const NABabyColor color){
+  return na_CreateBabyImage(size, color, NA_FALSE);
+}
+
+
+
+NA_DEF NABabyImage* naCreateBabyImageTiled(NASizei size, const NABabyColor color){
+  return na_CreateBabyImage(size, color, NA_TRUE);
+}
+
+
+
+// Images with at least this many pixels are processed in bands of lines on
+// the thread pool given with naSetBabyImageThreadPool.
+#define NA_BABY_IMAGE_PARALLEL_PIXEL_COUNT (1 << 18)
+#define NA_BABY_IMAGE_BAND_PIXEL_COUNT     (1 << 16)
+
+static NAThreadPool* na_BabyImageThreadPool = NA_NULL;
+
+
+
+NA_DEF void naSetBabyImageThreadPool(NAThreadPool* pool){
+  naStoreAtomicPointer((void**)&na_BabyImageThreadPool, pool);
+}
+
+
+
+// Calls function for all lines of an image with the given size. Large images
+// are split into bands of lines which run in parallel.
+NA_HDEF void na_RunBabyImageLines(NASizei size, NAParallelForFunction function, void* job){
+  NAThreadPool* pool = naLoadAtomicPointer((void**)&na_BabyImageThreadPool);
+  size_t width = (size_t)size.width;
+  size_t height = (size_t)size.height;
+  if(pool && width * height >= NA_BABY_IMAGE_PARALLEL_PIXEL_COUNT){
+    size_t bandHeight = naMaxs(1, NA_BABY_IMAGE_BAND_PIXEL_COUNT / width);
+    naRunParallelFor(pool, height, bandHeight, function, job);
+  }else{
+    function(job, 0, height);
+  }
+}
+
+
+
+#if NA_SIMD_SSE2
+
+// One pixel of 4 floats fits exactly into one register. Note that the
+// shuffle macros need constants, hence there are no general functions.
+NA_HIDEF __m128 na_BroadcastBabyAlpha(__m128 pixel){
+  return _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+NA_HIDEF __m128 na_BroadcastBabyGreen(__m128 pixel){
+  return _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(1, 1, 1, 1));
+}
+
+// Returns the alpha channel of alpha combined with the colors of color.
+NA_HIDEF __m128 na_SelectBabyAlpha(__m128 alpha, __m128 color){
+  const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+  return _mm_or_ps(_mm_and_ps(mask, alpha), _mm_andnot_ps(mask, color));
+}
+
+// (1 - factor) * base + factor * top
+NA_HIDEF __m128 na_InterpolateBabyPixels(__m128 base, __m128 top, __m128 factor){
+  return _mm_add_ps(
+    _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.f), factor), base),
+    _mm_mul_ps(factor, top));
+}
+
+#endif // NA_SIMD_SSE2
+
+
+
+NA_HIDEF void na_BlendBabyPixel(float* ret, const float* base, const float* top, NABlendMode mode, float blend){
+  #if NA_SIMD_SSE2
+    const __m128 one = _mm_set1_ps(1.f);
+    __m128 b = _mm_loadu_ps(base);
+    __m128 t = _mm_loadu_ps(top);
+    __m128 blendv = _mm_set1_ps(blend);
+    __m128 topblend = _mm_mul_ps(na_BroadcastBabyAlpha(t), blendv);
+    // The factor applied to the alpha of the opaque modes.
+    __m128 keep = _mm_sub_ps(one, _mm_mul_ps(_mm_sub_ps(one, na_BroadcastBabyAlpha(t)), blendv));
+    __m128 result;
+    switch(mode){
+    case NA_BLEND_ZERO:
+      result = b;
+      break;
+    case NA_BLEND:
+      result = na_InterpolateBabyPixels(b, t, blendv);
+      break;
+    case NA_BLEND_OVERLAY:
+      result = na_SelectBabyAlpha(
+        _mm_add_ps(b, _mm_mul_ps(_mm_sub_ps(one, b), topblend)),
+        na_InterpolateBabyPixels(b, t, topblend));
+      break;
+    case NA_BLEND_OPAQUE:
+      result = na_SelectBabyAlpha(_mm_mul_ps(b, keep), na_InterpolateBabyPixels(b, t, topblend));
+      break;
+    case NA_BLEND_BLACK_GREEN:
+      result = na_SelectBabyAlpha(
+        _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(one, na_BroadcastBabyGreen(b)), b), keep),
+        na_InterpolateBabyPixels(b, t, topblend));
+      break;
+    case NA_BLEND_WHITE_GREEN:
+      result = na_SelectBabyAlpha(
+        _mm_mul_ps(_mm_mul_ps(na_BroadcastBabyGreen(b), b), keep),
+        na_InterpolateBabyPixels(b, t, topblend));
+      break;
+    default:
+      result = b;
+      break;
+    }
+    // Transparent pixels have no color.
+    __m128 visible = _mm_cmpneq_ps(na_BroadcastBabyAlpha(result), _mm_setzero_ps());
+    _mm_storeu_ps(ret, _mm_and_ps(visible, result));
+  #else
     float topblend;
     switch(mode){
     case NA_BLEND_ZERO:
@@ -141,20 +412,102 @@ NA_HDEF void na_BlendBabyImage(NAInt pixelCount, float* ret, const float* base,
         (1.f - topblend) * base[2] + topblend * top[2],
         base[1] * base[3] * (1.f - (1.f - top[3]) * blend));
       break;
+    default:
+      naCopyV4f(ret, base);
+      break;
     }
     if(ret[3] == 0.f){
       naFillV3f(ret, 0.f, 0.f, 0.f);
     }
+  #endif
+}
+
+
+
+// Blends count pixels. The steps are 0 if base or top is a single color.
+NA_HIDEF void na_BlendBabyPixels(float* ret, const float* base, const float* top, size_t count, size_t baseStep, size_t topStep, NABlendMode mode, float blend){
+  for(size_t i = 0; i < count; i++){
+    na_BlendBabyPixel(ret, base, top, mode, blend);
     ret += NA_BABY_COLOR_CHANNEL_COUNT;
-    if(baseIsImage){base += NA_BABY_COLOR_CHANNEL_COUNT;}
-    if(topIsImage){top += NA_BABY_COLOR_CHANNEL_COUNT;}
+    base += baseStep;
+    top += topStep;
   }
 }
 
 
+
+typedef struct NABabyImageBlendJob NABabyImageBlendJob;
+struct NABabyImageBlendJob{
+  float* ret;
+  const float* base;
+  const float* top;
+  size_t width;
+  size_t baseStep;
+  size_t topStep;
+  NABlendMode mode;
+  float blend;        // already linearized
+};
+
+// The mode is a constant in every call which gives every mode its own loop
+// without any branches.
+NA_HDEF void na_BlendBabyPixelRun(float* ret, const float* base, const float* top, size_t count, const NABabyImageBlendJob* job){
+  switch(job->mode){
+  case NA_BLEND_ZERO:
+    na_BlendBabyPixels(ret, base, top, count, job->baseStep, job->topStep, NA_BLEND_ZERO, job->blend);
+    break;
+  case NA_BLEND:
+    na_BlendBabyPixels(ret, base, top, count, job->baseStep, job->topStep, NA_BLEND, job->blend);
+    break;
+  case NA_BLEND_OVERLAY:
+    na_BlendBabyPixels(ret, base, top, count, job->baseStep, job->topStep, NA_BLEND_OVERLAY, job->blend);
+    break;
+  case NA_BLEND_OPAQUE:
+    na_BlendBabyPixels(ret, base, top, count, job->baseStep, job->topStep, NA_BLEND_OPAQUE, job->blend);
+    break;
+  case NA_BLEND_BLACK_GREEN:
+    na_BlendBabyPixels(ret, base, top, count, job->baseStep, job->topStep, NA_BLEND_BLACK_GREEN, job->blend);
+    break;
+  case NA_BLEND_WHITE_GREEN:
+    na_BlendBabyPixels(ret, base, top, count, job->baseStep, job->topStep, NA_BLEND_WHITE_GREEN, job->blend);
+    break;
+  default:
+    #if NA_DEBUG
+      naError("Invalid blend mode");
+    #endif
+    break;
+  }
+}
+
+NA_HDEF void na_BlendBabyImageLines(void* arg, size_t beginLine, size_t endLine){
+  const NABabyImageBlendJob* job = (const NABabyImageBlendJob*)arg;
+  size_t firstPixel = beginLine * job->width;
+  na_BlendBabyPixelRun(
+    job->ret + firstPixel * NA_BABY_COLOR_CHANNEL_COUNT,
+    job->base + firstPixel * job->baseStep,
+    job->top + firstPixel * job->topStep,
+    (endLine - beginLine) * job->width,
+    job);
+}
+
+
+
+NA_HDEF void na_BlendBabyImage(NASizei size, float* ret, const float* base, const float* top, NABlendMode mode, float blend, NABool baseIsImage, NABool topIsImage){
+  NABabyImageBlendJob job;
+  job.ret = ret;
+  job.base = base;
+  job.top = top;
+  job.width = (size_t)size.width;
+  job.baseStep = baseIsImage ? NA_BABY_COLOR_CHANNEL_COUNT : 0;
+  job.topStep = topIsImage ? NA_BABY_COLOR_CHANNEL_COUNT : 0;
+  job.mode = mode;
+  job.blend = naLinearizeColorValue(blend);
+  na_RunBabyImageLines(size, na_BlendBabyImageLines, &job);
+}
+
+
+
 NA_DEF NABabyImage* naCreateBabyImageWithTint(const NABabyImage* base, const NABabyColor tint, NABlendMode mode, float blend){
   NABabyImage* retimage;
-  NAInt pixelCount;
   const float* baseptr;
   
   #if NA_DEBUG
@@ -166,11 +519,12 @@ NA_DEF NABabyImage* naCreateBabyImageWithTint(const NABabyImage* base, const NAB
       naError("inanoSecondure tint color given");
   #endif
   
-  retimage = naCreateBabyImage(naGetBabyImageSize(base), NA_NULL);
-  pixelCount = na_GetBabyImagePixelCount(base);
+  retimage = na_CreateBabyImage(naGetBabyImageSize(base), NA_NULL, base->tiled);
   
+  // The tint does not depend on the position, hence the pixels are blended
+  // in the order they are stored.
   baseptr = base->data;
-  na_BlendBabyImage(pixelCount, retimage->data, baseptr, tint, mode, blend, NA_TRUE, NA_FALSE);
+  na_BlendBabyImage(na_GetBabyImageStorageSize(base), retimage->data, baseptr, tint, mode, blend, NA_TRUE, NA_FALSE);
 
   return retimage;
 }
@@ -179,7 +533,6 @@ NA_DEF NABabyImage* naCreateBabyImageWithTint(const NABabyImage* base, const NAB
 
 NA_DEF NABabyImage* naCreateBabyImageWithBlend(const NABabyImage* base, const NABabyImage* top, NABlendMode mode, float blend){
   NABabyImage* retimage;
-  NAInt pixelCount;
   
   #if NA_DEBUG
     if(!top)
@@ -188,15 +541,19 @@ NA_DEF NABabyImage* naCreateBabyImageWithBlend(const NABabyImage* base, const NA
       naError("The two images have not the same size");
   #endif
   
-  retimage = naCreateBabyImage(naGetBabyImageSize(top), NA_NULL);
-  pixelCount = na_GetBabyImagePixelCount(top);
-    
   if(base){
-    const float* baseptr = base->data;
-    na_BlendBabyImage(pixelCount, retimage->data, baseptr, top->data, mode, blend, NA_TRUE, NA_TRUE);
+    // Both images must be stored the same way to be blended in the order
+    // they are stored.
+    const NABabyImage* storedTop = (top->tiled == base->tiled)
+      ? top
+      : naCreateBabyImageWithTiling(top, base->tiled);
+    retimage = na_CreateBabyImage(naGetBabyImageSize(base), NA_NULL, base->tiled);
+    na_BlendBabyImage(na_GetBabyImageStorageSize(base), retimage->data, base->data, storedTop->data, mode, blend, NA_TRUE, NA_TRUE);
+    if(storedTop != top){naReleaseBabyImage(storedTop);}
   }else{
     NABabyColor transparent = {0.f, 0.f, 0.f, 0.f};
-    na_BlendBabyImage(pixelCount, retimage->data, transparent, top->data, mode, blend, NA_FALSE, NA_TRUE);
+    retimage = na_CreateBabyImage(naGetBabyImageSize(top), NA_NULL, top->tiled);
+    na_BlendBabyImage(na_GetBabyImageStorageSize(top), retimage->data, transparent, top->data, mode, blend, NA_FALSE, NA_TRUE);
   }
 
   return retimage;
@@ -204,39 +561,45 @@ NA_DEF NABabyImage* naCreateBabyImageWithBlend(const NABabyImage* base, const NA
 
 
 
-NA_DEF NABabyImage* naCreateBabyImageWithHalfSize(const NABabyImage* image){
-  NASizei halfsize;
-  NAInt x, y;
-  NABabyImage* outimage;
-  NAInt valuesPerLine;
-  float* inPtr1;
-  float* inPtr2;
-  float* outdataptr;
-  
-  #if NA_DEBUG
-    if((image->width % 2) || (image->height % 2))
-      naError("Width or height not divisible by 2");
-  #endif
-  halfsize = naMakeSizei(image->width / 2, image->height / 2);
+typedef struct NABabyImageHalfSizeJob NABabyImageHalfSizeJob;
+struct NABabyImageHalfSizeJob{
+  NABabyImage* out;
+  const NABabyImage* in;
+};
 
-  outimage = naCreateBabyImage(halfsize, NA_NULL);
-  valuesPerLine = naGetBabyImageValuesPerLine(image);
-  
-  inPtr1 = image->data;
-  inPtr2 = image->data + valuesPerLine;
-  outdataptr = outimage->data;
-  for(y = 0; y < image->height; y += 2){
-    for(x = 0; x < image->width; x += 2){
+// Computes count output pixels out of the two given input lines.
+NA_HIDEF void na_HalfBabyPixels(float* outdataptr, const float* inPtr1, const float* inPtr2, size_t count){
+  for(size_t x = 0; x < count; x++){
+    #if NA_SIMD_SSE2
+      // The colors get weighted by alpha, alpha itself is summed up.
+      __m128 p1 = _mm_loadu_ps(&inPtr1[0]);
+      __m128 p2 = _mm_loadu_ps(&inPtr1[4]);
+      __m128 p3 = _mm_loadu_ps(&inPtr2[0]);
+      __m128 p4 = _mm_loadu_ps(&inPtr2[4]);
+      __m128 sum = _mm_add_ps(
+        _mm_add_ps(
+          na_SelectBabyAlpha(p1, _mm_mul_ps(p1, na_BroadcastBabyAlpha(p1))),
+          na_SelectBabyAlpha(p2, _mm_mul_ps(p2, na_BroadcastBabyAlpha(p2)))),
+        _mm_add_ps(
+          na_SelectBabyAlpha(p3, _mm_mul_ps(p3, na_BroadcastBabyAlpha(p3))),
+          na_SelectBabyAlpha(p4, _mm_mul_ps(p4, na_BroadcastBabyAlpha(p4)))));
+      __m128 weight = na_BroadcastBabyAlpha(sum);
+      __m128 factor = na_SelectBabyAlpha(
+        _mm_set1_ps(.25f),
+        _mm_div_ps(_mm_set1_ps(1.f), weight));
+      __m128 transparent = _mm_cmpeq_ps(weight, _mm_setzero_ps());
+      _mm_storeu_ps(outdataptr, _mm_or_ps(
+        _mm_and_ps(transparent, sum),
+        _mm_andnot_ps(transparent, _mm_mul_ps(sum, factor))));
+    #else
       outdataptr[0] = inPtr1[0] * inPtr1[3] + inPtr1[4] * inPtr1[7];
       outdataptr[1] = inPtr1[1] * inPtr1[3] + inPtr1[5] * inPtr1[7];
       outdataptr[2] = inPtr1[2] * inPtr1[3] + inPtr1[6] * inPtr1[7];
       outdataptr[3] = inPtr1[3] + inPtr1[7];
-      inPtr1 += 8;
       outdataptr[0] += inPtr2[0] * inPtr2[3] + inPtr2[4] * inPtr2[7];
       outdataptr[1] += inPtr2[1] * inPtr2[3] + inPtr2[5] * inPtr2[7];
       outdataptr[2] += inPtr2[2] * inPtr2[3] + inPtr2[6] * inPtr2[7];
       outdataptr[3] += inPtr2[3] + inPtr2[7];
-      inPtr2 += 8;
       if(outdataptr[3] != 0.f){
         float invweight = naInvf(outdataptr[3]);
         outdataptr[0] *= invweight;
@@ -244,18 +607,401 @@ NA_DEF NABabyImage* naCreateBabyImageWithHalfSize(const NABabyImage* image){
         outdataptr[2] *= invweight;
         outdataptr[3] *= .25f;
       }
-      outdataptr += NA_BABY_COLOR_CHANNEL_COUNT;
+    #endif
+    inPtr1 += 8;
+    inPtr2 += 8;
+    outdataptr += NA_BABY_COLOR_CHANNEL_COUNT;
+  }
+}
+
+NA_HDEF void na_HalfBabyImageLines(void* arg, size_t beginLine, size_t endLine){
+  const NABabyImageHalfSizeJob* job = (const NABabyImageHalfSizeJob*)arg;
+  size_t outWidth = (size_t)job->out->width;
+  for(size_t y = beginLine; y < endLine; y++){
+    size_t x = 0;
+    while(x < outWidth){
+      // The tile size is even, so the pixels of a pair are always stored
+      // next to each other.
+      size_t outRun, inRun1, inRun2;
+      float* outPtr = na_GetBabyImageRun(job->out, x, y, &outRun);
+      const float* inPtr1 = na_GetBabyImageRun(job->in, 2 * x, 2 * y, &inRun1);
+      const float* inPtr2 = na_GetBabyImageRun(job->in, 2 * x, 2 * y + 1, &inRun2);
+      size_t count = naMins(outRun, naMins(inRun1, inRun2) / 2);
+      na_HalfBabyPixels(outPtr, inPtr1, inPtr2, count);
+      x += count;
+    }
+  }
+}
+
+
+
+NA_DEF NABabyImage* naCreateBabyImageWithHalfSize(const NABabyImage* image){
+  NASizei halfsize;
+  NABabyImage* outimage;
+  NABabyImageHalfSizeJob job;
+  
+  #if NA_DEBUG
+    if((image->width % 2) || (image->height % 2))
+      naError("Width or height not divisible by 2");
+  #endif
+  halfsize = naMakeSizei(image->width / 2, image->height / 2);
+
+  outimage = na_CreateBabyImage(halfsize, NA_NULL, image->tiled);
+  job.out = outimage;
+  job.in = image;
+  na_RunBabyImageLines(halfsize, na_HalfBabyImageLines, &job);
+  return outimage;
+}
+
+
+
+// Returns the radius of the filter for an unscaled image.
+NA_HIDEF float na_GetResampleFilterRadius(NAResampleFilter filter){
+  switch(filter){
+  case NA_RESAMPLE_BILINEAR: return 1.f;
+  case NA_RESAMPLE_BICUBIC: return 2.f;
+  case NA_RESAMPLE_LANCZOS: return 3.f;
+  }
+  return 1.f;
+}
+
+NA_HDEF float na_GetResampleFilterValue(NAResampleFilter filter, float x){
+  x = naAbsf(x);
+  switch(filter){
+  case NA_RESAMPLE_BILINEAR:
+    return (x < 1.f) ? 1.f - x : 0.f;
+  case NA_RESAMPLE_BICUBIC:
+    // Catmull-Rom spline
+    if(x < 1.f){return (1.5f * x - 2.5f) * x * x + 1.f;}
+    if(x < 2.f){return ((-.5f * x + 2.5f) * x - 4.f) * x + 2.f;}
+    return 0.f;
+  case NA_RESAMPLE_LANCZOS:
+    if(x == 0.f){return 1.f;}
+    // Exactly zero at all other integers such that scale 1 is lossless.
+    if(x == naFloorf(x)){return 0.f;}
+    if(x < 3.f){
+      float pix = NA_PIf * x;
+      return 3.f * naSinf(pix) * naSinf(pix / 3.f) / (pix * pix);
+    }
+    return 0.f;
+  }
+  return 0.f;
+}
+
+
+
+// For every output position, the weights of the input positions first to
+// first + count - 1 are stored at weights[position * maxCount].
+typedef struct NAResampleWeights NAResampleWeights;
+struct NAResampleWeights{
+  size_t* first;
+  size_t* count;
+  float* weights;
+  size_t maxCount;
+};
+
+NA_HDEF void na_InitResampleWeights(NAResampleWeights* weights, size_t inSize, size_t outSize, NAResampleFilter filter){
+  float scale = (float)inSize / (float)outSize;
+  // When downscaling, the filter is stretched to cover all input pixels.
+  float stretch = naMaxf(scale, 1.f);
+  float support = na_GetResampleFilterRadius(filter) * stretch;
+
+  weights->maxCount = (size_t)naCeilf(support) * 2 + 1;
+  weights->first = naMalloc(outSize * sizeof(size_t));
+  weights->count = naMalloc(outSize * sizeof(size_t));
+  weights->weights = naMalloc(outSize * weights->maxCount * sizeof(float));
+
+  for(size_t o = 0; o < outSize; o++){
+    float center = ((float)o + .5f) * scale;
+    NAInt begin = (NAInt)naFloorf(center - support + .5f);
+    NAInt end = (NAInt)naFloorf(center + support + .5f);
+    begin = naMaxi(begin, 0);
+    end = naMini(end, (NAInt)inSize);
+    end = naMini(end, begin + (NAInt)weights->maxCount);
+
+    float* w = &weights->weights[o * weights->maxCount];
+    float sum = 0.f;
+    for(NAInt i = begin; i < end; i++){
+      w[i - begin] = na_GetResampleFilterValue(filter, ((float)i + .5f - center) / stretch);
+      sum += w[i - begin];
+    }
+    // Pixels outside of the image are ignored and the remaining weights are
+    // normalized.
+    if(sum != 0.f){
+      float invSum = naInvf(sum);
+      for(NAInt i = begin; i < end; i++){w[i - begin] *= invSum;}
+    }
+    weights->first[o] = (size_t)begin;
+    weights->count[o] = (size_t)(end - begin);
+  }
+}
+
+NA_HDEF void na_ClearResampleWeights(NAResampleWeights* weights){
+  naFree(weights->weights);
+  naFree(weights->count);
+  naFree(weights->first);
+}
+
+
+
+typedef struct NABabyImageResampleJob NABabyImageResampleJob;
+struct NABabyImageResampleJob{
+  const NABabyImage* in;
+  float* tmp;           // premultiplied, output width times input height
+  NABabyImage* out;
+  size_t inWidth;
+  size_t outWidth;
+  NAResampleWeights horizontal;
+  NAResampleWeights vertical;
+};
+
+// Accumulates the premultiplied pixel weighted by the given weight.
+NA_HIDEF void na_AccumulateBabyPixel(float* acc, const float* pixel, float weight, NABool premultiply){
+  #if NA_SIMD_SSE2
+    __m128 p = _mm_loadu_ps(pixel);
+    if(premultiply){p = na_SelectBabyAlpha(p, _mm_mul_ps(p, na_BroadcastBabyAlpha(p)));}
+    _mm_storeu_ps(acc, _mm_add_ps(_mm_loadu_ps(acc), _mm_mul_ps(p, _mm_set1_ps(weight))));
+  #else
+    float alphaWeight = premultiply ? pixel[3] * weight : weight;
+    acc[0] += pixel[0] * alphaWeight;
+    acc[1] += pixel[1] * alphaWeight;
+    acc[2] += pixel[2] * alphaWeight;
+    acc[3] += pixel[3] * weight;
+  #endif
+}
+
+NA_HDEF void na_ResampleBabyImageLinesHorizontal(void* arg, size_t beginLine, size_t endLine){
+  const NABabyImageResampleJob* job = (const NABabyImageResampleJob*)arg;
+  const NAResampleWeights* weights = &job->horizontal;
+  // Lines of tiled images are gathered first.
+  float* lineBuffer = job->in->tiled
+    ? naMalloc(job->inWidth * NA_BABY_COLOR_BYTES_PER_COMPONENT)
+    : NA_NULL;
+  for(size_t y = beginLine; y < endLine; y++){
+    const float* inLine;
+    if(lineBuffer){
+      na_GetBabyImageLinePixels(job->in, 0, y, job->inWidth, lineBuffer);
+      inLine = lineBuffer;
+    }else{
+      inLine = &job->in->data[y * job->inWidth * NA_BABY_COLOR_CHANNEL_COUNT];
+    }
+    float* tmpPtr = &job->tmp[y * job->outWidth * NA_BABY_COLOR_CHANNEL_COUNT];
+    for(size_t x = 0; x < job->outWidth; x++){
+      const float* w = &weights->weights[x * weights->maxCount];
+      const float* inPtr = &inLine[weights->first[x] * NA_BABY_COLOR_CHANNEL_COUNT];
+      naFillV4f(tmpPtr, 0.f, 0.f, 0.f, 0.f);
+      for(size_t i = 0; i < weights->count[x]; i++){
+        na_AccumulateBabyPixel(tmpPtr, inPtr, w[i], NA_TRUE);
+        inPtr += NA_BABY_COLOR_CHANNEL_COUNT;
+      }
+      tmpPtr += NA_BABY_COLOR_CHANNEL_COUNT;
+    }
+  }
+  if(lineBuffer){naFree(lineBuffer);}
+}
+
+// The vertical pass works on whole lines which keeps the memory access
+// linear. At the end, the colors are divided by alpha again.
+NA_HDEF void na_ResampleBabyImageLinesVertical(void* arg, size_t beginLine, size_t endLine){
+  const NABabyImageResampleJob* job = (const NABabyImageResampleJob*)arg;
+  const NAResampleWeights* weights = &job->vertical;
+  size_t valuesPerLine = job->outWidth * NA_BABY_COLOR_CHANNEL_COUNT;
+  // Lines of tiled images are scattered afterwards.
+  float* lineBuffer = job->out->tiled
+    ? naMalloc(job->outWidth * NA_BABY_COLOR_BYTES_PER_COMPONENT)
+    : NA_NULL;
+  for(size_t y = beginLine; y < endLine; y++){
+    const float* w = &weights->weights[y * weights->maxCount];
+    float* outLine = lineBuffer
+      ? lineBuffer
+      : &job->out->data[y * valuesPerLine];
+    for(size_t x = 0; x < valuesPerLine; x++){outLine[x] = 0.f;}
+
+    for(size_t i = 0; i < weights->count[y]; i++){
+      const float* tmpPtr = &job->tmp[(weights->first[y] + i) * valuesPerLine];
+      float* outPtr = outLine;
+      for(size_t x = 0; x < job->outWidth; x++){
+        na_AccumulateBabyPixel(outPtr, tmpPtr, w[i], NA_FALSE);
+        tmpPtr += NA_BABY_COLOR_CHANNEL_COUNT;
+        outPtr += NA_BABY_COLOR_CHANNEL_COUNT;
+      }
+    }
+
+    float* outPtr = outLine;
+    for(size_t x = 0; x < job->outWidth; x++){
+      // Filters with negative lobes may overshoot. Nearly transparent pixels
+      // become fully transparent.
+      float alpha = naMinf(outPtr[3], 1.f);
+      if(alpha >= NA_SINGULARITYf){
+        float invAlpha = naInvf(outPtr[3]);
+        naFillV4f(outPtr, outPtr[0] * invAlpha, outPtr[1] * invAlpha, outPtr[2] * invAlpha, alpha);
+      }else{
+        naFillV4f(outPtr, 0.f, 0.f, 0.f, 0.f);
+      }
+      outPtr += NA_BABY_COLOR_CHANNEL_COUNT;
+    }
+    if(lineBuffer){
+      na_SetBabyImageLinePixels(job->out, 0, y, job->outWidth, lineBuffer);
     }
-    // Each line has advanced till the last pixel of the line, so we only
-    // have to overjump one more line.
-    inPtr1 += valuesPerLine;
-    inPtr2 += valuesPerLine;
   }
+  if(lineBuffer){naFree(lineBuffer);}
+}
+
+
+
+NA_DEF NABabyImage* naCreateBabyImageWithResize(const NABabyImage* image, NASizei size, NAResampleFilter filter){
+  NABabyImage* outimage;
+  NABabyImageResampleJob job;
+
+  #if NA_DEBUG
+    if(!image)
+      naCrash("Given image is a Null-Pointer");
+    if(size.width <= 0 || size.height <= 0)
+      naError("size must be > 0");
+  #endif
+  outimage = na_CreateBabyImage(size, NA_NULL, image->tiled);
+
+  job.in = image;
+  job.out = outimage;
+  job.inWidth = (size_t)image->width;
+  job.outWidth = (size_t)size.width;
+  job.tmp = naMalloc(job.outWidth * (size_t)image->height * NA_BABY_COLOR_BYTES_PER_COMPONENT);
+  na_InitResampleWeights(&job.horizontal, (size_t)image->width, (size_t)size.width, filter);
+  na_InitResampleWeights(&job.vertical, (size_t)image->height, (size_t)size.height, filter);
+
+  na_RunBabyImageLines(naMakeSizei(size.width, image->height), na_ResampleBabyImageLinesHorizontal, &job);
+  na_RunBabyImageLines(size, na_ResampleBabyImageLinesVertical, &job);
+
+  na_ClearResampleWeights(&job.vertical);
+  na_ClearResampleWeights(&job.horizontal);
+  naFree(job.tmp);
   return outimage;
 }
 
 
 
+typedef struct NABabyImageRegionJob NABabyImageRegionJob;
+struct NABabyImageRegionJob{
+  NABabyImage* image;
+  NARecti rect;
+  float* data;        // the lines of the region without any padding
+  NABool toImage;
+};
+
+NA_HDEF void na_CopyBabyImageRegionLines(void* arg, size_t beginLine, size_t endLine){
+  const NABabyImageRegionJob* job = (const NABabyImageRegionJob*)arg;
+  size_t x = (size_t)job->rect.pos.x;
+  size_t width = (size_t)job->rect.size.width;
+  for(size_t y = beginLine; y < endLine; y++){
+    float* pixels = &job->data[y * width * NA_BABY_COLOR_CHANNEL_COUNT];
+    size_t imageY = (size_t)job->rect.pos.y + y;
+    if(job->toImage){
+      na_SetBabyImageLinePixels(job->image, x, imageY, width, pixels);
+    }else{
+      na_GetBabyImageLinePixels(job->image, x, imageY, width, pixels);
+    }
+  }
+}
+
+NA_HDEF void na_CopyBabyImageRegion(NABabyImage* image, NARecti rect, float* data, NABool toImage){
+  NABabyImageRegionJob job;
+  #if NA_DEBUG
+    if(!image)
+      naCrash("Given image is a Null-Pointer");
+    if(!naContainsRectiRect(naMakeRectiS(0, 0, image->width, image->height), rect))
+      naError("rect is not inside the image");
+  #endif
+  job.image = image;
+  job.rect = rect;
+  job.data = data;
+  job.toImage = toImage;
+  na_RunBabyImageLines(rect.size, na_CopyBabyImageRegionLines, &job);
+}
+
+
+
+NA_DEF void naGetBabyImageRegion(const NABabyImage* image, NARecti rect, float* data){
+  na_CopyBabyImageRegion((NABabyImage*)image, rect, data, NA_FALSE);
+}
+
+
+
+NA_DEF void naSetBabyImageRegion(NABabyImage* image, NARecti rect, const float* data){
+  na_CopyBabyImageRegion(image, rect, (float*)data, NA_TRUE);
+}
+
+
+
+NA_DEF NABabyImage* naCreateBabyImageWithTiling(const NABabyImage* image, NABool tiled){
+  NABabyImage* outimage;
+  #if NA_DEBUG
+    if(!image)
+      naCrash("Given image is a Null-Pointer");
+  #endif
+  outimage = na_CreateBabyImage(naGetBabyImageSize(image), NA_NULL, tiled);
+  if(image->tiled == tiled){
+    naCopyn(outimage->data, image->data, na_GetBabyImageDataSize(image));
+  }else{
+    NARecti rect = naMakeRectiS(0, 0, image->width, image->height);
+    if(tiled){
+      na_CopyBabyImageRegion(outimage, rect, image->data, NA_TRUE);
+    }else{
+      na_CopyBabyImageRegion((NABabyImage*)image, rect, outimage->data, NA_FALSE);
+    }
+  }
+  return outimage;
+}
+
+
+
+typedef struct NABabyImageRegionBlendJob NABabyImageRegionBlendJob;
+struct NABabyImageRegionBlendJob{
+  NABabyImage* base;
+  const NABabyImage* top;
+  NAPosi origin;
+  NABabyImageBlendJob blendJob;
+};
+
+NA_HDEF void na_BlendBabyImageRegionLines(void* arg, size_t beginLine, size_t endLine){
+  const NABabyImageRegionBlendJob* job = (const NABabyImageRegionBlendJob*)arg;
+  size_t width = (size_t)job->top->width;
+  for(size_t y = beginLine; y < endLine; y++){
+    size_t x = 0;
+    while(x < width){
+      size_t baseRun, topRun;
+      float* basePtr = na_GetBabyImageRun(job->base, (size_t)job->origin.x + x, (size_t)job->origin.y + y, &baseRun);
+      const float* topPtr = na_GetBabyImageRun(job->top, x, y, &topRun);
+      size_t count = naMins(baseRun, topRun);
+      na_BlendBabyPixelRun(basePtr, basePtr, topPtr, count, &job->blendJob);
+      x += count;
+    }
+  }
+}
+
+
+
+NA_DEF void naBlendBabyImageRegion(NABabyImage* base, const NABabyImage* top, NAPosi origin, NABlendMode mode, float blend){
+  NABabyImageRegionBlendJob job;
+  #if NA_DEBUG
+    if(!base)
+      naCrash("base is Null");
+    if(!top)
+      naCrash("top is Null");
+    if(!naContainsRectiRect(naMakeRectiS(0, 0, base->width, base->height), naMakeRecti(origin, naGetBabyImageSize(top))))
+      naError("top is not completely inside of base");
+  #endif
+  job.base = base;
+  job.top = top;
+  job.origin = origin;
+  job.blendJob.baseStep = NA_BABY_COLOR_CHANNEL_COUNT;
+  job.blendJob.topStep = NA_BABY_COLOR_CHANNEL_COUNT;
+  job.blendJob.mode = mode;
+  job.blendJob.blend = naLinearizeColorValue(blend);
+  na_RunBabyImageLines(naGetBabyImageSize(top), na_BlendBabyImageRegionLines, &job);
+}
+
+
+
 NA_HDEF void na_DestroyBabyImage(NABabyImage* image){
   naFree(image->data);
   naFree(image);
@@ -263,76 +1009,231 @@ NA_HDEF void na_DestroyBabyImage(NABabyImage* image){
 
 NA_API NABabyImage* naRetainBabyImage(const NABabyImage* image){
   NABabyImage* mutableImage = (NABabyImage*)image; 
-  return (NABabyImage*)naRetainRefCount(&mutableImage->refCount);
+  return (NABabyImage*)naRetainRefCountAtomic(&mutableImage->refCount);
 }
 
 NA_DEF void naReleaseBabyImage(const NABabyImage* image){
   NABabyImage* mutableImage = (NABabyImage*)image; 
-  naReleaseRefCount(&mutableImage->refCount, mutableImage, (NAMutator)na_DestroyBabyImage);
+  naReleaseRefCountAtomic(&mutableImage->refCount, mutableImage, (NAMutator)na_DestroyBabyImage);
 }
 
 
 
-NA_DEF void naFillBabyImageWithu8(NABabyImage* image, const void* data, NABool topToBottom, NAColorBufferType bufferType){
-  float* imgptr = image->data;
-  const uint8* u8ptr;
-
-  if(topToBottom){
-    NAInt x, y;
-    NASizei size = naGetBabyImageSize(image);
-    for(y = 0; y < size.height; y++){
-      u8ptr = &(((uint8*)data)[(size.height - y - 1) * naGetBabyImageValuesPerLine(image)]);
-      for(x = 0; x < size.width; x++){
-        naFillBabyColorWithu8(imgptr, u8ptr, bufferType);
-        imgptr += NA_BABY_COLOR_CHANNEL_COUNT;
-        u8ptr += NA_BABY_COLOR_CHANNEL_COUNT;
-      }
-    }
+// Both conversions between u8 and floats work with a job of this kind. The
+// u8 data always has 4 bytes per pixel.
+typedef struct NABabyImageu8Job NABabyImageu8Job;
+struct NABabyImageu8Job{
+  NABabyImage* image;
+  uint8* data;
+  size_t width;
+  size_t height;
+  NABool topToBottom;
+  NAColorBufferType bufferType;
+  const float* linearTable;   // only for filling
+};
+
+NA_HIDEF uint8* na_GetBabyImageu8Line(const NABabyImageu8Job* job, size_t y){
+  size_t dataLine = job->topToBottom ? job->height - y - 1 : y;
+  return job->data + dataLine * job->width * NA_BABY_COLOR_CHANNEL_COUNT;
+}
+
+
+
+// Same as naFillBabyColorWithu8 but looking up the linearized values in the
+// given table instead of computing them.
+NA_HIDEF void na_FillBabyPixelWithu8(float* outColor, const uint8* inColor, const float* linearTable, NAColorBufferType bufferType){
+  if(!inColor[3] && (bufferType != NA_COLOR_BUFFER_RGB) && bufferType != NA_COLOR_BUFFER_BGR0){
+    naFillV4f(outColor, 0.f, 0.f, 0.f, 0.f);
   }else{
-    NAInt pixelCount;
-    NAInt i;
-    u8ptr = data;
-    pixelCount = na_GetBabyImagePixelCount(image);
-    for(i = 0; i < pixelCount; i++){
-      naFillBabyColorWithu8(imgptr, u8ptr, bufferType);
-      imgptr += NA_BABY_COLOR_CHANNEL_COUNT;
-      u8ptr += NA_BABY_COLOR_CHANNEL_COUNT;
+    switch(bufferType){
+    case NA_COLOR_BUFFER_RGBA:
+    case NA_COLOR_BUFFER_BGRA:
+      outColor[3] = (float)inColor[3] * (1.f / 255.f);
+      break;
+    case NA_COLOR_BUFFER_RGBAPre:
+      // The premultiplied colors are not in the table.
+      naFillBabyColorWithu8(outColor, inColor, bufferType);
+      return;
+    case NA_COLOR_BUFFER_RGB:
+      break;
+    case NA_COLOR_BUFFER_BGR0:
+      outColor[3] = 1.f;
+      break;
     }
+    outColor[0] = linearTable[inColor[0]];
+    outColor[1] = linearTable[inColor[1]];
+    outColor[2] = linearTable[inColor[2]];
   }
 }
 
+NA_HIDEF void na_FillBabyPixelsWithu8(float* imgptr, const uint8* u8ptr, size_t count, const float* linearTable, NAColorBufferType bufferType){
+  for(size_t i = 0; i < count; i++){
+    na_FillBabyPixelWithu8(imgptr, u8ptr, linearTable, bufferType);
+    imgptr += NA_BABY_COLOR_CHANNEL_COUNT;
+    u8ptr += NA_BABY_COLOR_CHANNEL_COUNT;
+  }
+}
 
+// Same as with blending, every buffer type gets its own loop.
+NA_HDEF void na_FillBabyPixelRunWithu8(float* imgptr, const uint8* u8ptr, size_t count, const NABabyImageu8Job* job){
+  switch(job->bufferType){
+  case NA_COLOR_BUFFER_RGBA:
+    na_FillBabyPixelsWithu8(imgptr, u8ptr, count, job->linearTable, NA_COLOR_BUFFER_RGBA);
+    break;
+  case NA_COLOR_BUFFER_RGBAPre:
+    na_FillBabyPixelsWithu8(imgptr, u8ptr, count, job->linearTable, NA_COLOR_BUFFER_RGBAPre);
+    break;
+  case NA_COLOR_BUFFER_RGB:
+    na_FillBabyPixelsWithu8(imgptr, u8ptr, count, job->linearTable, NA_COLOR_BUFFER_RGB);
+    break;
+  case NA_COLOR_BUFFER_BGR0:
+    na_FillBabyPixelsWithu8(imgptr, u8ptr, count, job->linearTable, NA_COLOR_BUFFER_BGR0);
+    break;
+  case NA_COLOR_BUFFER_BGRA:
+    na_FillBabyPixelsWithu8(imgptr, u8ptr, count, job->linearTable, NA_COLOR_BUFFER_BGRA);
+    break;
+  }
+}
 
-NA_DEF void naConvertBabyImageTou8(const NABabyImage* image, void* data, NABool topToBottom, NAColorBufferType bufferType){
-  const float* imgptr = image->data;
-  uint8* u8ptr;
-
-  if(topToBottom){
-    NAInt x, y;
-    NASizei size = naGetBabyImageSize(image);
-    for(y = 0; y < size.height; y++){
-      u8ptr = &(((uint8*)data)[(size.height - y - 1) * naGetBabyImageValuesPerLine(image)]);
-      for(x = 0; x < size.width; x++){
-        naFillu8WithBabyColor(u8ptr, imgptr, bufferType);
-        imgptr += NA_BABY_COLOR_CHANNEL_COUNT;
-        u8ptr += NA_BABY_COLOR_CHANNEL_COUNT;
-      }
+NA_HDEF void na_FillBabyImageLinesWithu8(void* arg, size_t beginLine, size_t endLine){
+  const NABabyImageu8Job* job = (const NABabyImageu8Job*)arg;
+  for(size_t y = beginLine; y < endLine; y++){
+    const uint8* u8ptr = na_GetBabyImageu8Line(job, y);
+    size_t x = 0;
+    while(x < job->width){
+      size_t count;
+      float* imgptr = na_GetBabyImageRun(job->image, x, y, &count);
+      na_FillBabyPixelRunWithu8(imgptr, &u8ptr[x * NA_BABY_COLOR_CHANNEL_COUNT], count, job);
+      x += count;
     }
-  }else{
-    NAInt pixelCount;
-    NAInt i;
-    u8ptr = data;
-    pixelCount = na_GetBabyImagePixelCount(image);
-    for(i = 0; i < pixelCount; i++){
-      naFillu8WithBabyColor(u8ptr, imgptr, bufferType);
-      imgptr += NA_BABY_COLOR_CHANNEL_COUNT;
-      u8ptr += NA_BABY_COLOR_CHANNEL_COUNT;
+  }
+}
+
+
+
+NA_DEF void naFillBabyImageWithu8(NABabyImage* image, const void* data, NABool topToBottom, NAColorBufferType bufferType){
+  float linearTable[256];
+  NABabyImageu8Job job;
+
+  // The table contains exactly the values naFillBabyColorWithu8 computes.
+  for(int c = 0; c < 256; c++){
+    linearTable[c] = naLinearizeColorValue((float)c * (1.f / 255.f));
+  }
+
+  job.image = (NABabyImage*)image;
+  job.data = (uint8*)data;
+  job.width = (size_t)image->width;
+  job.height = (size_t)image->height;
+  job.topToBottom = topToBottom;
+  job.bufferType = bufferType;
+  job.linearTable = linearTable;
+  na_RunBabyImageLines(naGetBabyImageSize(image), na_FillBabyImageLinesWithu8, &job);
+}
+
+
+
+#if NA_SIMD_SSE2
+
+// Converts 4 pixels at once, computing exactly what naFillu8WithBabyColor
+// computes for every single one of them.
+NA_HIDEF __m128i na_ConvertBabyPixelTou8SSE2(const float* inColor, NAColorBufferType bufferType){
+  __m128 color = _mm_loadu_ps(inColor);
+  __m128 unlinear = _mm_div_ps(color, _mm_add_ps(
+    _mm_mul_ps(_mm_set1_ps(NA_BABY_FACTOR), color),
+    _mm_set1_ps(1.f - NA_BABY_FACTOR)));
+  if(bufferType == NA_COLOR_BUFFER_RGBAPre){
+    unlinear = _mm_mul_ps(unlinear, na_BroadcastBabyAlpha(color));
+  }
+  color = na_SelectBabyAlpha(color, unlinear);
+  color = _mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(1.f));
+  __m128i values = _mm_cvttps_epi32(_mm_mul_ps(color, _mm_set1_ps(255.f)));
+  if(bufferType == NA_COLOR_BUFFER_BGR0 || bufferType == NA_COLOR_BUFFER_BGRA){
+    values = _mm_shuffle_epi32(values, _MM_SHUFFLE(3, 0, 1, 2));
+  }
+  return values;
+}
+
+#endif // NA_SIMD_SSE2
+
+NA_HIDEF void na_ConvertBabyPixelsTou8(uint8* u8ptr, const float* imgptr, size_t count, NAColorBufferType bufferType){
+  size_t i = 0;
+  #if NA_SIMD_SSE2
+    // RGB keeps the fourth byte untouched.
+    const __m128i keepMask = (bufferType == NA_COLOR_BUFFER_RGB)
+      ? _mm_set1_epi32((int)0xff000000)
+      : _mm_setzero_si128();
+    for(; i + 4 <= count; i += 4){
+      __m128i values = _mm_packus_epi16(
+        _mm_packs_epi32(
+          na_ConvertBabyPixelTou8SSE2(&imgptr[0], bufferType),
+          na_ConvertBabyPixelTou8SSE2(&imgptr[4], bufferType)),
+        _mm_packs_epi32(
+          na_ConvertBabyPixelTou8SSE2(&imgptr[8], bufferType),
+          na_ConvertBabyPixelTou8SSE2(&imgptr[12], bufferType)));
+      __m128i prev = _mm_loadu_si128((const __m128i*)u8ptr);
+      values = _mm_or_si128(_mm_and_si128(keepMask, prev), _mm_andnot_si128(keepMask, values));
+      _mm_storeu_si128((__m128i*)u8ptr, values);
+      imgptr += 4 * NA_BABY_COLOR_CHANNEL_COUNT;
+      u8ptr += 4 * NA_BABY_COLOR_CHANNEL_COUNT;
+    }
+  #endif
+  for(; i < count; i++){
+    naFillu8WithBabyColor(u8ptr, imgptr, bufferType);
+    imgptr += NA_BABY_COLOR_CHANNEL_COUNT;
+    u8ptr += NA_BABY_COLOR_CHANNEL_COUNT;
+  }
+}
+
+NA_HDEF void na_ConvertBabyPixelRunTou8(uint8* u8ptr, const float* imgptr, size_t count, const NABabyImageu8Job* job){
+  switch(job->bufferType){
+  case NA_COLOR_BUFFER_RGBA:
+    na_ConvertBabyPixelsTou8(u8ptr, imgptr, count, NA_COLOR_BUFFER_RGBA);
+    break;
+  case NA_COLOR_BUFFER_RGBAPre:
+    na_ConvertBabyPixelsTou8(u8ptr, imgptr, count, NA_COLOR_BUFFER_RGBAPre);
+    break;
+  case NA_COLOR_BUFFER_RGB:
+    na_ConvertBabyPixelsTou8(u8ptr, imgptr, count, NA_COLOR_BUFFER_RGB);
+    break;
+  case NA_COLOR_BUFFER_BGR0:
+    na_ConvertBabyPixelsTou8(u8ptr, imgptr, count, NA_COLOR_BUFFER_BGR0);
+    break;
+  case NA_COLOR_BUFFER_BGRA:
+    na_ConvertBabyPixelsTou8(u8ptr, imgptr, count, NA_COLOR_BUFFER_BGRA);
+    break;
+  }
+}
+
+NA_HDEF void na_ConvertBabyImageLinesTou8(void* arg, size_t beginLine, size_t endLine){
+  const NABabyImageu8Job* job = (const NABabyImageu8Job*)arg;
+  for(size_t y = beginLine; y < endLine; y++){
+    uint8* u8ptr = na_GetBabyImageu8Line(job, y);
+    size_t x = 0;
+    while(x < job->width){
+      size_t count;
+      const float* imgptr = na_GetBabyImageRun(job->image, x, y, &count);
+      na_ConvertBabyPixelRunTou8(&u8ptr[x * NA_BABY_COLOR_CHANNEL_COUNT], imgptr, count, job);
+      x += count;
     }
   }
 }
 
 
 
+NA_DEF void naConvertBabyImageTou8(const NABabyImage* image, void* data, NABool topToBottom, NAColorBufferType bufferType){
+  NABabyImageu8Job job;
+  job.image = (NABabyImage*)image;
+  job.data = (uint8*)data;
+  job.width = (size_t)image->width;
+  job.height = (size_t)image->height;
+  job.topToBottom = topToBottom;
+  job.bufferType = bufferType;
+  job.linearTable = NA_NULL;
+  na_RunBabyImageLines(naGetBabyImageSize(image), na_ConvertBabyImageLinesTou8, &job);
+}
+
+
+
 // This is free and unencumbered software released into the public domain.
 
 // Anyone is free to copy, modify, publish, use, compile, sell, or
@@ -1,552 +1,1732 @@
 
 #include "../NADeflate.h"
 #include "../NAMemory.h"
+#include "../NAMathOperators.h"
 
 
-typedef struct NAHuffmanCodeTree NAHuffmanCodeTree;
-struct NAHuffmanCodeTree{
-  uint16 alphabetcount;
-  uint16* codes;
-  uint16* codelengths;
-  int32* indextree;
-  int32 curIndex;
+#define NA_ZLIB_CMF_COMPRESSION_DEFLATE 8
+#define NA_ZLIB_CMF_MAX_WINDOW_SIZE 7     // 2 ^ MAX_WINDOWSIZE + 8
+
+#define NA_DEFLATE_WINDOW_SIZE      (1 << 15)
+#define NA_DEFLATE_MIN_MATCH        3
+#define NA_DEFLATE_MAX_MATCH        258
+#define NA_DEFLATE_LITLEN_COUNT     286
+#define NA_DEFLATE_FIXED_LITLEN_COUNT 288
+#define NA_DEFLATE_DIST_COUNT       30
+#define NA_DEFLATE_CODELENGTH_COUNT 19
+#define NA_DEFLATE_MAX_CODE_LENGTH  15
+
+
+// The lengths and distances in deflate are denoted by a code and a number of
+// extra bits added to a base value.
+static const uint16 na_DeflateLengthBase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8 na_DeflateLengthExtra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16 na_DeflateDistanceBase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8 na_DeflateDistanceExtra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const uint8 na_DeflateCodeLengthOrder[NA_DEFLATE_CODELENGTH_COUNT] = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+
+
+// ////////////////////////////
+// Decompression
+// ////////////////////////////
+
+// Huffman codes are decoded with lookup tables: The next tableBits bits of
+// the stream directly index the primary table. Codes which are longer than
+// that are resolved with a second probe into a subtable. Every entry stores
+// the decoded symbol in the upper 16 bits and the code length in bits in the
+// lowest 8 bits. Entries pointing to a subtable store the offset of the
+// subtable instead of the symbol and the number of bits indexing it instead
+// of the code length.
+#define NA_INFLATE_LITLEN_TABLE_BITS      10
+#define NA_INFLATE_DIST_TABLE_BITS        8
+#define NA_INFLATE_CODELENGTH_TABLE_BITS  7
+#define NA_INFLATE_ENTRY_SUBTABLE         0x100
+#define NA_INFLATE_INVALID_SYMBOL         0xffff
+#define NA_INFLATE_OUT_BUFFER_SIZE        (1 << 17)
+#define NA_INFLATE_CHUNK_SIZE             (1 << 15)
+
+typedef struct NAInflateTable NAInflateTable;
+struct NAInflateTable{
+  uint32* entries;
+  size_t capacity;
+  uint32 tableBits;
+};
+
+// The decoder stops at the following points whenever it runs out of input
+// or output space and resumes there once more is available.
+typedef enum{
+  NA_INFLATE_STATE_ZLIB_HEADER,
+  NA_INFLATE_STATE_BLOCK_HEADER,
+  NA_INFLATE_STATE_STORED,
+  NA_INFLATE_STATE_HUFFMAN,
+  NA_INFLATE_STATE_ZLIB_TRAILER,
+  NA_INFLATE_STATE_DONE,
+  NA_INFLATE_STATE_CORRUPT
+} NAInflateState;
+
+// The position in the bit input. Stored before decoding a unit which might
+// not be completely available yet, such that decoding can be rolled back.
+typedef struct NAInflateBitState NAInflateBitState;
+struct NAInflateBitState{
+  const NAByte* in;
+  uint64 bitBuf;
+  uint32 bitCount;
+  uint32 overrunBytes;
+};
+
+struct NAZLIBInflater{
+  NAInflateState state;
+  NABool isFinalBlock;
+  NABool inputComplete;
+  size_t storedRemaining;
+
+  // Bit input. Up to 64 bits are kept in bitBuf, LSB first. Bytes read past
+  // the end of the input are zero and counted in overrunBytes.
+  NAByte* inBuf;
+  size_t inCapacity;
+  const NAByte* in;
+  const NAByte* inEnd;
+  uint64 bitBuf;
+  uint32 bitCount;
+  uint32 overrunBytes;
+
+  NAInflateTable litLenTable;
+  NAInflateTable distTable;
+  NAInflateTable codeLengthTable;
+
+  // Output. At least the last 32 KB of output are kept as the window for
+  // matches. The bytes from drainPos to outPos have not been drained yet.
+  NAByte* out;
+  size_t outPos;
+  size_t drainPos;
+  size_t checksumPos;
+  NAChecksum checksum;
 };
 
+NA_HAPI void na_DestructZLIBInflater(NAZLIBInflater* inflater);
+NA_RUNTIME_TYPE(NAZLIBInflater, na_DestructZLIBInflater, NA_FALSE);
 
-NAHuffmanCodeTree* naAllocHuffmanCodeTree(uint16 alphabetcount){
-  NAHuffmanCodeTree* tree = naAlloc(NAHuffmanCodeTree);
-  tree->alphabetcount = alphabetcount;
-  tree->codes = naMalloc(alphabetcount * sizeof(uint16));
-  tree->codelengths = naMalloc(alphabetcount * sizeof(uint16));
-  tree->indextree = naMalloc((2 * (size_t)alphabetcount - 1) * sizeof(int32));
-  for(int16 i = 0; i < alphabetcount; i++){tree->codelengths[i] = 0;}
-  return tree;
+
+
+NA_HDEF void na_InitInflateTable(NAInflateTable* table, uint32 tableBits){
+  table->entries = NA_NULL;
+  table->capacity = 0;
+  table->tableBits = tableBits;
 }
 
 
-void naDeallocHuffmanCodeTree(NAHuffmanCodeTree* tree){
-  naFree(tree->codes);
-  naFree(tree->codelengths);
-  naFree(tree->indextree);
-  naFree(tree);
+
+NA_HDEF void na_ClearInflateTable(NAInflateTable* table){
+  if(table->entries){naFree(table->entries);}
 }
 
 
-void naBuildHuffmanCodeTree(NAHuffmanCodeTree* tree){
-  uint16 codelengthcount[17] = {0};
-  uint16 nextcodes[17] = {0};
-  uint16 a;
-  uint16 code;
-  int32  curIndex;
-  uint16 newtreeindex;
-  uint16 curmask;
-  #if NA_DEBUG
-    int32 openends;
-  #endif
 
-  // Count the number of code lengths
-  for(a = 0; a < tree->alphabetcount; a++){
-    #if NA_DEBUG
-      // Literals of the alphabet which are not in use have a codelength
-      // of 0 and therefore, we need to allow that value.
-//      if(tree->codelengths[a] == 0)
-//        naError("naBuildHuffmanCodeTree", "Found a codelength of 0");
-      if(tree->codelengths[a] > 16)
-        naError("Found a codelength of more than 16");
-    #endif
-    codelengthcount[tree->codelengths[a]]++;
+NA_HIDEF uint16 na_ReverseInflateBits(uint16 code, uint32 count){
+  uint16 reversed = 0;
+  for(uint32 i = 0; i < count; i++){
+    reversed = (uint16)((reversed << 1) | (code & 1));
+    code >>= 1;
   }
+  return reversed;
+}
+
+
+
+// Builds the lookup table for canonical huffman codes with the given code
+// lengths. Returns NA_FALSE if the lengths do not denote a valid code.
+// Incomplete codes are accepted as the specification allows them for
+// example for a distance code with only one symbol. Their unused entries
+// decode to NA_INFLATE_INVALID_SYMBOL.
+NA_HDEF NABool na_BuildInflateTable(NAInflateTable* table, const uint8* codeLengths, uint32 symbolCount){
+  uint16 lengthCounts[NA_DEFLATE_MAX_CODE_LENGTH + 1] = {0};
+  uint16 nextCodes[NA_DEFLATE_MAX_CODE_LENGTH + 1];
+  uint8 subtableBits[1 << NA_INFLATE_LITLEN_TABLE_BITS];
+  uint32 subtableOffsets[1 << NA_INFLATE_LITLEN_TABLE_BITS];
+  uint16 codes[NA_DEFLATE_LITLEN_COUNT + 2];
+  uint32 tableBits = table->tableBits;
+  uint32 primarySize = (uint32)1 << tableBits;
+  uint32 primaryMask = primarySize - 1;
+  int32 left;
+  uint16 code;
+  size_t size;
+
+  for(uint32 s = 0; s < symbolCount; s++){lengthCounts[codeLengths[s]]++;}
+  lengthCounts[0] = 0;
 
+  // Check whether the code is oversubscribed.
+  left = 1;
+  for(uint32 len = 1; len <= NA_DEFLATE_MAX_CODE_LENGTH; len++){
+    left = (left << 1) - lengthCounts[len];
+    if(left < 0){return NA_FALSE;}
+  }
 
-  // Prepare the next bit codes per codelength
+  // Compute the canonical codes, stored in reversed bit order as deflate
+  // streams are read starting with the least significant bit.
   code = 0;
-  codelengthcount[0] = 0;
-  for(a = 1; a < 17; a++) {
-    #if NA_DEBUG
-      if(codelengthcount[a] > (1<<a))
-        // Note that the case of having exaclty 1<<a codelengths can actually
-        // occur. For example with the fixed huffman codes.
-        naError("Too many codelengths of the same length");
-    #endif
-    code = (uint16)((code + codelengthcount[a - 1]) << 1);
-    if(codelengthcount[a]){ // this if is not necessary but is easier to debug
-      nextcodes[a] = code;
+  for(uint32 len = 1; len <= NA_DEFLATE_MAX_CODE_LENGTH; len++){
+    code = (uint16)((code + lengthCounts[len - 1]) << 1);
+    nextCodes[len] = code;
+  }
+  for(uint32 s = 0; s < symbolCount; s++){
+    uint8 len = codeLengths[s];
+    if(len){codes[s] = na_ReverseInflateBits(nextCodes[len]++, len);}
+  }
+
+  // Determine the size of every subtable by the longest code sharing the
+  // same primary index.
+  naZeron(subtableBits, primarySize * sizeof(uint8));
+  for(uint32 s = 0; s < symbolCount; s++){
+    uint8 len = codeLengths[s];
+    if(len > tableBits){
+      uint32 prefix = codes[s] & primaryMask;
+      if(len - tableBits > subtableBits[prefix]){subtableBits[prefix] = (uint8)(len - tableBits);}
+    }
+  }
+  size = primarySize;
+  for(uint32 p = 0; p < primarySize; p++){
+    if(subtableBits[p]){
+      subtableOffsets[p] = (uint32)size;
+      size += (size_t)1 << subtableBits[p];
     }
   }
 
-  // Compute the actual codes of the alphabet
-  for(a = 0; a < tree->alphabetcount; a++) {
-    if(tree->codelengths[a]){
-      #if NA_DEBUG
-        if(tree->codelengths[a] > 16)
-          naError("Suddenly found a codelength of more than 16");
-      #endif
-      tree->codes[a] = nextcodes[tree->codelengths[a]];
-      nextcodes[tree->codelengths[a]]++;
+  if(size > table->capacity){
+    if(table->entries){naFree(table->entries);}
+    table->entries = naMalloc(size * sizeof(uint32));
+    table->capacity = size;
+  }
+
+  for(size_t i = 0; i < size; i++){
+    table->entries[i] = ((uint32)NA_INFLATE_INVALID_SYMBOL << 16) | 1;
+  }
+  for(uint32 p = 0; p < primarySize; p++){
+    if(subtableBits[p]){
+      table->entries[p] = (subtableOffsets[p] << 16) | NA_INFLATE_ENTRY_SUBTABLE | subtableBits[p];
     }
   }
 
-  // Create the tree out of the codes.
-  #if NA_DEBUG
-    openends = 1;
-  #endif
-  tree->indextree[0] = 0;
-  newtreeindex = 1;
-  for(a = 0; a < tree->alphabetcount; a++){
-    uint16 len;
-    code = tree->codes[a];
-    len = tree->codelengths[a];
+  // Every code is replicated for all entries whose lower bits match it.
+  for(uint32 s = 0; s < symbolCount; s++){
+    uint32 len = codeLengths[s];
     if(!len){continue;}
-    curmask = (uint16)(1 << (len - 1));
-    curIndex = 0;
-    while(curmask){
-      // If there is no entry in the tree, create two branches.
-      if(tree->indextree[curIndex] == 0){
-        #if NA_DEBUG
-          if(newtreeindex >= (2 * tree->alphabetcount - 1))
-            naError("tree index suddenly overflows");
-        #endif
-        tree->indextree[curIndex] = newtreeindex;
-        tree->indextree[newtreeindex] = 0;
-        tree->indextree[newtreeindex+1] = 0;
-        newtreeindex += 2;
-        #if NA_DEBUG
-          openends++;
-        #endif
+    if(len <= tableBits){
+      for(uint32 i = codes[s]; i < primarySize; i += (uint32)1 << len){
+        table->entries[i] = (s << 16) | len;
+      }
+    }else{
+      uint32 prefix = codes[s] & primaryMask;
+      uint32 subtableSize = (uint32)1 << subtableBits[prefix];
+      uint32* subtable = &(table->entries[subtableOffsets[prefix]]);
+      for(uint32 i = (uint32)codes[s] >> tableBits; i < subtableSize; i += (uint32)1 << (len - tableBits)){
+        subtable[i] = (s << 16) | len;
       }
+    }
+  }
 
-      curIndex = tree->indextree[curIndex];
+  return NA_TRUE;
+}
 
-      if(code & curmask){curIndex++;}
 
-      curmask >>= 1;
+
+// Makes sure, at least 56 bits are available in the bit buffer. If 8 bytes
+// of input are available, they are loaded at once.
+NA_HIDEF void na_RefillInflateBits(NAZLIBInflater* inflater){
+  if(inflater->inEnd - inflater->in >= 8){
+    const NAByte* in = inflater->in;
+    uint64 word =
+        (uint64)in[0]
+      | (uint64)in[1] << 8
+      | (uint64)in[2] << 16
+      | (uint64)in[3] << 24
+      | (uint64)in[4] << 32
+      | (uint64)in[5] << 40
+      | (uint64)in[6] << 48
+      | (uint64)in[7] << 56;
+    inflater->bitBuf |= word << inflater->bitCount;
+    inflater->in += (63 - inflater->bitCount) >> 3;
+    inflater->bitCount |= 56;
+  }else{
+    while(inflater->bitCount <= 56){
+      if(inflater->in < inflater->inEnd){
+        inflater->bitBuf |= (uint64)*inflater->in << inflater->bitCount;
+        inflater->in++;
+      }else{
+        inflater->overrunBytes++;
+      }
+      inflater->bitCount += 8;
     }
-    #if NA_DEBUG
-      if(curIndex >= (2 * tree->alphabetcount - 1))
-        naError("tree index overflow");
-    #endif
-    // reaching here, curIndex denotes the position of where the alphabet must
-    // be stored. We store the alphabet as negative value.
-    tree->indextree[curIndex] = -1 - (int32)a;
-    #if NA_DEBUG
-      if(tree->indextree[curIndex] >= 0)
-        naError("code can not be stored as a negative number");
-    #endif
+  }
+}
 
-    #if NA_DEBUG
-      openends --;
-      if(openends < 0)
-        naError("Tree overfilled");
-    #endif
 
+
+NA_HIDEF uint32 na_PeekInflateBits(NAZLIBInflater* inflater, uint32 count){
+  return (uint32)(inflater->bitBuf & (((uint64)1 << count) - 1));
+}
+
+
+
+NA_HIDEF void na_ConsumeInflateBits(NAZLIBInflater* inflater, uint32 count){
+  inflater->bitBuf >>= count;
+  inflater->bitCount -= count;
+}
+
+
+
+NA_HIDEF uint32 na_ReadInflateBits(NAZLIBInflater* inflater, uint32 count){
+  uint32 value = na_PeekInflateBits(inflater, count);
+  na_ConsumeInflateBits(inflater, count);
+  return value;
+}
+
+
+
+// Returns true if bits have been consumed which lie past the end of the
+// input, meaning the last unit was not completely available.
+NA_HIDEF NABool na_HasInflateOverrun(const NAZLIBInflater* inflater){
+  return (size_t)inflater->overrunBytes * 8 > inflater->bitCount;
+}
+
+
+
+NA_HIDEF void na_SaveInflateBitState(const NAZLIBInflater* inflater, NAInflateBitState* bitState){
+  bitState->in = inflater->in;
+  bitState->bitBuf = inflater->bitBuf;
+  bitState->bitCount = inflater->bitCount;
+  bitState->overrunBytes = inflater->overrunBytes;
+}
+
+
+
+NA_HIDEF void na_RestoreInflateBitState(NAZLIBInflater* inflater, const NAInflateBitState* bitState){
+  inflater->in = bitState->in;
+  inflater->bitBuf = bitState->bitBuf;
+  inflater->bitCount = bitState->bitCount;
+  inflater->overrunBytes = bitState->overrunBytes;
+}
+
+
+
+// Removes the zero bytes past the end of the input from the bit buffer such
+// that new input can be appended.
+NA_HIDEF void na_StripInflateOverrun(NAZLIBInflater* inflater){
+  if(inflater->overrunBytes){
+    inflater->bitCount -= inflater->overrunBytes * 8;
+    inflater->bitBuf &= ((uint64)1 << inflater->bitCount) - 1;
+    inflater->overrunBytes = 0;
   }
+}
+
+
+
+// Decodes one symbol. Expects at least 15 bits in the bit buffer.
+NA_HIDEF uint32 na_DecodeInflateSymbol(NAZLIBInflater* inflater, const NAInflateTable* table){
+  uint32 entry = table->entries[na_PeekInflateBits(inflater, table->tableBits)];
+  if(entry & NA_INFLATE_ENTRY_SUBTABLE){
+    uint32 index = (uint32)(inflater->bitBuf >> table->tableBits) & (((uint32)1 << (entry & 0xff)) - 1);
+    entry = table->entries[(entry >> 16) + index];
+  }
+  na_ConsumeInflateBits(inflater, entry & 0xff);
+  return entry >> 16;
+}
 
-  #if NA_DEBUG
-    if(openends != 0)
-      naError("Tree incomplete");
 
-    for(a = 0; a < newtreeindex; a++) {
-      if(tree->indextree[a] == 0)
-        naError("undefined index in tree");
+
+NA_HIDEF void na_UpdateInflateChecksum(NAZLIBInflater* inflater){
+  if(inflater->outPos > inflater->checksumPos){
+    naAccumulateChecksum(
+      &(inflater->checksum),
+      &(inflater->out[inflater->checksumPos]),
+      inflater->outPos - inflater->checksumPos);
+    inflater->checksumPos = inflater->outPos;
+  }
+}
+
+
+
+// Makes sure, at least the given number of bytes can be written to the
+// output buffer. If not, the window and all undrained bytes are moved to
+// the front of the buffer. Returns NA_FALSE if there still is not enough
+// space meaning the output needs to be drained first.
+NA_HIDEF NABool na_ReserveInflateOutput(NAZLIBInflater* inflater, size_t count){
+  size_t keepFrom;
+  if(inflater->outPos + count <= NA_INFLATE_OUT_BUFFER_SIZE){return NA_TRUE;}
+
+  keepFrom = naMins(inflater->drainPos, inflater->outPos - NA_DEFLATE_WINDOW_SIZE);
+  if(!keepFrom){return NA_FALSE;}
+  na_UpdateInflateChecksum(inflater);
+  memmove(inflater->out, &(inflater->out[keepFrom]), inflater->outPos - keepFrom);
+  inflater->outPos -= keepFrom;
+  inflater->drainPos -= keepFrom;
+  inflater->checksumPos -= keepFrom;
+  return (inflater->outPos + count <= NA_INFLATE_OUT_BUFFER_SIZE);
+}
+
+
+
+NA_HDEF void na_ReadInflateFixedCodes(NAZLIBInflater* inflater){
+  uint8 codeLengths[288];
+  uint16 i;
+  for(i = 0; i <= 143; i++){codeLengths[i] = 8;}
+  for(i = 144; i <= 255; i++){codeLengths[i] = 9;}
+  for(i = 256; i <= 279; i++){codeLengths[i] = 7;}
+  for(i = 280; i <= 287; i++){codeLengths[i] = 8;}
+  na_BuildInflateTable(&(inflater->litLenTable), codeLengths, 288);
+
+  // Note that only the values up to 29 are used but we fill up the remaining
+  // two values anyway as otherwise, the code will be incomplete.
+  for(i = 0; i < 32; i++){codeLengths[i] = 5;}
+  na_BuildInflateTable(&(inflater->distTable), codeLengths, 32);
+}
+
+
+
+// Returns NA_FALSE if the codes are invalid.
+NA_HDEF NABool na_ReadInflateDynamicCodes(NAZLIBInflater* inflater){
+  uint8 codeLengths[NA_DEFLATE_LITLEN_COUNT + NA_DEFLATE_DIST_COUNT + 2];
+  uint8 codeLengthLengths[NA_DEFLATE_CODELENGTH_COUNT] = {0};
+  uint32 hlit;
+  uint32 hdist;
+  uint32 hclen;
+  uint32 count;
+
+  na_RefillInflateBits(inflater);
+  hlit = na_ReadInflateBits(inflater, 5) + 257;
+  hdist = na_ReadInflateBits(inflater, 5) + 1;
+  hclen = na_ReadInflateBits(inflater, 4) + 4;
+  if(hlit > NA_DEFLATE_LITLEN_COUNT || hdist > NA_DEFLATE_DIST_COUNT){return NA_FALSE;}
+
+  for(uint32 c = 0; c < hclen; c++){
+    na_RefillInflateBits(inflater);
+    codeLengthLengths[na_DeflateCodeLengthOrder[c]] = (uint8)na_ReadInflateBits(inflater, 3);
+  }
+  if(!na_BuildInflateTable(&(inflater->codeLengthTable), codeLengthLengths, NA_DEFLATE_CODELENGTH_COUNT)){return NA_FALSE;}
+
+  // The literal/length and distance code lengths are encoded as one
+  // sequence, repetitions may cross from one to the other.
+  count = 0;
+  while(count < hlit + hdist){
+    uint32 symbol;
+    uint32 repeatCount;
+    uint8 repeatValue;
+
+    na_RefillInflateBits(inflater);
+    symbol = na_DecodeInflateSymbol(inflater, &(inflater->codeLengthTable));
+    if(symbol < 16){
+      codeLengths[count++] = (uint8)symbol;
+      continue;
+    }else if(symbol == 16){
+      if(!count){return NA_FALSE;}
+      repeatValue = codeLengths[count - 1];
+      repeatCount = na_ReadInflateBits(inflater, 2) + 3;
+    }else if(symbol == 17){
+      repeatValue = 0;
+      repeatCount = na_ReadInflateBits(inflater, 3) + 3;
+    }else if(symbol == 18){
+      repeatValue = 0;
+      repeatCount = na_ReadInflateBits(inflater, 7) + 11;
+    }else{
+      return NA_FALSE;
     }
-  #endif
+    if(count + repeatCount > hlit + hdist){return NA_FALSE;}
+    while(repeatCount--){codeLengths[count++] = repeatValue;}
+  }
+
+  return na_BuildInflateTable(&(inflater->litLenTable), codeLengths, hlit)
+    && na_BuildInflateTable(&(inflater->distTable), &(codeLengths[hlit]), hdist);
+}
+
+
 
+// Reads the 2 byte zlib header (RFC 1950) and the dictionary id if present.
+// Returns NA_FALSE if the header is invalid.
+NA_HDEF NABool na_ReadInflateZLIBHeader(NAZLIBInflater* inflater){
+  uint32 compressionmethodflags;
+  uint32 compressionadditionalflags;
+
+  na_RefillInflateBits(inflater);
+  compressionmethodflags = na_ReadInflateBits(inflater, 8);
+  compressionadditionalflags = na_ReadInflateBits(inflater, 8);
+
+  if((compressionmethodflags & 0x0f) != NA_ZLIB_CMF_COMPRESSION_DEFLATE){return NA_FALSE;}
+  if(((compressionmethodflags & 0xf0) >> 4) > NA_ZLIB_CMF_MAX_WINDOW_SIZE){return NA_FALSE;}
+  if((compressionmethodflags * 256 + compressionadditionalflags) % 31){return NA_FALSE;}
+
+  // Preset dictionaries are not supported. The id is skipped.
+  if(compressionadditionalflags & (1 << 5)){
+    na_ReadInflateBits(inflater, 32);
+  }
+  return NA_TRUE;
 }
 
 
 
-void naResetHuffmanCodeTree(NAHuffmanCodeTree* tree){
-  tree->curIndex = 0;
+// Reads the header of a deflate block (RFC 1951) including the huffman codes
+// or the length of a stored block. Returns NA_FALSE if the header is invalid.
+NA_HDEF NABool na_ReadInflateBlockHeader(NAZLIBInflater* inflater){
+  uint32 blockType;
+  uint32 len;
+  uint32 nlen;
+
+  na_RefillInflateBits(inflater);
+  inflater->isFinalBlock = (NABool)na_ReadInflateBits(inflater, 1);
+  blockType = na_ReadInflateBits(inflater, 2);
+
+  switch(blockType){
+  case 0x00:
+    // Stored blocks start at a byte boundary.
+    na_ConsumeInflateBits(inflater, inflater->bitCount & 7);
+    na_RefillInflateBits(inflater);
+    len = na_ReadInflateBits(inflater, 16);
+    nlen = na_ReadInflateBits(inflater, 16);
+    if(len != (~nlen & 0xffff)){return NA_FALSE;}
+    inflater->storedRemaining = len;
+    inflater->state = NA_INFLATE_STATE_STORED;
+    return NA_TRUE;
+  case 0x01:
+    na_ReadInflateFixedCodes(inflater);
+    inflater->state = NA_INFLATE_STATE_HUFFMAN;
+    return NA_TRUE;
+  case 0x02:
+    inflater->state = NA_INFLATE_STATE_HUFFMAN;
+    return na_ReadInflateDynamicCodes(inflater);
+  default:
+    return NA_FALSE;
+  }
 }
 
 
 
-NABool naTraverseHuffmanCodeTree(NAHuffmanCodeTree* tree, NABool bit, uint16* alphabet){
-  tree->curIndex = tree->indextree[tree->curIndex];
-  if(bit){tree->curIndex++;}
-  *alphabet = (uint16)(-(tree->indextree[tree->curIndex] + 1));
-  return (tree->indextree[tree->curIndex] >= 0);
+// Copies the stored block. Returns NA_FALSE if more input or output space is
+// needed.
+NA_HDEF NABool na_InflateStoredBlock(NAZLIBInflater* inflater){
+  while(inflater->storedRemaining){
+    if(!na_ReserveInflateOutput(inflater, 1)){return NA_FALSE;}
+
+    if(inflater->bitCount > inflater->overrunBytes * 8){
+      // As the block started at a byte boundary, the bit buffer contains
+      // whole bytes only.
+      inflater->out[inflater->outPos++] = (NAByte)na_ReadInflateBits(inflater, 8);
+      inflater->storedRemaining--;
+    }else{
+      size_t count;
+      inflater->bitBuf = 0;
+      inflater->bitCount = 0;
+      inflater->overrunBytes = 0;
+      count = naMins(
+        naMins(inflater->storedRemaining, NA_INFLATE_OUT_BUFFER_SIZE - inflater->outPos),
+        (size_t)(inflater->inEnd - inflater->in));
+      if(!count){return NA_FALSE;}
+      naCopyn(&(inflater->out[inflater->outPos]), inflater->in, count);
+      inflater->outPos += count;
+      inflater->in += count;
+      inflater->storedRemaining -= count;
+    }
+  }
+  inflater->state = inflater->isFinalBlock
+    ? NA_INFLATE_STATE_ZLIB_TRAILER
+    : NA_INFLATE_STATE_BLOCK_HEADER;
+  return NA_TRUE;
 }
 
 
 
-uint16 naDecodeHuffman(NAHuffmanCodeTree* tree, NABufferIterator* iter){
-  uint16 symbol;
-  naResetHuffmanCodeTree(tree);
-  while(naTraverseHuffmanCodeTree(tree, naReadBufferBit(iter), &symbol)){}
-  return symbol;
-}
-
-
-
-NAHuffmanCodeTree* naReadCodeLengthHuffman(NAHuffmanCodeTree* codelengthhuffman, NABufferIterator* iter, uint16 alphabetcount){
-  NAHuffmanCodeTree* alphabethuffman = naAllocHuffmanCodeTree(alphabetcount);
-  uint16 curalphabetcount = 0;
-  while(curalphabetcount < alphabetcount){
-    uint16 codelength;
-    uint16 repeatcount;
-    uint16 i;
-    codelength = naDecodeHuffman(codelengthhuffman, iter);
-    switch(codelength){
-    case 16:
-      repeatcount = (uint16)naReadBufferBits32(iter, 2) + 3;
-      #if NA_DEBUG
-        if((curalphabetcount + repeatcount) > alphabetcount)
-          naError("Internal Error: Reading too many literals at codelength 16");
-      #endif
-      for(i = 0; i < repeatcount; i++){alphabethuffman->codelengths[curalphabetcount + i] = alphabethuffman->codelengths[curalphabetcount - 1];}
-      curalphabetcount += repeatcount;
+// Decodes the symbols of a huffman block. Returns NA_FALSE if more input or
+// output space is needed or the data is corrupt.
+NA_HDEF NABool na_InflateHuffmanBlock(NAZLIBInflater* inflater){
+  const NAInflateTable* litLenTable = &(inflater->litLenTable);
+  const NAInflateTable* distTable = &(inflater->distTable);
+  NAInflateBitState bitState = {NA_NULL, 0, 0, 0};
+
+  while(1){
+    uint32 symbol;
+    NABool mayOverrun;
+
+    if(!na_ReserveInflateOutput(inflater, NA_DEFLATE_MAX_MATCH)){return NA_FALSE;}
+
+    // With at least 8 bytes of input, the refill provides 56 bits which is
+    // enough for the longest combination of litlen code, extra bits,
+    // distance code and extra bits: 15 + 5 + 15 + 13 = 48 bits. Otherwise,
+    // the symbol might be incomplete and decoding must be undoable.
+    mayOverrun = (inflater->inEnd - inflater->in < 8);
+    if(mayOverrun){na_SaveInflateBitState(inflater, &bitState);}
+
+    na_RefillInflateBits(inflater);
+    symbol = na_DecodeInflateSymbol(inflater, litLenTable);
+
+    if(symbol < 256){
+      if(mayOverrun && na_HasInflateOverrun(inflater)){break;}
+      inflater->out[inflater->outPos++] = (NAByte)symbol;
+    }else if(symbol == 256){
+      if(mayOverrun && na_HasInflateOverrun(inflater)){break;}
+      inflater->state = inflater->isFinalBlock
+        ? NA_INFLATE_STATE_ZLIB_TRAILER
+        : NA_INFLATE_STATE_BLOCK_HEADER;
+      return NA_TRUE;
+    }else if(symbol < 257 + 29){
+      size_t length;
+      size_t dist;
+      NAByte* dst;
+      const NAByte* src;
+
+      symbol -= 257;
+      length = na_DeflateLengthBase[symbol] + na_ReadInflateBits(inflater, na_DeflateLengthExtra[symbol]);
+      symbol = na_DecodeInflateSymbol(inflater, distTable);
+      if(mayOverrun && na_HasInflateOverrun(inflater)){break;}
+      if(symbol >= NA_DEFLATE_DIST_COUNT){
+        inflater->state = NA_INFLATE_STATE_CORRUPT;
+        return NA_FALSE;
+      }
+      dist = na_DeflateDistanceBase[symbol] + na_ReadInflateBits(inflater, na_DeflateDistanceExtra[symbol]);
+      if(mayOverrun && na_HasInflateOverrun(inflater)){break;}
+
+      if(dist > inflater->outPos){
+        #if NA_DEBUG
+          naError("Distance reaches before the start of the stream");
+        #endif
+        inflater->state = NA_INFLATE_STATE_CORRUPT;
+        return NA_FALSE;
+      }
+      dst = &(inflater->out[inflater->outPos]);
+      src = dst - dist;
+      inflater->outPos += length;
+      if(dist >= length){
+        naCopyn(dst, src, length);
+      }else{
+        // Overlapping copy repeating the last dist bytes.
+        while(length--){*dst++ = *src++;}
+      }
+    }else{
+      if(mayOverrun && na_HasInflateOverrun(inflater)){break;}
+      inflater->state = NA_INFLATE_STATE_CORRUPT;
+      return NA_FALSE;
+    }
+  }
+
+  // Reaching here, the symbol was incomplete.
+  na_RestoreInflateBitState(inflater, &bitState);
+  return NA_FALSE;
+}
+
+
+
+// Reads the adler checksum (RFC 1950) and compares it to the output.
+NA_HDEF void na_ReadInflateZLIBTrailer(NAZLIBInflater* inflater){
+  uint32 adler = 0;
+  na_ConsumeInflateBits(inflater, inflater->bitCount & 7);
+  na_RefillInflateBits(inflater);
+  for(int i = 0; i < 4; i++){
+    adler = (adler << 8) | na_ReadInflateBits(inflater, 8);
+  }
+  if(na_HasInflateOverrun(inflater)){return;}
+
+  na_UpdateInflateChecksum(inflater);
+  if(adler == naGetChecksumResult(&(inflater->checksum))){
+    inflater->state = NA_INFLATE_STATE_DONE;
+  }else{
+    #if NA_DEBUG
+      naError("Adler code does not correspond to decompression result");
+    #endif
+    inflater->state = NA_INFLATE_STATE_CORRUPT;
+  }
+}
+
+
+
+// Decodes as much as possible with the available input and output space.
+NA_HDEF void na_RunInflater(NAZLIBInflater* inflater){
+  NAInflateBitState bitState;
+  NAInflateState prevState;
+  NABool proceed = NA_TRUE;
+
+  while(proceed){
+    NABool valid = NA_TRUE;
+
+    switch(inflater->state){
+    case NA_INFLATE_STATE_ZLIB_HEADER:
+    case NA_INFLATE_STATE_BLOCK_HEADER:
+    case NA_INFLATE_STATE_ZLIB_TRAILER:
+      // Headers are decoded as a whole. If the input ends within, decoding
+      // is undone and resumed when more input is available.
+      prevState = inflater->state;
+      na_SaveInflateBitState(inflater, &bitState);
+      if(inflater->state == NA_INFLATE_STATE_ZLIB_HEADER){
+        valid = na_ReadInflateZLIBHeader(inflater);
+        if(valid){inflater->state = NA_INFLATE_STATE_BLOCK_HEADER;}
+      }else if(inflater->state == NA_INFLATE_STATE_BLOCK_HEADER){
+        valid = na_ReadInflateBlockHeader(inflater);
+      }else{
+        na_ReadInflateZLIBTrailer(inflater);
+      }
+      if(na_HasInflateOverrun(inflater)){
+        na_RestoreInflateBitState(inflater, &bitState);
+        inflater->state = prevState;
+        proceed = NA_FALSE;
+      }else if(!valid){
+        #if NA_DEBUG
+          naError("Invalid zlib or deflate block header");
+        #endif
+        inflater->state = NA_INFLATE_STATE_CORRUPT;
+      }
       break;
-    case 17:
-      repeatcount = (uint16)naReadBufferBits32(iter, 3) + 3;
-      #if NA_DEBUG
-        if((curalphabetcount + repeatcount) > alphabetcount)
-          naError("Internal Error: Reading too many literals at codelength 17");
-      #endif
-      for(i = 0; i < repeatcount; i++){alphabethuffman->codelengths[curalphabetcount + i] = 0;}
-      curalphabetcount += repeatcount;
+    case NA_INFLATE_STATE_STORED:
+      proceed = na_InflateStoredBlock(inflater);
       break;
-    case 18:
-      repeatcount = (uint16)naReadBufferBits32(iter, 7) + 11;
-      #if NA_DEBUG
-        if((curalphabetcount + repeatcount) > alphabetcount)
-          naError("Internal Error: Reading too many literals at codelength 18");
-      #endif
-      for(i = 0; i < repeatcount; i++){alphabethuffman->codelengths[curalphabetcount + i] = 0;}
-      curalphabetcount += repeatcount;
+    case NA_INFLATE_STATE_HUFFMAN:
+      proceed = na_InflateHuffmanBlock(inflater);
       break;
-    default:
-      alphabethuffman->codelengths[curalphabetcount] = codelength;
-      curalphabetcount++;
+    case NA_INFLATE_STATE_DONE:
+    case NA_INFLATE_STATE_CORRUPT:
+      proceed = NA_FALSE;
       break;
     }
   }
 
-  naBuildHuffmanCodeTree(alphabethuffman);
-  return alphabethuffman;
-}
-
-
-
-uint16 naDecodeLiteralLength(NABufferIterator* iter, uint16 code){
-  uint16 retValue;
-  switch(code){
-  case 257: retValue = 3; break;
-  case 258: retValue = 4; break;
-  case 259: retValue = 5; break;
-  case 260: retValue = 6; break;
-  case 261: retValue = 7; break;
-  case 262: retValue = 8; break;
-  case 263: retValue = 9; break;
-  case 264: retValue = 10; break;
-  case 265: retValue = 11 + (uint16)naReadBufferBits32(iter, 1); break;
-  case 266: retValue = 13 + (uint16)naReadBufferBits32(iter, 1); break;
-  case 267: retValue = 15 + (uint16)naReadBufferBits32(iter, 1); break;
-  case 268: retValue = 17 + (uint16)naReadBufferBits32(iter, 1); break;
-  case 269: retValue = 19 + (uint16)naReadBufferBits32(iter, 2); break;
-  case 270: retValue = 23 + (uint16)naReadBufferBits32(iter, 2); break;
-  case 271: retValue = 27 + (uint16)naReadBufferBits32(iter, 2); break;
-  case 272: retValue = 31 + (uint16)naReadBufferBits32(iter, 2); break;
-  case 273: retValue = 35 + (uint16)naReadBufferBits32(iter, 3); break;
-  case 274: retValue = 43 + (uint16)naReadBufferBits32(iter, 3); break;
-  case 275: retValue = 51 + (uint16)naReadBufferBits32(iter, 3); break;
-  case 276: retValue = 59 + (uint16)naReadBufferBits32(iter, 3); break;
-  case 277: retValue = 67 + (uint16)naReadBufferBits32(iter, 4); break;
-  case 278: retValue = 83 + (uint16)naReadBufferBits32(iter, 4); break;
-  case 279: retValue = 99 + (uint16)naReadBufferBits32(iter, 4); break;
-  case 280: retValue = 115 + (uint16)naReadBufferBits32(iter, 4); break;
-  case 281: retValue = 131 + (uint16)naReadBufferBits32(iter, 5); break;
-  case 282: retValue = 163 + (uint16)naReadBufferBits32(iter, 5); break;
-  case 283: retValue = 195 + (uint16)naReadBufferBits32(iter, 5); break;
-  case 284: retValue = 227 + (uint16)naReadBufferBits32(iter, 5); break;
-  case 285: retValue = 258; break;
-  default:
-    #if NA_DEBUG
-      naError("Invalid literal length code receyved");
-    #endif
-    retValue = 0;
-    break;
-  }
-  return retValue;
-}
-
-
-uint16 naDecodeDistance(NABufferIterator* iter, uint16 code){
-  uint16 retValue;
-  switch(code){
-  case 0: retValue = 1; break;
-  case 1: retValue = 2; break;
-  case 2: retValue = 3; break;
-  case 3: retValue = 4; break;
-  case 4: retValue = 5 + (uint16)naReadBufferBits32(iter, 1); break;
-  case 5: retValue = 7 + (uint16)naReadBufferBits32(iter, 1); break;
-  case 6: retValue = 9 + (uint16)naReadBufferBits32(iter, 2); break;
-  case 7: retValue = 13 + (uint16)naReadBufferBits32(iter, 2); break;
-  case 8: retValue = 17 + (uint16)naReadBufferBits32(iter, 3); break;
-  case 9: retValue = 25 + (uint16)naReadBufferBits32(iter, 3); break;
-  case 10: retValue = 33 + (uint16)naReadBufferBits32(iter, 4); break;
-  case 11: retValue = 49 + (uint16)naReadBufferBits32(iter, 4); break;
-  case 12: retValue = 65 + (uint16)naReadBufferBits32(iter, 5); break;
-  case 13: retValue = 97 + (uint16)naReadBufferBits32(iter, 5); break;
-  case 14: retValue = 129 + (uint16)naReadBufferBits32(iter, 6); break;
-  case 15: retValue = 193 + (uint16)naReadBufferBits32(iter, 6); break;
-  case 16: retValue = 257 + (uint16)naReadBufferBits32(iter, 7); break;
-  case 17: retValue = 385 + (uint16)naReadBufferBits32(iter, 7); break;
-  case 18: retValue = 513 + (uint16)naReadBufferBits32(iter, 8); break;
-  case 19: retValue = 769 + (uint16)naReadBufferBits32(iter, 8); break;
-  case 20: retValue = 1025 + (uint16)naReadBufferBits32(iter, 9); break;
-  case 21: retValue = 1537 + (uint16)naReadBufferBits32(iter, 9); break;
-  case 22: retValue = 2049 + (uint16)naReadBufferBits32(iter, 10); break;
-  case 23: retValue = 3073 + (uint16)naReadBufferBits32(iter, 10); break;
-  case 24: retValue = 4097 + (uint16)naReadBufferBits32(iter, 11); break;
-  case 25: retValue = 6145 + (uint16)naReadBufferBits32(iter, 11); break;
-  case 26: retValue = 8193 + (uint16)naReadBufferBits32(iter, 12); break;
-  case 27: retValue = 12289 + (uint16)naReadBufferBits32(iter, 12); break;
-  case 28: retValue = 16385 + (uint16)naReadBufferBits32(iter, 13); break;
-  case 29: retValue = 24577 + (uint16)naReadBufferBits32(iter, 13); break;
-  default:
+  na_UpdateInflateChecksum(inflater);
+  na_StripInflateOverrun(inflater);
+
+  // If decoding stopped without any output pending, it is waiting for input.
+  if(inflater->inputComplete
+    && inflater->drainPos == inflater->outPos
+    && inflater->state != NA_INFLATE_STATE_DONE
+    && inflater->state != NA_INFLATE_STATE_CORRUPT){
     #if NA_DEBUG
-      naError("Invalid distance code receyved");
+      naError("Deflate stream is truncated");
     #endif
-    retValue = 0;
-    break;
+    inflater->state = NA_INFLATE_STATE_CORRUPT;
   }
-  return retValue;
 }
 
 
 
-NA_HDEF void na_ReadDymanicHuffmanCodes(NABufferIterator* iter, NAHuffmanCodeTree** literalhuffman, NAHuffmanCodeTree** distancehuffman){
-  uint8 codeorder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
-  int c;
+NA_DEF NAZLIBInflater* naNewZLIBInflater(void){
+  NAZLIBInflater* inflater = naNew(NAZLIBInflater);
+  inflater->state = NA_INFLATE_STATE_ZLIB_HEADER;
+  inflater->isFinalBlock = NA_FALSE;
+  inflater->inputComplete = NA_FALSE;
+  inflater->storedRemaining = 0;
+
+  inflater->inBuf = NA_NULL;
+  inflater->inCapacity = 0;
+  inflater->in = NA_NULL;
+  inflater->inEnd = NA_NULL;
+  inflater->bitBuf = 0;
+  inflater->bitCount = 0;
+  inflater->overrunBytes = 0;
+
+  na_InitInflateTable(&(inflater->litLenTable), NA_INFLATE_LITLEN_TABLE_BITS);
+  na_InitInflateTable(&(inflater->distTable), NA_INFLATE_DIST_TABLE_BITS);
+  na_InitInflateTable(&(inflater->codeLengthTable), NA_INFLATE_CODELENGTH_TABLE_BITS);
+
+  inflater->out = naMalloc(NA_INFLATE_OUT_BUFFER_SIZE);
+  inflater->outPos = 0;
+  inflater->drainPos = 0;
+  inflater->checksumPos = 0;
+  naInitChecksum(&(inflater->checksum), NA_CHECKSUM_TYPE_ADLER_32);
+  return inflater;
+}
+
+
+
+NA_HDEF void na_DestructZLIBInflater(NAZLIBInflater* inflater){
+  if(inflater->inBuf){naFree(inflater->inBuf);}
+  na_ClearInflateTable(&(inflater->litLenTable));
+  na_ClearInflateTable(&(inflater->distTable));
+  na_ClearInflateTable(&(inflater->codeLengthTable));
+  naFree(inflater->out);
+  naClearChecksum(&(inflater->checksum));
+}
+
 
-  uint16 hlit = (uint16)naReadBufferBits32(iter, 5) + 257;
-  uint8 hdist = (uint8)naReadBufferBits32(iter, 5) + 1;
-  uint8 hclen = (uint8)naReadBufferBits32(iter, 4) + 4;
 
-//  naAlloc(NABuffer);
-  NAHuffmanCodeTree* codelengthhuffman = naAllocHuffmanCodeTree(19);
-  for(c = 0; c < hclen; c++){
-    codelengthhuffman->codelengths[codeorder[c]] = (uint16)naReadBufferBits32(iter, 3);
+NA_DEF void naFeedZLIBInflater(NAZLIBInflater* inflater, const NAByte* data, size_t byteSize){
+  size_t remaining;
+  #if NA_DEBUG
+    if(inflater->inputComplete)
+      naError("Inflater has already been finished");
+  #endif
+  if(!byteSize){return;}
+
+  // Unconsumed input is moved to the front before appending the new data.
+  remaining = (size_t)(inflater->inEnd - inflater->in);
+  if(remaining + byteSize > inflater->inCapacity){
+    size_t newCapacity = naMaxs(remaining + byteSize, 2 * inflater->inCapacity);
+    NAByte* newBuf = naMalloc(newCapacity);
+    if(remaining){naCopyn(newBuf, inflater->in, remaining);}
+    if(inflater->inBuf){naFree(inflater->inBuf);}
+    inflater->inBuf = newBuf;
+    inflater->inCapacity = newCapacity;
+  }else if(remaining && inflater->in != inflater->inBuf){
+    memmove(inflater->inBuf, inflater->in, remaining);
   }
-  naBuildHuffmanCodeTree(codelengthhuffman);
+  naCopyn(&(inflater->inBuf[remaining]), data, byteSize);
+  inflater->in = inflater->inBuf;
+  inflater->inEnd = inflater->inBuf + remaining + byteSize;
+}
 
-  *literalhuffman = naReadCodeLengthHuffman(codelengthhuffman, iter, hlit);
-  *distancehuffman = naReadCodeLengthHuffman(codelengthhuffman, iter, hdist);
 
-  // Now, the literal and distance codes are read.
-  naDeallocHuffmanCodeTree(codelengthhuffman);
 
+NA_DEF size_t naDrainZLIBInflater(NAZLIBInflater* inflater, NAByte* data, size_t byteSize){
+  size_t drained = 0;
+  while(drained < byteSize){
+    size_t count;
+    if(inflater->drainPos == inflater->outPos){
+      na_RunInflater(inflater);
+      if(inflater->drainPos == inflater->outPos){break;}
+    }
+    count = naMins(inflater->outPos - inflater->drainPos, byteSize - drained);
+    naCopyn(&(data[drained]), &(inflater->out[inflater->drainPos]), count);
+    inflater->drainPos += count;
+    drained += count;
+  }
+  return drained;
 }
 
 
 
-NA_HDEF void na_AllocFixedHuffmanCodes(NAHuffmanCodeTree** literalhuffman, NAHuffmanCodeTree** distancehuffman){
-  uint16 i;
+NA_DEF NABool naFinishZLIBInflater(NAZLIBInflater* inflater){
+  inflater->inputComplete = NA_TRUE;
+  if(inflater->drainPos == inflater->outPos){
+    na_RunInflater(inflater);
+  }
+  return inflater->state == NA_INFLATE_STATE_DONE;
+}
 
-  *literalhuffman = naAllocHuffmanCodeTree(288);
-  for(i = 0; i <= 143; i++){
-    (*literalhuffman)->codelengths[i] = 8;
+
+
+NA_DEF NABool naFillBufferWithZLIBDecompression(NABuffer* output, NABuffer* input){
+  NABufferIterator iterin;
+  NABufferIterator iterout;
+  NAByte* chunk;
+  NAInt remaining;
+  size_t count;
+  NABool success;
+
+  #if NA_DEBUG
+    if(naGetBufferEndianness(input) != NA_ENDIANNESS_NETWORK)
+      naError("Input buffer should be big endianed");
+  #endif
+
+  NAZLIBInflater* inflater = naNewZLIBInflater();
+  chunk = naMalloc(NA_INFLATE_CHUNK_SIZE);
+  iterin = naMakeBufferAccessor(input);
+  iterout = naMakeBufferModifier(output);
+
+  // The input is fed in chunks and the output written as soon as possible,
+  // hence neither needs to be available as a whole.
+  remaining = naGetBufferRange(input).length;
+  while(remaining > 0){
+    count = naMins((size_t)remaining, NA_INFLATE_CHUNK_SIZE);
+    naReadBufferBytes(&iterin, chunk, count);
+    naFeedZLIBInflater(inflater, chunk, count);
+    remaining -= (NAInt)count;
+    while((count = naDrainZLIBInflater(inflater, chunk, NA_INFLATE_CHUNK_SIZE))){
+      naWriteBufferBytes(&iterout, chunk, count);
+    }
   }
-  for(i = 144; i <= 255; i++){
-    (*literalhuffman)->codelengths[i] = 9;
+  success = naFinishZLIBInflater(inflater);
+
+  naClearBufferIterator(&iterin);
+  naClearBufferIterator(&iterout);
+  naFixBufferRange(output);
+  naFree(chunk);
+  naDelete(inflater);
+  return success;
+}
+
+
+
+// ////////////////////////////
+// Compression
+// ////////////////////////////
+
+#define NA_ZLIB_PRESET_DICT_AVAILABLE 0
+
+#define NA_DEFLATE_WINDOW_MASK      (NA_DEFLATE_WINDOW_SIZE - 1)
+#define NA_DEFLATE_HASH_BITS        15
+#define NA_DEFLATE_HASH_SIZE        (1 << NA_DEFLATE_HASH_BITS)
+#define NA_DEFLATE_TOO_FAR          4096  // Distance not worth a 3-byte match
+#define NA_DEFLATE_BLOCK_SYMBOLS    16384 // Symbols gathered per block
+#define NA_DEFLATE_MAX_STORED       65535 // Maximal bytes in a stored block
+#define NA_DEFLATE_MAX_CL_LENGTH    7
+#define NA_DEFLATE_BUFFER_SIZE      (1 << 17) // Input buffer, multiple of the window
+#define NA_DEFLATE_LOOKAHEAD        (NA_DEFLATE_MAX_MATCH + NA_DEFLATE_MIN_MATCH)
+#define NA_DEFLATE_OUT_BUFFER_SIZE  (1 << 16) // Initial output capacity
+
+
+// The compression levels mainly differ in how many candidates in the hash
+// chain are tested for a match and whether lazy matching is used, meaning
+// a match is deferred if the next position yields a longer one. Greedy
+// matching with longer chains tends to pick far matches whose distance codes
+// cost more than they save, hence all levels above the fastest match lazily
+// and on typical data each level compresses at least as well as the one
+// below.
+typedef struct NADeflateLevelSettings NADeflateLevelSettings;
+struct NADeflateLevelSettings{
+  size_t maxChain;    // Maximal number of hash chain candidates tested.
+  size_t niceLength;  // Stop searching once a match this long is found.
+  size_t lazyLength;  // Only search lazily if the current match is shorter.
+  NABool lazy;
+};
+
+static const NADeflateLevelSettings na_DeflateLevelSettings[4] = {
+  {   4,   8,   0, NA_FALSE},  // NA_DEFLATE_COMPRESSION_FASTEST
+  {  16,  32,   8, NA_TRUE},   // NA_DEFLATE_COMPRESSION_FAST
+  { 128, 128,  32, NA_TRUE},   // NA_DEFLATE_COMPRESSION_DEFAULT
+  {4096, 258, 258, NA_TRUE},   // NA_DEFLATE_COMPRESSION_MAX
+};
+
+
+
+struct NAZLIBDeflater{
+  NADeflateLevelSettings settings;
+  NABool finishing;
+
+  // Input. The bytes fed are appended to src. Once it is full, it is moved
+  // to the front by a multiple of the window size, keeping the window of
+  // the current position. pos is the next byte to be encoded.
+  NAByte* src;
+  size_t srcSize;
+  size_t pos;
+  NAChecksum checksum;
+
+  // The state of lazy matching: The match found at pos - 1 which might be
+  // replaced by a longer one starting at pos.
+  size_t prevLength;
+  size_t prevDistance;
+  NABool prevAvailable;
+
+  // Hash chains. head stores the most recent position for every hash value,
+  // prev the previous position with the same hash for every window position.
+  NAInt* head;
+  NAInt* prev;
+
+  // The symbols of the current block. A distance of 0 denotes a literal.
+  uint16* litLens;
+  uint16* dists;
+  size_t symbolCount;
+  size_t blockStart;
+
+  uint16 litLenFreqs[NA_DEFLATE_LITLEN_COUNT];
+  uint16 distFreqs[NA_DEFLATE_DIST_COUNT];
+
+  // Bit output. Bits are gathered LSB first and appended bytewise to out.
+  // The bytes from drainPos to outCount have not been drained yet.
+  uint32 bitBuf;
+  uint32 bitCount;
+  NAByte* out;
+  size_t outCount;
+  size_t outCapacity;
+  size_t drainPos;
+};
+
+NA_HAPI void na_DestructZLIBDeflater(NAZLIBDeflater* enc);
+NA_RUNTIME_TYPE(NAZLIBDeflater, na_DestructZLIBDeflater, NA_FALSE);
+
+
+
+// Makes sure, the given number of bytes can be appended to the output.
+NA_HDEF void na_ReserveDeflateOutput(NAZLIBDeflater* enc, size_t count){
+  if(enc->outCount + count <= enc->outCapacity){return;}
+  if(enc->drainPos){
+    if(enc->outCount > enc->drainPos){
+      memmove(enc->out, &(enc->out[enc->drainPos]), enc->outCount - enc->drainPos);
+    }
+    enc->outCount -= enc->drainPos;
+    enc->drainPos = 0;
   }
-  for(i = 256; i <= 279; i++){
-    (*literalhuffman)->codelengths[i] = 7;
+  if(enc->outCount + count > enc->outCapacity){
+    size_t newCapacity = naMaxs(enc->outCount + count, 2 * enc->outCapacity);
+    NAByte* newOut = naMalloc(newCapacity);
+    if(enc->outCount){naCopyn(newOut, enc->out, enc->outCount);}
+    naFree(enc->out);
+    enc->out = newOut;
+    enc->outCapacity = newCapacity;
   }
-  for(i = 280; i <= 287; i++){
-    (*literalhuffman)->codelengths[i] = 8;
+}
+
+
+
+NA_HIDEF void na_WriteDeflateByte(NAZLIBDeflater* enc, NAByte byte){
+  if(enc->outCount == enc->outCapacity){
+    na_ReserveDeflateOutput(enc, 1);
   }
-  naBuildHuffmanCodeTree(*literalhuffman);
+  enc->out[enc->outCount] = byte;
+  enc->outCount++;
+}
 
-  // Note that only the values up to 29 are used but we fill up the remaining
-  // thre values anyway as otherwise, the huffman tree will be incomplete.
-  *distancehuffman = naAllocHuffmanCodeTree(32);
-  for(i = 0; i < 32; i++){
-    (*distancehuffman)->codelengths[i] = 5;
+
+
+// Writes count bits (at most 16) of value, least significant bit first.
+NA_HIDEF void na_WriteDeflateBits(NAZLIBDeflater* enc, uint32 value, uint32 count){
+  enc->bitBuf |= value << enc->bitCount;
+  enc->bitCount += count;
+  while(enc->bitCount >= 8){
+    na_WriteDeflateByte(enc, (NAByte)(enc->bitBuf & 0xff));
+    enc->bitBuf >>= 8;
+    enc->bitCount -= 8;
   }
-  naBuildHuffmanCodeTree(*distancehuffman);
 }
 
 
-#define NA_ZLIB_CMF_COMPRESSION_DEFLATE 8
-#define NA_ZLIB_CMF_MAX_WINDOW_SIZE 7     // 2 ^ MAX_WINDOWSIZE + 8
 
+NA_HIDEF void na_PadDeflateBits(NAZLIBDeflater* enc){
+  if(enc->bitCount){
+    na_WriteDeflateByte(enc, (NAByte)(enc->bitBuf & 0xff));
+  }
+  enc->bitBuf = 0;
+  enc->bitCount = 0;
+}
 
-NA_DEF void naFillBufferWithZLIBDecompression(NABuffer* output, NABuffer* input){
-  uint8 compressionmethodflags;
-  uint8 compressionmethod;
-  uint8 compressioninfo;
-  uint16 windowsize;
-  uint8 compressionadditionalflags;
-  uint32 flagcheck;
-  NABool haspresetdict;
-  NADeflateCompressionLevel compressionlevel;
-  uint32 dictadler;
-  NABuffer* zbuffer;
-  uint32 zbufferadler;
-  NAChecksum checksum;
-  uint32 adler;
-  NABufferIterator iterin;
-  NABufferIterator iterout;
-  NABufferIterator iterz;
 
-  // First, read RFC 1950
-  NAInt zbuffersize = naGetBufferRange(input).length - 6;
-  // The 6 Bytes are the CMF and FLG Bytes as well as the Adler number.
-  // If there is a DICTID, zbuffersize will be reduced by 4 more bytes later.
 
-  iterin = naMakeBufferAccessor(input);
+NA_HIDEF uint16 na_GetDeflateLengthCode(size_t length){
+  uint16 code = 0;
+  while(code < 28 && na_DeflateLengthBase[code + 1] <= length){code++;}
+  return code;
+}
 
-  #if NA_DEBUG
-    if(naGetBufferEndianness(input) != NA_ENDIANNESS_NETWORK)
-      naError("Input buffer should be big endianed");
-  #endif
-  compressionmethodflags = naReadBufferu8(&iterin);
-  compressionmethod = compressionmethodflags & 0x0f;
-  #if NA_DEBUG
-    if(compressionmethod != NA_ZLIB_CMF_COMPRESSION_DEFLATE)
-      naError("Compression method of Deflate buffer unknown");
-  #endif
-  compressioninfo = (compressionmethodflags & 0xf0) >> 4;
-  #if NA_DEBUG
-    if(compressioninfo > NA_ZLIB_CMF_MAX_WINDOW_SIZE)
-      naError("Window size too big");
-  #endif
-  windowsize = (uint16)(1 << (compressioninfo + 8));
-  compressionadditionalflags = naReadBufferu8(&iterin);
-  flagcheck = compressionmethodflags * 256 + compressionadditionalflags;
-  #if NA_DEBUG
-    if(flagcheck % 31)
-      naError("Flag check failed");
-  #endif
-  haspresetdict = (compressionadditionalflags & (1 << 5)) ? NA_TRUE : NA_FALSE;
-  compressionlevel = (NADeflateCompressionLevel) ((compressionadditionalflags >> 6) & 0x03);
 
-  NA_UNUSED(windowsize);
-  NA_UNUSED(compressionlevel);
-  #if NA_DEBUG
-  #else
-    NA_UNUSED(compressionmethod);
-    NA_UNUSED(flagcheck);
-  #endif
 
-  if(haspresetdict){
-    dictadler = naReadBufferu32(&iterin);
-    zbuffersize -= 4;
+NA_HIDEF uint16 na_GetDeflateDistanceCode(size_t distance){
+  uint16 code = 0;
+  while(code < 29 && na_DeflateDistanceBase[code + 1] <= distance){code++;}
+  return code;
+}
+
+
+
+// Lookup tables to quickly convert a length or distance to its code.
+static uint8 na_DeflateLengthCodes[NA_DEFLATE_MAX_MATCH + 1];
+static uint8 na_DeflateDistanceCodesLow[256];   // distance - 1 < 256
+static uint8 na_DeflateDistanceCodesHigh[256];  // (distance - 1) >> 7
+static NABool na_DeflateCodeTablesInitialized = NA_FALSE;
+
+NA_HDEF void na_InitDeflateCodeTables(void){
+  if(na_DeflateCodeTablesInitialized){return;}
+  for(size_t i = NA_DEFLATE_MIN_MATCH; i <= NA_DEFLATE_MAX_MATCH; i++){
+    na_DeflateLengthCodes[i] = (uint8)na_GetDeflateLengthCode(i);
   }
-  NA_UNUSED(dictadler);
+  for(size_t i = 0; i < 256; i++){
+    na_DeflateDistanceCodesLow[i] = (uint8)na_GetDeflateDistanceCode(i + 1);
+    na_DeflateDistanceCodesHigh[i] = (uint8)na_GetDeflateDistanceCode((i << 7) + 1);
+  }
+  na_DeflateCodeTablesInitialized = NA_TRUE;
+}
 
-  zbuffer = naNewBufferExtraction(input, naGetBufferLocation(&iterin), zbuffersize);
-  naLocateBufferRelative(&iterin, zbuffersize);
-  zbufferadler = naReadBufferu32(&iterin);
 
-  naClearBufferIterator(&iterin);
 
-  // Now start RFC 1951
+NA_HIDEF uint16 na_LookupDeflateDistanceCode(size_t distance){
+  return (distance <= 256)
+    ? na_DeflateDistanceCodesLow[distance - 1]
+    : na_DeflateDistanceCodesHigh[(distance - 1) >> 7];
+}
 
-  // Important! RFC 1951 is Little-endianed, whereas RFC 1950 is big endianed!
-  naSetBufferEndianness(zbuffer, NA_ENDIANNESS_LITTLE);
 
-  iterout = naMakeBufferModifier(output);
-  iterz = naMakeBufferModifier(zbuffer);
 
-  while(1){
-    NAByte isblockfinal = (NAByte)naReadBufferBits32(&iterz, 1);
-    NAByte blocktype = (NAByte)naReadBufferBits32(&iterz, 2);
-    #if NA_DEBUG
-      if(blocktype == 0x03)
-      naError("Block compression invalid");
-    #endif
-    if(blocktype == 0x00){
-      // Blocktype 0x00 is an uncompressed block.
-      uint16 len;
-      uint16 nlen;
-      NAByte* tmpbuf;
-
-      naPadBufferBits(&iterz);
-      len = naReadBufferu16(&iterz);
-      nlen = naReadBufferu16(&iterz);
-      #if NA_DEBUG
-        if((uint16)len != (uint16)(~nlen))
-        naError("Len and NLen do not match in one's complement");
-      #else
-        NA_UNUSED(nlen);
-      #endif
-      // the len denotes the number of bytes in the whole block. Todo: Check
-      // how this behaves if the first three bits are not at the first bit
-      // position.
-      tmpbuf = naMalloc(len);
-      naReadBufferBytes(&iterz, tmpbuf, len);
-      naWriteBufferBytes(&iterout, tmpbuf, len);
-      naFree(tmpbuf);
+// Reverses the lowest count bits of code. Huffman codes are stored starting
+// with the most significant bit whereas all other values start with the least.
+NA_HIDEF uint16 na_ReverseDeflateBits(uint16 code, uint16 count){
+  uint16 result = 0;
+  for(uint16 i = 0; i < count; i++){
+    result = (uint16)((result << 1) | (code & 1));
+    code >>= 1;
+  }
+  return result;
+}
+
+
+
+typedef struct NADeflateSymbolFreq NADeflateSymbolFreq;
+struct NADeflateSymbolFreq{
+  uint32 freq;
+  uint16 symbol;
+};
+
+NA_HDEF int na_CompareDeflateSymbolFreqs(const void* a, const void* b){
+  const NADeflateSymbolFreq* fa = (const NADeflateSymbolFreq*)a;
+  const NADeflateSymbolFreq* fb = (const NADeflateSymbolFreq*)b;
+  if(fa->freq != fb->freq){return (fa->freq < fb->freq) ? -1 : 1;}
+  return (fa->symbol < fb->symbol) ? -1 : 1;
+}
+
+
+
+// Computes length-limited huffman code lengths for the given frequencies.
+// At least two codes will always be assigned such that the resulting code is
+// complete and every symbol decodes through the lookup tables of the
+// inflater built by na_BuildInflateTable.
+NA_HDEF void na_ComputeDeflateCodeLengths(uint16* lengths, const uint16* freqs, uint16 count, uint16 maxLength){
+  NADeflateSymbolFreq syms[NA_DEFLATE_LITLEN_COUNT];
+  uint32 weights[2 * NA_DEFLATE_LITLEN_COUNT];
+  int32 parents[2 * NA_DEFLATE_LITLEN_COUNT];
+  uint16 lengthCounts[2 * NA_DEFLATE_LITLEN_COUNT];
+  uint16 symCount = 0;
+
+  for(uint16 i = 0; i < count; i++){
+    lengths[i] = 0;
+    if(freqs[i]){
+      syms[symCount].freq = freqs[i];
+      syms[symCount].symbol = i;
+      symCount++;
+    }
+  }
+
+  // Make sure there are at least two symbols. Otherwise, the tree would be
+  // incomplete.
+  for(uint16 i = 0; symCount < 2 && i < count; i++){
+    if(!freqs[i]){
+      syms[symCount].freq = 1;
+      syms[symCount].symbol = i;
+      symCount++;
+    }
+  }
+
+  qsort(syms, symCount, sizeof(NADeflateSymbolFreq), na_CompareDeflateSymbolFreqs);
+
+  // Build the huffman tree with the two-queue method: The leaves are already
+  // sorted and the inner nodes are created in ascending order of weight.
+  for(uint16 i = 0; i < symCount; i++){weights[i] = syms[i].freq;}
+  uint16 leaf = 0;
+  uint16 node = symCount;
+  uint16 nodeNext = symCount;
+  for(uint16 n = 0; n < symCount - 1; n++){
+    uint16 pick[2];
+    for(int p = 0; p < 2; p++){
+      if(leaf < symCount && (node == nodeNext || weights[leaf] <= weights[node])){
+        pick[p] = leaf;
+        leaf++;
+      }else{
+        pick[p] = node;
+        node++;
+      }
+    }
+    weights[nodeNext] = weights[pick[0]] + weights[pick[1]];
+    parents[pick[0]] = nodeNext;
+    parents[pick[1]] = nodeNext;
+    nodeNext++;
+  }
+
+  // Compute the depths from the root downwards. The root is the last node.
+  uint16 depths[2 * NA_DEFLATE_LITLEN_COUNT];
+  depths[nodeNext - 1] = 0;
+  for(int32 i = (int32)nodeNext - 2; i >= 0; i--){
+    depths[i] = (uint16)(depths[parents[i]] + 1);
+  }
+
+  // Count the lengths and limit them to maxLength. The overflowing codes are
+  // redistributed such that the Kraft inequality holds again.
+  naZeron(lengthCounts, sizeof(lengthCounts));
+  for(uint16 i = 0; i < symCount; i++){
+    uint16 depth = depths[i];
+    lengthCounts[depth > maxLength ? maxLength : depth]++;
+  }
+  uint32 total = 0;
+  for(uint16 len = maxLength; len > 0; len--){
+    total += (uint32)lengthCounts[len] << (maxLength - len);
+  }
+  while(total != (1u << maxLength)){
+    lengthCounts[maxLength]--;
+    for(uint16 len = maxLength - 1; len > 0; len--){
+      if(lengthCounts[len]){
+        lengthCounts[len]--;
+        lengthCounts[len + 1] += 2;
+        break;
+      }
+    }
+    total--;
+  }
+
+  // Assign the lengths. The least frequent symbols get the longest codes.
+  uint16 s = 0;
+  for(uint16 len = maxLength; len > 0; len--){
+    for(uint16 c = 0; c < lengthCounts[len]; c++){
+      lengths[syms[s].symbol] = len;
+      s++;
+    }
+  }
+}
+
+
+
+// Computes the canonical codes for the given lengths, already bit-reversed
+// such that they can be written directly.
+NA_HDEF void na_ComputeDeflateCodes(uint16* codes, const uint16* lengths, uint16 count){
+  uint16 lengthCounts[NA_DEFLATE_MAX_CODE_LENGTH + 1] = {0};
+  uint16 nextCodes[NA_DEFLATE_MAX_CODE_LENGTH + 1] = {0};
+  for(uint16 i = 0; i < count; i++){lengthCounts[lengths[i]]++;}
+  lengthCounts[0] = 0;
+  uint16 code = 0;
+  for(uint16 len = 1; len <= NA_DEFLATE_MAX_CODE_LENGTH; len++){
+    code = (uint16)((code + lengthCounts[len - 1]) << 1);
+    nextCodes[len] = code;
+  }
+  for(uint16 i = 0; i < count; i++){
+    if(lengths[i]){
+      codes[i] = na_ReverseDeflateBits(nextCodes[lengths[i]], lengths[i]);
+      nextCodes[lengths[i]]++;
     }else{
-      NAHuffmanCodeTree* literalhuffman;
-      NAHuffmanCodeTree* distancehuffman;
-      if(blocktype == 0x02){
-        na_ReadDymanicHuffmanCodes(&iterz, &literalhuffman, &distancehuffman);
+      codes[i] = 0;
+    }
+  }
+}
+
+
+
+// Note that the fixed codes are defined with 288 literal/length symbols. The
+// two unused ones must be counted as well, otherwise the codes for the
+// literals 144 to 255 come out wrong.
+NA_HDEF void na_FillDeflateFixedCodeLengths(uint16* litLenLengths, uint16* distLengths){
+  uint16 i;
+  for(i = 0; i <= 143; i++){litLenLengths[i] = 8;}
+  for(i = 144; i <= 255; i++){litLenLengths[i] = 9;}
+  for(i = 256; i <= 279; i++){litLenLengths[i] = 7;}
+  for(i = 280; i < NA_DEFLATE_FIXED_LITLEN_COUNT; i++){litLenLengths[i] = 8;}
+  for(i = 0; i < NA_DEFLATE_DIST_COUNT; i++){distLengths[i] = 5;}
+}
+
+
+
+// The code lengths of the dynamic trees are themselves run-length encoded
+// using the symbols 16 (repeat previous), 17 and 18 (repeat zero).
+typedef struct NADeflateCodeLengthRun NADeflateCodeLengthRun;
+struct NADeflateCodeLengthRun{
+  uint8 symbol;
+  uint8 extra;
+};
+
+NA_HDEF size_t na_EncodeDeflateCodeLengths(NADeflateCodeLengthRun* runs, const uint16* lengths, size_t count){
+  size_t runCount = 0;
+  size_t i = 0;
+  while(i < count){
+    uint16 len = lengths[i];
+    size_t repeat = 1;
+    while(i + repeat < count && lengths[i + repeat] == len){repeat++;}
+    i += repeat;
+
+    if(len == 0){
+      while(repeat >= 11){
+        size_t r = naMins(repeat, 138);
+        runs[runCount].symbol = 18;
+        runs[runCount].extra = (uint8)(r - 11);
+        runCount++;
+        repeat -= r;
+      }
+      if(repeat >= 3){
+        runs[runCount].symbol = 17;
+        runs[runCount].extra = (uint8)(repeat - 3);
+        runCount++;
+        repeat = 0;
+      }
+    }else{
+      runs[runCount].symbol = (uint8)len;
+      runs[runCount].extra = 0;
+      runCount++;
+      repeat--;
+      while(repeat >= 3){
+        size_t r = naMins(repeat, 6);
+        runs[runCount].symbol = 16;
+        runs[runCount].extra = (uint8)(r - 3);
+        runCount++;
+        repeat -= r;
+      }
+    }
+    while(repeat){
+      runs[runCount].symbol = (uint8)len;
+      runs[runCount].extra = 0;
+      runCount++;
+      repeat--;
+    }
+  }
+  return runCount;
+}
+
+
+
+NA_HIDEF uint32 na_GetDeflateCodeLengthExtraBits(uint8 symbol){
+  switch(symbol){
+  case 16: return 2;
+  case 17: return 3;
+  case 18: return 7;
+  default: return 0;
+  }
+}
+
+
+
+// Returns the number of bits needed to store the symbols of the current
+// block with the given code lengths, excluding any block header.
+NA_HDEF size_t na_GetDeflateSymbolBitCount(NAZLIBDeflater* enc, const uint16* litLenLengths, const uint16* distLengths){
+  size_t bitCount = 0;
+  for(uint16 i = 0; i < NA_DEFLATE_LITLEN_COUNT; i++){
+    size_t extra = (i > 256) ? na_DeflateLengthExtra[i - 257] : 0;
+    bitCount += (size_t)enc->litLenFreqs[i] * (litLenLengths[i] + extra);
+  }
+  for(uint16 i = 0; i < NA_DEFLATE_DIST_COUNT; i++){
+    bitCount += (size_t)enc->distFreqs[i] * (distLengths[i] + na_DeflateDistanceExtra[i]);
+  }
+  return bitCount;
+}
+
+
+
+NA_HDEF void na_WriteDeflateSymbols(NAZLIBDeflater* enc, const uint16* litLenLengths, uint16 litLenCount, const uint16* distLengths){
+  uint16 litLenCodes[NA_DEFLATE_FIXED_LITLEN_COUNT];
+  uint16 distCodes[NA_DEFLATE_DIST_COUNT];
+  na_ComputeDeflateCodes(litLenCodes, litLenLengths, litLenCount);
+  na_ComputeDeflateCodes(distCodes, distLengths, NA_DEFLATE_DIST_COUNT);
+
+  for(size_t s = 0; s < enc->symbolCount; s++){
+    uint16 litLen = enc->litLens[s];
+    uint16 dist = enc->dists[s];
+    if(!dist){
+      na_WriteDeflateBits(enc, litLenCodes[litLen], litLenLengths[litLen]);
+    }else{
+      uint16 lengthCode = na_DeflateLengthCodes[litLen];
+      uint16 symbol = 257 + lengthCode;
+      na_WriteDeflateBits(enc, litLenCodes[symbol], litLenLengths[symbol]);
+      if(na_DeflateLengthExtra[lengthCode]){
+        na_WriteDeflateBits(enc, (uint32)(litLen - na_DeflateLengthBase[lengthCode]), na_DeflateLengthExtra[lengthCode]);
+      }
+      uint16 distCode = na_LookupDeflateDistanceCode(dist);
+      na_WriteDeflateBits(enc, distCodes[distCode], distLengths[distCode]);
+      if(na_DeflateDistanceExtra[distCode]){
+        na_WriteDeflateBits(enc, (uint32)(dist - na_DeflateDistanceBase[distCode]), na_DeflateDistanceExtra[distCode]);
+      }
+    }
+  }
+  // End of block
+  na_WriteDeflateBits(enc, litLenCodes[256], litLenLengths[256]);
+}
+
+
+
+NA_HDEF void na_WriteDeflateStoredBlocks(NAZLIBDeflater* enc, size_t blockEnd, NABool isFinal){
+  size_t pos = enc->blockStart;
+  do{
+    size_t byteCount = naMins(blockEnd - pos, NA_DEFLATE_MAX_STORED);
+    NABool isLast = isFinal && (pos + byteCount == blockEnd);
+    na_WriteDeflateBits(enc, isLast ? 1 : 0, 1);
+    na_WriteDeflateBits(enc, 0x00, 2);
+    na_PadDeflateBits(enc);
+    na_WriteDeflateBits(enc, (uint32)byteCount, 16);
+    na_WriteDeflateBits(enc, (uint32)(~byteCount & 0xffff), 16);
+    if(byteCount){
+      na_ReserveDeflateOutput(enc, byteCount);
+      naCopyn(&(enc->out[enc->outCount]), &(enc->src[pos]), byteCount);
+      enc->outCount += byteCount;
+    }
+    pos += byteCount;
+  }while(pos < blockEnd);
+}
+
+
+
+// Writes all symbols gathered so far as one block, choosing whichever of the
+// stored, fixed or dynamic huffman encoding results in the fewest bits.
+NA_HDEF void na_FlushDeflateBlock(NAZLIBDeflater* enc, size_t blockEnd, NABool isFinal){
+  uint16 fixedLitLenLengths[NA_DEFLATE_FIXED_LITLEN_COUNT];
+  uint16 fixedDistLengths[NA_DEFLATE_DIST_COUNT];
+  uint16 dynLitLenLengths[NA_DEFLATE_LITLEN_COUNT];
+  uint16 dynDistLengths[NA_DEFLATE_DIST_COUNT];
+  uint16 clFreqs[NA_DEFLATE_CODELENGTH_COUNT];
+  uint16 clLengths[NA_DEFLATE_CODELENGTH_COUNT];
+  uint16 clCodes[NA_DEFLATE_CODELENGTH_COUNT];
+  uint16 allLengths[NA_DEFLATE_LITLEN_COUNT + NA_DEFLATE_DIST_COUNT];
+  NADeflateCodeLengthRun runs[NA_DEFLATE_LITLEN_COUNT + NA_DEFLATE_DIST_COUNT];
+
+  enc->litLenFreqs[256] = 1;
+
+  // Fixed huffman codes
+  na_FillDeflateFixedCodeLengths(fixedLitLenLengths, fixedDistLengths);
+  size_t fixedBits = 3 + na_GetDeflateSymbolBitCount(enc, fixedLitLenLengths, fixedDistLengths);
+
+  // Dynamic huffman codes
+  na_ComputeDeflateCodeLengths(dynLitLenLengths, enc->litLenFreqs, NA_DEFLATE_LITLEN_COUNT, NA_DEFLATE_MAX_CODE_LENGTH);
+  na_ComputeDeflateCodeLengths(dynDistLengths, enc->distFreqs, NA_DEFLATE_DIST_COUNT, NA_DEFLATE_MAX_CODE_LENGTH);
+  size_t hlit = NA_DEFLATE_LITLEN_COUNT;
+  while(hlit > 257 && !dynLitLenLengths[hlit - 1]){hlit--;}
+  size_t hdist = NA_DEFLATE_DIST_COUNT;
+  while(hdist > 1 && !dynDistLengths[hdist - 1]){hdist--;}
+
+  naCopyn(allLengths, dynLitLenLengths, hlit * sizeof(uint16));
+  naCopyn(&(allLengths[hlit]), dynDistLengths, hdist * sizeof(uint16));
+  size_t runCount = na_EncodeDeflateCodeLengths(runs, allLengths, hlit + hdist);
+
+  naZeron(clFreqs, sizeof(clFreqs));
+  for(size_t r = 0; r < runCount; r++){clFreqs[runs[r].symbol]++;}
+  na_ComputeDeflateCodeLengths(clLengths, clFreqs, NA_DEFLATE_CODELENGTH_COUNT, NA_DEFLATE_MAX_CL_LENGTH);
+  size_t hclen = NA_DEFLATE_CODELENGTH_COUNT;
+  while(hclen > 4 && !clLengths[na_DeflateCodeLengthOrder[hclen - 1]]){hclen--;}
+
+  size_t dynamicBits = 3 + 5 + 5 + 4 + 3 * hclen;
+  for(size_t r = 0; r < runCount; r++){
+    dynamicBits += clLengths[runs[r].symbol] + na_GetDeflateCodeLengthExtraBits(runs[r].symbol);
+  }
+  dynamicBits += na_GetDeflateSymbolBitCount(enc, dynLitLenLengths, dynDistLengths);
+
+  // Stored blocks: Header, padding, length and the raw bytes.
+  size_t rawSize = blockEnd - enc->blockStart;
+  size_t storedBlockCount = (rawSize + NA_DEFLATE_MAX_STORED - 1) / NA_DEFLATE_MAX_STORED;
+  if(!storedBlockCount){storedBlockCount = 1;}
+  size_t storedBits = storedBlockCount * (3 + 7 + 32) + rawSize * 8;
+
+  if(storedBits <= fixedBits && storedBits <= dynamicBits){
+    na_WriteDeflateStoredBlocks(enc, blockEnd, isFinal);
+  }else if(fixedBits <= dynamicBits){
+    na_WriteDeflateBits(enc, isFinal ? 1 : 0, 1);
+    na_WriteDeflateBits(enc, 0x01, 2);
+    na_WriteDeflateSymbols(enc, fixedLitLenLengths, NA_DEFLATE_FIXED_LITLEN_COUNT, fixedDistLengths);
+  }else{
+    na_WriteDeflateBits(enc, isFinal ? 1 : 0, 1);
+    na_WriteDeflateBits(enc, 0x02, 2);
+    na_WriteDeflateBits(enc, (uint32)(hlit - 257), 5);
+    na_WriteDeflateBits(enc, (uint32)(hdist - 1), 5);
+    na_WriteDeflateBits(enc, (uint32)(hclen - 4), 4);
+    for(size_t c = 0; c < hclen; c++){
+      na_WriteDeflateBits(enc, clLengths[na_DeflateCodeLengthOrder[c]], 3);
+    }
+    na_ComputeDeflateCodes(clCodes, clLengths, NA_DEFLATE_CODELENGTH_COUNT);
+    for(size_t r = 0; r < runCount; r++){
+      uint8 symbol = runs[r].symbol;
+      na_WriteDeflateBits(enc, clCodes[symbol], clLengths[symbol]);
+      uint32 extraBits = na_GetDeflateCodeLengthExtraBits(symbol);
+      if(extraBits){na_WriteDeflateBits(enc, runs[r].extra, extraBits);}
+    }
+    na_WriteDeflateSymbols(enc, dynLitLenLengths, NA_DEFLATE_LITLEN_COUNT, dynDistLengths);
+  }
+
+  enc->symbolCount = 0;
+  enc->blockStart = blockEnd;
+  naZeron(enc->litLenFreqs, sizeof(enc->litLenFreqs));
+  naZeron(enc->distFreqs, sizeof(enc->distFreqs));
+}
+
+
+
+NA_HIDEF void na_AddDeflateLiteral(NAZLIBDeflater* enc, NAByte literal){
+  enc->litLens[enc->symbolCount] = literal;
+  enc->dists[enc->symbolCount] = 0;
+  enc->symbolCount++;
+  enc->litLenFreqs[literal]++;
+}
+
+
+
+NA_HIDEF void na_AddDeflateMatch(NAZLIBDeflater* enc, size_t length, size_t distance){
+  enc->litLens[enc->symbolCount] = (uint16)length;
+  enc->dists[enc->symbolCount] = (uint16)distance;
+  enc->symbolCount++;
+  enc->litLenFreqs[257 + na_DeflateLengthCodes[length]]++;
+  enc->distFreqs[na_LookupDeflateDistanceCode(distance)]++;
+}
+
+
+
+NA_HIDEF size_t na_GetDeflateHash(const NAByte* ptr){
+  uint32 value = ((uint32)ptr[0] << 16) | ((uint32)ptr[1] << 8) | (uint32)ptr[2];
+  return (size_t)((value * 2654435761u) >> (32 - NA_DEFLATE_HASH_BITS));
+}
+
+
+
+// Inserts the given position into the hash chains. Positions too close to
+// the end of the source can not be hashed and are ignored.
+NA_HIDEF void na_InsertDeflateHash(NAZLIBDeflater* enc, size_t pos){
+  if(pos + NA_DEFLATE_MIN_MATCH <= enc->srcSize){
+    size_t hash = na_GetDeflateHash(&(enc->src[pos]));
+    enc->prev[pos & NA_DEFLATE_WINDOW_MASK] = enc->head[hash];
+    enc->head[hash] = (NAInt)pos;
+  }
+}
+
+
+
+// Searches the hash chain for the longest match at the given position which
+// is longer than minLength. Returns the length found or 0.
+NA_HDEF size_t na_FindDeflateMatch(NAZLIBDeflater* enc, size_t pos, size_t minLength, size_t* distance){
+  size_t bestLength = 0;
+  if(pos + NA_DEFLATE_MIN_MATCH > enc->srcSize){return 0;}
+
+  size_t maxLength = naMins(NA_DEFLATE_MAX_MATCH, enc->srcSize - pos);
+  size_t chain = enc->settings.maxChain;
+  const NAByte* cur = &(enc->src[pos]);
+  NAInt candidate = enc->head[na_GetDeflateHash(cur)];
+  if(minLength < NA_DEFLATE_MIN_MATCH - 1){minLength = NA_DEFLATE_MIN_MATCH - 1;}
+  // Near the end of the source, no longer match is possible and the quick
+  // reject below would read beyond the source.
+  if(minLength >= maxLength){return 0;}
+
+  while(candidate >= 0 && chain){
+    size_t dist = pos - (size_t)candidate;
+    if(dist > NA_DEFLATE_WINDOW_SIZE){break;}
+    const NAByte* cand = &(enc->src[candidate]);
+
+    // Quick reject by testing the byte which would make the match longer.
+    if(cand[minLength] == cur[minLength] && cand[0] == cur[0] && cand[1] == cur[1]){
+      size_t length = 2;
+      while(length < maxLength && cand[length] == cur[length]){length++;}
+      if(length > minLength && !(length == NA_DEFLATE_MIN_MATCH && dist > NA_DEFLATE_TOO_FAR)){
+        bestLength = length;
+        minLength = length;
+        *distance = dist;
+        if(length >= enc->settings.niceLength || length == maxLength){break;}
+      }
+    }
+
+    NAInt next = enc->prev[(size_t)candidate & NA_DEFLATE_WINDOW_MASK];
+    if(next >= candidate){break;}
+    candidate = next;
+    chain--;
+  }
+  return bestLength;
+}
+
+
+
+// Moves the input to the front of the buffer, keeping the window before the
+// current position. Hash chain entries pointing before the kept part are
+// dropped.
+NA_HDEF void na_SlideDeflateWindow(NAZLIBDeflater* enc){
+  size_t shift = ((enc->pos - NA_DEFLATE_WINDOW_SIZE) / NA_DEFLATE_WINDOW_SIZE) * NA_DEFLATE_WINDOW_SIZE;
+  if(!shift){return;}
+
+  // A stored block needs the raw bytes, hence the block must not start
+  // within the part being dropped.
+  if(enc->blockStart < shift){
+    na_FlushDeflateBlock(enc, enc->prevAvailable ? enc->pos - 1 : enc->pos, NA_FALSE);
+  }
+
+  memmove(enc->src, &(enc->src[shift]), enc->srcSize - shift);
+  enc->srcSize -= shift;
+  enc->pos -= shift;
+  enc->blockStart -= shift;
+  for(size_t i = 0; i < NA_DEFLATE_HASH_SIZE; i++){
+    enc->head[i] = (enc->head[i] >= (NAInt)shift) ? enc->head[i] - (NAInt)shift : -1;
+  }
+  for(size_t i = 0; i < NA_DEFLATE_WINDOW_SIZE; i++){
+    enc->prev[i] = (enc->prev[i] >= (NAInt)shift) ? enc->prev[i] - (NAInt)shift : -1;
+  }
+}
+
+
+
+// Encodes the available input. Unless finishing, enough bytes are kept
+// back such that the longest possible match can be found.
+NA_HDEF void na_DeflateCompress(NAZLIBDeflater* enc){
+  size_t pos = enc->pos;
+  size_t prevLength = enc->prevLength;
+  size_t prevDistance = enc->prevDistance;
+  NABool prevAvailable = enc->prevAvailable;
+  size_t end = enc->finishing
+    ? enc->srcSize
+    : (enc->srcSize > NA_DEFLATE_LOOKAHEAD ? enc->srcSize - NA_DEFLATE_LOOKAHEAD : 0);
+
+  while(pos < end){
+    if(enc->symbolCount >= NA_DEFLATE_BLOCK_SYMBOLS - 1){
+      // When lazy matching, the byte at pos - 1 is still pending.
+      na_FlushDeflateBlock(enc, prevAvailable ? pos - 1 : pos, NA_FALSE);
+    }
+
+    size_t distance = 0;
+    size_t length = 0;
+
+    if(!enc->settings.lazy){
+      length = na_FindDeflateMatch(enc, pos, 0, &distance);
+      if(length >= NA_DEFLATE_MIN_MATCH){
+        na_AddDeflateMatch(enc, length, distance);
+        for(size_t i = 0; i < length; i++){na_InsertDeflateHash(enc, pos + i);}
+        pos += length;
       }else{
-        na_AllocFixedHuffmanCodes(&literalhuffman, &distancehuffman);
+        na_AddDeflateLiteral(enc, enc->src[pos]);
+        na_InsertDeflateHash(enc, pos);
+        pos++;
       }
-      // Now, we have the literal and distance codes. Start reading until we
-      // find the value 256.
-      while(1){
-
-        uint16 curcode;
-        uint16 length;
-        uint16 dist;
-        curcode = naDecodeHuffman(literalhuffman, &iterz);
-        if(curcode < 256){
-          naWriteBufferu8(&iterout, (uint8)curcode);
-        }else if(curcode == 256){
-          break;
-        }else{
-          uint16 distcode;
-          length = naDecodeLiteralLength(&iterz, curcode);
-          distcode = naDecodeHuffman(distancehuffman, &iterz);
-          dist = naDecodeDistance(&iterz, distcode);
-          naRepeatBufferBytes(&iterout, dist, length, NA_FALSE);
+
+    }else{
+      if(prevLength < enc->settings.lazyLength){
+        length = na_FindDeflateMatch(enc, pos, prevLength, &distance);
+      }
+
+      if(prevAvailable && prevLength >= NA_DEFLATE_MIN_MATCH && length <= prevLength){
+        // The match of the previous position is at least as good.
+        na_AddDeflateMatch(enc, prevLength, prevDistance);
+        size_t matchEnd = pos - 1 + prevLength;
+        for(size_t i = pos; i < matchEnd; i++){na_InsertDeflateHash(enc, i);}
+        pos = matchEnd;
+        prevAvailable = NA_FALSE;
+        prevLength = 0;
+      }else{
+        if(prevAvailable){
+          na_AddDeflateLiteral(enc, enc->src[pos - 1]);
         }
+        na_InsertDeflateHash(enc, pos);
+        prevAvailable = NA_TRUE;
+        prevLength = length;
+        prevDistance = distance;
+        pos++;
       }
+    }
+  }
 
-      naDeallocHuffmanCodeTree(literalhuffman);
-      naDeallocHuffmanCodeTree(distancehuffman);
+  enc->pos = pos;
+  enc->prevLength = prevLength;
+  enc->prevDistance = prevDistance;
+  enc->prevAvailable = prevAvailable;
+
+  if(enc->finishing){
+    if(prevAvailable){
+      na_AddDeflateLiteral(enc, enc->src[pos - 1]);
+      enc->prevAvailable = NA_FALSE;
     }
-    if(isblockfinal){break;}
+    na_FlushDeflateBlock(enc, enc->srcSize, NA_TRUE);
+    na_PadDeflateBits(enc);
   }
+}
 
-  naClearBufferIterator(&iterout);
-  naClearBufferIterator(&iterz);
-  naRelease(zbuffer);
 
-  naFixBufferRange(output);
-  naInitChecksum(&checksum, NA_CHECKSUM_TYPE_ADLER_32);
-  naAccumulateChecksumBuffer(&checksum, output);
-  adler = naGetChecksumResult(&checksum);
-  naClearChecksum(&checksum);
+
+NA_DEF NAZLIBDeflater* naNewZLIBDeflater(NADeflateCompressionLevel level){
+  uint8 cmf;
+  uint8 flg;
+  NAZLIBDeflater* enc;
 
   #if NA_DEBUG
-    if(adler != zbufferadler)
-      naError("Adler code does not correspond to decompression result");
-  #else
-    NA_UNUSED(zbufferadler);
-    NA_UNUSED(adler);
+    if(level < NA_DEFLATE_COMPRESSION_FASTEST || level > NA_DEFLATE_COMPRESSION_MAX)
+      naError("Invalid compression level");
   #endif
+
+  na_InitDeflateCodeTables();
+
+  enc = naNew(NAZLIBDeflater);
+  enc->settings = na_DeflateLevelSettings[level];
+  enc->finishing = NA_FALSE;
+
+  enc->src = naMalloc(NA_DEFLATE_BUFFER_SIZE);
+  enc->srcSize = 0;
+  enc->pos = 0;
+  naInitChecksum(&(enc->checksum), NA_CHECKSUM_TYPE_ADLER_32);
+  enc->prevLength = 0;
+  enc->prevDistance = 0;
+  enc->prevAvailable = NA_FALSE;
+
+  enc->head = naMalloc(NA_DEFLATE_HASH_SIZE * sizeof(NAInt));
+  enc->prev = naMalloc(NA_DEFLATE_WINDOW_SIZE * sizeof(NAInt));
+  for(size_t i = 0; i < NA_DEFLATE_HASH_SIZE; i++){enc->head[i] = -1;}
+  for(size_t i = 0; i < NA_DEFLATE_WINDOW_SIZE; i++){enc->prev[i] = -1;}
+  enc->litLens = naMalloc(NA_DEFLATE_BLOCK_SYMBOLS * sizeof(uint16));
+  enc->dists = naMalloc(NA_DEFLATE_BLOCK_SYMBOLS * sizeof(uint16));
+  enc->symbolCount = 0;
+  enc->blockStart = 0;
+  naZeron(enc->litLenFreqs, sizeof(enc->litLenFreqs));
+  naZeron(enc->distFreqs, sizeof(enc->distFreqs));
+
+  enc->bitBuf = 0;
+  enc->bitCount = 0;
+  enc->out = naMalloc(NA_DEFLATE_OUT_BUFFER_SIZE);
+  enc->outCount = 0;
+  enc->outCapacity = NA_DEFLATE_OUT_BUFFER_SIZE;
+  enc->drainPos = 0;
+
+  // First, RFC 1950 applies.
+  cmf = (NA_ZLIB_CMF_MAX_WINDOW_SIZE<<4 | NA_ZLIB_CMF_COMPRESSION_DEFLATE);
+  flg = (uint8)((level << 6 | NA_ZLIB_PRESET_DICT_AVAILABLE << 5));
+  flg |= 31 - ((cmf * 256 + flg) % 31); // Check-bits
+  na_WriteDeflateByte(enc, cmf);
+  na_WriteDeflateByte(enc, flg);
+
+  return enc;
 }
 
 
 
-#define NA_ZLIB_PRESET_DICT_AVAILABLE 0
+NA_HDEF void na_DestructZLIBDeflater(NAZLIBDeflater* enc){
+  naFree(enc->src);
+  naClearChecksum(&(enc->checksum));
+  naFree(enc->head);
+  naFree(enc->prev);
+  naFree(enc->litLens);
+  naFree(enc->dists);
+  naFree(enc->out);
+}
 
-NA_DEF void naFillBufferWithZLIBCompression(NABuffer* output, NABuffer* input, NADeflateCompressionLevel level){
 
-  uint8 cmf;
-  uint8 flg;
-  NAInt byteSize;
-  NAChecksum checksum;
+
+NA_DEF void naFeedZLIBDeflater(NAZLIBDeflater* enc, const NAByte* data, size_t byteSize){
+  #if NA_DEBUG
+    if(enc->finishing)
+      naError("Deflater has already been finished");
+  #endif
+  if(!byteSize){return;}
+
+  naAccumulateChecksum(&(enc->checksum), data, byteSize);
+  while(byteSize){
+    if(enc->srcSize == NA_DEFLATE_BUFFER_SIZE){
+      na_SlideDeflateWindow(enc);
+    }
+    size_t count = naMins(byteSize, NA_DEFLATE_BUFFER_SIZE - enc->srcSize);
+    naCopyn(&(enc->src[enc->srcSize]), data, count);
+    enc->srcSize += count;
+    data += count;
+    byteSize -= count;
+    na_DeflateCompress(enc);
+  }
+}
+
+
+
+NA_DEF void naFinishZLIBDeflater(NAZLIBDeflater* enc){
   uint32 adler;
-  NAInt curOffset;
+  #if NA_DEBUG
+    if(enc->finishing)
+      naError("Deflater has already been finished");
+  #endif
+  enc->finishing = NA_TRUE;
+  na_DeflateCompress(enc);
+
+  // We write the adler number. Note that this must be in network byte order
+  // again as it belongs to RFC 1950!
+  adler = naGetChecksumResult(&(enc->checksum));
+  na_WriteDeflateByte(enc, (NAByte)(adler >> 24));
+  na_WriteDeflateByte(enc, (NAByte)(adler >> 16));
+  na_WriteDeflateByte(enc, (NAByte)(adler >> 8));
+  na_WriteDeflateByte(enc, (NAByte)adler);
+}
+
+
+
+NA_DEF size_t naDrainZLIBDeflater(NAZLIBDeflater* enc, NAByte* data, size_t byteSize){
+  size_t count = naMins(enc->outCount - enc->drainPos, byteSize);
+  if(count){
+    naCopyn(data, &(enc->out[enc->drainPos]), count);
+    enc->drainPos += count;
+  }
+  if(enc->drainPos == enc->outCount){
+    enc->drainPos = 0;
+    enc->outCount = 0;
+  }
+  return count;
+}
+
+
+
+NA_DEF void naFillBufferWithZLIBCompression(NABuffer* output, NABuffer* input, NADeflateCompressionLevel level){
+  NABufferIterator iterin;
   NABufferIterator iterout;
+  NAByte* chunk;
+  NAInt remaining;
+  size_t count;
 
   #if NA_DEBUG
     if(naGetBufferEndianness(output) != NA_ENDIANNESS_NETWORK)
@@ -555,52 +1735,30 @@ NA_DEF void naFillBufferWithZLIBCompression(NABuffer* output, NABuffer* input, N
       naError("Input buffer should be big endianed");
   #endif
 
+  NAZLIBDeflater* deflater = naNewZLIBDeflater(level);
+  chunk = naMalloc(NA_DEFLATE_BUFFER_SIZE);
+  iterin = naMakeBufferAccessor(input);
   iterout = naMakeBufferModifier(output);
 
-  cmf = (NA_ZLIB_CMF_MAX_WINDOW_SIZE<<4 | NA_ZLIB_CMF_COMPRESSION_DEFLATE);
-  flg = (uint8)((level << 6 | NA_ZLIB_PRESET_DICT_AVAILABLE << 5));
-  flg |= 31 - ((cmf * 256 + flg) % 31); // Check-bits
-  naWriteBufferu8(&iterout, cmf);
-  naWriteBufferu8(&iterout, flg);
-
-  // Now, for the actual content, we change to little endian due to RFC 1951!
-  naSetBufferEndianness(output, NA_ENDIANNESS_LITTLE);
-  // todo: this should be in a separate buffer.
-
-  byteSize = naGetBufferRange(input).length;
-//  naLocateBufferAbsolute(input, 0);
-
-  curOffset = 0;
-  while(byteSize > 0){
-    uint16 curByteSize;
-    NAByte headbyte = (0 << 1);
-    if(byteSize >= (1 << 15)){
-      curByteSize = (1 << 15) - 1;
-    }else{
-      curByteSize = (uint16)byteSize;
-      headbyte |= 1;
+  remaining = naGetBufferRange(input).length;
+  while(remaining > 0){
+    count = naMins((size_t)remaining, NA_DEFLATE_BUFFER_SIZE);
+    naReadBufferBytes(&iterin, chunk, count);
+    naFeedZLIBDeflater(deflater, chunk, count);
+    remaining -= (NAInt)count;
+    while((count = naDrainZLIBDeflater(deflater, chunk, NA_DEFLATE_BUFFER_SIZE))){
+      naWriteBufferBytes(&iterout, chunk, count);
     }
-    naWriteBufferu8(&iterout, headbyte);
-    naWriteBufferu16(&iterout, curByteSize);
-    naWriteBufferu16(&iterout, ~curByteSize);
-    naWriteBufferBuffer(&iterout, input, naMakeRangei(curOffset, curByteSize));
-    byteSize -= curByteSize;
-    curOffset += curByteSize;
+  }
+  naFinishZLIBDeflater(deflater);
+  while((count = naDrainZLIBDeflater(deflater, chunk, NA_DEFLATE_BUFFER_SIZE))){
+    naWriteBufferBytes(&iterout, chunk, count);
   }
 
-  // We write the adler number. Note that this must be in network byte order
-  // again as it belongs to RFC 1950!
-  // todo: this should be in a separate buffer.
-  naSetBufferEndianness(output, NA_ENDIANNESS_NETWORK);
-  naInitChecksum(&checksum, NA_CHECKSUM_TYPE_ADLER_32);
-//  naLocateBufferAbsolute(input, 0);
-  naAccumulateChecksumBuffer(&checksum, input);
-  adler = naGetChecksumResult(&checksum);
-  naClearChecksum(&checksum);
-  naWriteBufferu32(&iterout, adler);
-
+  naClearBufferIterator(&iterin);
   naClearBufferIterator(&iterout);
-
+  naFree(chunk);
+  naDelete(deflater);
 }
 
 
@@ -4,6 +4,14 @@
 #include "../NADeflate.h"
 #include "../NAFile.h"
 #include "../NABabyImage.h"
+#include "../NAThreading.h"
+
+#if NA_SIMD_SSE2
+  #include <emmintrin.h>
+#endif
+#if NA_SIMD_AVX2
+  #include <immintrin.h>
+#endif
 
 // Reference: http://www.w3.org/TR/PNG
 
@@ -248,10 +256,265 @@ NA_DEF NAByte naGetPaethPredictor(NAByte a, NAByte b, NAByte c){
 
 
 
+// Returns the byte predicted by the given filter type from the left byte a,
+// the upper byte b and the upper left byte c.
+NA_HIDEF NAByte na_GetPNGFilterPredictor(NAByte filterType, NAByte a, NAByte b, NAByte c){
+  NAByte retValue;
+  switch(filterType){
+  case NA_PNG_FILTER_TYPE_SUB:     retValue = a; break;
+  case NA_PNG_FILTER_TYPE_UP:      retValue = b; break;
+  case NA_PNG_FILTER_TYPE_AVERAGE: retValue = (NAByte)(((size_t)a + (size_t)b) / 2); break;
+  case NA_PNG_FILTER_TYPE_PAETH:   retValue = naGetPaethPredictor(a, b, c); break;
+  default:                         retValue = 0; break;
+  }
+  return retValue;
+}
+
+
+
+#if NA_SIMD_SSE2
+
+// Loads one pixel of 3 or 4 bytes into the lowest bytes of a vector without
+// touching any memory beyond the pixel. Pixels within a line are not aligned,
+// hence the bytes are copied instead of read as an uint32.
+NA_HIDEF __m128i na_LoadPNGPixel(const NAByte* pixel, size_t bpp){
+  uint32 value = 0;
+  naCopyn(&value, pixel, bpp);
+  return _mm_cvtsi32_si128((int)value);
+}
+
+NA_HIDEF void na_StorePNGPixel(NAByte* pixel, __m128i vec, size_t bpp){
+  uint32 value = (uint32)_mm_cvtsi128_si32(vec);
+  naCopyn(pixel, &value, bpp);
+}
+
+// Rounding down average of unsigned bytes. _mm_avg_epu8 rounds up.
+NA_HIDEF __m128i na_GetAveragePredictorSSE2(__m128i a, __m128i b){
+  __m128i roundUp = _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1));
+  return _mm_sub_epi8(_mm_avg_epu8(a, b), roundUp);
+}
+
+// Paeth predictor of 8 values stored as 16 bit integers.
+NA_HIDEF __m128i na_GetPaethPredictorSSE2(__m128i a, __m128i b, __m128i c){
+  __m128i zero = _mm_setzero_si128();
+  __m128i pa = _mm_sub_epi16(b, c);
+  __m128i pb = _mm_sub_epi16(a, c);
+  __m128i pc = _mm_add_epi16(pa, pb);
+  pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+  pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+  pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+  __m128i smallest = _mm_min_epi16(pa, _mm_min_epi16(pb, pc));
+  // Ties are broken in favour of a, then b, then c.
+  __m128i useA = _mm_cmpeq_epi16(smallest, pa);
+  __m128i useB = _mm_cmpeq_epi16(smallest, pb);
+  __m128i bOrC = _mm_or_si128(_mm_and_si128(useB, b), _mm_andnot_si128(useB, c));
+  return _mm_or_si128(_mm_and_si128(useA, a), _mm_andnot_si128(useA, bOrC));
+}
+
+// Predictor of 16 bytes at once. All neighbours must be known which is the
+// case when filtering but not when unfiltering.
+NA_HIDEF __m128i na_GetPNGFilterPredictorSSE2(NAByte filterType, __m128i a, __m128i b, __m128i c){
+  __m128i zero = _mm_setzero_si128();
+  __m128i retValue;
+  switch(filterType){
+  case NA_PNG_FILTER_TYPE_SUB:     retValue = a; break;
+  case NA_PNG_FILTER_TYPE_UP:      retValue = b; break;
+  case NA_PNG_FILTER_TYPE_AVERAGE: retValue = na_GetAveragePredictorSSE2(a, b); break;
+  case NA_PNG_FILTER_TYPE_PAETH:
+    retValue = _mm_packus_epi16(
+      na_GetPaethPredictorSSE2(
+        _mm_unpacklo_epi8(a, zero),
+        _mm_unpacklo_epi8(b, zero),
+        _mm_unpacklo_epi8(c, zero)),
+      na_GetPaethPredictorSSE2(
+        _mm_unpackhi_epi8(a, zero),
+        _mm_unpackhi_epi8(b, zero),
+        _mm_unpackhi_epi8(c, zero)));
+    break;
+  default:                         retValue = zero; break;
+  }
+  return retValue;
+}
+
+#endif // NA_SIMD_SSE2
+
+
+
+NA_HIDEF void na_UnfilterPNGLineSub(NAByte* line, size_t bytesPerLine, size_t bpp){
+  #if NA_SIMD_SSE2
+    // The bytes of one pixel are independent of each other, only the pixels
+    // depend on their left neighbour.
+    if(bpp == 3 || bpp == 4){
+      __m128i a = _mm_setzero_si128();
+      for(size_t x = 0; x < bytesPerLine; x += bpp){
+        a = _mm_add_epi8(a, na_LoadPNGPixel(&line[x], bpp));
+        na_StorePNGPixel(&line[x], a, bpp);
+      }
+      return;
+    }
+  #endif
+  // The first bpp bytes add value 0 from the virtual left byte.
+  for(size_t x = bpp; x < bytesPerLine; x++){
+    line[x] += line[x - bpp];
+  }
+}
+
+NA_HIDEF void na_UnfilterPNGLineUp(NAByte* line, const NAByte* upLine, size_t bytesPerLine){
+  size_t x = 0;
+  #if NA_SIMD_AVX2
+    for(; x + 32 <= bytesPerLine; x += 32){
+      __m256i cur = _mm256_loadu_si256((const __m256i*)&line[x]);
+      __m256i up = _mm256_loadu_si256((const __m256i*)&upLine[x]);
+      _mm256_storeu_si256((__m256i*)&line[x], _mm256_add_epi8(cur, up));
+    }
+  #endif
+  #if NA_SIMD_SSE2
+    for(; x + 16 <= bytesPerLine; x += 16){
+      __m128i cur = _mm_loadu_si128((const __m128i*)&line[x]);
+      __m128i up = _mm_loadu_si128((const __m128i*)&upLine[x]);
+      _mm_storeu_si128((__m128i*)&line[x], _mm_add_epi8(cur, up));
+    }
+  #endif
+  for(; x < bytesPerLine; x++){
+    line[x] += upLine[x];
+  }
+}
+
+NA_HIDEF void na_UnfilterPNGLineAverage(NAByte* line, const NAByte* upLine, size_t bytesPerLine, size_t bpp){
+  #if NA_SIMD_SSE2
+    if(bpp == 3 || bpp == 4){
+      __m128i a = _mm_setzero_si128();
+      for(size_t x = 0; x < bytesPerLine; x += bpp){
+        __m128i b = na_LoadPNGPixel(&upLine[x], bpp);
+        a = _mm_add_epi8(na_LoadPNGPixel(&line[x], bpp), na_GetAveragePredictorSSE2(a, b));
+        na_StorePNGPixel(&line[x], a, bpp);
+      }
+      return;
+    }
+  #endif
+  for(size_t x = 0; x < bpp; x++){
+    line[x] += (NAByte)(((size_t)upLine[x]) / 2);
+  }
+  for(size_t x = bpp; x < bytesPerLine; x++){
+    line[x] += (NAByte)(((size_t)line[x - bpp] + (size_t)upLine[x]) / 2);
+  }
+}
+
+NA_HIDEF void na_UnfilterPNGLinePaeth(NAByte* line, const NAByte* upLine, size_t bytesPerLine, size_t bpp){
+  #if NA_SIMD_SSE2
+    if(bpp == 3 || bpp == 4){
+      // The predictor is computed with 16 bits per byte.
+      __m128i zero = _mm_setzero_si128();
+      __m128i a = zero;
+      __m128i c = zero;
+      for(size_t x = 0; x < bytesPerLine; x += bpp){
+        __m128i b = _mm_unpacklo_epi8(na_LoadPNGPixel(&upLine[x], bpp), zero);
+        __m128i predictor = na_GetPaethPredictorSSE2(a, b, c);
+        __m128i cur = _mm_add_epi8(na_LoadPNGPixel(&line[x], bpp), _mm_packus_epi16(predictor, predictor));
+        na_StorePNGPixel(&line[x], cur, bpp);
+        a = _mm_unpacklo_epi8(cur, zero);
+        c = b;
+      }
+      return;
+    }
+  #endif
+  for(size_t x = 0; x < bpp; x++){
+    line[x] += naGetPaethPredictor(0, upLine[x], 0);
+  }
+  for(size_t x = bpp; x < bytesPerLine; x++){
+    line[x] += naGetPaethPredictor(line[x - bpp], upLine[x], upLine[x - bpp]);
+  }
+}
+
+
+
+// Reverts the filter of one line in place. upLine is the already unfiltered
+// previous line or all zero for the first line.
+NA_HDEF void na_UnfilterPNGLine(NAByte* line, const NAByte* upLine, NAByte filterType, size_t bytesPerLine, size_t bpp){
+  switch(filterType){
+  case NA_PNG_FILTER_TYPE_NONE:
+    // nothing to do.
+    break;
+  case NA_PNG_FILTER_TYPE_SUB:
+    na_UnfilterPNGLineSub(line, bytesPerLine, bpp);
+    break;
+  case NA_PNG_FILTER_TYPE_UP:
+    na_UnfilterPNGLineUp(line, upLine, bytesPerLine);
+    break;
+  case NA_PNG_FILTER_TYPE_AVERAGE:
+    na_UnfilterPNGLineAverage(line, upLine, bytesPerLine, bpp);
+    break;
+  case NA_PNG_FILTER_TYPE_PAETH:
+    na_UnfilterPNGLinePaeth(line, upLine, bytesPerLine, bpp);
+    break;
+  default:
+    #if NA_DEBUG
+      naError("Invalid Filter");
+    #endif
+    break;
+  }
+}
+
+
+
+// Applies the filter to one line and stores the result in out. upLine is the
+// previous line or all zero for the first line. Other than unfiltering, all
+// bytes are independent of each other.
+NA_HDEF void na_FilterPNGLine(NAByte* out, const NAByte* line, const NAByte* upLine, NAByte filterType, size_t bytesPerLine, size_t bpp){
+  size_t x = 0;
+  // The first pixel has no left neighbours.
+  for(; x < bpp && x < bytesPerLine; x++){
+    out[x] = line[x] - na_GetPNGFilterPredictor(filterType, 0, upLine[x], 0);
+  }
+  #if NA_SIMD_SSE2
+    for(; x + 16 <= bytesPerLine; x += 16){
+      __m128i cur = _mm_loadu_si128((const __m128i*)&line[x]);
+      __m128i a = _mm_loadu_si128((const __m128i*)&line[x - bpp]);
+      __m128i b = _mm_loadu_si128((const __m128i*)&upLine[x]);
+      __m128i c = _mm_loadu_si128((const __m128i*)&upLine[x - bpp]);
+      __m128i predictor = na_GetPNGFilterPredictorSSE2(filterType, a, b, c);
+      _mm_storeu_si128((__m128i*)&out[x], _mm_sub_epi8(cur, predictor));
+    }
+  #endif
+  for(; x < bytesPerLine; x++){
+    out[x] = line[x] - na_GetPNGFilterPredictor(filterType, line[x - bpp], upLine[x], upLine[x - bpp]);
+  }
+}
+
+
+
+// Sums up the absolute values of the filtered bytes interpreted as signed
+// values. The filter with the smallest sum usually compresses best.
+NA_HDEF size_t na_GetPNGFilterCost(const NAByte* filtered, size_t bytesPerLine){
+  size_t cost = 0;
+  size_t x = 0;
+  #if NA_SIMD_SSE2
+    __m128i zero = _mm_setzero_si128();
+    while(x + 16 <= bytesPerLine){
+      // The 32 bit accumulators can hold at least 2^16 blocks of 16 bytes.
+      size_t blockEnd = naMins(bytesPerLine, x + 16 * 0x10000);
+      __m128i sum = zero;
+      for(; x + 16 <= blockEnd; x += 16){
+        __m128i value = _mm_loadu_si128((const __m128i*)&filtered[x]);
+        __m128i absValue = _mm_min_epu8(value, _mm_sub_epi8(zero, value));
+        sum = _mm_add_epi32(sum, _mm_sad_epu8(absValue, zero));
+      }
+      sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+      cost += (size_t)(uint32)_mm_cvtsi128_si32(sum);
+    }
+  #endif
+  for(; x < bytesPerLine; x++){
+    cost += filtered[x] < 128 ? filtered[x] : 256 - (size_t)filtered[x];
+  }
+  return cost;
+}
+
+
+
 NA_DEF void naReconstructFilterData(NAPNG* png){
   NAByte* curByte;
   NAByte* upBuffer;
-  NAByte* upBufPtr;
+  const NAByte* upBufPtr;
   NABufferIterator iterFilter;
 
   size_t bpp = naGetPNGBytesPerPixel(png->colorType);
@@ -267,70 +530,13 @@ NA_DEF void naReconstructFilterData(NAPNG* png){
   iterFilter = naMakeBufferMutator(png->filteredData);
 
   for(size_t y = 0; y < (size_t)png->size.height; y++){
-
     NAByte filtertype = naReadBufferu8(&iterFilter);
     naReadBufferu8v(&iterFilter, curByte, bytesPerLine);
-
-    switch(filtertype){
-    case NA_PNG_FILTER_TYPE_NONE:
-      // nothing to do.
-      curByte += bytesPerLine;
-      break;
-    case NA_PNG_FILTER_TYPE_SUB:
-      for(size_t x = 0; x < bpp; x++){
-        curByte++;  // The first byte adds value 0 from the virtual left byte.
-      }
-      for(size_t x = bpp; x < ((size_t)png->size.width * bpp); x++){
-        *curByte += *(curByte - bpp);
-        curByte++;
-      }
-      break;
-    case NA_PNG_FILTER_TYPE_UP:
-      for(size_t x = 0; x < ((size_t)png->size.width * bpp); x++){
-        *curByte += *upBufPtr;
-        curByte++;
-        upBufPtr++;
-      }
-      break;
-    case NA_PNG_FILTER_TYPE_AVERAGE:
-      for(size_t x = 0; x < bpp; x++){
-        *curByte += (NAByte)(((size_t)*upBufPtr) / 2);
-        curByte++;
-        upBufPtr++;
-      }
-      for(size_t x = bpp; x < ((size_t)png->size.width * bpp); x++){
-        *curByte += (NAByte)(((size_t)*(curByte - bpp) + (size_t)*upBufPtr) / 2);
-        curByte++;
-        upBufPtr++;
-      }
-      break;
-    case NA_PNG_FILTER_TYPE_PAETH:
-      for(size_t x = 0; x < bpp; x++){
-        *curByte += naGetPaethPredictor(0, *upBufPtr, 0);
-        curByte++;
-        upBufPtr++;
-      }
-      for(size_t x = bpp; x < ((size_t)png->size.width * bpp); x++){
-        *curByte += naGetPaethPredictor(*(curByte - bpp), *upBufPtr, *(upBufPtr - bpp));
-        curByte++;
-        upBufPtr++;
-      }
-      break;
-    default:
-      #if NA_DEBUG
-        naError("Invalid Filter");
-      #endif
-      curByte += bytesPerLine;
-      break;
-    }
-
-    upBufPtr = curByte - bytesPerLine;
+    na_UnfilterPNGLine(curByte, upBufPtr, filtertype, bytesPerLine, bpp);
+    upBufPtr = curByte;
+    curByte += bytesPerLine;
   }
 
-//  outFile = naCreateFileWritingPath("test.raw", NA_FILEMODE_DEFAULT);
-//  naWriteFileBytes(outFile, png->pixeldata, png->size.width * png->size.height * bpp);
-//  naReleaseFile(outFile);
-
   naClearBufferIterator(&iterFilter);
   naFree(upBuffer);
 }
@@ -340,23 +546,53 @@ NA_DEF void naReconstructFilterData(NAPNG* png){
 
 NA_DEF void naFilterData(NAPNG* png){
   NAByte* pixeldata;
-  NAInt y;
+  NAByte* zeroLine;
+  const NAByte* upLine;
+  NAByte* candidate;
+  NAByte* best;
   NABufferIterator iter;
 
+  if(png->filteredData){naRelease(png->filteredData);}
   png->filteredData = naNewBuffer(NA_FALSE);
   naSetBufferEndianness(png->filteredData, NA_ENDIANNESS_NETWORK);
 
   size_t bpp = naGetPNGBytesPerPixel(png->colorType);
+  size_t bytesPerLine = (size_t)png->size.width * bpp;
   pixeldata = naGetPNGPixelData(png);
 
+  zeroLine = naMalloc(bytesPerLine);
+  naZeron(zeroLine, bytesPerLine);
+  candidate = naMalloc(bytesPerLine);
+  best = naMalloc(bytesPerLine);
+  upLine = zeroLine;
+
   iter = naMakeBufferModifier(png->filteredData);
-  for(y = 0; y < png->size.height; y++){
-    naWriteBufferu8(&iter, NA_PNG_FILTER_TYPE_NONE);
-    naWriteBufferBytes(&iter, pixeldata, (size_t)png->size.width * bpp);
-    pixeldata += (size_t)png->size.width * bpp;
+  for(NAInt y = 0; y < png->size.height; y++){
+    // Every line gets the filter with the smallest sum of absolute values.
+    NAByte bestFilterType = NA_PNG_FILTER_TYPE_NONE;
+    size_t bestCost = NA_MAX_s;
+    for(NAByte filterType = NA_PNG_FILTER_TYPE_NONE; filterType <= NA_PNG_FILTER_TYPE_PAETH; filterType++){
+      na_FilterPNGLine(candidate, pixeldata, upLine, filterType, bytesPerLine, bpp);
+      size_t cost = na_GetPNGFilterCost(candidate, bytesPerLine);
+      if(cost < bestCost){
+        NAByte* tmp = best;
+        best = candidate;
+        candidate = tmp;
+        bestCost = cost;
+        bestFilterType = filterType;
+      }
+    }
+    naWriteBufferu8(&iter, bestFilterType);
+    naWriteBufferBytes(&iter, best, bytesPerLine);
+    upLine = pixeldata;
+    pixeldata += bytesPerLine;
   }
   naClearBufferIterator(&iter);
 
+  naFree(best);
+  naFree(candidate);
+  naFree(zeroLine);
+
   naFixBufferRange(png->filteredData);
 }
 
@@ -454,7 +690,7 @@ NA_HDEF NAPNGChunk* na_AllocPNGIDATChunk(NAPNG* png){
   naSetBufferEndianness(idat->data, NA_ENDIANNESS_NETWORK);
 
   naFilterData(png);
-  naFillBufferWithZLIBCompression(idat->data, png->filteredData, NA_DEFLATE_COMPRESSION_FASTEST);
+  naFillBufferWithZLIBCompression(idat->data, png->filteredData, NA_DEFLATE_COMPRESSION_DEFAULT);
 
   idat->type = NA_PNG_CHUNK_TYPE_IDAT;
 
@@ -697,6 +933,7 @@ NA_DEF NAPNG* naNewPNG(NASizei size, NAPNGColorType colorType, int8 bitDepth){
 
   size_t bpp = naGetPNGBytesPerPixel(colorType);
   png->pixeldata = naMalloc(naGetSizeiIndexCount(size) * bpp);
+  png->compresseddata = NA_NULL;
   png->filteredData = NA_NULL;
 
   return png;
@@ -704,13 +941,15 @@ NA_DEF NAPNG* naNewPNG(NASizei size, NAPNGColorType colorType, int8 bitDepth){
 
 
 
-NA_DEF NAPNG* naNewPNGWithPath(const char* filePath){
+// Reads all chunks of the png file and evaluates all chunks except the image
+// data. Returns NA_FALSE if the file is no png file.
+NA_HDEF NABool na_ReadPNGChunksWithPath(NAPNG* png, const char* filePath){
   NABuffer* buffer;
   NAByte magic[8];
   NAListIterator iter;
   NABufferIterator bufiter;
+  NABool success = NA_FALSE;
 
-  NAPNG* png = naNew(NAPNG);
   naInitList(&(png->chunks));
 
   // Set the default values. Needed if no appropriate chunk is available.
@@ -719,6 +958,8 @@ NA_DEF NAPNG* naNewPNGWithPath(const char* filePath){
   png->pixeldimensions[0] = 1.f;
   png->pixeldimensions[1] = 1.f;
   png->pixelunit = NA_PIXEL_UNIT_RATIO;
+  png->pixeldata = NA_NULL;
+  png->compresseddata = NA_NULL;
   png->filteredData = NA_NULL;
 
   buffer = naNewBufferWithInputPath(filePath);
@@ -726,7 +967,7 @@ NA_DEF NAPNG* naNewPNGWithPath(const char* filePath){
 
   // If the buffer is empty, there is no png to read.
   if(naIsBufferEmpty(buffer)){
-    goto NAEndReadingPNG;
+    goto NAEndReadingPNGChunks;
   }
 
   // Important! RFC 1950 is big endianed (network endianness)
@@ -738,7 +979,7 @@ NA_DEF NAPNG* naNewPNGWithPath(const char* filePath){
     #if NA_DEBUG
       naError("File is not a PNG file.");
     #endif
-    goto NAEndReadingPNG;
+    goto NAEndReadingPNGChunks;
   }
 
   // Read the chunks until the IEND chunk is read.
@@ -747,18 +988,12 @@ NA_DEF NAPNG* naNewPNGWithPath(const char* filePath){
     naAddListLastMutable(&(png->chunks), chunk);
     if(chunk->type == NA_PNG_CHUNK_TYPE_IEND){break;}
   }
-  naClearBufferIterator(&bufiter);
-
-  // Create the buffer to hold the compressed and decompressed data
-  png->compresseddata = naNewBuffer(NA_FALSE);
-  naSetBufferEndianness(png->compresseddata, NA_ENDIANNESS_NETWORK);
-  png->filteredData = naNewBuffer(NA_FALSE);
 
   naBeginListMutatorIteration(NAPNGChunk* chunk, &(png->chunks), iter);
     switch(chunk->type){
     case NA_PNG_CHUNK_TYPE_IHDR:  na_ReadPNGIHDRChunk(png, chunk);  break;
     case NA_PNG_CHUNK_TYPE_PLTE:  na_ReadPNGPLTEChunk(png, chunk);  break;
-    case NA_PNG_CHUNK_TYPE_IDAT:  na_ReadPNGIDATChunk(png, chunk);  break;
+    case NA_PNG_CHUNK_TYPE_IDAT:  break; // Read by the caller.
     case NA_PNG_CHUNK_TYPE_IEND:  na_ReadPNGIENDChunk(png, chunk);  break;
 
     case NA_PNG_CHUNK_TYPE_cHRM:  na_ReadPNGcHRMChunk(png, chunk);  break;
@@ -779,18 +1014,36 @@ NA_DEF NAPNG* naNewPNGWithPath(const char* filePath){
       break;
     }
   naEndListIteration(iter);
+  success = NA_TRUE;
+
+  NAEndReadingPNGChunks:
+  naClearBufferIterator(&bufiter);
+  naRelease(buffer);
+
+  return success;
+}
+
+
+
+NA_DEF NAPNG* naNewPNGWithPath(const char* filePath){
+  NAListIterator iter;
+
+  NAPNG* png = naNew(NAPNG);
+  if(!na_ReadPNGChunksWithPath(png, filePath)){return png;}
 
-//  NAFile* outFile = naCreateFileWritingPath("test.raw", NA_FILEMODE_DEFAULT);
-//  naWriteBufferToFile(png->compresseddata, outFile);
-//  naReleaseFile(outFile);
+  // Create the buffer to hold the compressed and decompressed data
+  png->compresseddata = naNewBuffer(NA_FALSE);
+  naSetBufferEndianness(png->compresseddata, NA_ENDIANNESS_NETWORK);
+  png->filteredData = naNewBuffer(NA_FALSE);
+
+  naBeginListMutatorIteration(NAPNGChunk* chunk, &(png->chunks), iter);
+    if(chunk->type == NA_PNG_CHUNK_TYPE_IDAT){na_ReadPNGIDATChunk(png, chunk);}
+  naEndListIteration(iter);
 
   naFixBufferRange(png->compresseddata);
-  naFillBufferWithZLIBDecompression(png->filteredData, png->compresseddata);
+  if(!naFillBufferWithZLIBDecompression(png->filteredData, png->compresseddata)){return png;}
   naReconstructFilterData(png);
 
-  NAEndReadingPNG:
-  naRelease(buffer);
-
   return png;
 }
 
@@ -817,31 +1070,30 @@ NA_DEF size_t naGetPNGPixelDataByteSize(NAPNG* png){
 
 
 
-NA_DEF NABabyImage* naCreateBabyImageFromPNG(NAPNG* png){
-  NABabyImage* babyImage = naCreateBabyImage(png->size, NA_NULL);
-  NAByte* pngptr;
-  float* babyptr;
+// Converts one unfiltered line of the png into the floats of a baby image
+// line.
+NA_HDEF void na_ConvertPNGLineToBabyImage(const NAPNG* png, const NAByte* pngptr, float* babyptr){
   uint8 inbuf[4];
-  NAInt x, y;
-
   switch(png->colorType){
   case NA_PNG_COLORTYPE_TRUECOLOR:
-    pngptr = png->pixeldata;
+    // The conversion reads 4 bytes, the png only has 3 per pixel.
     inbuf[3] = 255;
-    for(y = 0; y < png->size.height; y++){
-      babyptr = &(naGetBabyImageData(babyImage)[(png->size.height - y - 1) * naGetBabyImageValuesPerLine(babyImage)]);
-      for(x = 0; x < png->size.width; x++){
-        inbuf[0] = pngptr[0];
-        inbuf[1] = pngptr[1];
-        inbuf[2] = pngptr[2];
-        naFillBabyColorWithu8(babyptr, inbuf, NA_COLOR_BUFFER_RGB);
-        babyptr += 4;
-        pngptr += 3;
-      }
+    for(NAInt x = 0; x < png->size.width; x++){
+      inbuf[0] = pngptr[0];
+      inbuf[1] = pngptr[1];
+      inbuf[2] = pngptr[2];
+      naFillBabyColorWithu8(babyptr, inbuf, NA_COLOR_BUFFER_RGB);
+      babyptr[3] = 1.f;
+      babyptr += 4;
+      pngptr += 3;
     }
     break;
   case NA_PNG_COLORTYPE_TRUECOLOR_ALPHA:
-    naFillBabyImageWithu8(babyImage, png->pixeldata, NA_TRUE, NA_COLOR_BUFFER_RGBA);
+    for(NAInt x = 0; x < png->size.width; x++){
+      naFillBabyColorWithu8(babyptr, pngptr, NA_COLOR_BUFFER_RGBA);
+      babyptr += 4;
+      pngptr += 4;
+    }
     break;
   default:
     #if NA_DEBUG
@@ -849,11 +1101,162 @@ NA_DEF NABabyImage* naCreateBabyImageFromPNG(NAPNG* png){
     #endif
     break;
   }
+}
+
+
+
+// Returns the line of the baby image for the png line y. PNGs are stored
+// top to bottom, baby images bottom to top.
+NA_HIDEF float* na_GetBabyImageLineForPNGLine(NABabyImage* babyImage, NAInt y){
+  NASizei size = naGetBabyImageSize(babyImage);
+  return &(naGetBabyImageData(babyImage)[(size.height - y - 1) * naGetBabyImageValuesPerLine(babyImage)]);
+}
+
+
+
+NA_DEF NABabyImage* naCreateBabyImageFromPNG(NAPNG* png){
+  NABabyImage* babyImage = naCreateBabyImage(png->size, NA_NULL);
+  size_t bytesPerLine = (size_t)png->size.width * naGetPNGBytesPerPixel(png->colorType);
+  const NAByte* pngptr = png->pixeldata;
+
+  for(NAInt y = 0; y < png->size.height; y++){
+    na_ConvertPNGLineToBabyImage(png, pngptr, na_GetBabyImageLineForPNGLine(babyImage, y));
+    pngptr += bytesPerLine;
+  }
   return babyImage;
 }
 
 
 
+// The number of compressed bytes given to the inflater at once.
+#define NA_PNG_INFLATE_INPUT_BYTESIZE 16384
+
+// Decodes the image data of a png whose chunks have been read. The data is
+// inflated, unfiltered and converted line by line, such that apart from the
+// resulting image, only two lines need to be in memory.
+NA_HDEF NABabyImage* na_DecodePNGToBabyImage(NAPNG* png){
+  size_t bpp = naGetPNGBytesPerPixel(png->colorType);
+  size_t bytesPerLine = (size_t)png->size.width * bpp;
+  size_t filteredLineBytes = bytesPerLine + 1;  // The filter type comes first.
+  NAInt y = 0;
+  size_t lineFill = 0;
+  NAListIterator iter;
+
+  NABabyImage* babyImage = naCreateBabyImage(png->size, NA_NULL);
+
+  // Two lines with their filter type byte, the current and the one above.
+  // The line above the first line is all zero.
+  NAByte* lines = naMalloc(2 * filteredLineBytes);
+  NAByte* curLine = lines;
+  NAByte* upLine = lines + filteredLineBytes;
+  naZeron(upLine, filteredLineBytes);
+
+  NAByte* input = naMalloc(NA_PNG_INFLATE_INPUT_BYTESIZE);
+  NAZLIBInflater* inflater = naNewZLIBInflater();
+
+  naBeginListMutatorIteration(NAPNGChunk* chunk, &(png->chunks), iter);
+    if(chunk->type == NA_PNG_CHUNK_TYPE_IDAT && chunk->length){
+      NABufferIterator chunkIter = naMakeBufferAccessor(chunk->data);
+      size_t remainingBytes = chunk->length;
+      while(remainingBytes){
+        size_t inputBytes = naMins(remainingBytes, NA_PNG_INFLATE_INPUT_BYTESIZE);
+        naReadBufferBytes(&chunkIter, input, inputBytes);
+        naFeedZLIBInflater(inflater, input, inputBytes);
+        remainingBytes -= inputBytes;
+
+        // Drain all lines which are complete by now.
+        while(y < png->size.height){
+          size_t drainedBytes = naDrainZLIBInflater(inflater, curLine + lineFill, filteredLineBytes - lineFill);
+          if(!drainedBytes){break;}
+          lineFill += drainedBytes;
+          if(lineFill == filteredLineBytes){
+            na_UnfilterPNGLine(curLine + 1, upLine + 1, curLine[0], bytesPerLine, bpp);
+            na_ConvertPNGLineToBabyImage(png, curLine + 1, na_GetBabyImageLineForPNGLine(babyImage, y));
+            NAByte* tmp = upLine;
+            upLine = curLine;
+            curLine = tmp;
+            lineFill = 0;
+            y++;
+          }
+        }
+      }
+      naClearBufferIterator(&chunkIter);
+    }
+  naEndListIteration(iter);
+
+  NABool success = naFinishZLIBInflater(inflater) && (y == png->size.height);
+  #if NA_DEBUG
+    if(!success)
+      naError("Image data of the PNG is corrupt.");
+  #endif
+
+  naDelete(inflater);
+  naFree(input);
+  naFree(lines);
+
+  if(!success){
+    naReleaseBabyImage(babyImage);
+    babyImage = NA_NULL;
+  }
+  return babyImage;
+}
+
+
+
+NA_DEF NABabyImage* naCreateBabyImageWithPNGPath(const char* filePath){
+  NABabyImage* babyImage = NA_NULL;
+  NAPNG* png = naNew(NAPNG);
+  if(na_ReadPNGChunksWithPath(png, filePath)){
+    if(png->colorType == NA_PNG_COLORTYPE_TRUECOLOR || png->colorType == NA_PNG_COLORTYPE_TRUECOLOR_ALPHA){
+      babyImage = na_DecodePNGToBabyImage(png);
+    }else{
+      #if NA_DEBUG
+        naError("Not implemented yet");
+      #endif
+    }
+  }
+  naDelete(png);
+  return babyImage;
+}
+
+
+
+typedef struct NA_PNGBatch NA_PNGBatch;
+struct NA_PNGBatch{
+  NABabyImage** images;
+  const char* const* filePaths;
+};
+
+NA_HDEF void na_CreateBabyImagesWithPNGPaths(void* arg, size_t begin, size_t end){
+  NA_PNGBatch* batch = (NA_PNGBatch*)arg;
+  for(size_t i = begin; i < end; i++){
+    batch->images[i] = naCreateBabyImageWithPNGPath(batch->filePaths[i]);
+  }
+}
+
+
+
+NA_DEF void naCreateBabyImagesWithPNGPaths(NABabyImage** images, const char* const* filePaths, size_t count, NAThreadPool* pool){
+  #if NA_DEBUG
+    if(!images)
+      naCrash("images is Null");
+    if(!filePaths)
+      naCrash("filePaths is Null");
+  #endif
+  NA_PNGBatch batch;
+  batch.images = images;
+  batch.filePaths = filePaths;
+  if(pool){
+    // Every file is a task of its own. Files differ a lot in size, stealing
+    // single files balances the work best.
+    naRunParallelFor(pool, count, 1, na_CreateBabyImagesWithPNGPaths, &batch);
+  }else{
+    na_CreateBabyImagesWithPNGPaths(&batch, 0, count);
+  }
+}
+
+
+
 NA_DEF NASizei naGetPNGSize(NAPNG* png){
   return png->size;
 }
@@ -879,10 +1282,14 @@ NA_DEF void naWritePNGToPath(NAPNG* png, const char* filePath){
   NAFile* outFile;
   NAListIterator iter;
   NABufferIterator iterout;
+  NAList chunks;
 
-  naAddListLastMutable(&(png->chunks), na_AllocPNGIHDRChunk(png));
-  naAddListLastMutable(&(png->chunks), na_AllocPNGIDATChunk(png));
-  naAddListLastMutable(&(png->chunks), na_AllocPNGIENDChunk(png));
+  // The chunks are only created for writing and are not stored in the png
+  // such that writing multiple times results in the same file.
+  naInitList(&chunks);
+  naAddListLastMutable(&chunks, na_AllocPNGIHDRChunk(png));
+  naAddListLastMutable(&chunks, na_AllocPNGIDATChunk(png));
+  naAddListLastMutable(&chunks, na_AllocPNGIENDChunk(png));
 
   outbuffer = naNewBuffer(NA_FALSE);
   iterout = naMakeBufferMutator(outbuffer);
@@ -890,7 +1297,7 @@ NA_DEF void naWritePNGToPath(NAPNG* png, const char* filePath){
 
   naWriteBufferBytes(&iterout, na_PngMagic, 8);
 
-  naBeginListMutatorIteration(NAPNGChunk* chunk, &(png->chunks), iter);
+  naBeginListMutatorIteration(NAPNGChunk* chunk, &chunks, iter);
     naFixBufferRange(chunk->data);
 
     chunk->length = (uint32)naGetBufferRange(chunk->data).length;
@@ -920,6 +1327,9 @@ NA_DEF void naWritePNGToPath(NAPNG* png, const char* filePath){
   naWriteBufferToFile(outbuffer, outFile);
   naReleaseFile(outFile);
   naRelease(outbuffer);
+
+  naForeachListMutable(&chunks, (NAMutator)na_DeallocPNGChunk);
+  naClearList(&chunks);
 }
 
 
@@ -14,9 +14,13 @@ void printNAStruct(void);
 void testNABase(void);
 void testNACore(void);
 void testNAStruct(void);
+void testNAVisual(void);
 
 void benchmarkNABase(void);
+void benchmarkNACore(void);
+void benchmarkNAMath(void);
 void benchmarkNAStruct(void);
+void benchmarkNAVisual(void);
 
 int main(int argc, const char** argv){
 
@@ -51,13 +55,17 @@ int main(int argc, const char** argv){
     naTestGroupFunction(NABase);
     naTestGroupFunction(NACore);
     naTestGroupFunction(NAStruct);
+    naTestGroupFunction(NAVisual);
 
     //printf(NA_NL);
     //naPrintUntested();
 
-    //printf(NA_NL "Benchmarking:" NA_NL);
-    //benchmarkNABase();
-    //benchmarkNAStruct();
+    // Benchmarks only run with the -P argument.
+    naBenchmarkGroupFunction(NABase);
+    naBenchmarkGroupFunction(NACore);
+    naBenchmarkGroupFunction(NAMath);
+    naBenchmarkGroupFunction(NAStruct);
+    naBenchmarkGroupFunction(NAVisual);
     
     printf(NA_NL);
   }else{
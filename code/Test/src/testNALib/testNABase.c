@@ -62,9 +62,9 @@ void testNABase(){
 }
 
 void benchmarkNABase(){
-  benchmarkNAInt64();
-  benchmarkNAInt128();
-  benchmarkNAInt256();
+  naBenchmarkGroupFunction(NAInt64);
+  naBenchmarkGroupFunction(NAInt128);
+  naBenchmarkGroupFunction(NAInt256);
 }
 
 
@@ -9,6 +9,12 @@ void printNATesting(void);
 
 void testNATesting(void);
 void testNAValueHelper(void);
+void testNAMemory(void);
+void testNAThreading(void);
+void testNABinaryData(void);
+void testNATranslator(void);
+
+void benchmarkNABinaryData(void);
 
 
 
@@ -19,6 +25,14 @@ void printNACore(){
 void testNACore(){
   naTestGroupFunction(NATesting);
   naTestGroupFunction(NAValueHelper);
+  naTestGroupFunction(NAMemory);
+  naTestGroupFunction(NAThreading);
+  naTestGroupFunction(NABinaryData);
+  naTestGroupFunction(NATranslator);
+}
+
+void benchmarkNACore(){
+  naBenchmarkGroupFunction(NABinaryData);
 }
 
 
@@ -0,0 +1,165 @@
+#include "NATesting.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "NABinaryData.h"
+#include "NAMemory.h"
+
+
+
+// Straight forward implementations to compare against.
+uint32 na_TestBinaryDataCRC(const NAByte* data, size_t byteSize){
+  uint32 c = 0xffffffff;
+  for(size_t i = 0; i < byteSize; i++){
+    c ^= data[i];
+    for(int k = 0; k < 8; k++){
+      c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+    }
+  }
+  return c ^ 0xffffffff;
+}
+
+uint32 na_TestBinaryDataAdler(const NAByte* data, size_t byteSize){
+  uint32 s1 = 1;
+  uint32 s2 = 0;
+  for(size_t i = 0; i < byteSize; i++){
+    s1 = (s1 + data[i]) % 65521;
+    s2 = (s2 + s1) % 65521;
+  }
+  return (s2 << 16) | s1;
+}
+
+uint32 na_TestBinaryDataChecksum(NAChecksumType type, const NAByte* data, size_t byteSize){
+  NAChecksum checksum;
+  naInitChecksum(&checksum, type);
+  naAccumulateChecksum(&checksum, data, byteSize);
+  uint32 result = naGetChecksumResult(&checksum);
+  naClearChecksum(&checksum);
+  return result;
+}
+
+// Accumulates the data in two parts and combines them.
+uint32 na_TestBinaryDataCombined(NAChecksumType type, const NAByte* data, size_t byteSize, size_t splitPos){
+  NAChecksum checksum;
+  NAChecksum appended;
+  naInitChecksum(&checksum, type);
+  naInitChecksum(&appended, type);
+  naAccumulateChecksum(&checksum, data, splitPos);
+  naAccumulateChecksum(&appended, &data[splitPos], byteSize - splitPos);
+  naCombineChecksum(&checksum, &appended);
+  uint32 result = naGetChecksumResult(&checksum);
+  naClearChecksum(&appended);
+  naClearChecksum(&checksum);
+  return result;
+}
+
+
+
+void testNABinaryDataChecksum(){
+  const NAByte* digits = (const NAByte*)"123456789";
+  size_t byteSize = 100000;
+  NAByte* data = naMalloc(byteSize);
+  uint32 seed = 1234;
+  for(size_t i = 0; i < byteSize; i++){
+    seed = seed * 1103515245 + 12345;
+    data[i] = (i % 1000 < 500) ? (NAByte)(seed >> 16) : 0xff;
+  }
+
+  naTestGroup("Known values"){
+    naTest(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_CRC_PNG, digits, 9) == 0xcbf43926);
+    naTest(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_ADLER_32, digits, 9) == 0x091e01de);
+    naTest(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_CRC_PNG, digits, 0) == 0);
+    naTest(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_ADLER_32, digits, 0) == 1);
+  }
+
+  naTestGroup("All lengths and alignments"){
+    NABool crcCorrect = NA_TRUE;
+    NABool adlerCorrect = NA_TRUE;
+    for(size_t offset = 0; offset < 16; offset++){
+      for(size_t length = 0; length < 300; length++){
+        if(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_CRC_PNG, &data[offset], length) != na_TestBinaryDataCRC(&data[offset], length)){crcCorrect = NA_FALSE;}
+        if(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_ADLER_32, &data[offset], length) != na_TestBinaryDataAdler(&data[offset], length)){adlerCorrect = NA_FALSE;}
+      }
+    }
+    naTest(crcCorrect);
+    naTest(adlerCorrect);
+  }
+
+  naTestGroup("Large data"){
+    naTest(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_CRC_PNG, data, byteSize) == na_TestBinaryDataCRC(data, byteSize));
+    naTest(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_ADLER_32, data, byteSize) == na_TestBinaryDataAdler(data, byteSize));
+    naTest(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_CRC_PNG, &data[1], byteSize - 1) == na_TestBinaryDataCRC(&data[1], byteSize - 1));
+    naTest(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_ADLER_32, &data[1], byteSize - 1) == na_TestBinaryDataAdler(&data[1], byteSize - 1));
+  }
+
+  naTestGroup("Combine"){
+    uint32 crc = na_TestBinaryDataCRC(data, byteSize);
+    uint32 adler = na_TestBinaryDataAdler(data, byteSize);
+    naTest(na_TestBinaryDataCombined(NA_CHECKSUM_TYPE_CRC_PNG, data, byteSize, 0) == crc);
+    naTest(na_TestBinaryDataCombined(NA_CHECKSUM_TYPE_CRC_PNG, data, byteSize, 1) == crc);
+    naTest(na_TestBinaryDataCombined(NA_CHECKSUM_TYPE_CRC_PNG, data, byteSize, 65521) == crc);
+    naTest(na_TestBinaryDataCombined(NA_CHECKSUM_TYPE_CRC_PNG, data, byteSize, byteSize) == crc);
+    naTest(na_TestBinaryDataCombined(NA_CHECKSUM_TYPE_ADLER_32, data, byteSize, 0) == adler);
+    naTest(na_TestBinaryDataCombined(NA_CHECKSUM_TYPE_ADLER_32, data, byteSize, 1) == adler);
+    naTest(na_TestBinaryDataCombined(NA_CHECKSUM_TYPE_ADLER_32, data, byteSize, 65521) == adler);
+    naTest(na_TestBinaryDataCombined(NA_CHECKSUM_TYPE_ADLER_32, data, byteSize, byteSize) == adler);
+  }
+
+  naFree(data);
+}
+
+
+
+void testNABinaryData(){
+  naTestGroupFunction(NABinaryDataChecksum);
+}
+
+
+
+void na_BenchmarkNABinaryDataChecksumSize(size_t byteSize){
+  NAByte* data = naMalloc(byteSize);
+  uint32 seed = 2345;
+  for(size_t i = 0; i < byteSize; i++){
+    seed = seed * 1103515245 + 12345;
+    data[i] = (NAByte)(seed >> 16);
+  }
+
+  naBenchmark(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_CRC_PNG, data, byteSize));
+  naBenchmark(na_TestBinaryDataChecksum(NA_CHECKSUM_TYPE_ADLER_32, data, byteSize));
+
+  naFree(data);
+}
+
+void benchmarkNABinaryData(){
+  printf(NA_NL "NAChecksum:" NA_NL);
+  naTestGroup("1000"){na_BenchmarkNABinaryDataChecksumSize(1000);}
+  naTestGroup("65536"){na_BenchmarkNABinaryDataChecksumSize(65536);}
+  naTestGroup("1048576"){na_BenchmarkNABinaryDataChecksumSize(1048576);}
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
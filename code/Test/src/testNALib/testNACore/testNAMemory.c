@@ -0,0 +1,337 @@
+#include "NATesting.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "NAMemory.h"
+#include "NAThreading.h"
+
+
+
+// Enough values to fill several pool parts.
+#define NA_TEST_MEMORY_VALUE_COUNT 50000
+
+typedef struct NATestMemoryValue NATestMemoryValue;
+struct NATestMemoryValue{
+  size_t index;
+  size_t check;
+  double filler[2];
+};
+NA_RUNTIME_TYPE(NATestMemoryValue, NA_NULL, NA_FALSE);
+
+typedef struct NATestMemoryShared NATestMemoryShared;
+struct NATestMemoryShared{
+  NAInt* destructCount;
+};
+void na_DestructTestMemoryShared(NATestMemoryShared* shared){
+  naAddAtomicInt(shared->destructCount, 1);
+}
+NA_RUNTIME_TYPE(NATestMemoryShared, na_DestructTestMemoryShared, NA_REFCOUNTING_ATOMIC);
+
+typedef struct NATestMemorySmall NATestMemorySmall;
+struct NATestMemorySmall{
+  size_t index;
+};
+NA_RUNTIME_TYPE_WITH_PART_SIZE(NATestMemorySmall, NA_NULL, NA_FALSE, 4096);
+
+typedef struct NATestMemoryJob NATestMemoryJob;
+struct NATestMemoryJob{
+  NATestMemoryValue** values;
+  NATestMemoryShared** shared;
+  NAInt destructCount;
+  NAInt wrongCount;
+};
+
+
+
+void na_TestMemoryNewValues(void* arg, size_t begin, size_t end){
+  NATestMemoryJob* job = (NATestMemoryJob*)arg;
+  for(size_t i = begin; i < end; ++i){
+    job->values[i] = naNew(NATestMemoryValue);
+    job->values[i]->index = i;
+    job->values[i]->check = ~i;
+  }
+}
+
+// Deletes the values in reverse order such that most of them get deleted by
+// a thread different from the one which created them.
+void na_TestMemoryDeleteValues(void* arg, size_t begin, size_t end){
+  NATestMemoryJob* job = (NATestMemoryJob*)arg;
+  for(size_t i = begin; i < end; ++i){
+    NATestMemoryValue* value = job->values[NA_TEST_MEMORY_VALUE_COUNT - 1 - i];
+    if(value->index != NA_TEST_MEMORY_VALUE_COUNT - 1 - i || value->check != ~value->index){
+      naAddAtomicInt(&(job->wrongCount), 1);
+    }
+    naDelete(value);
+  }
+}
+
+void na_TestMemoryNewShared(void* arg, size_t begin, size_t end){
+  NATestMemoryJob* job = (NATestMemoryJob*)arg;
+  for(size_t i = begin; i < end; ++i){
+    job->shared[i] = naNew(NATestMemoryShared);
+    job->shared[i]->destructCount = &(job->destructCount);
+  }
+}
+
+// Every shared value gets retained and released by multiple threads at the
+// same time.
+void na_TestMemoryRetainReleaseShared(void* arg, size_t begin, size_t end){
+  NATestMemoryJob* job = (NATestMemoryJob*)arg;
+  for(size_t i = begin; i < end; ++i){
+    NATestMemoryShared* shared = job->shared[i % 64];
+    naRetain(shared);
+    naRelease(shared);
+  }
+}
+
+void na_TestMemoryRetainShared(void* arg, size_t begin, size_t end){
+  NATestMemoryJob* job = (NATestMemoryJob*)arg;
+  for(size_t i = begin; i < end; ++i){
+    naRetain(job->shared[i % 64]);
+  }
+}
+
+// Releases the values which have been retained 4 times.
+void na_TestMemoryReleaseShared(void* arg, size_t begin, size_t end){
+  NATestMemoryJob* job = (NATestMemoryJob*)arg;
+  for(size_t i = begin; i < end; ++i){
+    naRelease(job->shared[i / 4]);
+  }
+}
+
+
+
+NABool na_TestMemoryFindStats(NARuntimeTypeStats* stats, const char* typeName){
+  size_t typeCount = naGetRuntimeTypeCount();
+  for(size_t i = 0; i < typeCount; ++i){
+    naGetRuntimeTypeStats(stats, i);
+    if(!strcmp(stats->typeName, typeName)){return NA_TRUE;}
+  }
+  return NA_FALSE;
+}
+
+
+
+void testNAMemoryRuntime(){
+  NATestMemoryJob job;
+  job.values = naMalloc(NA_TEST_MEMORY_VALUE_COUNT * sizeof(NATestMemoryValue*));
+  job.shared = naMalloc(NA_TEST_MEMORY_VALUE_COUNT * sizeof(NATestMemoryShared*));
+  job.destructCount = 0;
+  job.wrongCount = 0;
+
+  naTestGroup("Single thread"){
+    NABool allCorrect = NA_TRUE;
+    na_TestMemoryNewValues(&job, 0, NA_TEST_MEMORY_VALUE_COUNT);
+    for(size_t i = 0; i < NA_TEST_MEMORY_VALUE_COUNT; ++i){
+      if(job.values[i]->index != i || job.values[i]->check != ~i){allCorrect = NA_FALSE;}
+    }
+    naTest(allCorrect);
+    naTest(job.values[0] != job.values[1]);
+    naTestVoid(na_TestMemoryDeleteValues(&job, 0, NA_TEST_MEMORY_VALUE_COUNT));
+    naTest(job.wrongCount == 0);
+  }
+
+  NAThreadPool* pool = naNewThreadPool(4);
+
+  naTestGroup("Multiple threads"){
+    job.wrongCount = 0;
+    naTestVoid(naRunParallelFor(pool, NA_TEST_MEMORY_VALUE_COUNT, 64, na_TestMemoryNewValues, &job));
+    naTestVoid(naRunParallelFor(pool, NA_TEST_MEMORY_VALUE_COUNT, 64, na_TestMemoryDeleteValues, &job));
+    naTest(job.wrongCount == 0);
+
+    // Spaces deleted by other threads get reused.
+    naTestVoid(naRunParallelFor(pool, NA_TEST_MEMORY_VALUE_COUNT, 64, na_TestMemoryNewValues, &job));
+    naTestVoid(na_TestMemoryDeleteValues(&job, 0, NA_TEST_MEMORY_VALUE_COUNT));
+    naTest(job.wrongCount == 0);
+  }
+
+  naTestGroup("Reference counting"){
+    naTestVoid(naRunParallelFor(pool, NA_TEST_MEMORY_VALUE_COUNT, 64, na_TestMemoryNewShared, &job));
+    for(size_t i = 0; i < NA_TEST_MEMORY_VALUE_COUNT; ++i){
+      naRelease(job.shared[i]);
+    }
+    naTest(job.destructCount == NA_TEST_MEMORY_VALUE_COUNT);
+  }
+
+  naTestGroup("Atomic reference counting"){
+    job.destructCount = 0;
+    naRunParallelFor(pool, 64, 1, na_TestMemoryNewShared, &job);
+    naTestVoid(naRunParallelFor(pool, NA_TEST_MEMORY_VALUE_COUNT, 64, na_TestMemoryRetainReleaseShared, &job));
+    naTest(job.destructCount == 0);
+    naTest(naGetRuntimeTypeRefCount(job.shared[0]) == 1);
+
+    naTestVoid(naRunParallelFor(pool, 64 * 3, 1, na_TestMemoryRetainShared, &job));
+    naTest(naGetRuntimeTypeRefCount(job.shared[63]) == 4);
+    naTestVoid(naRunParallelFor(pool, 64 * 4, 1, na_TestMemoryReleaseShared, &job));
+    naTest(job.destructCount == 64);
+  }
+
+  naDelete(pool);
+
+  naTestGroup("Detach"){
+    NATestMemoryValue* value = naNew(NATestMemoryValue);
+    naTestVoid(naDetachRuntimeThread());
+    naTestVoid(naDelete(value));
+    naTestVoid(naDetachRuntimeThread());
+    value = naNew(NATestMemoryValue);
+    naTest(value != NA_NULL);
+    naDelete(value);
+  }
+
+  naFree(job.shared);
+  naFree(job.values);
+}
+
+
+
+void testNAMemoryStats(){
+  NARuntimeTypeStats stats;
+  NATestMemoryValue* values[1000];
+
+  naTestGroup("Type statistics"){
+    naTest(naGetRuntimeTypeCount() > 0);
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemoryValue"));
+    size_t prevAllocCount = stats.allocCount;
+
+    for(size_t i = 0; i < 1000; ++i){values[i] = naNew(NATestMemoryValue);}
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemoryValue"));
+    naTest(stats.typeSize == sizeof(NATestMemoryValue));
+    naTest(stats.count == 1000);
+    naTest(stats.allocCount == prevAllocCount + 1000);
+    naTest(stats.deleteCount == stats.allocCount - 1000);
+    naTest(stats.partCount >= 1);
+    naTest(stats.peakPartCount >= stats.partCount);
+    naTest(stats.reservedBytes == stats.partCount * naGetRuntimePoolPartSize());
+    naTest(stats.usedBytes == 1000 * sizeof(NATestMemoryValue));
+
+    for(size_t i = 0; i < 1000; ++i){naDelete(values[i]);}
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemoryValue"));
+    naTest(stats.count == 0);
+    naTest(stats.deleteCount == stats.allocCount);
+  }
+
+  naTestGroup("Peak count"){
+    // Reading the statistics observes the current count.
+    for(size_t i = 0; i < 1000; ++i){values[i] = naNew(NATestMemoryValue);}
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemoryValue"));
+    naTest(stats.peakCount >= 1000);
+    size_t expectedPeak = stats.peakCount;
+
+    for(size_t i = 0; i < 500; ++i){naDelete(values[i]);}
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemoryValue"));
+    naTest(stats.count == 500);
+    naTest(stats.peakCount == expectedPeak);
+
+    // Refilling the deleted spaces reaches the previous peak, one more
+    // value exceeds it.
+    for(size_t i = 0; i < 500; ++i){values[i] = naNew(NATestMemoryValue);}
+    NATestMemoryValue* extra = naNew(NATestMemoryValue);
+    if(expectedPeak < 1001){expectedPeak = 1001;}
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemoryValue"));
+    naTest(stats.peakCount == expectedPeak);
+
+    naDelete(extra);
+    for(size_t i = 0; i < 1000; ++i){naDelete(values[i]);}
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemoryValue"));
+    naTest(stats.count == 0);
+    naTest(stats.peakCount == expectedPeak);
+  }
+
+  naTestGroup("Reference counting types"){
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemoryShared"));
+    naTest(stats.typeSize > sizeof(NATestMemoryShared));
+    naTest(stats.count == 0);
+  }
+}
+
+
+
+void testNAMemoryParts(){
+  NARuntimeTypeStats stats;
+  NATestMemorySmall* values[1000];
+
+  naTestGroup("Peak count per part"){
+    // Without reading the statistics, the count is observed whenever a new
+    // part is needed. The values in the last part might be missed.
+    size_t countPerPart = (4096 - 16 * sizeof(void*)) / sizeof(NATestMemorySmall);
+    for(size_t i = 0; i < 1000; ++i){values[i] = naNew(NATestMemorySmall);}
+    for(size_t i = 0; i < 1000; ++i){naDelete(values[i]);}
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemorySmall"));
+    naTest(stats.count == 0);
+    naTest(stats.peakCount >= 1000 - countPerPart);
+    naTest(stats.peakCount <= 1000);
+  }
+
+  naTestGroup("Part size"){
+    for(size_t i = 0; i < 1000; ++i){
+      values[i] = naNew(NATestMemorySmall);
+      values[i]->index = i;
+    }
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemorySmall"));
+    naTest(stats.partSize == 4096);
+    naTest(stats.partCount > 1);
+    naTest(stats.reservedBytes == stats.partCount * 4096);
+    naTest(values[999]->index == 999);
+
+    // Small parts are aligned to their own size and share a block of the
+    // default part size.
+    size_t blockMask = ~(naGetRuntimePoolPartSize() - 1);
+    naTest(((size_t)values[0] & ~(size_t)4095) != ((size_t)values[999] & ~(size_t)4095));
+    naTest(((size_t)values[0] & blockMask) == ((size_t)values[999] & blockMask));
+    for(size_t i = 0; i < 1000; ++i){naDelete(values[i]);}
+  }
+
+  naTestGroup("Trim"){
+    for(size_t i = 0; i < 1000; ++i){values[i] = naNew(NATestMemorySmall);}
+    for(size_t i = 1; i < 1000; ++i){naDelete(values[i]);}
+    naTest(naTrimRuntimePools() > 0);
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemorySmall"));
+    naTest(stats.partCount == 1);
+    naTest(stats.count == 1);
+    naDelete(values[0]);
+
+    naTest(naTrimRuntimePools() > 0);
+    naTest(na_TestMemoryFindStats(&stats, "NATestMemorySmall"));
+    naTest(stats.partCount == 0);
+    naTest(naTrimRuntimePools() == 0);
+
+    values[0] = naNew(NATestMemorySmall);
+    naTest(values[0] != NA_NULL);
+    naDelete(values[0]);
+  }
+}
+
+
+
+void testNAMemory(){
+  naTestGroupFunction(NAMemoryRuntime);
+  naTestGroupFunction(NAMemoryStats);
+  naTestGroupFunction(NAMemoryParts);
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
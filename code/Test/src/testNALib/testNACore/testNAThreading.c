@@ -0,0 +1,288 @@
+#include "NATesting.h"
+#include <stdio.h>
+
+#include "NAThreading.h"
+
+
+
+#define NA_TEST_THREADING_THREAD_COUNT 4
+#define NA_TEST_THREADING_INCREMENTS 10000
+
+typedef struct NATestThreadingCounter NATestThreadingCounter;
+struct NATestThreadingCounter{
+  NAMutex mutex;
+  int value;
+};
+
+typedef struct NATestThreadingAlarmer NATestThreadingAlarmer;
+struct NATestThreadingAlarmer{
+  NAAlarm alarm;
+  NAMutex mutex;
+  NABool stop;
+};
+
+
+
+void na_TestThreadingSetFlag(void* arg){
+  naSleepM(10);
+  *(int*)arg = 1;
+}
+
+
+
+void na_TestThreadingIncrement(void* arg){
+  NATestThreadingCounter* counter = (NATestThreadingCounter*)arg;
+  for(int i = 0; i < NA_TEST_THREADING_INCREMENTS; ++i){
+    naLockMutex(counter->mutex);
+    counter->value++;
+    naUnlockMutex(counter->mutex);
+  }
+}
+
+
+
+void na_TestThreadingTrigger(void* arg){
+  NATestThreadingAlarmer* alarmer = (NATestThreadingAlarmer*)arg;
+  NABool stop = NA_FALSE;
+  // A trigger without anyone awaiting the alarm is lost. Therefore, keep on
+  // triggering until the main thread has noticed.
+  while(!stop){
+    naTriggerAlarm(alarmer->alarm);
+    naSleepM(1);
+    naLockMutex(alarmer->mutex);
+    stop = alarmer->stop;
+    naUnlockMutex(alarmer->mutex);
+  }
+}
+
+
+
+void na_TestThreadingAddAtomic(void* arg){
+  naAddAtomicInt((NAInt*)arg, 1);
+}
+
+
+
+typedef struct NATestThreadingNested NATestThreadingNested;
+struct NATestThreadingNested{
+  NATaskGroup* group;
+  NAInt count;
+};
+
+void na_TestThreadingNestedInner(void* arg){
+  NATestThreadingNested* nested = (NATestThreadingNested*)arg;
+  naAddAtomicInt(&(nested->count), 1);
+}
+
+void na_TestThreadingNestedOuter(void* arg){
+  NATestThreadingNested* nested = (NATestThreadingNested*)arg;
+  NATaskGroup innerGroup;
+  naInitTaskGroup(&innerGroup, nested->group->pool);
+  for(int i = 0; i < 10; ++i){
+    naAddTask(&innerGroup, na_TestThreadingNestedInner, nested);
+  }
+  naClearTaskGroup(&innerGroup);
+}
+
+
+
+void na_TestThreadingParallelFor(void* arg, size_t begin, size_t end){
+  uint32* values = (uint32*)arg;
+  for(size_t i = begin; i < end; ++i){
+    values[i] += (uint32)i;
+  }
+}
+
+
+
+void testNAThreadingThreads(){
+  naTestGroup("Run and join"){
+    int flag = 0;
+    NAThread thread = naMakeThread("NATest Thread", na_TestThreadingSetFlag, &flag);
+    naRunThread(thread);
+    naJoinThread(thread);
+    naTest(flag == 1);
+    flag = 0;
+    naRunThread(thread);
+    naJoinThread(thread);
+    naTest(flag == 1);
+    naClearThread(thread);
+  }
+}
+
+
+
+void testNAThreadingMutex(){
+  naTestGroup("Lock and try"){
+    NAMutex mutex = naMakeMutex();
+    naTest(naTryMutex(mutex));
+    naTest(!naTryMutex(mutex));
+    naTestVoid(naUnlockMutex(mutex));
+    naTestVoid(naLockMutex(mutex));
+    naTestVoid(naUnlockMutex(mutex));
+    naClearMutex(mutex);
+  }
+
+  naTestGroup("Concurrent increments"){
+    NATestThreadingCounter counter;
+    NAThread threads[NA_TEST_THREADING_THREAD_COUNT];
+    counter.mutex = naMakeMutex();
+    counter.value = 0;
+    for(int i = 0; i < NA_TEST_THREADING_THREAD_COUNT; ++i){
+      threads[i] = naMakeThread("NATest Increment", na_TestThreadingIncrement, &counter);
+      naRunThread(threads[i]);
+    }
+    for(int i = 0; i < NA_TEST_THREADING_THREAD_COUNT; ++i){
+      naJoinThread(threads[i]);
+      naClearThread(threads[i]);
+    }
+    naTest(counter.value == NA_TEST_THREADING_THREAD_COUNT * NA_TEST_THREADING_INCREMENTS);
+    naClearMutex(counter.mutex);
+  }
+}
+
+
+
+void testNAThreadingAlarm(){
+  naTestGroup("Timeout"){
+    NAAlarm alarm = naMakeAlarm();
+    naTest(!naAwaitAlarm(alarm, .01));
+    naTestError(naAwaitAlarm(alarm, -1.));
+    naClearAlarm(alarm);
+  }
+
+  naTestGroup("Trigger"){
+    NATestThreadingAlarmer alarmer;
+    NAThread thread;
+    alarmer.alarm = naMakeAlarm();
+    alarmer.mutex = naMakeMutex();
+    alarmer.stop = NA_FALSE;
+    thread = naMakeThread("NATest Trigger", na_TestThreadingTrigger, &alarmer);
+    naRunThread(thread);
+    naTest(naAwaitAlarm(alarmer.alarm, 10.));
+    naLockMutex(alarmer.mutex);
+    alarmer.stop = NA_TRUE;
+    naUnlockMutex(alarmer.mutex);
+    naJoinThread(thread);
+    naClearThread(thread);
+    naClearMutex(alarmer.mutex);
+    naClearAlarm(alarmer.alarm);
+  }
+}
+
+
+
+void testNAThreadingAtomics(){
+  naTestGroup("Integers"){
+    NAInt value = 5;
+    naTest(naLoadAtomicInt(&value) == 5);
+    naTestVoid(naStoreAtomicInt(&value, 7));
+    naTest(naAddAtomicInt(&value, 3) == 10);
+    naTest(naAddAtomicInt(&value, -10) == 0);
+    naTest(!naCompareExchangeAtomicInt(&value, 1, 2));
+    naTest(naCompareExchangeAtomicInt(&value, 0, 2));
+    naTest(value == 2);
+  }
+
+  naTestGroup("Pointers"){
+    int a = 0;
+    int b = 0;
+    void* pointer = &a;
+    naTest(naLoadAtomicPointer(&pointer) == &a);
+    naTest(!naCompareExchangeAtomicPointer(&pointer, &b, &b));
+    naTest(naCompareExchangeAtomicPointer(&pointer, &a, &b));
+    naTestVoid(naStoreAtomicPointer(&pointer, NA_NULL));
+    naTest(pointer == NA_NULL);
+  }
+}
+
+
+
+void testNAThreadingThreadPool(){
+  NAThreadPool* pool = naNewThreadPool(4);
+
+  naTestGroup("Pool"){
+    naTest(naGetSystemProcessorCount() >= 1);
+    naTest(naGetThreadPoolWorkerCount(pool) == 4);
+  }
+
+  naTestGroup("Task groups"){
+    NATaskGroup group;
+    NAInt count = 0;
+    naInitTaskGroup(&group, pool);
+    for(int i = 0; i < 1000; ++i){
+      naAddTask(&group, na_TestThreadingAddAtomic, &count);
+    }
+    naWaitTaskGroup(&group);
+    naTest(count == 1000);
+    naTestVoid(naAddTask(&group, na_TestThreadingAddAtomic, &count));
+    naTestVoid(naClearTaskGroup(&group));
+    naTest(count == 1001);
+  }
+
+  naTestGroup("Nested task groups"){
+    NATaskGroup group;
+    NATestThreadingNested nested;
+    naInitTaskGroup(&group, pool);
+    nested.group = &group;
+    nested.count = 0;
+    for(int i = 0; i < 100; ++i){
+      naAddTask(&group, na_TestThreadingNestedOuter, &nested);
+    }
+    naClearTaskGroup(&group);
+    naTest(nested.count == 1000);
+  }
+
+  naTestGroup("Parallel for"){
+    uint32 values[10000];
+    NABool allCorrect = NA_TRUE;
+    for(size_t i = 0; i < 10000; ++i){values[i] = 1;}
+    naTestVoid(naRunParallelFor(pool, 10000, 0, na_TestThreadingParallelFor, values));
+    naTestVoid(naRunParallelFor(pool, 0, 0, na_TestThreadingParallelFor, values));
+    for(size_t i = 0; i < 10000; ++i){
+      if(values[i] != (uint32)i + 1){allCorrect = NA_FALSE;}
+    }
+    naTest(allCorrect);
+    naTestVoid(naRunParallelFor(pool, 3, 100, na_TestThreadingParallelFor, values));
+    naTest(values[0] == 1 && values[1] == 3 && values[2] == 5);
+  }
+
+  naDelete(pool);
+}
+
+
+
+void testNAThreading(){
+  naTestGroupFunction(NAThreadingThreads);
+  naTestGroupFunction(NAThreadingMutex);
+  naTestGroupFunction(NAThreadingAlarm);
+  naTestGroupFunction(NAThreadingAtomics);
+  naTestGroupFunction(NAThreadingThreadPool);
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
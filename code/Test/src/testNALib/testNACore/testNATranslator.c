@@ -0,0 +1,165 @@
+#include "NATesting.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "NATranslator.h"
+
+
+
+#define NA_TEST_TRANSLATOR_NOT_FOUND "String not found"
+
+NABool na_TestTranslation(NAInt group, NAInt id, const NAUTF8Char* expected){
+  return !strcmp(naTranslate(group, id), expected);
+}
+
+
+
+void testTranslatorPreference(){
+  naStartTranslator();
+  NAInt group = naRegisterTranslatorGroup();
+  naSwitchTranslatorInsertionLanguage(NA_LANG_ENG);
+  naInsertTranslatorString(0, "Hello World");
+  naInsertTranslatorString(1, "Bread crumbs");
+  naSwitchTranslatorInsertionLanguage(NA_LANG_DEU);
+  naInsertTranslatorString(0, "Hallo Welt");
+
+  naTestGroup("Lookup in the preferred language"){
+    naSetTranslatorLanguagePreference(NA_LANG_ENG);
+    naTest(na_TestTranslation(group, 0, "Hello World"));
+    naTest(na_TestTranslation(group, 1, "Bread crumbs"));
+  }
+
+  naTestGroup("Switching the preference after a lookup"){
+    naSetTranslatorLanguagePreference(NA_LANG_DEU);
+    naTest(na_TestTranslation(group, 0, "Hallo Welt"));
+    naTest(na_TestTranslation(group, 1, "Bread crumbs"));
+    naSetTranslatorLanguagePreference(NA_LANG_ENG);
+    naTest(na_TestTranslation(group, 0, "Hello World"));
+    naSetTranslatorLanguagePreference(NA_LANG_ENG);
+    naTest(na_TestTranslation(group, 0, "Hello World"));
+  }
+
+  naStopTranslator();
+}
+
+
+
+void testTranslatorInsertion(){
+  naStartTranslator();
+  NAInt group = naRegisterTranslatorGroup();
+  naSetTranslatorLanguagePreference(NA_LANG_ENG);
+  naSwitchTranslatorInsertionLanguage(NA_LANG_ENG);
+  naInsertTranslatorString(0, "Hello World");
+
+  naTestGroup("Inserting after a lookup"){
+    naTest(na_TestTranslation(group, 0, "Hello World"));
+    naTest(na_TestTranslation(group, 1, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naInsertTranslatorString(1, "Bread crumbs");
+    naTest(na_TestTranslation(group, 1, "Bread crumbs"));
+    naInsertTranslatorString(0, "Hi World");
+    naTest(na_TestTranslation(group, 0, "Hi World"));
+  }
+
+  naTestGroup("Registering a group after a lookup"){
+    NAInt secondGroup = naRegisterTranslatorGroup();
+    naInsertTranslatorString(0, "Beaver spit");
+    naTest(na_TestTranslation(secondGroup, 0, "Beaver spit"));
+    naTest(na_TestTranslation(group, 0, "Hi World"));
+  }
+
+  naStopTranslator();
+}
+
+
+
+void testTranslatorIds(){
+  naStartTranslator();
+  naSetTranslatorLanguagePreference(NA_LANG_ENG);
+  naSwitchTranslatorInsertionLanguage(NA_LANG_ENG);
+
+  NAInt negativeGroup = naRegisterTranslatorGroup();
+  naInsertTranslatorString(-2, "Minus two");
+  naInsertTranslatorString(-1, "Minus one");
+  naInsertTranslatorString(1, "One");
+
+  NAInt offsetGroup = naRegisterTranslatorGroup();
+  naInsertTranslatorString(0xfffe, "Near the end");
+  naInsertTranslatorString(0xffff, "At the end");
+
+  NAInt sparseGroup = naRegisterTranslatorGroup();
+  naInsertTranslatorString(0, "First");
+  naInsertTranslatorString(0xfffe, "Far away");
+  naInsertTranslatorString(NA_MAX_i, "Largest");
+  naInsertTranslatorString(NA_MIN_i, "Smallest");
+
+  naTestGroup("Negative ids"){
+    naTest(na_TestTranslation(negativeGroup, -2, "Minus two"));
+    naTest(na_TestTranslation(negativeGroup, -1, "Minus one"));
+    naTest(na_TestTranslation(negativeGroup, 0, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naTest(na_TestTranslation(negativeGroup, 1, "One"));
+    naTest(na_TestTranslation(negativeGroup, -3, NA_TEST_TRANSLATOR_NOT_FOUND));
+  }
+
+  naTestGroup("Ids outside of the table"){
+    naTest(na_TestTranslation(negativeGroup, 2, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naTest(na_TestTranslation(negativeGroup, NA_MAX_i, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naTest(na_TestTranslation(negativeGroup, NA_MIN_i, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naTest(na_TestTranslation(offsetGroup, 0xfffe, "Near the end"));
+    naTest(na_TestTranslation(offsetGroup, 0xffff, "At the end"));
+    naTest(na_TestTranslation(offsetGroup, 0, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naTest(na_TestTranslation(offsetGroup, 0xfffd, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naTest(na_TestTranslation(offsetGroup, 0x10000, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naTest(na_TestTranslation(offsetGroup, NA_MIN_i, NA_TEST_TRANSLATOR_NOT_FOUND));
+  }
+
+  naTestGroup("Sparse ids"){
+    naTest(na_TestTranslation(sparseGroup, 0, "First"));
+    naTest(na_TestTranslation(sparseGroup, 0xfffe, "Far away"));
+    naTest(na_TestTranslation(sparseGroup, NA_MAX_i, "Largest"));
+    naTest(na_TestTranslation(sparseGroup, NA_MIN_i, "Smallest"));
+    naTest(na_TestTranslation(sparseGroup, 1, NA_TEST_TRANSLATOR_NOT_FOUND));
+  }
+
+  naTestGroup("Unknown groups"){
+    naTest(na_TestTranslation(-1, 1, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naTest(na_TestTranslation(sparseGroup + 1, 0, NA_TEST_TRANSLATOR_NOT_FOUND));
+    naTest(na_TestTranslation(NA_MAX_i, 0, NA_TEST_TRANSLATOR_NOT_FOUND));
+  }
+
+  naStopTranslator();
+}
+
+
+
+void testNATranslator(){
+  naTestGroupFunction(TranslatorPreference);
+  naTestGroupFunction(TranslatorInsertion);
+  naTestGroupFunction(TranslatorIds);
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
@@ -0,0 +1,137 @@
+#include "NATesting.h"
+#include <stdio.h>
+
+#include "NAVectorAlgebra.h"
+
+
+
+// The results of the benchmarks are accumulated here such that the compiler
+// can not optimize the work away.
+double na_VectorAlgebraBenchmarkSum = 0.;
+
+// Fills the values with fixed pseudo random numbers in [-1, 1) such that
+// every run measures the same data.
+void na_FillVectorAlgebraBenchmarkValues(double* values, size_t count){
+  uint32 seed = 2345;
+  for(size_t i = 0; i < count; i++){
+    seed = seed * 1103515245 + 12345;
+    values[i] = (double)(seed >> 8) / (double)(1 << 23) - 1.;
+  }
+}
+
+// The matrices are made diagonally dominant such that they are invertible.
+void na_FillVectorAlgebraBenchmarkMatrices(double* matrices, size_t count){
+  na_FillVectorAlgebraBenchmarkValues(matrices, count * 16);
+  for(size_t i = 0; i < count; i++){
+    for(size_t d = 0; d < 4; d++){
+      matrices[i * 16 + d * 5] += 4.;
+    }
+  }
+}
+
+void na_BenchmarkMulM44dV4d(const double* matrices, const double* vectors, size_t count){
+  double d[4];
+  for(size_t i = 0; i < count; i++){
+    naMulM44dV4d(d, &matrices[i * 16], &vectors[i * 4]);
+    na_VectorAlgebraBenchmarkSum += d[0];
+  }
+}
+
+void na_BenchmarkMulM44dM44d(const double* matrices, size_t count){
+  double D[16];
+  for(size_t i = 0; i < count; i++){
+    naMulM44dM44d(D, &matrices[i * 16], &matrices[((i + 1) % count) * 16]);
+    na_VectorAlgebraBenchmarkSum += D[5];
+  }
+}
+
+void na_BenchmarkInvM44d(const double* matrices, size_t count){
+  double D[16];
+  for(size_t i = 0; i < count; i++){
+    naInvM44d(D, &matrices[i * 16]);
+    na_VectorAlgebraBenchmarkSum += D[10];
+  }
+}
+
+void na_BenchmarkMulM33dV3d(const double* matrices, const double* vectors, size_t count){
+  double d[3];
+  for(size_t i = 0; i < count; i++){
+    naMulM33dV3d(d, &matrices[i * 16], &vectors[i * 4]);
+    na_VectorAlgebraBenchmarkSum += d[1];
+  }
+}
+
+void na_BenchmarkCrossV3d(const double* vectors, size_t count){
+  double d[3];
+  for(size_t i = 0; i < count; i++){
+    naCrossV3d(d, &vectors[i * 4], &vectors[((i + 1) % count) * 4]);
+    na_VectorAlgebraBenchmarkSum += d[2];
+  }
+}
+
+void na_BenchmarkDotV3d(const double* vectors, size_t count){
+  for(size_t i = 0; i < count; i++){
+    na_VectorAlgebraBenchmarkSum += naDotV3d(&vectors[i * 4], &vectors[((i + 1) % count) * 4]);
+  }
+}
+
+void na_BenchmarkNormalizeV3d(const double* vectors, size_t count){
+  double d[3];
+  for(size_t i = 0; i < count; i++){
+    na_VectorAlgebraBenchmarkSum += naNormalizeV3d(d, &vectors[i * 4]);
+  }
+}
+
+void na_BenchmarkVectorAlgebraSize(size_t count){
+  double* matrices = naMalloc(count * 16 * sizeof(double));
+  double* vectors = naMalloc(count * 4 * sizeof(double));
+  na_FillVectorAlgebraBenchmarkMatrices(matrices, count);
+  na_FillVectorAlgebraBenchmarkValues(vectors, count * 4);
+
+  naBenchmark(na_BenchmarkMulM44dV4d(matrices, vectors, count));
+  naBenchmark(na_BenchmarkMulM44dM44d(matrices, count));
+  naBenchmark(na_BenchmarkInvM44d(matrices, count));
+  naBenchmark(na_BenchmarkMulM33dV3d(matrices, vectors, count));
+  naBenchmark(na_BenchmarkCrossV3d(vectors, count));
+  naBenchmark(na_BenchmarkDotV3d(vectors, count));
+  naBenchmark(na_BenchmarkNormalizeV3d(vectors, count));
+
+  naFree(vectors);
+  naFree(matrices);
+}
+
+
+
+void benchmarkNAVectorAlgebra(){
+  printf(NA_NL "NAVectorAlgebra:" NA_NL);
+  naTestGroup("100"){na_BenchmarkVectorAlgebraSize(100);}
+  naTestGroup("10000"){na_BenchmarkVectorAlgebraSize(10000);}
+  naTestGroup("1000000"){na_BenchmarkVectorAlgebraSize(1000000);}
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
@@ -9,9 +9,17 @@ void printNABuffer(void);
 void printNAStack(void);
 
 void testNABuffer(void);
+void testNACircularBuffer(void);
 void testNAStack(void);
+void testNAString(void);
 
+void benchmarkNAArray(void);
+void benchmarkNABuffer(void);
+void benchmarkNAHeap(void);
+void benchmarkNAList(void);
 void benchmarkNAStack(void);
+void benchmarkNAString(void);
+void benchmarkNATree(void);
 
 void printNAStruct(){
   printNABuffer();
@@ -20,11 +28,19 @@ void printNAStruct(){
 
 void testNAStruct(){
   naTestGroupFunction(NABuffer);
+  naTestGroupFunction(NACircularBuffer);
   naTestGroupFunction(NAStack);
+  naTestGroupFunction(NAString);
 }
 
 void benchmarkNAStruct(){
-  benchmarkNAStack();
+  naBenchmarkGroupFunction(NAArray);
+  naBenchmarkGroupFunction(NAList);
+  naBenchmarkGroupFunction(NAStack);
+  naBenchmarkGroupFunction(NAHeap);
+  naBenchmarkGroupFunction(NATree);
+  naBenchmarkGroupFunction(NABuffer);
+  naBenchmarkGroupFunction(NAString);
 }
 
 // This is free and unencumbered software released into the public domain.
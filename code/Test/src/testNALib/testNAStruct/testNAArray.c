@@ -0,0 +1,99 @@
+
+#include "NATesting.h"
+#include <stdio.h>
+
+#include "NAArray.h"
+
+
+
+// The results of the benchmarks are accumulated here such that the compiler
+// can not optimize the work away.
+uint32 na_ArrayBenchmarkSum = 0;
+
+// Fills the values with fixed pseudo random numbers such that every run
+// measures the same data.
+void na_FillArrayBenchmarkValues(uint32* values, size_t count){
+  uint32 seed = 1234;
+  for(size_t i = 0; i < count; i++){
+    seed = seed * 1103515245 + 12345;
+    values[i] = seed >> 8;
+  }
+}
+
+void na_BenchmarkArrayInit(const uint32* values, size_t count){
+  NAArray array;
+  naInitArrayWithCount(&array, sizeof(uint32), count);
+  naCopyn(naGetArrayPointerMutable(&array), values, count * sizeof(uint32));
+  na_ArrayBenchmarkSum += *(const uint32*)naGetArrayElementConst(&array, count / 2);
+  naClearArray(&array);
+}
+
+void na_BenchmarkArrayIterate(const NAArray* array){
+  NAArrayIterator iter = naMakeArrayAccessor(array);
+  while(naIterateArray(&iter, 1)){
+    na_ArrayBenchmarkSum += *(const uint32*)naGetArrayCurConst(&iter);
+  }
+  naClearArrayIterator(&iter);
+}
+
+void na_BenchmarkArrayIndex(const NAArray* array, const uint32* values){
+  size_t count = naGetArrayCount(array);
+  for(size_t i = 0; i < count; i++){
+    na_ArrayBenchmarkSum += *(const uint32*)naGetArrayElementConst(array, values[i] % count);
+  }
+}
+
+void na_AccumulateArrayBenchmarkValue(const void* value){
+  na_ArrayBenchmarkSum += *(const uint32*)value;
+}
+
+void na_BenchmarkArraySize(size_t count){
+  uint32* values = naMalloc(count * sizeof(uint32));
+  na_FillArrayBenchmarkValues(values, count);
+  NAArray array;
+  naInitArrayWithDataConst(&array, values, sizeof(uint32), count);
+
+  naBenchmark(na_BenchmarkArrayInit(values, count));
+  naBenchmark(na_BenchmarkArrayIterate(&array));
+  naBenchmark(na_BenchmarkArrayIndex(&array, values));
+  naBenchmark(naForeachArrayConst(&array, na_AccumulateArrayBenchmarkValue));
+
+  naClearArray(&array);
+  naFree(values);
+}
+
+
+
+void benchmarkNAArray(){
+  printf(NA_NL "NAArray:" NA_NL);
+  naTestGroup("100"){na_BenchmarkArraySize(100);}
+  naTestGroup("10000"){na_BenchmarkArraySize(10000);}
+  naTestGroup("1000000"){na_BenchmarkArraySize(1000000);}
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
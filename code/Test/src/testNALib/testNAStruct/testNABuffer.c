@@ -1,8 +1,10 @@
 
 #include "NATesting.h"
+#include <string.h>
 #include <stdio.h>
 
 #include "NABuffer.h"
+#include "NAFile.h"
 
 
 void testMemoryBlock(){
@@ -29,6 +31,16 @@ void testMemoryBlock(){
     naTestCrash(block = na_NewMemoryBlockWithData(constPtr, sizeof(int), naFree); naRelease(block));
   }
 
+  naTestGroup("New and release with owner"){
+    NAPtr mutablePtr = naMakePtrWithDataMutable(naAlloc(int));
+    NAMemoryBlock* block = NA_NULL;
+    naTestVoid(block = na_NewMemoryBlockWithOwner(mutablePtr, sizeof(int), naGetPtrMutable(mutablePtr), naFree));
+    naTest(na_GetMemoryBlockDataPointerConst(block, 0) == naGetPtrConst(mutablePtr));
+    naTestVoid(naRelease(block));
+
+    naTestError(block = na_NewMemoryBlockWithOwner(mutablePtr, sizeof(int), NA_NULL, NA_NULL); naRelease(block));
+  }
+
   naTestGroup("Accessing and Mutating"){
     NAPtr mutablePtr = naMakePtrWithDataMutable(naAlloc(int));
     NAMemoryBlock* block = na_NewMemoryBlockWithData(mutablePtr, sizeof(int), naFree);
@@ -131,6 +143,22 @@ void testBufferSource(){
     naTestCrash(na_GetBufferSourceLimit(NA_NULL));
   }
 
+  naTestGroup("Memory block"){
+    NAByte dataConst[] = {0, 1, 2, 3};
+    NAMemoryBlock* block = na_NewMemoryBlockWithData(naMakePtrWithDataConst(dataConst), 4, NA_NULL);
+    NABufferSource* source = naNewBufferSource(NA_NULL, NA_NULL);
+    naTest(!na_HasBufferSourceMemoryBlock(source));
+    naTestVoid(na_SetBufferSourceMemoryBlock(source, block));
+    naTest(na_HasBufferSourceMemoryBlock(source));
+    naTest(na_GetBufferSourceMemoryBlock(source) == block);
+    naTestError(na_SetBufferSourceMemoryBlock(source, block));
+    naRelease(source);
+    naRelease(block);
+
+    naTestCrash(na_HasBufferSourceMemoryBlock(NA_NULL));
+    naTestCrash(na_GetBufferSourceMemoryBlock(NA_NULL));
+  }
+
   naTestGroup("Filling data"){
     NAByte buf[10];
 
@@ -273,6 +301,394 @@ void testBufferPart(){
 
 
 
+#define NA_TEST_BUFFER_FILE_PATH "NABufferTestFile.bin"
+#define NA_TEST_BUFFER_FILE_PATH2 "NABufferTestFile2.bin"
+#define NA_TEST_BUFFER_FILE_VALUE_COUNT 100000
+
+void testBufferFile(){
+  uint32* values = naMalloc(NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32));
+  for(uint32 i = 0; i < NA_TEST_BUFFER_FILE_VALUE_COUNT; ++i){values[i] = i;}
+  NAFile* file = naCreateFileWritingPath(NA_TEST_BUFFER_FILE_PATH, NA_FILEMODE_DEFAULT);
+  naWriteFileBytes(file, values, NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32));
+  naReleaseFile(file);
+
+  naTestGroup("Reading at offsets"){
+    uint32 value = 0;
+    file = naCreateFileReadingPath(NA_TEST_BUFFER_FILE_PATH);
+    naTest(naReadFileBytesAt(file, &value, 4000 * sizeof(uint32), sizeof(uint32)) == sizeof(uint32));
+    naTest(value == 4000);
+    naTest(naReadFileBytesAt(file, &value, 12 * sizeof(uint32), sizeof(uint32)) == sizeof(uint32));
+    naTest(value == 12);
+    naTest(naReadFileBytesAt(file, &value, (NA_TEST_BUFFER_FILE_VALUE_COUNT - 1) * sizeof(uint32), 2 * sizeof(uint32)) == sizeof(uint32));
+    naTest(value == NA_TEST_BUFFER_FILE_VALUE_COUNT - 1);
+    #if NA_OS != NA_OS_WINDOWS
+      naTest(naTell(file->desc) == 0);
+    #endif
+    naReleaseFile(file);
+  }
+
+  naTestGroup("Mapping"){
+    file = naCreateFileReadingPath(NA_TEST_BUFFER_FILE_PATH);
+    uint32* mapped = naMapFileBytes(file, NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32));
+    naReleaseFile(file);
+    naTest(mapped != NA_NULL);
+    naTest(mapped[54321] == 54321);
+    // The mapping is private, changes do not go to the file.
+    mapped[0] = 42;
+    naTestVoid(naUnmapFileBytes(mapped, NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32)));
+  }
+
+  naTestGroup("Random access buffer"){
+    NABuffer* buffer = naNewBufferWithInputPath(NA_TEST_BUFFER_FILE_PATH);
+    naTest(naGetBufferRange(buffer).length == NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32));
+
+    NABufferIterator iter = naMakeBufferAccessor(buffer);
+    naTest(naLocateBufferAbsolute(&iter, 90000 * sizeof(uint32)));
+    naTest(naReadBufferu32(&iter) == 90000);
+    naTest(naLocateBufferAbsolute(&iter, 7 * sizeof(uint32)));
+    naTest(naReadBufferu32(&iter) == 7);
+    naTest(naReadBufferu32(&iter) == 8);
+    naTest(naLocateBufferAbsolute(&iter, 0));
+    naTest(naReadBufferu32(&iter) == 0);
+    naClearBufferIterator(&iter);
+
+    NABool allCorrect = NA_TRUE;
+    iter = naMakeBufferAccessor(buffer);
+    for(uint32 i = 0; i < NA_TEST_BUFFER_FILE_VALUE_COUNT; ++i){
+      if(naReadBufferu32(&iter) != i){allCorrect = NA_FALSE;}
+    }
+    naTest(allCorrect);
+    naClearBufferIterator(&iter);
+    naRelease(buffer);
+  }
+
+  naTestGroup("Random access buffer without mapping"){
+    // The file is read through the cache buffer as if it could not be
+    // mapped.
+    NABuffer* buffer = na_NewBufferWithInputPath(NA_TEST_BUFFER_FILE_PATH, NA_FALSE);
+    naTest(naGetBufferRange(buffer).length == NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32));
+
+    NABufferIterator iter = naMakeBufferAccessor(buffer);
+    naTest(naLocateBufferAbsolute(&iter, 90000 * sizeof(uint32)));
+    naTest(naReadBufferu32(&iter) == 90000);
+    naTest(naLocateBufferAbsolute(&iter, 7 * sizeof(uint32)));
+    naTest(naReadBufferu32(&iter) == 7);
+    naTest(naReadBufferu32(&iter) == 8);
+    naTest(naLocateBufferAbsolute(&iter, 89990 * sizeof(uint32)));
+    naTest(naReadBufferu32(&iter) == 89990);
+    naClearBufferIterator(&iter);
+
+    // Values straddling the boundary between two parts. The second part is
+    // not read yet when the first one is.
+    NAInt partSize = (NAInt)naGetRuntimeMemoryPageSize();
+    uint32 value;
+    iter = naMakeBufferAccessor(buffer);
+    naTest(naLocateBufferAbsolute(&iter, 3 * partSize - 2));
+    naTestVoid(value = naReadBufferu32(&iter));
+    naTest(!memcmp(&value, (NAByte*)values + 3 * partSize - 2, sizeof(uint32)));
+    naTest(naLocateBufferAbsolute(&iter, 5 * partSize - 1));
+    naTestVoid(value = naReadBufferu32(&iter));
+    naTest(!memcmp(&value, (NAByte*)values + 5 * partSize - 1, sizeof(uint32)));
+
+    // Bytes spanning several parts, starting in the middle of one.
+    size_t byteCount = (size_t)(3 * partSize + 100);
+    NAByte* bytes = naMalloc(byteCount);
+    naTest(naLocateBufferAbsolute(&iter, 7 * partSize + 50));
+    naTestVoid(naReadBufferBytes(&iter, bytes, byteCount));
+    naTest(!memcmp(bytes, (NAByte*)values + 7 * partSize + 50, byteCount));
+    naFree(bytes);
+    naClearBufferIterator(&iter);
+
+    NABool allCorrect = NA_TRUE;
+    iter = naMakeBufferAccessor(buffer);
+    for(uint32 i = 0; i < NA_TEST_BUFFER_FILE_VALUE_COUNT; ++i){
+      if(naReadBufferu32(&iter) != i){allCorrect = NA_FALSE;}
+    }
+    naTest(allCorrect);
+    naClearBufferIterator(&iter);
+    naRelease(buffer);
+  }
+
+  // Writing a buffer in small pieces creates many parts.
+  NABuffer* memBuffer = naNewBuffer(NA_FALSE);
+  NABufferIterator memIter = naMakeBufferModifier(memBuffer);
+  for(uint32 i = 0; i < NA_TEST_BUFFER_FILE_VALUE_COUNT; i += 1000){
+    naWriteBufferBytes(&memIter, &values[i], 1000 * sizeof(uint32));
+  }
+  naClearBufferIterator(&memIter);
+  naFixBufferRange(memBuffer);
+
+  naTestGroup("Spans"){
+    NABuffer* buffer = memBuffer;
+    NARangei range = naMakeRangei(10, 100000);
+    size_t spanCount = naGetBufferSpans(buffer, range, NA_NULL, 0);
+    naTest(spanCount > 1);
+
+    NAByteSpan* spans = naMalloc(spanCount * sizeof(NAByteSpan));
+    naTest(naGetBufferSpans(buffer, range, spans, spanCount) == spanCount);
+    size_t totalSize = 0;
+    for(size_t i = 0; i < spanCount; ++i){totalSize += spans[i].byteSize;}
+    naTest(totalSize == 100000);
+    naTest(!memcmp(spans[0].data, (NAByte*)values + 10, spans[0].byteSize));
+    naTest(!memcmp(spans[spanCount - 1].data, (NAByte*)values + 100010 - spans[spanCount - 1].byteSize, spans[spanCount - 1].byteSize));
+    naTest(naGetBufferSpans(buffer, range, spans, 1) == spanCount);
+    naTest(naGetBufferSpans(buffer, naMakeRangeiE(10, 0), spans, 1) == 0);
+    naFree(spans);
+  }
+
+  naTestGroup("Writing spans"){
+    NAByteSpan spans[4];
+    spans[0].data = &values[3];
+    spans[0].byteSize = sizeof(uint32);
+    spans[1].data = values;
+    spans[1].byteSize = 0;
+    spans[2].data = &values[1];
+    spans[2].byteSize = 2 * sizeof(uint32);
+    spans[3].data = &values[7];
+    spans[3].byteSize = sizeof(uint32);
+    file = naCreateFileWritingPath(NA_TEST_BUFFER_FILE_PATH2, NA_FILEMODE_DEFAULT);
+    naTest(naWriteFileByteSpans(file, spans, 4) == 4 * sizeof(uint32));
+    naTest(naWriteFileByteSpans(file, spans, 0) == 0);
+    naReleaseFile(file);
+
+    uint32 readValues[5];
+    file = naCreateFileReadingPath(NA_TEST_BUFFER_FILE_PATH2);
+    naTest(naReadFileBytesAt(file, readValues, 0, sizeof(readValues)) == 4 * sizeof(uint32));
+    naTest(readValues[0] == 3 && readValues[1] == 1 && readValues[2] == 2 && readValues[3] == 7);
+    naReleaseFile(file);
+  }
+
+  naTestGroup("Writing more spans than one system call takes"){
+    size_t spanCount = 5000;
+    NAByteSpan* spans = naMalloc(spanCount * sizeof(NAByteSpan));
+    for(size_t i = 0; i < spanCount; ++i){
+      spans[i].data = &values[spanCount - 1 - i];
+      spans[i].byteSize = sizeof(uint32);
+    }
+    file = naCreateFileWritingPath(NA_TEST_BUFFER_FILE_PATH2, NA_FILEMODE_DEFAULT);
+    naTest(naWriteFileByteSpans(file, spans, spanCount) == (NAFileSize)(spanCount * sizeof(uint32)));
+    naReleaseFile(file);
+    naFree(spans);
+
+    uint32* readValues = naMalloc(spanCount * sizeof(uint32));
+    file = naCreateFileReadingPath(NA_TEST_BUFFER_FILE_PATH2);
+    naTest(naReadFileBytesAt(file, readValues, 0, spanCount * sizeof(uint32)) == (NAFileSize)(spanCount * sizeof(uint32)));
+    NABool allCorrect = NA_TRUE;
+    for(size_t i = 0; i < spanCount; ++i){
+      if(readValues[i] != spanCount - 1 - i){allCorrect = NA_FALSE;}
+    }
+    naTest(allCorrect);
+    naFree(readValues);
+    naReleaseFile(file);
+  }
+
+  naTestGroup("Writing buffer to file"){
+    // The parts get written in batches.
+    file = naCreateFileWritingPath(NA_TEST_BUFFER_FILE_PATH2, NA_FILEMODE_DEFAULT);
+    naTestVoid(naWriteBufferToFile(memBuffer, file));
+    naReleaseFile(file);
+
+    file = naCreateFileReadingPath(NA_TEST_BUFFER_FILE_PATH2);
+    uint32* readValues = naMalloc(NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32));
+    naTest(naReadFileBytesAt(file, readValues, 0, NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32)) == NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32));
+    naTest(!memcmp(readValues, values, NA_TEST_BUFFER_FILE_VALUE_COUNT * sizeof(uint32)));
+    naFree(readValues);
+    naReleaseFile(file);
+  }
+
+  naRelease(memBuffer);
+  naRemove(NA_TEST_BUFFER_FILE_PATH2);
+  naRemove(NA_TEST_BUFFER_FILE_PATH);
+  naFree(values);
+}
+
+
+
+#define NA_TEST_BUFFER_PARSE_LINE_COUNT 3000
+
+// Creates a buffer with many parts containing lines with all kinds of line
+// endings and empty lines.
+NABuffer* na_NewTestBufferWithLines(NAUTF8Char** text, size_t* byteSize){
+  const char* endings[] = {"\n", "\r\n", "\r"};
+  NAUTF8Char* str = naMalloc(NA_TEST_BUFFER_PARSE_LINE_COUNT * 32);
+  size_t len = 0;
+  for(int i = 0; i < NA_TEST_BUFFER_PARSE_LINE_COUNT; ++i){
+    if(i % 7 != 3){
+      len += (size_t)sprintf(&str[len], "Line %d with some text", i);
+    }
+    len += (size_t)sprintf(&str[len], "%s", endings[i % 3]);
+  }
+  len += (size_t)sprintf(&str[len], "Last line");
+
+  NABuffer* buffer = naNewBuffer(NA_FALSE);
+  NABufferIterator iter = naMakeBufferModifier(buffer);
+  for(size_t pos = 0; pos < len; pos += 1001){
+    naWriteBufferBytes(&iter, &str[pos], naMins(1001, len - pos));
+  }
+  naClearBufferIterator(&iter);
+  naFixBufferRange(buffer);
+
+  *text = str;
+  *byteSize = len;
+  return buffer;
+}
+
+// Returns the line at pos of the text and moves pos after the line ending.
+size_t na_GetTestLine(const NAUTF8Char* text, size_t byteSize, size_t* pos, const NAUTF8Char** line){
+  size_t start = *pos;
+  size_t end = start;
+  while(end < byteSize && text[end] != '\r' && text[end] != '\n'){end++;}
+  *pos = end;
+  if(*pos < byteSize){
+    (*pos)++;
+    if(text[end] == '\r' && *pos < byteSize && text[*pos] == '\n'){(*pos)++;}
+  }
+  *line = &text[start];
+  return end - start;
+}
+
+void testBufferParse(){
+  NAUTF8Char* text;
+  size_t byteSize;
+  NABuffer* buffer = na_NewTestBufferWithLines(&text, &byteSize);
+
+  // A CR at the end of a line followed by an empty line ending with LF
+  // counts as one CR-LF line ending.
+  size_t expectedLineCount = 0;
+  size_t expectedNonEmptyCount = 0;
+  size_t textPos = 0;
+  while(textPos < byteSize){
+    const NAUTF8Char* line;
+    if(na_GetTestLine(text, byteSize, &textPos, &line)){expectedNonEmptyCount++;}
+    expectedLineCount++;
+  }
+
+  naTestGroup("Parsing lines"){
+    NABool allCorrect = NA_TRUE;
+    size_t lineCount = 0;
+    size_t pos = 0;
+    NABufferIterator iter = naMakeBufferAccessor(buffer);
+    while(!naIsBufferAtEnd(&iter)){
+      const NAUTF8Char* line;
+      size_t lineByteSize = na_GetTestLine(text, byteSize, &pos, &line);
+      NAString* string = naParseBufferLine(&iter, NA_FALSE);
+      if(naGetStringByteSize(string) != lineByteSize
+        || (lineByteSize && memcmp(naGetStringUTF8Pointer(string), line, lineByteSize))){
+        allCorrect = NA_FALSE;
+      }
+      naDelete(string);
+      lineCount++;
+    }
+    naClearBufferIterator(&iter);
+    naTest(allCorrect);
+    naTest(lineCount == expectedLineCount);
+  }
+
+  naTestGroup("Parsing lines skipping empty ones"){
+    size_t lineCount = 0;
+    NABool allCorrect = NA_TRUE;
+    NABufferIterator iter = naMakeBufferAccessor(buffer);
+    while(!naIsBufferAtEnd(&iter)){
+      NAString* string = naParseBufferLine(&iter, NA_TRUE);
+      if(!naIsBufferAtEnd(&iter) && naGetStringByteSize(string) == 0){allCorrect = NA_FALSE;}
+      if(naGetStringByteSize(string)){lineCount++;}
+      naDelete(string);
+    }
+    naClearBufferIterator(&iter);
+    naTest(allCorrect);
+    naTest(lineCount == expectedNonEmptyCount);
+  }
+
+  naTestGroup("Line iterator"){
+    NABool allCorrect = NA_TRUE;
+    size_t lineCount = 0;
+    size_t pos = 0;
+    NABufferLineIterator lineIter = naMakeBufferLineIterator(buffer);
+    while(naIterateBufferLine(&lineIter, NA_FALSE)){
+      const NAUTF8Char* line;
+      size_t lineByteSize = na_GetTestLine(text, byteSize, &pos, &line);
+      if(naGetBufferLineByteSize(&lineIter) != lineByteSize
+        || (lineByteSize && memcmp(naGetBufferLineUTF8Pointer(&lineIter), line, lineByteSize))){
+        allCorrect = NA_FALSE;
+      }
+      lineCount++;
+    }
+    naTest(allCorrect);
+    naTest(lineCount == expectedLineCount);
+    naTest(!naIterateBufferLine(&lineIter, NA_FALSE));
+    naTest(naGetBufferLineUTF8Pointer(&lineIter) == NA_NULL);
+    naClearBufferLineIterator(&lineIter);
+
+    lineCount = 0;
+    lineIter = naMakeBufferLineIterator(buffer);
+    while(naIterateBufferLine(&lineIter, NA_TRUE)){
+      if(naGetBufferLineByteSize(&lineIter) == 0){allCorrect = NA_FALSE;}
+      lineCount++;
+    }
+    naClearBufferLineIterator(&lineIter);
+    naTest(allCorrect);
+    naTest(lineCount == expectedNonEmptyCount);
+  }
+
+  naTestGroup("Line iterator on single part"){
+    NABuffer* constBuffer = naNewBufferWithConstData("a\r\n\nbc\r", 7);
+    NABufferLineIterator lineIter = naMakeBufferLineIterator(constBuffer);
+    naTest(naIterateBufferLine(&lineIter, NA_TRUE));
+    naTest(naGetBufferLineByteSize(&lineIter) == 1 && naGetBufferLineUTF8Pointer(&lineIter)[0] == 'a');
+    naTest(naIterateBufferLine(&lineIter, NA_TRUE));
+    naTest(naGetBufferLineByteSize(&lineIter) == 2 && naGetBufferLineUTF8Pointer(&lineIter)[1] == 'c');
+    naTest(!naIterateBufferLine(&lineIter, NA_TRUE));
+    naClearBufferLineIterator(&lineIter);
+    naRelease(constBuffer);
+  }
+
+  naTestGroup("Tokens and whitespaces"){
+    NABuffer* constBuffer = naNewBufferWithConstData("first   \t\n second\n\n\n/path/to\\file", 33);
+    NABufferIterator iter = naMakeBufferAccessor(constBuffer);
+    NAString* token = naParseBufferToken(&iter);
+    naTest(naGetStringByteSize(token) == 5);
+    naDelete(token);
+    naTest(naGetBufferLocation(&iter) == 11);
+    token = naParseBufferToken(&iter);
+    naTest(naGetStringByteSize(token) == 6);
+    naDelete(token);
+    naTest(naGetBufferLocation(&iter) == 20);
+    naLocateBufferRelative(&iter, 1);
+    token = naParseBufferPathComponent(&iter);
+    naTest(naGetStringByteSize(token) == 4);
+    naDelete(token);
+    naClearBufferIterator(&iter);
+    naRelease(constBuffer);
+  }
+
+  naTestGroup("Searching bytes"){
+    naTest(naSearchBufferByteOffset(buffer, 'L', 0, NA_TRUE) == 0);
+    naTest(naSearchBufferByteOffset(buffer, 'x', 1, NA_TRUE) == (NAInt)(strstr(text, "text") - text) + 2);
+    naTest(naSearchBufferByteOffset(buffer, 'L', (NAInt)byteSize - 1, NA_FALSE) == (NAInt)byteSize - 9);
+    naTest(naSearchBufferByteOffset(buffer, 'L', 5, NA_FALSE) == 0);
+    naTest(naSearchBufferByteOffset(buffer, '#', 0, NA_TRUE) == NA_INVALID_MEMORY_INDEX);
+    naTest(naSearchBufferByteOffset(buffer, '#', (NAInt)byteSize - 1, NA_FALSE) == NA_INVALID_MEMORY_INDEX);
+
+    // Every line of the buffer is found, also in other parts.
+    NABool allCorrect = NA_TRUE;
+    NAInt offset = 0;
+    size_t lineCount = 0;
+    while((offset = naSearchBufferByteOffset(buffer, 'L', offset, NA_TRUE)) != NA_INVALID_MEMORY_INDEX){
+      if(text[offset] != 'L'){allCorrect = NA_FALSE;}
+      lineCount++;
+      offset++;
+      if(offset == (NAInt)byteSize){break;}
+    }
+    naTest(allCorrect);
+    naTest(lineCount == expectedNonEmptyCount);
+  }
+
+  naRelease(buffer);
+  naFree(text);
+}
+
+
+
 void printNABuffer(){
   printf("NABuffer.h:" NA_NL);
 
@@ -288,6 +704,122 @@ void testNABuffer(){
   naTestGroupFunction(MemoryBlock);  
   naTestGroupFunction(BufferSource);  
   naTestGroupFunction(BufferPart);  
+  naTestGroupFunction(BufferFile);
+  naTestGroupFunction(BufferParse);
+}
+
+
+
+// The results of the benchmarks are accumulated here such that the compiler
+// can not optimize the work away.
+size_t na_BufferBenchmarkSum = 0;
+
+// Creates a text of lines with three numbers each. The numbers are the same
+// for every run.
+NABuffer* na_NewBenchmarkBufferWithNumberLines(size_t lineCount){
+  NABuffer* buffer = naNewBuffer(NA_FALSE);
+  NABufferIterator iter = naMakeBufferModifier(buffer);
+  uint32 seed = 5678;
+  for(size_t i = 0; i < lineCount; i++){
+    int32 values[3];
+    for(int c = 0; c < 3; c++){
+      seed = seed * 1103515245 + 12345;
+      values[c] = (int32)(seed >> 12) - 0x40000;
+    }
+    naWriteBufferStringWithFormat(&iter, "%d %d %d\n", values[0], values[1], values[2]);
+  }
+  naClearBufferIterator(&iter);
+  naFixBufferRange(buffer);
+  return buffer;
+}
+
+void na_BenchmarkBufferWrite(const int32* values, size_t count){
+  NABuffer* buffer = naNewBuffer(NA_FALSE);
+  NABufferIterator iter = naMakeBufferModifier(buffer);
+  for(size_t i = 0; i < count; i++){
+    naWriteBufferi32(&iter, values[i]);
+  }
+  naClearBufferIterator(&iter);
+  na_BufferBenchmarkSum += (size_t)naGetBufferRange(buffer).length;
+  naRelease(buffer);
+}
+
+void na_BenchmarkBufferWriteArray(const int32* values, size_t count){
+  NABuffer* buffer = naNewBuffer(NA_FALSE);
+  NABufferIterator iter = naMakeBufferModifier(buffer);
+  naWriteBufferi32v(&iter, values, count);
+  naClearBufferIterator(&iter);
+  na_BufferBenchmarkSum += (size_t)naGetBufferRange(buffer).length;
+  naRelease(buffer);
+}
+
+void na_BenchmarkBufferRead(NABuffer* buffer, size_t count){
+  NABufferIterator iter = naMakeBufferAccessor(buffer);
+  for(size_t i = 0; i < count; i++){
+    na_BufferBenchmarkSum += (size_t)naReadBufferi32(&iter);
+  }
+  naClearBufferIterator(&iter);
+}
+
+void na_BenchmarkBufferParseLines(NABuffer* buffer){
+  NABufferIterator iter = naMakeBufferAccessor(buffer);
+  while(!naIsBufferAtEnd(&iter)){
+    NAString* line = naParseBufferLine(&iter, NA_TRUE);
+    na_BufferBenchmarkSum += naGetStringByteSize(line);
+    naDelete(line);
+  }
+  naClearBufferIterator(&iter);
+}
+
+void na_BenchmarkBufferIterateLines(NABuffer* buffer){
+  NABufferLineIterator lineIter = naMakeBufferLineIterator(buffer);
+  while(naIterateBufferLine(&lineIter, NA_TRUE)){
+    na_BufferBenchmarkSum += naGetBufferLineByteSize(&lineIter);
+  }
+  naClearBufferLineIterator(&lineIter);
+}
+
+void na_BenchmarkBufferParseNumbers(NABuffer* buffer, size_t lineCount){
+  NABufferIterator iter = naMakeBufferAccessor(buffer);
+  for(size_t i = 0; i < lineCount * 3; i++){
+    na_BufferBenchmarkSum += (size_t)naParseBufferi32(&iter, NA_TRUE);
+  }
+  naClearBufferIterator(&iter);
+}
+
+void na_BenchmarkBufferSize(size_t count){
+  int32* values = naMalloc(count * sizeof(int32));
+  uint32 seed = 6789;
+  for(size_t i = 0; i < count; i++){
+    seed = seed * 1103515245 + 12345;
+    values[i] = (int32)seed;
+  }
+  NABuffer* valueBuffer = naNewBuffer(NA_FALSE);
+  NABufferIterator iter = naMakeBufferModifier(valueBuffer);
+  naWriteBufferi32v(&iter, values, count);
+  naClearBufferIterator(&iter);
+  naFixBufferRange(valueBuffer);
+  NABuffer* textBuffer = na_NewBenchmarkBufferWithNumberLines(count);
+
+  naBenchmark(na_BenchmarkBufferWrite(values, count));
+  naBenchmark(na_BenchmarkBufferWriteArray(values, count));
+  naBenchmark(na_BenchmarkBufferRead(valueBuffer, count));
+  naBenchmark(na_BenchmarkBufferParseLines(textBuffer));
+  naBenchmark(na_BenchmarkBufferIterateLines(textBuffer));
+  naBenchmark(na_BenchmarkBufferParseNumbers(textBuffer, count));
+
+  naRelease(textBuffer);
+  naRelease(valueBuffer);
+  naFree(values);
+}
+
+
+
+void benchmarkNABuffer(){
+  printf(NA_NL "NABuffer:" NA_NL);
+  naTestGroup("100"){na_BenchmarkBufferSize(100);}
+  naTestGroup("10000"){na_BenchmarkBufferSize(10000);}
+  naTestGroup("100000"){na_BenchmarkBufferSize(100000);}
 }
 
 
@@ -0,0 +1,241 @@
+#include "NATesting.h"
+#include <stdio.h>
+
+#include "NACircularBuffer.h"
+#include "NAThreading.h"
+
+#define NA_TEST_CIRCULAR_BUFFER_ELEMENT_COUNT 100000
+#define NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT 4
+#define NA_TEST_CIRCULAR_BUFFER_BATCH_SIZE 7
+
+
+
+// Elements are stored as pointers to 1 ... elementCount. Whenever a thread
+// can not make progress, it sleeps shortly to let the other threads run on
+// machines with few processors.
+typedef struct NATestCircularBufferThread NATestCircularBufferThread;
+struct NATestCircularBufferThread{
+  void* buffer;
+  size_t elementCount;
+  size_t sum;
+  NABool ordered;
+};
+
+
+
+void na_TestSPSCProducer(void* arg){
+  NATestCircularBufferThread* thread = (NATestCircularBufferThread*)arg;
+  size_t i = 1;
+  while(i <= thread->elementCount){
+    size_t pushedCount;
+    if(i % 3){
+      pushedCount = naPushSPSCCircularBuffer(thread->buffer, (void*)i) ? 1 : 0;
+    }else{
+      void* batch[NA_TEST_CIRCULAR_BUFFER_BATCH_SIZE];
+      size_t batchCount = 0;
+      while(batchCount < NA_TEST_CIRCULAR_BUFFER_BATCH_SIZE && i + batchCount <= thread->elementCount){
+        batch[batchCount] = (void*)(i + batchCount);
+        batchCount++;
+      }
+      pushedCount = naPushSPSCCircularBufferBatch(thread->buffer, batch, batchCount);
+    }
+    if(!pushedCount){naSleepU(1);}
+    i += pushedCount;
+  }
+}
+
+
+
+void na_TestSPSCConsumer(NATestCircularBufferThread* thread){
+  size_t expected = 1;
+  thread->ordered = NA_TRUE;
+  while(expected <= thread->elementCount){
+    void* batch[NA_TEST_CIRCULAR_BUFFER_BATCH_SIZE];
+    size_t count = naPullSPSCCircularBufferBatch(thread->buffer, batch, (expected % 2) ? 1 : NA_TEST_CIRCULAR_BUFFER_BATCH_SIZE);
+    if(!count){naSleepU(1);}
+    for(size_t i = 0; i < count; ++i){
+      if((size_t)batch[i] != expected){thread->ordered = NA_FALSE;}
+      expected++;
+    }
+  }
+}
+
+
+
+void na_TestMPMCProducer(void* arg){
+  NATestCircularBufferThread* thread = (NATestCircularBufferThread*)arg;
+  size_t i = 1;
+  while(i <= thread->elementCount){
+    void* batch[NA_TEST_CIRCULAR_BUFFER_BATCH_SIZE];
+    size_t batchCount = 0;
+    while(batchCount < NA_TEST_CIRCULAR_BUFFER_BATCH_SIZE && i + batchCount <= thread->elementCount){
+      batch[batchCount] = (void*)(i + batchCount);
+      batchCount++;
+    }
+    size_t pushedCount = naPushMPMCCircularBufferBatch(thread->buffer, batch, batchCount);
+    if(!pushedCount){naSleepU(1);}
+    i += pushedCount;
+  }
+}
+
+
+
+void na_TestMPMCConsumer(void* arg){
+  NATestCircularBufferThread* thread = (NATestCircularBufferThread*)arg;
+  size_t pulledCount = 0;
+  thread->sum = 0;
+  while(pulledCount < thread->elementCount){
+    void* data;
+    if(naPullMPMCCircularBuffer(thread->buffer, &data)){
+      thread->sum += (size_t)data;
+      pulledCount++;
+    }else{
+      naSleepU(1);
+    }
+  }
+}
+
+
+
+void testNACircularBufferSingle(){
+  naTestGroup("Push and pull"){
+    NACircularBuffer buffer;
+    int values[3];
+    naInitCircularBuffer(&buffer, 3);
+    naTest(naIsCircularBufferEmpty(&buffer));
+    naPushCircularBuffer(&buffer, &values[0]);
+    naPushCircularBuffer(&buffer, &values[1]);
+    naTest(naGetCircularBufferCount(&buffer) == 2);
+    naTest(naPullCircularBuffer(&buffer) == &values[0]);
+    naPushCircularBuffer(&buffer, &values[2]);
+    naPushCircularBuffer(&buffer, &values[0]);
+    naTest(naIsCircularBufferFull(&buffer));
+    naTestError(naPushCircularBuffer(&buffer, &values[0]));
+    naTest(naPullCircularBuffer(&buffer) == &values[1]);
+    naTest(naPullCircularBuffer(&buffer) == &values[2]);
+    naTest(naPullCircularBuffer(&buffer) == &values[0]);
+    naTest(naIsCircularBufferEmpty(&buffer));
+    naClearCircularBuffer(&buffer);
+  }
+}
+
+
+
+void testNACircularBufferSPSC(){
+  naTestGroup("Full and empty"){
+    NASPSCCircularBuffer buffer;
+    void* data = NA_NULL;
+    void* batch[5] = {(void*)1, (void*)2, (void*)3, (void*)4, (void*)5};
+    naInitSPSCCircularBuffer(&buffer, 3);
+    naTest(!naPullSPSCCircularBuffer(&buffer, &data));
+    naTest(data == NA_NULL);
+    naTest(naPushSPSCCircularBufferBatch(&buffer, batch, 5) == 4);
+    naTest(!naPushSPSCCircularBuffer(&buffer, batch[4]));
+    naTest(naPullSPSCCircularBuffer(&buffer, &data) && data == (void*)1);
+    naTest(naPushSPSCCircularBuffer(&buffer, batch[4]));
+    naTest(naPullSPSCCircularBufferBatch(&buffer, batch, 5) == 4);
+    naTest(batch[0] == (void*)2 && batch[3] == (void*)5);
+    naTest(naPullSPSCCircularBufferBatch(&buffer, batch, 5) == 0);
+    naClearSPSCCircularBuffer(&buffer);
+  }
+
+  naTestGroup("Two threads"){
+    NASPSCCircularBuffer buffer;
+    NATestCircularBufferThread thread;
+    NAThread producer;
+    naInitSPSCCircularBuffer(&buffer, 64);
+    thread.buffer = &buffer;
+    thread.elementCount = NA_TEST_CIRCULAR_BUFFER_ELEMENT_COUNT;
+    producer = naMakeThread("NATest SPSC Producer", na_TestSPSCProducer, &thread);
+    naRunThread(producer);
+    na_TestSPSCConsumer(&thread);
+    naJoinThread(producer);
+    naClearThread(producer);
+    naTest(thread.ordered);
+    naClearSPSCCircularBuffer(&buffer);
+  }
+}
+
+
+
+void testNACircularBufferMPMC(){
+  naTestGroup("Full and empty"){
+    NAMPMCCircularBuffer buffer;
+    void* data = NA_NULL;
+    void* batch[5] = {(void*)1, (void*)2, (void*)3, (void*)4, (void*)5};
+    naInitMPMCCircularBuffer(&buffer, 4);
+    naTest(!naPullMPMCCircularBuffer(&buffer, &data));
+    naTest(naPushMPMCCircularBufferBatch(&buffer, batch, 5) == 4);
+    naTest(!naPushMPMCCircularBuffer(&buffer, batch[4]));
+    naTest(naPullMPMCCircularBuffer(&buffer, &data) && data == (void*)1);
+    naTest(naPushMPMCCircularBuffer(&buffer, batch[4]));
+    naTest(naPullMPMCCircularBufferBatch(&buffer, batch, 5) == 4);
+    naTest(batch[0] == (void*)2 && batch[3] == (void*)5);
+    naClearMPMCCircularBuffer(&buffer);
+  }
+
+  naTestGroup("Multiple threads"){
+    NAMPMCCircularBuffer buffer;
+    NATestCircularBufferThread producers[NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT];
+    NATestCircularBufferThread consumers[NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT];
+    NAThread threads[2 * NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT];
+    size_t elementCount = NA_TEST_CIRCULAR_BUFFER_ELEMENT_COUNT / NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT;
+    size_t sum = 0;
+    naInitMPMCCircularBuffer(&buffer, 64);
+    for(int i = 0; i < NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT; ++i){
+      producers[i].buffer = &buffer;
+      producers[i].elementCount = elementCount;
+      consumers[i].buffer = &buffer;
+      consumers[i].elementCount = elementCount;
+      threads[2 * i] = naMakeThread("NATest MPMC Producer", na_TestMPMCProducer, &producers[i]);
+      threads[2 * i + 1] = naMakeThread("NATest MPMC Consumer", na_TestMPMCConsumer, &consumers[i]);
+    }
+    for(int i = 0; i < 2 * NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT; ++i){
+      naRunThread(threads[i]);
+    }
+    for(int i = 0; i < 2 * NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT; ++i){
+      naJoinThread(threads[i]);
+      naClearThread(threads[i]);
+    }
+    for(int i = 0; i < NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT; ++i){
+      sum += consumers[i].sum;
+    }
+    naTest(sum == NA_TEST_CIRCULAR_BUFFER_THREAD_COUNT * (elementCount * (elementCount + 1) / 2));
+    naClearMPMCCircularBuffer(&buffer);
+  }
+}
+
+
+
+void testNACircularBuffer(){
+  naTestGroupFunction(NACircularBufferSingle);
+  naTestGroupFunction(NACircularBufferSPSC);
+  naTestGroupFunction(NACircularBufferMPMC);
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
@@ -0,0 +1,152 @@
+
+#include "NATesting.h"
+#include <stdio.h>
+
+#include "NAHeap.h"
+#include "NADateTime.h"
+
+
+
+// The results of the benchmarks are accumulated here such that the compiler
+// can not optimize the work away.
+size_t na_HeapBenchmarkSum = 0;
+
+typedef struct NAHeapBenchmarkData NAHeapBenchmarkData;
+struct NAHeapBenchmarkData{
+  size_t count;
+  double* doubleKeys;
+  float* floatKeys;
+  NAInt* intKeys;
+  NADateTime* dateTimeKeys;
+  double* updateKeys;
+  NAInt* backPointers;
+};
+
+// Creates the same pseudo random keys of all types for every run.
+void na_InitHeapBenchmarkData(NAHeapBenchmarkData* data, size_t count){
+  data->count = count;
+  data->doubleKeys = naMalloc(count * sizeof(double));
+  data->floatKeys = naMalloc(count * sizeof(float));
+  data->intKeys = naMalloc(count * sizeof(NAInt));
+  data->dateTimeKeys = naMalloc(count * sizeof(NADateTime));
+  data->updateKeys = naMalloc(count * sizeof(double));
+  data->backPointers = naMalloc(count * sizeof(NAInt));
+  uint32 seed = 3456;
+  for(size_t i = 0; i < count; i++){
+    seed = seed * 1103515245 + 12345;
+    uint32 value = seed >> 8;
+    data->doubleKeys[i] = (double)value / (double)(1 << 24);
+    data->floatKeys[i] = (float)data->doubleKeys[i];
+    data->intKeys[i] = (NAInt)value;
+    naZeron(&(data->dateTimeKeys[i]), sizeof(NADateTime));
+    data->dateTimeKeys[i].siSecond = naMakei64WithLo((int32)(value >> 4));
+    data->dateTimeKeys[i].nanoSecond = (int32)(value & 0x0f) * 1000;
+  }
+}
+
+void na_ClearHeapBenchmarkData(NAHeapBenchmarkData* data){
+  naFree(data->backPointers);
+  naFree(data->updateKeys);
+  naFree(data->dateTimeKeys);
+  naFree(data->intKeys);
+  naFree(data->floatKeys);
+  naFree(data->doubleKeys);
+}
+
+const void* na_GetHeapBenchmarkKey(const NAHeapBenchmarkData* data, NAInt flags, size_t index){
+  switch(flags & NA_HEAP_DATATYPE_MASK){
+  case NA_HEAP_USES_FLOAT_KEY: return &(data->floatKeys[index]);
+  case NA_HEAP_USES_NAINT_KEY: return &(data->intKeys[index]);
+  case NA_HEAP_USES_DATETIME_KEY: return &(data->dateTimeKeys[index]);
+  default: return &(data->doubleKeys[index]);
+  }
+}
+
+// Inserts all keys into a heap and removes them again in sorted order.
+void na_BenchmarkHeapSort(NAHeapBenchmarkData* data, NAInt flags){
+  NAHeap heap;
+  naInitHeap(&heap, (NAInt)data->count, flags);
+  NABool backPointers = (flags & NA_HEAP_STORES_BACKPOINTERS) == NA_HEAP_STORES_BACKPOINTERS;
+  for(size_t i = 0; i < data->count; i++){
+    naInsertHeapElementConst(
+      &heap,
+      &(data->intKeys[i]),
+      na_GetHeapBenchmarkKey(data, flags, i),
+      backPointers ? &(data->backPointers[i]) : NA_NULL);
+  }
+  while(naGetHeapCount(&heap)){
+    na_HeapBenchmarkSum += (size_t)*(const NAInt*)naRemoveHeapRootConst(&heap);
+  }
+  naClearHeap(&heap);
+}
+
+// Changes the keys of a tenth of the elements while they are in the heap.
+void na_BenchmarkHeapUpdate(NAHeapBenchmarkData* data){
+  NAHeap heap;
+  naInitHeap(&heap, (NAInt)data->count, NA_HEAP_USES_DOUBLE_KEY | NA_HEAP_STORES_BACKPOINTERS);
+  naCopyn(data->updateKeys, data->doubleKeys, data->count * sizeof(double));
+  for(size_t i = 0; i < data->count; i++){
+    naInsertHeapElementConst(&heap, &(data->intKeys[i]), &(data->updateKeys[i]), &(data->backPointers[i]));
+  }
+  for(size_t i = 0; i < data->count; i += 10){
+    data->updateKeys[i] = 1. - data->updateKeys[i];
+    naUpdateHeapElement(&heap, data->backPointers[i]);
+  }
+  na_HeapBenchmarkSum += (size_t)*(const NAInt*)naGetHeapRootConst(&heap);
+  naClearHeap(&heap);
+}
+
+void na_BenchmarkHeapSize(size_t count){
+  NAHeapBenchmarkData data;
+  na_InitHeapBenchmarkData(&data, count);
+
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_DOUBLE_KEY));
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_FLOAT_KEY));
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_NAINT_KEY));
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_DATETIME_KEY));
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_DOUBLE_KEY | NA_HEAP_IS_MAX_HEAP));
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_DOUBLE_KEY | NA_HEAP_STORES_BACKPOINTERS));
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_FLOAT_KEY | NA_HEAP_STORES_BACKPOINTERS));
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_NAINT_KEY | NA_HEAP_STORES_BACKPOINTERS));
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_DATETIME_KEY | NA_HEAP_STORES_BACKPOINTERS));
+  naBenchmark(na_BenchmarkHeapSort(&data, NA_HEAP_USES_DOUBLE_KEY | NA_HEAP_IS_MAX_HEAP | NA_HEAP_STORES_BACKPOINTERS));
+  naBenchmark(na_BenchmarkHeapUpdate(&data));
+
+  na_ClearHeapBenchmarkData(&data);
+}
+
+
+
+void benchmarkNAHeap(){
+  printf(NA_NL "NAHeap:" NA_NL);
+  naTestGroup("100"){na_BenchmarkHeapSize(100);}
+  naTestGroup("10000"){na_BenchmarkHeapSize(10000);}
+  naTestGroup("100000"){na_BenchmarkHeapSize(100000);}
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
@@ -0,0 +1,112 @@
+
+#include "NATesting.h"
+#include <stdio.h>
+
+#include "NAList.h"
+
+
+
+// The results of the benchmarks are accumulated here such that the compiler
+// can not optimize the work away.
+uint32 na_ListBenchmarkSum = 0;
+
+void na_FillListBenchmarkValues(uint32* values, size_t count){
+  uint32 seed = 2345;
+  for(size_t i = 0; i < count; i++){
+    seed = seed * 1103515245 + 12345;
+    values[i] = seed >> 8;
+  }
+}
+
+void na_BenchmarkListAddRemove(const uint32* values, size_t count){
+  NAList list;
+  naInitList(&list);
+  for(size_t i = 0; i < count; i++){
+    naAddListLastConst(&list, &values[i]);
+  }
+  while(!naIsListEmpty(&list)){
+    na_ListBenchmarkSum += *(const uint32*)naGetListFirstConst(&list);
+    naRemoveListFirstConst(&list);
+  }
+  naClearList(&list);
+}
+
+void na_BenchmarkListIterate(const NAList* list){
+  NAListIterator iter = naMakeListAccessor(list);
+  while(naIterateList(&iter)){
+    na_ListBenchmarkSum += *(const uint32*)naGetListCurConst(&iter);
+  }
+  naClearListIterator(&iter);
+}
+
+// Adds every element in the middle of the list, right after the iterator.
+void na_BenchmarkListInsert(const uint32* values, size_t count){
+  NAList list;
+  naInitList(&list);
+  NAListIterator iter = naMakeListModifier(&list);
+  for(size_t i = 0; i < count; i++){
+    naAddListAfterConst(&iter, &values[i]);
+    if(i & 1){naIterateList(&iter);}
+  }
+  naClearListIterator(&iter);
+  na_ListBenchmarkSum += (uint32)naGetListCount(&list);
+  naClearList(&list);
+}
+
+void na_AccumulateListBenchmarkValue(const void* value){
+  na_ListBenchmarkSum += *(const uint32*)value;
+}
+
+void na_BenchmarkListSize(size_t count){
+  uint32* values = naMalloc(count * sizeof(uint32));
+  na_FillListBenchmarkValues(values, count);
+  NAList list;
+  naInitList(&list);
+  for(size_t i = 0; i < count; i++){
+    naAddListLastConst(&list, &values[i]);
+  }
+
+  naBenchmark(na_BenchmarkListAddRemove(values, count));
+  naBenchmark(na_BenchmarkListInsert(values, count));
+  naBenchmark(na_BenchmarkListIterate(&list));
+  naBenchmark(naForeachListConst(&list, na_AccumulateListBenchmarkValue));
+
+  naClearList(&list);
+  naFree(values);
+}
+
+
+
+void benchmarkNAList(){
+  printf(NA_NL "NAList:" NA_NL);
+  naTestGroup("100"){na_BenchmarkListSize(100);}
+  naTestGroup("10000"){na_BenchmarkListSize(10000);}
+  naTestGroup("1000000"){na_BenchmarkListSize(1000000);}
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
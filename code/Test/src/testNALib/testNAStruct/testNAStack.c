@@ -783,7 +783,7 @@ void benchmarkNAStack(){
   // Get cur element of iterator int
   naInitStack(&stack, sizeof(int), 1, 0);
   naPushStack(&stack);
-  iter = naMakeStackAccessor(&stack);
+  iter = naMakeStackMutator(&stack);
   naIterateStack(&iter);
   naBenchmark(naGetStackCurConst(&iter));
   naBenchmark(naGetStackCurMutable(&iter));
@@ -793,7 +793,7 @@ void benchmarkNAStack(){
   // Get cur element of iterator int*
   naInitStack(&stack, sizeof(int*), 1, 0);
   naPushStack(&stack);
-  iter = naMakeStackAccessor(&stack);
+  iter = naMakeStackMutator(&stack);
   naIterateStack(&iter);
   naBenchmark(naGetStackCurpConst(&iter));
   naBenchmark(naGetStackCurpMutable(&iter));
@@ -0,0 +1,254 @@
+#include "NATesting.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "NAString.h"
+
+
+
+void testStringView(){
+  naTestGroup("Making views"){
+    NAStringView view = naMakeStringViewWithUTF8CString("Hello World");
+    naTest(naGetStringViewByteSize(view) == 11);
+    naTest(!naIsStringViewEmpty(view));
+    NAStringView sub = naMakeStringViewExtraction(view, 6, 5);
+    naTest(naGetStringViewUTF8Pointer(sub) == naGetStringViewUTF8Pointer(view) + 6);
+    naTest(naIsStringViewEmpty(naMakeStringViewExtraction(view, 11, 0)));
+    naTestError(naMakeStringViewExtraction(view, 6, 6));
+
+    NAString* string = naNewStringWithFormat("Number %d", 42);
+    NAStringView stringView = naMakeStringViewWithString(string);
+    naTest(naGetStringViewByteSize(stringView) == 9);
+    naTest(!memcmp(naGetStringViewUTF8Pointer(stringView), "Number 42", 9));
+    naDelete(string);
+
+    // Strings consisting of multiple parts get copied.
+    string = naNewString();
+    naAppendStringFormat(string, "first");
+    naAppendStringFormat(string, " second");
+    stringView = naMakeStringViewWithString(string);
+    naTest(naGetStringViewByteSize(stringView) == 12);
+    naTest(!memcmp(naGetStringViewUTF8Pointer(stringView), "first second", 12));
+    naDelete(string);
+
+    string = naNewString();
+    naTest(naIsStringViewEmpty(naMakeStringViewWithString(string)));
+    naDelete(string);
+  }
+
+  naTestGroup("Comparing and appending"){
+    NAStringView view = naMakeStringView("Token;Rest", 5);
+    NAString* string = naNewStringWithFormat("token");
+    naTest(naEqualStringViewToString(view, string, NA_FALSE));
+    naTest(!naEqualStringViewToString(view, string, NA_TRUE));
+    naTest(naEqualStringViews(view, naMakeStringViewWithUTF8CString("Token"), NA_TRUE));
+    naTest(!naEqualStringViews(view, naMakeStringViewWithUTF8CString("Tokens"), NA_TRUE));
+    naTest(naEqualStringViews(naMakeStringView("a", 0), naMakeStringView("b", 0), NA_TRUE));
+
+    naDelete(string);
+
+    string = naNewString();
+    naAppendStringStringView(string, view);
+    naAppendStringStringView(string, naMakeStringViewWithUTF8CString(" and more"));
+    naAppendStringStringView(string, naMakeStringView("", 0));
+    naTest(naEqualStringToUTF8CString(string, "Token and more", NA_TRUE));
+    naDelete(string);
+
+    string = naNewStringWithFormat("Literal");
+    naAppendStringStringView(string, naMakeStringView(" and a view", 6));
+    naTest(naEqualStringToUTF8CString(string, "Literal and a", NA_TRUE));
+    naDelete(string);
+
+    string = naNewStringWithStringView(view);
+    naTest(naEqualStringToUTF8CString(string, "Token", NA_TRUE));
+    naDelete(string);
+  }
+
+  naTestGroup("Tokenizing"){
+    NAStringView view = naMakeStringViewWithUTF8CString("  alpha beta\t\n gamma  ");
+    NAStringView token = naParseStringViewToken(&view);
+    naTest(naEqualStringViews(token, naMakeStringViewWithUTF8CString("alpha"), NA_TRUE));
+    token = naParseStringViewToken(&view);
+    naTest(naEqualStringViews(token, naMakeStringViewWithUTF8CString("beta"), NA_TRUE));
+    token = naParseStringViewToken(&view);
+    naTest(naEqualStringViews(token, naMakeStringViewWithUTF8CString("gamma"), NA_TRUE));
+    naTest(naIsStringViewEmpty(view));
+    naTest(naIsStringViewEmpty(naParseStringViewToken(&view)));
+
+    view = naMakeStringViewWithUTF8CString("12;-34;;x");
+    token = naParseStringViewTokenWithDelimiter(&view, ';');
+    naTest(naParseStringViewi32(token) == 12);
+    token = naParseStringViewTokenWithDelimiter(&view, ';');
+    naTest(naParseStringViewi32(token) == -34);
+    token = naParseStringViewTokenWithDelimiter(&view, ';');
+    naTest(naIsStringViewEmpty(token));
+    token = naParseStringViewTokenWithDelimiter(&view, ';');
+    naTest(naEqualStringViews(token, naMakeStringViewWithUTF8CString("x"), NA_TRUE));
+    naTest(naIsStringViewEmpty(view));
+  }
+
+  naTestGroup("Parsing numbers"){
+    // The views are not Null-terminated, the digits after them must not be
+    // parsed.
+    const NAUTF8Char* digits = "-1234567890123456789";
+    naTest(naParseStringViewi8(naMakeStringView(digits, 3)) == -12);
+    naTest(naParseStringViewi16(naMakeStringView(digits, 5)) == -1234);
+    naTest(naParseStringViewi32(naMakeStringView(digits, 8)) == -1234567);
+    naTest(naEquali64(naParseStringViewi64(naMakeStringView(digits, 20)), naNegi64(naMakei64(287445236, 2112454933))));
+    naTest(naParseStringViewu8(naMakeStringView(&digits[1], 2)) == 12);
+    naTest(naParseStringViewu16(naMakeStringView(&digits[1], 4)) == 1234);
+    naTest(naParseStringViewu32(naMakeStringView(&digits[1], 9)) == 123456789);
+    naTest(naEqualu64(naParseStringViewu64(naMakeStringView(&digits[1], 3)), naMakeu64WithLo(123)));
+    naTest(naParseStringViewi32(naMakeStringViewWithUTF8CString("+77abc")) == 77);
+    naTest(naParseStringViewi8(naMakeStringViewWithUTF8CString("-128")) == NA_MIN_i8);
+    naTest(naEquali64(naParseStringViewi64(naMakeStringViewWithUTF8CString("-9223372036854775808")), NA_MIN_i64));
+    naTest(naEquali64(naParseStringViewi64(naMakeStringViewWithUTF8CString("9223372036854775807")), NA_MAX_i64));
+    naTestError(naParseStringViewi64(naMakeStringViewWithUTF8CString("-9223372036854775809")));
+    naTest(naParseStringViewu32(naMakeStringView("", 0)) == 0);
+    naTestError(naParseStringViewu8(naMakeStringViewWithUTF8CString("300")));
+    naTest(naParseStringViewFloat(naMakeStringView("2.5e3", 3)) == 2.5f);
+    naTest(naParseStringViewDouble(naMakeStringViewWithUTF8CString("-0.125")) == -0.125);
+  }
+}
+
+
+
+void testStringEncoding(){
+  NAString* string = naNewStringWithFormat("a<b> & \"(c)\\\n'");
+  naTestGroup("C"){
+    NAString* escaped = naNewStringCEscaped(string);
+    naTest(naEqualStringToUTF8CString(escaped, "a<b> & \\\"(c)\\\\\\n\\'", NA_TRUE));
+    NAString* unescaped = naNewStringCUnescaped(escaped);
+    naTest(naEqualStringToString(unescaped, string, NA_TRUE));
+    naDelete(unescaped);
+    naDelete(escaped);
+  }
+  naTestGroup("XML"){
+    NAString* encoded = naNewStringXMLEncoded(string);
+    naTest(naEqualStringToUTF8CString(encoded, "a&lt;b&gt; &amp; &quot;(c)\\\n&apos;", NA_TRUE));
+    naDelete(encoded);
+  }
+  naTestGroup("EPS"){
+    NAString* encoded = naNewStringEPSEncoded(string);
+    naTest(naEqualStringToUTF8CString(encoded, "a<b> & \"\\(c\\)\\\\\n'", NA_TRUE));
+    NAString* decoded = naNewStringEPSDecoded(encoded);
+    naTest(naEqualStringToString(decoded, string, NA_TRUE));
+    naDelete(decoded);
+    naDelete(encoded);
+  }
+  naDelete(string);
+}
+
+
+
+void testNAString(){
+  naTestGroupFunction(StringView);
+  naTestGroupFunction(StringEncoding);
+}
+
+
+
+// The results of the benchmarks are accumulated here such that the compiler
+// can not optimize the work away.
+size_t na_StringBenchmarkSum = 0;
+
+void na_BenchmarkStringFormat(const int32* values, size_t count){
+  for(size_t i = 0; i < count; i++){
+    NAString* string = naNewStringWithFormat("%d", values[i]);
+    na_StringBenchmarkSum += naGetStringByteSize(string);
+    naDelete(string);
+  }
+}
+
+void na_BenchmarkStringAppend(const int32* values, size_t count){
+  NAString* string = naNewString();
+  for(size_t i = 0; i < count; i++){
+    naAppendStringFormat(string, "%d ", values[i]);
+  }
+  na_StringBenchmarkSum += naGetStringByteSize(string);
+  naDelete(string);
+}
+
+void na_BenchmarkStringViewParse(const NAString* text){
+  NAStringView view = naMakeStringViewWithString(text);
+  while(!naIsStringViewEmpty(view)){
+    na_StringBenchmarkSum += (size_t)naParseStringViewi32(naParseStringViewToken(&view));
+  }
+}
+
+void na_BenchmarkStringParse(NAString** strings, size_t count){
+  for(size_t i = 0; i < count; i++){
+    na_StringBenchmarkSum += (size_t)naParseStringi32(strings[i]);
+  }
+}
+
+void na_BenchmarkStringEncode(const NAString* text){
+  NAString* escaped = naNewStringCEscaped(text);
+  NAString* encoded = naNewStringXMLEncoded(text);
+  na_StringBenchmarkSum += naGetStringByteSize(escaped) + naGetStringByteSize(encoded);
+  naDelete(encoded);
+  naDelete(escaped);
+}
+
+void na_BenchmarkStringSize(size_t count){
+  int32* values = naMalloc(count * sizeof(int32));
+  NAString** strings = naMalloc(count * sizeof(NAString*));
+  NAString* text = naNewString();
+  uint32 seed = 7890;
+  for(size_t i = 0; i < count; i++){
+    seed = seed * 1103515245 + 12345;
+    values[i] = (int32)(seed >> 8) - 0x800000;
+    strings[i] = naNewStringWithFormat("%d", values[i]);
+    naAppendStringFormat(text, (i % 10 == 9) ? "%d\n" : "%d \"<&>\" ", values[i]);
+  }
+
+  naBenchmark(na_BenchmarkStringFormat(values, count));
+  naBenchmark(na_BenchmarkStringAppend(values, count));
+  naBenchmark(na_BenchmarkStringParse(strings, count));
+  naBenchmark(na_BenchmarkStringViewParse(text));
+  naBenchmark(na_BenchmarkStringEncode(text));
+  NAString* textCopy = naNewStringWithFormat("%s", naGetStringUTF8Pointer(text));
+  naBenchmark(naEqualStringToString(text, textCopy, NA_TRUE));
+
+  naDelete(textCopy);
+  naDelete(text);
+  for(size_t i = 0; i < count; i++){naDelete(strings[i]);}
+  naFree(strings);
+  naFree(values);
+}
+
+
+
+void benchmarkNAString(){
+  printf(NA_NL "NAString:" NA_NL);
+  naTestGroup("100"){na_BenchmarkStringSize(100);}
+  naTestGroup("10000"){na_BenchmarkStringSize(10000);}
+  naTestGroup("100000"){na_BenchmarkStringSize(100000);}
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
@@ -0,0 +1,157 @@
+
+#include "NATesting.h"
+#include <stdio.h>
+
+#include "NATree.h"
+#include "NACoord.h"
+
+
+
+// The results of the benchmarks are accumulated here such that the compiler
+// can not optimize the work away.
+size_t na_TreeBenchmarkSum = 0;
+
+typedef struct NATreeBenchmarkData NATreeBenchmarkData;
+struct NATreeBenchmarkData{
+  size_t count;
+  double* doubleKeys;
+  NAInt* intKeys;
+  NAPos* posKeys;
+  NAVertex* vertexKeys;
+};
+
+// Creates the same pseudo random keys of all types for every run.
+void na_InitTreeBenchmarkData(NATreeBenchmarkData* data, size_t count){
+  data->count = count;
+  data->doubleKeys = naMalloc(count * sizeof(double));
+  data->intKeys = naMalloc(count * sizeof(NAInt));
+  data->posKeys = naMalloc(count * sizeof(NAPos));
+  data->vertexKeys = naMalloc(count * sizeof(NAVertex));
+  uint32 seed = 4567;
+  for(size_t i = 0; i < count; i++){
+    double values[3];
+    for(int c = 0; c < 3; c++){
+      seed = seed * 1103515245 + 12345;
+      values[c] = (double)(seed >> 8) / (double)(1 << 24) * 1000.;
+    }
+    data->doubleKeys[i] = values[0];
+    data->intKeys[i] = (NAInt)(values[0] * 1000.);
+    data->posKeys[i] = naMakePos(values[0], values[1]);
+    data->vertexKeys[i] = naMakeVertex(values[0], values[1], values[2]);
+  }
+}
+
+void na_ClearTreeBenchmarkData(NATreeBenchmarkData* data){
+  naFree(data->vertexKeys);
+  naFree(data->posKeys);
+  naFree(data->intKeys);
+  naFree(data->doubleKeys);
+}
+
+const void* na_GetTreeBenchmarkKey(const NATreeBenchmarkData* data, NAInt flags, size_t index){
+  if(flags & NA_TREE_QUADTREE){return &(data->posKeys[index]);}
+  if(flags & NA_TREE_OCTTREE){return &(data->vertexKeys[index]);}
+  if(flags & NA_TREE_KEY_NAINT){return &(data->intKeys[index]);}
+  return &(data->doubleKeys[index]);
+}
+
+void na_FillBenchmarkTree(NATree* tree, const NATreeBenchmarkData* data, NAInt flags){
+  NATreeIterator iter = naMakeTreeModifier(tree);
+  for(size_t i = 0; i < data->count; i++){
+    naAddTreeKeyConst(&iter, na_GetTreeBenchmarkKey(data, flags, i), &(data->intKeys[i]), NA_TRUE);
+  }
+  naClearTreeIterator(&iter);
+}
+
+void na_BenchmarkTreeInsert(const NATreeBenchmarkData* data, NATreeConfiguration* config, NAInt flags){
+  NATree tree;
+  naInitTree(&tree, config);
+  na_FillBenchmarkTree(&tree, data, flags);
+  na_TreeBenchmarkSum += naIsTreeEmpty(&tree) ? 0 : 1;
+  naClearTree(&tree);
+}
+
+void na_BenchmarkTreeLocate(NATree* tree, const NATreeBenchmarkData* data, NAInt flags){
+  NATreeIterator iter = naMakeTreeAccessor(tree);
+  for(size_t i = 0; i < data->count; i++){
+    if(naLocateTreeKey(&iter, na_GetTreeBenchmarkKey(data, flags, data->count - 1 - i), NA_FALSE)){
+      na_TreeBenchmarkSum++;
+    }
+  }
+  naClearTreeIterator(&iter);
+}
+
+void na_BenchmarkTreeIterate(NATree* tree){
+  NATreeIterator iter = naMakeTreeAccessor(tree);
+  while(naIterateTree(&iter, NA_NULL, NA_NULL)){
+    na_TreeBenchmarkSum += (size_t)*(const NAInt*)naGetTreeCurLeafConst(&iter);
+  }
+  naClearTreeIterator(&iter);
+}
+
+void na_BenchmarkTreeType(const NATreeBenchmarkData* data, NAInt flags){
+  NATreeConfiguration* config = naCreateTreeConfiguration(flags);
+  if(flags & (NA_TREE_QUADTREE | NA_TREE_OCTTREE)){
+    naSetTreeConfigurationBaseLeafExponent(config, 0);
+  }
+  NATree tree;
+  naInitTree(&tree, config);
+  na_FillBenchmarkTree(&tree, data, flags);
+
+  naBenchmark(na_BenchmarkTreeInsert(data, config, flags));
+  naBenchmark(na_BenchmarkTreeLocate(&tree, data, flags));
+  naBenchmark(na_BenchmarkTreeIterate(&tree));
+
+  naClearTree(&tree);
+  naReleaseTreeConfiguration(config);
+}
+
+void na_BenchmarkTreeSize(size_t count){
+  NATreeBenchmarkData data;
+  na_InitTreeBenchmarkData(&data, count);
+
+  naTestGroup("Binary double"){na_BenchmarkTreeType(&data, NA_TREE_KEY_DOUBLE);}
+  naTestGroup("Binary NAInt"){na_BenchmarkTreeType(&data, NA_TREE_KEY_NAINT);}
+  naTestGroup("AVL double"){na_BenchmarkTreeType(&data, NA_TREE_KEY_DOUBLE | NA_TREE_BALANCE_AVL);}
+  naTestGroup("AVL NAInt"){na_BenchmarkTreeType(&data, NA_TREE_KEY_NAINT | NA_TREE_BALANCE_AVL);}
+  naTestGroup("Quadtree"){na_BenchmarkTreeType(&data, NA_TREE_KEY_DOUBLE | NA_TREE_QUADTREE);}
+  naTestGroup("Octtree"){na_BenchmarkTreeType(&data, NA_TREE_KEY_DOUBLE | NA_TREE_OCTTREE);}
+
+  na_ClearTreeBenchmarkData(&data);
+}
+
+
+
+void benchmarkNATree(){
+  printf(NA_NL "NATree:" NA_NL);
+  naTestGroup("100"){na_BenchmarkTreeSize(100);}
+  naTestGroup("10000"){na_BenchmarkTreeSize(10000);}
+  naTestGroup("100000"){na_BenchmarkTreeSize(100000);}
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
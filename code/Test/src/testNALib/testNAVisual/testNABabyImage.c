@@ -0,0 +1,528 @@
+#include "NATesting.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "NABabyImage.h"
+#include "NAThreading.h"
+
+
+
+// Fills the given u8 data with pixels of all kinds, some of them transparent.
+void na_FillBabyImageTestData(uint8* data, size_t pixelCount){
+  uint32 seed = 2468;
+  for(size_t i = 0; i < pixelCount * 4; i++){
+    seed = seed * 1103515245 + 12345;
+    data[i] = (NAByte)(seed >> 16);
+  }
+  for(size_t i = 0; i < pixelCount; i += 7){
+    data[i * 4 + 3] = 0;
+  }
+}
+
+
+
+NABabyImage* na_CreateBabyImageTestImage(NASizei size, uint32 seed){
+  NABabyImage* image = naCreateBabyImage(size, NA_NULL);
+  size_t pixelCount = (size_t)size.width * (size_t)size.height;
+  uint8* data = naMalloc(pixelCount * 4);
+  na_FillBabyImageTestData(data, pixelCount);
+  for(size_t i = 0; i < pixelCount * 4; i++){
+    seed = seed * 1103515245 + 12345;
+    data[i] ^= (NAByte)(seed >> 16) & 0x0f;
+  }
+  naFillBabyImageWithu8(image, data, NA_FALSE, NA_COLOR_BUFFER_RGBA);
+  naFree(data);
+  return image;
+}
+
+
+
+NABool na_EqualBabyImageValues(const float* values1, const float* values2, size_t count){
+  for(size_t i = 0; i < count; i++){
+    if(naAbsf(values1[i] - values2[i]) > 1e-6f){return NA_FALSE;}
+  }
+  return NA_TRUE;
+}
+
+
+
+// Compares the conversions from and to u8 with the ones of single colors.
+NABool na_TestBabyImageu8(NASizei size, NABool topToBottom, NAColorBufferType bufferType){
+  size_t pixelCount = (size_t)size.width * (size_t)size.height;
+  uint8* data = naMalloc(pixelCount * 4);
+  uint8* output = naMalloc(pixelCount * 4);
+  uint8* expectedOutput = naMalloc(pixelCount * 4);
+  float* expected = naMalloc(pixelCount * 4 * sizeof(float));
+  NABabyImage* image = naCreateBabyImage(size, NA_NULL);
+  NABool success = NA_TRUE;
+
+  na_FillBabyImageTestData(data, pixelCount);
+  naFillBabyImageWithu8(image, data, topToBottom, bufferType);
+  for(size_t y = 0; y < (size_t)size.height; y++){
+    size_t dataLine = topToBottom ? (size_t)size.height - y - 1 : y;
+    for(size_t x = 0; x < (size_t)size.width; x++){
+      size_t i = y * (size_t)size.width + x;
+      naFillBabyColorWithu8(&expected[i * 4], &data[(dataLine * (size_t)size.width + x) * 4], bufferType);
+    }
+  }
+  // RGB leaves the alpha untouched.
+  if(bufferType == NA_COLOR_BUFFER_RGB){
+    for(size_t i = 0; i < pixelCount; i++){expected[i * 4 + 3] = naGetBabyImageData(image)[i * 4 + 3];}
+  }
+  success = success && !memcmp(expected, naGetBabyImageData(image), pixelCount * 4 * sizeof(float));
+
+  memset(output, 0x5a, pixelCount * 4);
+  memset(expectedOutput, 0x5a, pixelCount * 4);
+  naConvertBabyImageTou8(image, output, topToBottom, bufferType);
+  for(size_t y = 0; y < (size_t)size.height; y++){
+    size_t dataLine = topToBottom ? (size_t)size.height - y - 1 : y;
+    for(size_t x = 0; x < (size_t)size.width; x++){
+      size_t i = y * (size_t)size.width + x;
+      naFillu8WithBabyColor(&expectedOutput[(dataLine * (size_t)size.width + x) * 4], &naGetBabyImageData(image)[i * 4], bufferType);
+    }
+  }
+  success = success && !memcmp(expectedOutput, output, pixelCount * 4);
+
+  naReleaseBabyImage(image);
+  naFree(expected);
+  naFree(expectedOutput);
+  naFree(output);
+  naFree(data);
+  return success;
+}
+
+
+
+// Blends a single pixel the way NABabyImage always did.
+void na_BlendBabyImageTestPixel(float* ret, const float* base, const float* top, NABlendMode mode, float blend){
+  float topblend = (mode == NA_BLEND) ? blend : top[3] * blend;
+  for(size_t c = 0; c < 3; c++){
+    ret[c] = (mode == NA_BLEND_ZERO) ? base[c] : (1.f - topblend) * base[c] + topblend * top[c];
+  }
+  switch(mode){
+  case NA_BLEND_ZERO: ret[3] = base[3]; break;
+  case NA_BLEND: ret[3] = (1.f - topblend) * base[3] + topblend * top[3]; break;
+  case NA_BLEND_OVERLAY: ret[3] = base[3] + (1.f - base[3]) * topblend; break;
+  case NA_BLEND_OPAQUE: ret[3] = base[3] * (1.f - (1.f - top[3]) * blend); break;
+  case NA_BLEND_BLACK_GREEN: ret[3] = (1.f - base[1]) * base[3] * (1.f - (1.f - top[3]) * blend); break;
+  case NA_BLEND_WHITE_GREEN: ret[3] = base[1] * base[3] * (1.f - (1.f - top[3]) * blend); break;
+  }
+  if(ret[3] == 0.f){ret[0] = 0.f; ret[1] = 0.f; ret[2] = 0.f;}
+}
+
+NABool na_TestBabyImageBlend(NASizei size, NABlendMode mode, float blend){
+  size_t pixelCount = (size_t)size.width * (size_t)size.height;
+  NABabyImage* base = na_CreateBabyImageTestImage(size, 1);
+  NABabyImage* top = na_CreateBabyImageTestImage(size, 2);
+  NABabyColor tint = {.2f, .7f, .4f, .6f};
+  NABabyImage* blended = naCreateBabyImageWithBlend(base, top, mode, blend);
+  NABabyImage* tinted = naCreateBabyImageWithTint(base, tint, mode, blend);
+  float* expectedBlend = naMalloc(pixelCount * 4 * sizeof(float));
+  float* expectedTint = naMalloc(pixelCount * 4 * sizeof(float));
+
+  float linearBlend = naLinearizeColorValue(blend);
+  for(size_t i = 0; i < pixelCount; i++){
+    na_BlendBabyImageTestPixel(&expectedBlend[i * 4], &naGetBabyImageData(base)[i * 4], &naGetBabyImageData(top)[i * 4], mode, linearBlend);
+    na_BlendBabyImageTestPixel(&expectedTint[i * 4], &naGetBabyImageData(base)[i * 4], tint, mode, linearBlend);
+  }
+  NABool success = na_EqualBabyImageValues(expectedBlend, naGetBabyImageData(blended), pixelCount * 4)
+    && na_EqualBabyImageValues(expectedTint, naGetBabyImageData(tinted), pixelCount * 4);
+
+  naFree(expectedTint);
+  naFree(expectedBlend);
+  naReleaseBabyImage(tinted);
+  naReleaseBabyImage(blended);
+  naReleaseBabyImage(top);
+  naReleaseBabyImage(base);
+  return success;
+}
+
+
+
+NABool na_TestBabyImageHalfSize(NASizei size){
+  NABabyImage* image = na_CreateBabyImageTestImage(size, 3);
+  NABabyImage* half = naCreateBabyImageWithHalfSize(image);
+  const float* in = naGetBabyImageData(image);
+  const float* out = naGetBabyImageData(half);
+  size_t width = (size_t)size.width;
+  NABool success = NA_TRUE;
+
+  for(size_t y = 0; y < (size_t)size.height / 2; y++){
+    for(size_t x = 0; x < width / 2; x++){
+      const float* p[4] = {
+        &in[((2 * y) * width + 2 * x) * 4],
+        &in[((2 * y) * width + 2 * x + 1) * 4],
+        &in[((2 * y + 1) * width + 2 * x) * 4],
+        &in[((2 * y + 1) * width + 2 * x + 1) * 4]};
+      float expected[4] = {0.f, 0.f, 0.f, 0.f};
+      for(size_t i = 0; i < 4; i++){
+        for(size_t c = 0; c < 3; c++){expected[c] += p[i][c] * p[i][3];}
+        expected[3] += p[i][3];
+      }
+      if(expected[3] != 0.f){
+        for(size_t c = 0; c < 3; c++){expected[c] /= expected[3];}
+        expected[3] *= .25f;
+      }
+      success = success && na_EqualBabyImageValues(expected, &out[(y * width / 2 + x) * 4], 4);
+    }
+  }
+
+  naReleaseBabyImage(half);
+  naReleaseBabyImage(image);
+  return success;
+}
+
+
+
+void testBabyImageKernels(){
+  NASizei smallSize = naMakeSizei(38, 24);
+  NASizei largeSize = naMakeSizei(642, 480);
+
+  naTestGroup("Conversion from and to u8"){
+    naTest(na_TestBabyImageu8(smallSize, NA_FALSE, NA_COLOR_BUFFER_RGBA));
+    naTest(na_TestBabyImageu8(smallSize, NA_TRUE, NA_COLOR_BUFFER_RGBA));
+    naTest(na_TestBabyImageu8(smallSize, NA_FALSE, NA_COLOR_BUFFER_RGBAPre));
+    naTest(na_TestBabyImageu8(smallSize, NA_FALSE, NA_COLOR_BUFFER_RGB));
+    naTest(na_TestBabyImageu8(smallSize, NA_TRUE, NA_COLOR_BUFFER_BGR0));
+    naTest(na_TestBabyImageu8(smallSize, NA_FALSE, NA_COLOR_BUFFER_BGRA));
+    naTest(na_TestBabyImageu8(naMakeSizei(3, 1), NA_FALSE, NA_COLOR_BUFFER_RGBA));
+  }
+
+  naTestGroup("Blending"){
+    naTest(na_TestBabyImageBlend(smallSize, NA_BLEND_ZERO, .5f));
+    naTest(na_TestBabyImageBlend(smallSize, NA_BLEND, .3f));
+    naTest(na_TestBabyImageBlend(smallSize, NA_BLEND_OVERLAY, .8f));
+    naTest(na_TestBabyImageBlend(smallSize, NA_BLEND_OPAQUE, .5f));
+    naTest(na_TestBabyImageBlend(smallSize, NA_BLEND_BLACK_GREEN, .6f));
+    naTest(na_TestBabyImageBlend(smallSize, NA_BLEND_WHITE_GREEN, 1.f));
+  }
+
+  naTestGroup("Half size"){
+    naTest(na_TestBabyImageHalfSize(smallSize));
+    naTest(na_TestBabyImageHalfSize(naMakeSizei(2, 2)));
+  }
+
+  NAThreadPool* pool = naNewThreadPool(4);
+  naSetBabyImageThreadPool(pool);
+
+  naTestGroup("Large images in parallel"){
+    naTest(na_TestBabyImageu8(largeSize, NA_TRUE, NA_COLOR_BUFFER_RGBA));
+    naTest(na_TestBabyImageu8(largeSize, NA_FALSE, NA_COLOR_BUFFER_BGRA));
+    naTest(na_TestBabyImageBlend(largeSize, NA_BLEND_OVERLAY, .7f));
+    naTest(na_TestBabyImageHalfSize(naMakeSizei(1284, 960)));
+  }
+
+  naSetBabyImageThreadPool(NA_NULL);
+  naDelete(pool);
+}
+
+
+
+NABool na_TestBabyImageResizeColor(NASizei inSize, NASizei outSize, NAResampleFilter filter){
+  NABabyColor color = {.3f, .6f, .1f, .5f};
+  NABabyImage* image = naCreateBabyImage(inSize, color);
+  NABabyImage* resized = naCreateBabyImageWithResize(image, outSize, filter);
+  size_t pixelCount = (size_t)outSize.width * (size_t)outSize.height;
+  NABool success = naEqualSizei(naGetBabyImageSize(resized), outSize);
+  for(size_t i = 0; i < pixelCount; i++){
+    success = success && na_EqualBabyImageValues(&naGetBabyImageData(resized)[i * 4], color, 4);
+  }
+  naReleaseBabyImage(resized);
+  naReleaseBabyImage(image);
+  return success;
+}
+
+NABool na_TestBabyImageResizeIdentity(NASizei size, NAResampleFilter filter){
+  NABabyImage* image = na_CreateBabyImageTestImage(size, 4);
+  NABabyImage* resized = naCreateBabyImageWithResize(image, size, filter);
+  NABool success = na_EqualBabyImageValues(naGetBabyImageData(image), naGetBabyImageData(resized), (size_t)size.width * (size_t)size.height * 4);
+  naReleaseBabyImage(resized);
+  naReleaseBabyImage(image);
+  return success;
+}
+
+// Upscaling a horizontal ramp keeps it linear inside the image.
+NABool na_TestBabyImageResizeRamp(NAResampleFilter filter){
+  NABabyImage* image = naCreateBabyImage(naMakeSizei(16, 4), NA_NULL);
+  float* data = naGetBabyImageData(image);
+  for(size_t y = 0; y < 4; y++){
+    for(size_t x = 0; x < 16; x++){
+      float* pixel = &data[(y * 16 + x) * 4];
+      pixel[0] = (float)x / 16.f;
+      pixel[1] = .5f;
+      pixel[2] = .5f;
+      pixel[3] = 1.f;
+    }
+  }
+  NABabyImage* resized = naCreateBabyImageWithResize(image, naMakeSizei(64, 3), filter);
+  const float* out = naGetBabyImageData(resized);
+  NABool success = NA_TRUE;
+  for(size_t x = 12; x < 52; x++){
+    float expected = ((float)x + .5f) / 4.f / 16.f - .5f / 16.f;
+    success = success && naAbsf(out[(64 + x) * 4] - expected) < 1e-5f;
+  }
+  naReleaseBabyImage(resized);
+  naReleaseBabyImage(image);
+  return success;
+}
+
+NABool na_TestBabyImageResizeParallel(NASizei inSize, NASizei outSize, NAResampleFilter filter, NAThreadPool* pool){
+  NABabyImage* image = na_CreateBabyImageTestImage(inSize, 5);
+  NABabyImage* serial = naCreateBabyImageWithResize(image, outSize, filter);
+  naSetBabyImageThreadPool(pool);
+  NABabyImage* parallel = naCreateBabyImageWithResize(image, outSize, filter);
+  naSetBabyImageThreadPool(NA_NULL);
+  NABool success = !memcmp(naGetBabyImageData(serial), naGetBabyImageData(parallel), (size_t)outSize.width * (size_t)outSize.height * 4 * sizeof(float));
+  naReleaseBabyImage(parallel);
+  naReleaseBabyImage(serial);
+  naReleaseBabyImage(image);
+  return success;
+}
+
+
+
+void testBabyImageResize(){
+  naTestGroup("Uniform color"){
+    naTest(na_TestBabyImageResizeColor(naMakeSizei(40, 30), naMakeSizei(13, 7), NA_RESAMPLE_BILINEAR));
+    naTest(na_TestBabyImageResizeColor(naMakeSizei(40, 30), naMakeSizei(97, 61), NA_RESAMPLE_BICUBIC));
+    naTest(na_TestBabyImageResizeColor(naMakeSizei(40, 30), naMakeSizei(1, 1), NA_RESAMPLE_LANCZOS));
+    naTest(na_TestBabyImageResizeColor(naMakeSizei(1, 1), naMakeSizei(5, 3), NA_RESAMPLE_LANCZOS));
+  }
+
+  naTestGroup("Same size"){
+    naTest(na_TestBabyImageResizeIdentity(naMakeSizei(21, 17), NA_RESAMPLE_BILINEAR));
+    naTest(na_TestBabyImageResizeIdentity(naMakeSizei(21, 17), NA_RESAMPLE_BICUBIC));
+    naTest(na_TestBabyImageResizeIdentity(naMakeSizei(21, 17), NA_RESAMPLE_LANCZOS));
+  }
+
+  naTestGroup("Interpolation"){
+    naTest(na_TestBabyImageResizeRamp(NA_RESAMPLE_BILINEAR));
+    naTest(na_TestBabyImageResizeRamp(NA_RESAMPLE_BICUBIC));
+  }
+
+  naTestGroup("Transparency"){
+    NABabyColor transparent = {0.f, 0.f, 0.f, 0.f};
+    NABabyImage* image = na_CreateBabyImageTestImage(naMakeSizei(30, 30), 6);
+    NABabyImage* resized = naCreateBabyImageWithResize(image, naMakeSizei(11, 45), NA_RESAMPLE_LANCZOS);
+    NABool valid = NA_TRUE;
+    for(size_t i = 0; i < 11 * 45; i++){
+      const float* pixel = &naGetBabyImageData(resized)[i * 4];
+      valid = valid && pixel[3] >= 0.f && pixel[3] <= 1.f;
+      valid = valid && (pixel[3] > 0.f || na_EqualBabyImageValues(pixel, transparent, 4));
+    }
+    naTest(valid);
+    naReleaseBabyImage(resized);
+    naReleaseBabyImage(image);
+  }
+
+  NAThreadPool* pool = naNewThreadPool(4);
+  naTestGroup("Large images in parallel"){
+    naTest(na_TestBabyImageResizeParallel(naMakeSizei(1000, 800), naMakeSizei(333, 217), NA_RESAMPLE_LANCZOS, pool));
+    naTest(na_TestBabyImageResizeParallel(naMakeSizei(300, 200), naMakeSizei(1024, 768), NA_RESAMPLE_BICUBIC, pool));
+  }
+  naDelete(pool);
+}
+
+
+
+// Compares the pixels of two images, no matter whether they are tiled.
+NABool na_EqualBabyImages(const NABabyImage* image1, const NABabyImage* image2){
+  if(!naEqualSizei(naGetBabyImageSize(image1), naGetBabyImageSize(image2))){return NA_FALSE;}
+  NABabyImage* linear1 = naCreateBabyImageWithTiling(image1, NA_FALSE);
+  NABabyImage* linear2 = naCreateBabyImageWithTiling(image2, NA_FALSE);
+  NASizei size = naGetBabyImageSize(image1);
+  NABool equal = !memcmp(naGetBabyImageData(linear1), naGetBabyImageData(linear2), (size_t)size.width * (size_t)size.height * 4 * sizeof(float));
+  naReleaseBabyImage(linear2);
+  naReleaseBabyImage(linear1);
+  return equal;
+}
+
+NABool na_TestBabyImageTileData(const NABabyImage* linear, const NABabyImage* tiled){
+  NABool success = NA_TRUE;
+  for(size_t t = 0; t < naGetBabyImageTileCount(tiled); t++){
+    NARecti rect = naGetBabyImageTileRect(tiled, t);
+    const float* tileData = naGetBabyImageTileData(tiled, t);
+    for(NAInt y = 0; y < rect.size.height; y++){
+      const float* tileLine = &tileData[y * naGetBabyImageTileValuesPerLine(tiled)];
+      const float* linearLine = &naGetBabyImageData(linear)[(rect.pos.y + y) * naGetBabyImageValuesPerLine(linear) + rect.pos.x * 4];
+      success = success && !memcmp(tileLine, linearLine, (size_t)rect.size.width * 4 * sizeof(float));
+    }
+  }
+  return success;
+}
+
+
+
+void testBabyImageTiles(){
+  NASizei size = naMakeSizei(150, 98);
+  NABabyImage* linear = na_CreateBabyImageTestImage(size, 7);
+  NABabyImage* tiled = naCreateBabyImageWithTiling(linear, NA_TRUE);
+
+  naTestGroup("Tiles"){
+    naTest(naIsBabyImageTiled(tiled));
+    naTest(!naIsBabyImageTiled(linear));
+    naTest(naGetBabyImageTileCount(tiled) == 6);
+    naTest(naGetBabyImageTileCount(linear) == 1);
+    naTest(naEqualRecti(naGetBabyImageTileRect(tiled, 5), naMakeRectiS(128, 64, 22, 34)));
+    naTest(naGetBabyImageTileValuesPerLine(tiled) == NA_BABY_IMAGE_TILE_SIZE * 4);
+    naTest(na_TestBabyImageTileData(linear, tiled));
+    naTest(na_EqualBabyImages(linear, tiled));
+    naTestError(naGetBabyImageData(tiled));
+  }
+
+  naTestGroup("u8 conversion"){
+    uint8* data = naMalloc((size_t)size.width * (size_t)size.height * 4);
+    uint8* linearData = naMalloc((size_t)size.width * (size_t)size.height * 4);
+    uint8* tiledData = naMalloc((size_t)size.width * (size_t)size.height * 4);
+    na_FillBabyImageTestData(data, (size_t)size.width * (size_t)size.height);
+    NABabyImage* tiledFilled = naCreateBabyImageTiled(size, NA_NULL);
+    NABabyImage* linearFilled = naCreateBabyImage(size, NA_NULL);
+    naFillBabyImageWithu8(tiledFilled, data, NA_TRUE, NA_COLOR_BUFFER_BGRA);
+    naFillBabyImageWithu8(linearFilled, data, NA_TRUE, NA_COLOR_BUFFER_BGRA);
+    naTest(na_EqualBabyImages(linearFilled, tiledFilled));
+    naConvertBabyImageTou8(tiledFilled, tiledData, NA_FALSE, NA_COLOR_BUFFER_RGBAPre);
+    naConvertBabyImageTou8(linearFilled, linearData, NA_FALSE, NA_COLOR_BUFFER_RGBAPre);
+    naTest(!memcmp(linearData, tiledData, (size_t)size.width * (size_t)size.height * 4));
+    naReleaseBabyImage(linearFilled);
+    naReleaseBabyImage(tiledFilled);
+    naFree(tiledData);
+    naFree(linearData);
+    naFree(data);
+  }
+
+  naTestGroup("Blending and resampling"){
+    NABabyImage* top = na_CreateBabyImageTestImage(size, 8);
+    NABabyImage* tiledTop = naCreateBabyImageWithTiling(top, NA_TRUE);
+    NABabyColor tint = {.1f, .2f, .3f, .4f};
+    NABabyImage* results[2];
+
+    results[0] = naCreateBabyImageWithBlend(linear, top, NA_BLEND_OVERLAY, .6f);
+    results[1] = naCreateBabyImageWithBlend(tiled, tiledTop, NA_BLEND_OVERLAY, .6f);
+    naTest(naIsBabyImageTiled(results[1]) && na_EqualBabyImages(results[0], results[1]));
+    naReleaseBabyImage(results[1]);
+    results[1] = naCreateBabyImageWithBlend(tiled, top, NA_BLEND_OVERLAY, .6f);
+    naTest(naIsBabyImageTiled(results[1]) && na_EqualBabyImages(results[0], results[1]));
+    naReleaseBabyImage(results[1]);
+    naReleaseBabyImage(results[0]);
+
+    results[0] = naCreateBabyImageWithTint(linear, tint, NA_BLEND_OPAQUE, .5f);
+    results[1] = naCreateBabyImageWithTint(tiled, tint, NA_BLEND_OPAQUE, .5f);
+    naTest(na_EqualBabyImages(results[0], results[1]));
+    naReleaseBabyImage(results[1]);
+    naReleaseBabyImage(results[0]);
+
+    results[0] = naCreateBabyImageWithHalfSize(linear);
+    results[1] = naCreateBabyImageWithHalfSize(tiled);
+    naTest(naIsBabyImageTiled(results[1]) && na_EqualBabyImages(results[0], results[1]));
+    naReleaseBabyImage(results[1]);
+    naReleaseBabyImage(results[0]);
+
+    results[0] = naCreateBabyImageWithResize(linear, naMakeSizei(201, 67), NA_RESAMPLE_LANCZOS);
+    results[1] = naCreateBabyImageWithResize(tiled, naMakeSizei(201, 67), NA_RESAMPLE_LANCZOS);
+    naTest(naIsBabyImageTiled(results[1]) && na_EqualBabyImages(results[0], results[1]));
+    naReleaseBabyImage(results[1]);
+    naReleaseBabyImage(results[0]);
+
+    naReleaseBabyImage(tiledTop);
+    naReleaseBabyImage(top);
+  }
+
+  naTestGroup("Regions"){
+    NARecti rect = naMakeRectiS(50, 20, 90, 70);
+    float* region = naMalloc((size_t)rect.size.width * (size_t)rect.size.height * 4 * sizeof(float));
+    float* tiledRegion = naMalloc((size_t)rect.size.width * (size_t)rect.size.height * 4 * sizeof(float));
+    naGetBabyImageRegion(linear, rect, region);
+    naGetBabyImageRegion(tiled, rect, tiledRegion);
+    naTest(!memcmp(region, tiledRegion, (size_t)rect.size.width * (size_t)rect.size.height * 4 * sizeof(float)));
+    naTest(!memcmp(region, &naGetBabyImageData(linear)[(20 * 150 + 50) * 4], 90 * 4 * sizeof(float)));
+
+    NABabyImage* copy = naCreateBabyImageTiled(size, NA_NULL);
+    naSetBabyImageRegion(copy, naMakeRectiS(0, 0, 150, 98), naGetBabyImageData(linear));
+    naTest(na_EqualBabyImages(linear, copy));
+    naReleaseBabyImage(copy);
+
+    NABabyImage* top = na_CreateBabyImageTestImage(naMakeSizei(90, 70), 9);
+    NABabyImage* linearBase = naCreateBabyImageWithTiling(linear, NA_FALSE);
+    NABabyImage* tiledBase = naCreateBabyImageWithTiling(linear, NA_TRUE);
+    naBlendBabyImageRegion(linearBase, top, rect.pos, NA_BLEND_OVERLAY, .8f);
+    naBlendBabyImageRegion(tiledBase, top, rect.pos, NA_BLEND_OVERLAY, .8f);
+    naTest(na_EqualBabyImages(linearBase, tiledBase));
+
+    // Compare with blending the whole region.
+    naGetBabyImageRegion(linear, rect, region);
+    NABabyImage* regionImage = naCreateBabyImage(rect.size, NA_NULL);
+    naSetBabyImageRegion(regionImage, naMakeRectiS(0, 0, 90, 70), region);
+    NABabyImage* blended = naCreateBabyImageWithBlend(regionImage, top, NA_BLEND_OVERLAY, .8f);
+    naGetBabyImageRegion(tiledBase, rect, tiledRegion);
+    naTest(!memcmp(naGetBabyImageData(blended), tiledRegion, (size_t)rect.size.width * (size_t)rect.size.height * 4 * sizeof(float)));
+
+    naReleaseBabyImage(blended);
+    naReleaseBabyImage(regionImage);
+    naReleaseBabyImage(tiledBase);
+    naReleaseBabyImage(linearBase);
+    naReleaseBabyImage(top);
+    naFree(tiledRegion);
+    naFree(region);
+  }
+
+  NAThreadPool* pool = naNewThreadPool(4);
+  naSetBabyImageThreadPool(pool);
+  naTestGroup("Large images in parallel"){
+    NABabyImage* large = na_CreateBabyImageTestImage(naMakeSizei(1000, 700), 10);
+    NABabyImage* largeTiled = naCreateBabyImageWithTiling(large, NA_TRUE);
+    NABabyImage* results[2];
+    naTest(na_EqualBabyImages(large, largeTiled));
+    results[0] = naCreateBabyImageWithBlend(large, large, NA_BLEND, .5f);
+    results[1] = naCreateBabyImageWithBlend(largeTiled, largeTiled, NA_BLEND, .5f);
+    naTest(na_EqualBabyImages(results[0], results[1]));
+    naReleaseBabyImage(results[1]);
+    naReleaseBabyImage(results[0]);
+    results[0] = naCreateBabyImageWithResize(large, naMakeSizei(640, 480), NA_RESAMPLE_BICUBIC);
+    results[1] = naCreateBabyImageWithResize(largeTiled, naMakeSizei(640, 480), NA_RESAMPLE_BICUBIC);
+    naTest(na_EqualBabyImages(results[0], results[1]));
+    naReleaseBabyImage(results[1]);
+    naReleaseBabyImage(results[0]);
+    naReleaseBabyImage(largeTiled);
+    naReleaseBabyImage(large);
+  }
+  naSetBabyImageThreadPool(NA_NULL);
+  naDelete(pool);
+
+  naReleaseBabyImage(tiled);
+  naReleaseBabyImage(linear);
+}
+
+
+
+void testNABabyImage(){
+  naTestGroupFunction(BabyImageKernels);
+  naTestGroupFunction(BabyImageResize);
+  naTestGroupFunction(BabyImageTiles);
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
@@ -0,0 +1,326 @@
+
+#include "NATesting.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "NADeflate.h"
+
+
+
+// Fills the given data with text-like content which compresses well.
+void na_FillDeflateTestData(NAByte* data, size_t byteSize){
+  const char* words[] = {"NALib ", "buffer ", "deflate ", "huffman ", "tree ", "\n"};
+  uint32 seed = 12345;
+  for(size_t i = 0; i < byteSize; i++){
+    seed = seed * 1103515245 + 12345;
+    const char* word = words[(seed >> 16) % 6];
+    while(*word && i < byteSize){
+      data[i] = (NAByte)*word;
+      word++;
+      i++;
+    }
+    i--;
+  }
+}
+
+
+
+// Fills the given data with something resembling filtered image scanlines:
+// smooth gradients with some noise.
+void na_FillDeflateImageData(NAByte* data, size_t width, size_t height){
+  uint32 seed = 6789;
+  for(size_t y = 0; y < height; y++){
+    for(size_t x = 0; x < width; x++){
+      seed = seed * 1103515245 + 12345;
+      NAByte* pixel = &data[(y * width + x) * 4];
+      pixel[0] = (NAByte)(x + y);
+      pixel[1] = (NAByte)(x / 4);
+      pixel[2] = (NAByte)((seed >> 16) & 0x07);
+      pixel[3] = 255;
+    }
+  }
+}
+
+
+
+NABool na_TestDeflateRoundtrip(const NAByte* data, size_t byteSize, NADeflateCompressionLevel level, size_t* compressedSize){
+  NABuffer* input = naNewBufferWithConstData(data, byteSize);
+  naSetBufferEndianness(input, NA_ENDIANNESS_NETWORK);
+  NABuffer* compressed = naNewBuffer(NA_FALSE);
+  naSetBufferEndianness(compressed, NA_ENDIANNESS_NETWORK);
+  naFillBufferWithZLIBCompression(compressed, input, level);
+  naFixBufferRange(compressed);
+  *compressedSize = (size_t)naGetBufferRange(compressed).length;
+
+  NABuffer* output = naNewBuffer(NA_FALSE);
+  naFillBufferWithZLIBDecompression(output, compressed);
+  NABool success = ((size_t)naGetBufferRange(output).length == byteSize)
+    && naEqualBufferToData(output, data, byteSize, NA_TRUE);
+
+  naRelease(output);
+  naRelease(compressed);
+  naRelease(input);
+  return success;
+}
+
+
+
+// Decompresses the compressed data with the last bytes cut off.
+NABool na_TestDeflateTruncated(const NAByte* data, size_t byteSize, size_t truncation){
+  NABuffer* input = naNewBufferWithConstData(data, byteSize);
+  naSetBufferEndianness(input, NA_ENDIANNESS_NETWORK);
+  NABuffer* compressed = naNewBuffer(NA_FALSE);
+  naSetBufferEndianness(compressed, NA_ENDIANNESS_NETWORK);
+  naFillBufferWithZLIBCompression(compressed, input, NA_DEFLATE_COMPRESSION_DEFAULT);
+  naFixBufferRange(compressed);
+
+  NARangei range = naGetBufferRange(compressed);
+  NABuffer* truncated = naNewBufferExtraction(compressed, range.origin, range.length - (NAInt)truncation);
+  NABuffer* output = naNewBuffer(NA_FALSE);
+  NABool success = naFillBufferWithZLIBDecompression(output, truncated);
+
+  naRelease(output);
+  naRelease(truncated);
+  naRelease(compressed);
+  naRelease(input);
+  return success;
+}
+
+
+
+// Compresses and decompresses the data with the streaming objects, feeding
+// and draining in chunks of the given sizes.
+NABool na_TestDeflateStreaming(const NAByte* data, size_t byteSize, size_t inChunk, size_t outChunk, size_t truncation){
+  NAByte* compressed = naMalloc(byteSize * 2 + 64);
+  NAByte* decompressed = naMalloc(byteSize + 1);
+  NAByte* chunk = naMalloc(outChunk);
+  size_t compressedSize = 0;
+  size_t decompressedSize = 0;
+  size_t count;
+
+  NAZLIBDeflater* deflater = naNewZLIBDeflater(NA_DEFLATE_COMPRESSION_DEFAULT);
+  for(size_t pos = 0; pos < byteSize; pos += inChunk){
+    naFeedZLIBDeflater(deflater, &data[pos], naMins(inChunk, byteSize - pos));
+    while((count = naDrainZLIBDeflater(deflater, chunk, outChunk))){
+      naCopyn(&compressed[compressedSize], chunk, count);
+      compressedSize += count;
+    }
+  }
+  naFinishZLIBDeflater(deflater);
+  while((count = naDrainZLIBDeflater(deflater, chunk, outChunk))){
+    naCopyn(&compressed[compressedSize], chunk, count);
+    compressedSize += count;
+  }
+  naDelete(deflater);
+
+  compressedSize -= truncation;
+  NAZLIBInflater* inflater = naNewZLIBInflater();
+  for(size_t pos = 0; pos < compressedSize; pos += inChunk){
+    naFeedZLIBInflater(inflater, &compressed[pos], naMins(inChunk, compressedSize - pos));
+    while((count = naDrainZLIBInflater(inflater, chunk, outChunk))){
+      if(decompressedSize + count > byteSize){break;}
+      naCopyn(&decompressed[decompressedSize], chunk, count);
+      decompressedSize += count;
+    }
+  }
+  NABool success = naFinishZLIBInflater(inflater)
+    && decompressedSize == byteSize
+    && (!byteSize || !memcmp(decompressed, data, byteSize));
+  naDelete(inflater);
+
+  naFree(chunk);
+  naFree(decompressed);
+  naFree(compressed);
+  return success;
+}
+
+
+
+void testDeflateRoundtrip(){
+  size_t byteSize = 100000;
+  NAByte* text = naMalloc(byteSize);
+  NAByte* noise = naMalloc(byteSize);
+  size_t compressedSize;
+
+  na_FillDeflateTestData(text, byteSize);
+  uint32 seed = 4321;
+  for(size_t i = 0; i < byteSize; i++){
+    seed = seed * 1103515245 + 12345;
+    noise[i] = (NAByte)(seed >> 16);
+  }
+
+  naTestGroup("Compressible data"){
+    naTest(na_TestDeflateRoundtrip(text, byteSize, NA_DEFLATE_COMPRESSION_FASTEST, &compressedSize) && compressedSize < byteSize / 3);
+    naTest(na_TestDeflateRoundtrip(text, byteSize, NA_DEFLATE_COMPRESSION_FAST, &compressedSize) && compressedSize < byteSize / 3);
+    naTest(na_TestDeflateRoundtrip(text, byteSize, NA_DEFLATE_COMPRESSION_DEFAULT, &compressedSize) && compressedSize < byteSize / 3);
+    naTest(na_TestDeflateRoundtrip(text, byteSize, NA_DEFLATE_COMPRESSION_MAX, &compressedSize) && compressedSize < byteSize / 3);
+  }
+
+  naTestGroup("Data larger than the decoding window"){
+    size_t imageByteSize = 512 * 512 * 4;
+    NAByte* image = naMalloc(imageByteSize);
+    na_FillDeflateImageData(image, 512, 512);
+    naTest(na_TestDeflateRoundtrip(image, imageByteSize, NA_DEFLATE_COMPRESSION_FAST, &compressedSize));
+    naTest(na_TestDeflateRoundtrip(image, imageByteSize, NA_DEFLATE_COMPRESSION_DEFAULT, &compressedSize));
+    naFree(image);
+  }
+
+  naTestGroup("Higher levels compress at least as well"){
+    size_t textSizes[4];
+    for(size_t level = 0; level < 4; level++){
+      na_TestDeflateRoundtrip(text, byteSize, (NADeflateCompressionLevel)level, &textSizes[level]);
+    }
+    naTest(textSizes[NA_DEFLATE_COMPRESSION_FAST] <= textSizes[NA_DEFLATE_COMPRESSION_FASTEST]);
+    naTest(textSizes[NA_DEFLATE_COMPRESSION_DEFAULT] <= textSizes[NA_DEFLATE_COMPRESSION_FAST]);
+    naTest(textSizes[NA_DEFLATE_COMPRESSION_MAX] <= textSizes[NA_DEFLATE_COMPRESSION_DEFAULT]);
+
+    size_t imageByteSize = 512 * 512 * 4;
+    NAByte* image = naMalloc(imageByteSize);
+    na_FillDeflateImageData(image, 512, 512);
+    size_t imageSizes[4];
+    for(size_t level = 0; level < 4; level++){
+      na_TestDeflateRoundtrip(image, imageByteSize, (NADeflateCompressionLevel)level, &imageSizes[level]);
+    }
+    naTest(imageSizes[NA_DEFLATE_COMPRESSION_FAST] <= imageSizes[NA_DEFLATE_COMPRESSION_FASTEST]);
+    naTest(imageSizes[NA_DEFLATE_COMPRESSION_DEFAULT] <= imageSizes[NA_DEFLATE_COMPRESSION_FAST]);
+    naTest(imageSizes[NA_DEFLATE_COMPRESSION_MAX] <= imageSizes[NA_DEFLATE_COMPRESSION_DEFAULT]);
+    naFree(image);
+  }
+
+  naTestGroup("Fixed huffman codes"){
+    // Short inputs with literals above 143 which need 9 bit fixed codes.
+    NAByte lines[5 * 16];
+    for(size_t i = 0; i < 5; i++){
+      lines[i * 16] = 1;
+      for(size_t x = 1; x < 16; x++){lines[i * 16 + x] = 0x15;}
+      lines[i * 16 + 1] = (NAByte)(0xa0 + i * 13);
+      lines[i * 16 + 2] = (NAByte)(0xa7 + i * 13);
+      lines[i * 16 + 3] = (NAByte)(0xae + i * 13);
+    }
+    naTest(na_TestDeflateRoundtrip(lines, sizeof(lines), NA_DEFLATE_COMPRESSION_DEFAULT, &compressedSize) && compressedSize < sizeof(lines));
+  }
+
+  naTestGroup("Incompressible data"){
+    naTest(na_TestDeflateRoundtrip(noise, byteSize, NA_DEFLATE_COMPRESSION_DEFAULT, &compressedSize) && compressedSize < byteSize + byteSize / 100);
+    naTest(na_TestDeflateRoundtrip(noise, 1, NA_DEFLATE_COMPRESSION_DEFAULT, &compressedSize));
+  }
+
+  naTestGroup("Streaming"){
+    naTest(na_TestDeflateStreaming(text, byteSize, 1000, 1000, 0));
+    naTest(na_TestDeflateStreaming(text, byteSize, 7, 13, 0));
+    naTest(na_TestDeflateStreaming(noise, byteSize, 4096, 100, 0));
+    naTest(na_TestDeflateStreaming(noise, 0, 1, 1, 0));
+    naTestError(na_TestDeflateStreaming(text, byteSize, 1000, 1000, 10));
+  }
+
+  naTestGroup("Truncated stream"){
+    // The failure is reported with an error in debug and by the return value.
+    #if NA_DEBUG
+      NABool decoded = NA_TRUE;
+      naTestError(decoded = na_TestDeflateTruncated(text, byteSize, 10));
+      naTest(!decoded);
+      naTestError(decoded = na_TestDeflateTruncated(text, byteSize, 2));
+      naTest(!decoded);
+    #else
+      naTest(!na_TestDeflateTruncated(text, byteSize, 10));
+      naTest(!na_TestDeflateTruncated(text, byteSize, 2));
+    #endif
+  }
+
+  naFree(noise);
+  naFree(text);
+}
+
+
+
+void testNADeflate(){
+  naTestGroupFunction(DeflateRoundtrip);
+}
+
+
+
+// The results of the benchmarks are accumulated here such that the compiler
+// can not optimize the work away.
+size_t na_DeflateBenchmarkSum = 0;
+
+void na_BenchmarkDeflateCompress(NABuffer* input, NADeflateCompressionLevel level){
+  NABuffer* compressed = naNewBuffer(NA_FALSE);
+  naSetBufferEndianness(compressed, NA_ENDIANNESS_NETWORK);
+  naFillBufferWithZLIBCompression(compressed, input, level);
+  naFixBufferRange(compressed);
+  na_DeflateBenchmarkSum += (size_t)naGetBufferRange(compressed).length;
+  naRelease(compressed);
+}
+
+void na_BenchmarkDeflateDecompress(NABuffer* compressed){
+  NABuffer* output = naNewBuffer(NA_FALSE);
+  naFillBufferWithZLIBDecompression(output, compressed);
+  na_DeflateBenchmarkSum += (size_t)naGetBufferRange(output).length;
+  naRelease(output);
+}
+
+void na_BenchmarkDeflateSize(size_t width, size_t height){
+  size_t byteSize = width * height * 4;
+  NAByte* image = naMalloc(byteSize);
+  NAByte* text = naMalloc(byteSize);
+  na_FillDeflateImageData(image, width, height);
+  na_FillDeflateTestData(text, byteSize);
+
+  NABuffer* imageInput = naNewBufferWithConstData(image, byteSize);
+  naSetBufferEndianness(imageInput, NA_ENDIANNESS_NETWORK);
+  NABuffer* textInput = naNewBufferWithConstData(text, byteSize);
+  naSetBufferEndianness(textInput, NA_ENDIANNESS_NETWORK);
+  NABuffer* compressed = naNewBuffer(NA_FALSE);
+  naSetBufferEndianness(compressed, NA_ENDIANNESS_NETWORK);
+  naFillBufferWithZLIBCompression(compressed, imageInput, NA_DEFLATE_COMPRESSION_DEFAULT);
+  naFixBufferRange(compressed);
+
+  naBenchmark(na_BenchmarkDeflateCompress(imageInput, NA_DEFLATE_COMPRESSION_FASTEST));
+  naBenchmark(na_BenchmarkDeflateCompress(imageInput, NA_DEFLATE_COMPRESSION_FAST));
+  naBenchmark(na_BenchmarkDeflateCompress(imageInput, NA_DEFLATE_COMPRESSION_DEFAULT));
+  naBenchmark(na_BenchmarkDeflateCompress(imageInput, NA_DEFLATE_COMPRESSION_MAX));
+  naBenchmark(na_BenchmarkDeflateCompress(textInput, NA_DEFLATE_COMPRESSION_DEFAULT));
+  naBenchmark(na_BenchmarkDeflateDecompress(compressed));
+
+  naRelease(compressed);
+  naRelease(textInput);
+  naRelease(imageInput);
+  naFree(text);
+  naFree(image);
+}
+
+
+
+void benchmarkNADeflate(){
+  printf(NA_NL "NADeflate:" NA_NL);
+  naTestGroup("64x64"){na_BenchmarkDeflateSize(64, 64);}
+  naTestGroup("512x512"){na_BenchmarkDeflateSize(512, 512);}
+  naTestGroup("1024x1024"){na_BenchmarkDeflateSize(1024, 1024);}
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>
@@ -0,0 +1,459 @@
+#include "NATesting.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "NAPNG.h"
+#include "NABuffer.h"
+#include "NADeflate.h"
+#include "NAFile.h"
+
+
+
+#define NA_TEST_PNG_PATH_RGB  "NAPNGTestRGB.png"
+#define NA_TEST_PNG_PATH_RGBA "NAPNGTestRGBA.png"
+#define NA_TEST_PNG_PATH_FILTER "NAPNGTestFilter.png"
+#define NA_TEST_PNG_COUNT 8
+
+// Fills a png with a gradient and some noise. Every filter type of the
+// encoder should be worth trying for this content.
+void na_FillPNGTestData(NAPNG* png){
+  NASizei size = naGetPNGSize(png);
+  NAByte* data = naGetPNGPixelData(png);
+  size_t bpp = naGetPNGBytesPerPixel(naGetPNGColorType(png));
+  uint32 seed = 4711;
+  for(NAInt y = 0; y < size.height; y++){
+    for(NAInt x = 0; x < size.width; x++){
+      seed = seed * 1103515245 + 12345;
+      NAByte* pixel = &data[((size_t)y * (size_t)size.width + (size_t)x) * bpp];
+      pixel[0] = (NAByte)(x + y);
+      if(bpp >= 3){
+        pixel[1] = (NAByte)(x * 3);
+        pixel[2] = (NAByte)((seed >> 16) & 0x0f);
+      }
+      if(bpp == 4){pixel[3] = (NAByte)(128 + y);}
+    }
+  }
+}
+
+void na_WritePNGTestFile(const char* path, NAPNGColorType colorType, NASizei size){
+  NAPNG* png = naNewPNG(size, colorType, 8);
+  na_FillPNGTestData(png);
+  naWritePNGToPath(png, path);
+  naDelete(png);
+}
+
+// Writes and reads back a png, returns whether the pixels survived.
+NABool na_RoundtripTestPNG(NAPNGColorType colorType, NASizei size){
+  NAPNG* png = naNewPNG(size, colorType, 8);
+  na_FillPNGTestData(png);
+  naWritePNGToPath(png, NA_TEST_PNG_PATH_RGB);
+  NAPNG* readPNG = naNewPNGWithPath(NA_TEST_PNG_PATH_RGB);
+  naRemove(NA_TEST_PNG_PATH_RGB);
+
+  NABool equal = naEqualSizei(naGetPNGSize(readPNG), size)
+    && naGetPNGPixelDataByteSize(readPNG) == naGetPNGPixelDataByteSize(png)
+    && !memcmp(naGetPNGPixelData(readPNG), naGetPNGPixelData(png), naGetPNGPixelDataByteSize(png));
+  naDelete(readPNG);
+  naDelete(png);
+  return equal;
+}
+
+
+
+NAFileSize na_GetPNGTestFileSize(const char* path){
+  NAFile* file = naCreateFileReadingPath(path);
+  NAFileSize byteSize = naComputeFileByteSize(file);
+  naReleaseFile(file);
+  return byteSize;
+}
+
+
+
+NABool na_EqualTestBabyImages(const NABabyImage* image1, const NABabyImage* image2){
+  NASizei size = naGetBabyImageSize(image1);
+  if(!naEqualSizei(size, naGetBabyImageSize(image2))){return NA_FALSE;}
+  const float* data1 = naGetBabyImageData(image1);
+  const float* data2 = naGetBabyImageData(image2);
+  NAInt valueCount = naGetBabyImageValuesPerLine(image1) * size.height;
+  for(NAInt i = 0; i < valueCount; i++){
+    if(data1[i] != data2[i]){return NA_FALSE;}
+  }
+  return NA_TRUE;
+}
+
+
+
+// The filter predictors as written in the PNG specification. The vectorized
+// unfiltering of the decoder is compared against them.
+NAByte na_GetPNGTestPredictor(NAByte filterType, NAByte a, NAByte b, NAByte c){
+  int p = (int)a + (int)b - (int)c;
+  int pa = p > a ? p - a : a - p;
+  int pb = p > b ? p - b : b - p;
+  int pc = p > c ? p - c : c - p;
+  switch(filterType){
+  case 1: return a;
+  case 2: return b;
+  case 3: return (NAByte)(((int)a + (int)b) / 2);
+  case 4: return (pa <= pb && pa <= pc) ? a : ((pb <= pc) ? b : c);
+  default: return 0;
+  }
+}
+
+// Filters every line with the given filter type and stores the lines with
+// their leading filter type byte in filtered.
+void na_FilterPNGTestLines(NAByte* filtered, const NAByte* pixels, NASizei size, size_t bpp, NAByte filterType){
+  size_t bytesPerLine = (size_t)size.width * bpp;
+  for(size_t y = 0; y < (size_t)size.height; y++){
+    const NAByte* line = &pixels[y * bytesPerLine];
+    const NAByte* upLine = y ? line - bytesPerLine : NA_NULL;
+    NAByte* out = &filtered[y * (bytesPerLine + 1)];
+    out[0] = filterType;
+    for(size_t x = 0; x < bytesPerLine; x++){
+      NAByte a = (x >= bpp) ? line[x - bpp] : 0;
+      NAByte b = upLine ? upLine[x] : 0;
+      NAByte c = (upLine && x >= bpp) ? upLine[x - bpp] : 0;
+      out[x + 1] = line[x] - na_GetPNGTestPredictor(filterType, a, b, c);
+    }
+  }
+}
+
+void na_WritePNGTestChunk(NABufferIterator* iter, const char* typeName, NABuffer* data){
+  NAChecksum checksum;
+  NARangei range = naGetBufferRange(data);
+  naWriteBufferu32(iter, (uint32)range.length);
+  naWriteBufferBytes(iter, typeName, 4);
+  naInitChecksum(&checksum, NA_CHECKSUM_TYPE_CRC_PNG);
+  naAccumulateChecksum(&checksum, (const NAByte*)typeName, 4);
+  if(range.length){
+    naWriteBufferBuffer(iter, data, range);
+    naAccumulateChecksumBuffer(&checksum, data);
+  }
+  naWriteBufferu32(iter, naGetChecksumResult(&checksum));
+  naClearChecksum(&checksum);
+}
+
+// Writes a png file whose lines are filtered with the given filter type
+// instead of the one chosen by the encoder. The encoder only supports
+// truecolor, hence the file is assembled here.
+void na_WriteFilteredTestPNG(const char* path, const NAByte* pixels, NASizei size, NAPNGColorType colorType, NAByte filterType){
+  size_t bpp = naGetPNGBytesPerPixel(colorType);
+  size_t filteredSize = ((size_t)size.width * bpp + 1) * (size_t)size.height;
+  NAByte* filtered = naMalloc(filteredSize);
+  na_FilterPNGTestLines(filtered, pixels, size, bpp, filterType);
+
+  NABuffer* header = naNewBuffer(NA_FALSE);
+  naSetBufferEndianness(header, NA_ENDIANNESS_NETWORK);
+  NABufferIterator iter = naMakeBufferModifier(header);
+  naWriteBufferu32(&iter, (uint32)size.width);
+  naWriteBufferu32(&iter, (uint32)size.height);
+  naWriteBufferu8(&iter, 8);
+  naWriteBufferu8(&iter, (uint8)colorType);
+  naWriteBufferu8(&iter, 0);
+  naWriteBufferu8(&iter, 0);
+  naWriteBufferu8(&iter, 0);
+  naClearBufferIterator(&iter);
+  naFixBufferRange(header);
+
+  NABuffer* input = naNewBufferWithConstData(filtered, filteredSize);
+  naSetBufferEndianness(input, NA_ENDIANNESS_NETWORK);
+  NABuffer* compressed = naNewBuffer(NA_FALSE);
+  naSetBufferEndianness(compressed, NA_ENDIANNESS_NETWORK);
+  naFillBufferWithZLIBCompression(compressed, input, NA_DEFLATE_COMPRESSION_DEFAULT);
+  naFixBufferRange(compressed);
+  NABuffer* empty = naNewBuffer(NA_FALSE);
+  naFixBufferRange(empty);
+
+  const NAByte magic[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  NABuffer* output = naNewBuffer(NA_FALSE);
+  naSetBufferEndianness(output, NA_ENDIANNESS_NETWORK);
+  iter = naMakeBufferModifier(output);
+  naWriteBufferBytes(&iter, magic, 8);
+  na_WritePNGTestChunk(&iter, "IHDR", header);
+  na_WritePNGTestChunk(&iter, "IDAT", compressed);
+  na_WritePNGTestChunk(&iter, "IEND", empty);
+  naClearBufferIterator(&iter);
+  naFixBufferRange(output);
+
+  NAFile* file = naCreateFileWritingPath(path, NA_FILEMODE_DEFAULT);
+  naWriteBufferToFile(output, file);
+  naReleaseFile(file);
+
+  naRelease(output);
+  naRelease(empty);
+  naRelease(compressed);
+  naRelease(input);
+  naRelease(header);
+  naFree(filtered);
+}
+
+// Decodes a png filtered with the given filter type and compares the pixels
+// with the original ones. The pixels are noise on top of a gradient such
+// that all branches of the paeth predictor are taken. Truecolor pngs are
+// also decoded directly into a baby image.
+NABool na_TestPNGUnfiltering(NAPNGColorType colorType, NAByte filterType){
+  // An odd width makes sure the lines are neither aligned nor a multiple of
+  // the vector size.
+  NASizei size = naMakeSizei(37, 9);
+  size_t byteSize = (size_t)naGetSizeiIndexCount(size) * naGetPNGBytesPerPixel(colorType);
+  NAByte* pixels = naMalloc(byteSize);
+  uint32 seed = 815;
+  for(size_t i = 0; i < byteSize; i++){
+    seed = seed * 1103515245 + 12345;
+    pixels[i] = (NAByte)(i / 7 + ((seed >> 16) & 0x3f));
+  }
+  na_WriteFilteredTestPNG(NA_TEST_PNG_PATH_FILTER, pixels, size, colorType, filterType);
+
+  NAPNG* readPNG = naNewPNGWithPath(NA_TEST_PNG_PATH_FILTER);
+  NABool equal = naGetPNGPixelData(readPNG)
+    && naGetPNGPixelDataByteSize(readPNG) == byteSize
+    && !memcmp(naGetPNGPixelData(readPNG), pixels, byteSize);
+
+  if(colorType == NA_PNG_COLORTYPE_TRUECOLOR || colorType == NA_PNG_COLORTYPE_TRUECOLOR_ALPHA){
+    NABabyImage* decoded = naCreateBabyImageWithPNGPath(NA_TEST_PNG_PATH_FILTER);
+    NABabyImage* expected = naCreateBabyImageFromPNG(readPNG);
+    equal = equal && na_EqualTestBabyImages(decoded, expected);
+    naReleaseBabyImage(expected);
+    naReleaseBabyImage(decoded);
+  }
+
+  naRemove(NA_TEST_PNG_PATH_FILTER);
+  naDelete(readPNG);
+  naFree(pixels);
+  return equal;
+}
+
+// Reads back the filter type of every line of a png file.
+void na_ReadPNGTestFilterTypes(const char* path, NAByte* filterTypes, NASizei size, size_t bpp){
+  NABuffer* buffer = naNewBufferWithInputPath(path);
+  naSetBufferEndianness(buffer, NA_ENDIANNESS_NETWORK);
+  NABuffer* compressed = naNewBuffer(NA_FALSE);
+  naSetBufferEndianness(compressed, NA_ENDIANNESS_NETWORK);
+  NABufferIterator compressedIter = naMakeBufferModifier(compressed);
+
+  NAByte magic[8];
+  NAByte typeName[4];
+  NABufferIterator iter = naMakeBufferAccessor(buffer);
+  naReadBufferBytes(&iter, magic, 8);
+  do{
+    uint32 length = naReadBufferu32(&iter);
+    naReadBufferBytes(&iter, typeName, 4);
+    if(length){
+      NABuffer* data = naReadBufferBuffer(&iter, (NAInt)length);
+      if(!memcmp(typeName, "IDAT", 4)){
+        naWriteBufferBuffer(&compressedIter, data, naGetBufferRange(data));
+      }
+      naRelease(data);
+    }
+    naReadBufferu32(&iter);
+  }while(memcmp(typeName, "IEND", 4));
+  naClearBufferIterator(&iter);
+  naClearBufferIterator(&compressedIter);
+  naFixBufferRange(compressed);
+
+  size_t bytesPerLine = (size_t)size.width * bpp;
+  size_t filteredSize = (bytesPerLine + 1) * (size_t)size.height;
+  NAByte* filteredData = naMalloc(filteredSize);
+  NABuffer* filtered = naNewBuffer(NA_FALSE);
+  naFillBufferWithZLIBDecompression(filtered, compressed);
+  iter = naMakeBufferAccessor(filtered);
+  naReadBufferBytes(&iter, filteredData, filteredSize);
+  naClearBufferIterator(&iter);
+  for(size_t y = 0; y < (size_t)size.height; y++){
+    filterTypes[y] = filteredData[y * (bytesPerLine + 1)];
+  }
+  naFree(filteredData);
+
+  naRelease(filtered);
+  naRelease(compressed);
+  naRelease(buffer);
+}
+
+
+
+void testPNGFiltering(){
+  naTestGroup("Roundtrip"){
+    naTest(na_RoundtripTestPNG(NA_PNG_COLORTYPE_TRUECOLOR_ALPHA, naMakeSizei(77, 61)));
+    naTest(na_RoundtripTestPNG(NA_PNG_COLORTYPE_TRUECOLOR, naMakeSizei(77, 61)));
+  }
+
+  naTestGroup("Small and large lines"){
+    naTest(na_RoundtripTestPNG(NA_PNG_COLORTYPE_TRUECOLOR_ALPHA, naMakeSizei(1, 5)));
+    naTest(na_RoundtripTestPNG(NA_PNG_COLORTYPE_TRUECOLOR, naMakeSizei(5, 3)));
+    naTest(na_RoundtripTestPNG(NA_PNG_COLORTYPE_TRUECOLOR_ALPHA, naMakeSizei(1000, 7)));
+    naTest(na_RoundtripTestPNG(NA_PNG_COLORTYPE_TRUECOLOR, naMakeSizei(1001, 7)));
+  }
+
+  naTestGroup("Unfiltering matches the specification"){
+    // All filter types with 1 to 4 bytes per pixel.
+    for(NAByte filterType = 0; filterType <= 4; filterType++){
+      naTest(na_TestPNGUnfiltering(NA_PNG_COLORTYPE_GREYSCALE, filterType));
+      naTest(na_TestPNGUnfiltering(NA_PNG_COLORTYPE_GREYSCALE_ALPHA, filterType));
+      naTest(na_TestPNGUnfiltering(NA_PNG_COLORTYPE_TRUECOLOR, filterType));
+      naTest(na_TestPNGUnfiltering(NA_PNG_COLORTYPE_TRUECOLOR_ALPHA, filterType));
+    }
+  }
+
+  naTestGroup("Filter heuristic"){
+    // In a gradient, every pixel is predictable from its neighbours, hence
+    // no line should be stored unfiltered.
+    NASizei size = naMakeSizei(64, 16);
+    NAPNG* png = naNewPNG(size, NA_PNG_COLORTYPE_TRUECOLOR, 8);
+    NAByte* data = naGetPNGPixelData(png);
+    for(NAInt y = 0; y < size.height; y++){
+      for(NAInt x = 0; x < size.width; x++){
+        NAByte* pixel = &data[((size_t)y * (size_t)size.width + (size_t)x) * 3];
+        pixel[0] = (NAByte)(x * 4);
+        pixel[1] = (NAByte)(y * 8);
+        pixel[2] = (NAByte)(x + y);
+      }
+    }
+    naWritePNGToPath(png, NA_TEST_PNG_PATH_FILTER);
+    NAByte filterTypes[16];
+    na_ReadPNGTestFilterTypes(NA_TEST_PNG_PATH_FILTER, filterTypes, size, 3);
+    NABool allFiltered = NA_TRUE;
+    for(size_t y = 0; y < 16; y++){
+      if(filterTypes[y] == 0 || filterTypes[y] > 4){allFiltered = NA_FALSE;}
+    }
+    naTest(allFiltered);
+    naRemove(NA_TEST_PNG_PATH_FILTER);
+    naDelete(png);
+  }
+
+  naTestGroup("Writing twice"){
+    NAPNG* png = naNewPNG(naMakeSizei(77, 61), NA_PNG_COLORTYPE_TRUECOLOR_ALPHA, 8);
+    na_FillPNGTestData(png);
+    naWritePNGToPath(png, NA_TEST_PNG_PATH_RGBA);
+    NAFileSize byteSize = na_GetPNGTestFileSize(NA_TEST_PNG_PATH_RGBA);
+    naWritePNGToPath(png, NA_TEST_PNG_PATH_RGBA);
+    naTest(na_GetPNGTestFileSize(NA_TEST_PNG_PATH_RGBA) == byteSize);
+    naRemove(NA_TEST_PNG_PATH_RGBA);
+    naDelete(png);
+  }
+}
+
+
+
+void testPNGReading(){
+  NASizei size = naMakeSizei(77, 61);
+  na_WritePNGTestFile(NA_TEST_PNG_PATH_RGB, NA_PNG_COLORTYPE_TRUECOLOR, size);
+  na_WritePNGTestFile(NA_TEST_PNG_PATH_RGBA, NA_PNG_COLORTYPE_TRUECOLOR_ALPHA, size);
+
+  naTestGroup("Pipelined decoding"){
+    NAPNG* png = naNewPNGWithPath(NA_TEST_PNG_PATH_RGBA);
+    NABabyImage* expected = naCreateBabyImageFromPNG(png);
+    NABabyImage* image = naCreateBabyImageWithPNGPath(NA_TEST_PNG_PATH_RGBA);
+    naTest(image != NA_NULL);
+    naTest(na_EqualTestBabyImages(image, expected));
+    naReleaseBabyImage(image);
+    naReleaseBabyImage(expected);
+    naDelete(png);
+
+    png = naNewPNGWithPath(NA_TEST_PNG_PATH_RGB);
+    expected = naCreateBabyImageFromPNG(png);
+    image = naCreateBabyImageWithPNGPath(NA_TEST_PNG_PATH_RGB);
+    naTest(image != NA_NULL);
+    naTest(na_EqualTestBabyImages(image, expected));
+    naTest(naGetBabyImageData(image)[3] == 1.f);
+    naReleaseBabyImage(image);
+    naReleaseBabyImage(expected);
+    naDelete(png);
+  }
+
+  naTestGroup("Batch decoding"){
+    const char* paths[NA_TEST_PNG_COUNT];
+    NABabyImage* images[NA_TEST_PNG_COUNT];
+    for(size_t i = 0; i < NA_TEST_PNG_COUNT; i++){
+      paths[i] = (i % 2) ? NA_TEST_PNG_PATH_RGB : NA_TEST_PNG_PATH_RGBA;
+    }
+    NABabyImage* expectedRGBA = naCreateBabyImageWithPNGPath(NA_TEST_PNG_PATH_RGBA);
+    NABabyImage* expectedRGB = naCreateBabyImageWithPNGPath(NA_TEST_PNG_PATH_RGB);
+
+    NAThreadPool* pool = naNewThreadPool(4);
+    naTestVoid(naCreateBabyImagesWithPNGPaths(images, paths, NA_TEST_PNG_COUNT, pool));
+    naDelete(pool);
+    NABool allCorrect = NA_TRUE;
+    for(size_t i = 0; i < NA_TEST_PNG_COUNT; i++){
+      if(!images[i] || !na_EqualTestBabyImages(images[i], (i % 2) ? expectedRGB : expectedRGBA)){allCorrect = NA_FALSE;}
+      if(images[i]){naReleaseBabyImage(images[i]);}
+    }
+    naTest(allCorrect);
+
+    naTestVoid(naCreateBabyImagesWithPNGPaths(images, paths, 2, NA_NULL));
+    naTest(na_EqualTestBabyImages(images[0], expectedRGBA));
+    naTest(na_EqualTestBabyImages(images[1], expectedRGB));
+    naReleaseBabyImage(images[0]);
+    naReleaseBabyImage(images[1]);
+
+    naReleaseBabyImage(expectedRGBA);
+    naReleaseBabyImage(expectedRGB);
+  }
+
+  naRemove(NA_TEST_PNG_PATH_RGB);
+  naRemove(NA_TEST_PNG_PATH_RGBA);
+}
+
+
+
+void testNAPNG(){
+  naTestGroupFunction(PNGFiltering);
+  naTestGroupFunction(PNGReading);
+}
+
+
+
+void na_BenchmarkPNGRead(const char* path){
+  NAPNG* png = naNewPNGWithPath(path);
+  naDelete(png);
+}
+
+void na_BenchmarkPNGDecode(const char* path){
+  NABabyImage* image = naCreateBabyImageWithPNGPath(path);
+  naReleaseBabyImage(image);
+}
+
+void na_BenchmarkPNGSize(NASizei size){
+  NAPNG* png = naNewPNG(size, NA_PNG_COLORTYPE_TRUECOLOR_ALPHA, 8);
+  na_FillPNGTestData(png);
+  naWritePNGToPath(png, NA_TEST_PNG_PATH_RGBA);
+
+  naBenchmark(naWritePNGToPath(png, NA_TEST_PNG_PATH_RGBA));
+  naBenchmark(na_BenchmarkPNGRead(NA_TEST_PNG_PATH_RGBA));
+  naBenchmark(na_BenchmarkPNGDecode(NA_TEST_PNG_PATH_RGBA));
+
+  naRemove(NA_TEST_PNG_PATH_RGBA);
+  naDelete(png);
+}
+
+void benchmarkNAPNG(){
+  printf(NA_NL "NAPNG:" NA_NL);
+  naTestGroup("64x64"){na_BenchmarkPNGSize(naMakeSizei(64, 64));}
+  naTestGroup("256x256"){na_BenchmarkPNGSize(naMakeSizei(256, 256));}
+  naTestGroup("1024x1024"){na_BenchmarkPNGSize(naMakeSizei(1024, 1024));}
+}
+
+
+
+// This is free and unencumbered software released into the public domain.
+
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// For more information, please refer to <http://unlicense.org/>